@@ -1,6 +1,9 @@
 #include "EchoApo.h"
+#include <algorithm>
 static const GUID CLSID_EchoApo_Value = { 0x5f6c2a6e, 0x6b09, 0x4b1a,{0x9a,0x57,0x91,0x2c,0x7f,0x0a,0x0b,0x11} };
 extern "C" const CLSID CLSID_EchoApo = CLSID_EchoApo_Value;
+// Mic DC blocker corner: r = 0.995 at 48 kHz
+static const float kDcCutoffHz = 38.3f;
 EchoApo::EchoApo() : refCount(1), channels(1) {}
 EchoApo::~EchoApo() {}
 ULONG EchoApo::AddRef() { return InterlockedIncrement(&refCount); }
@@ -24,13 +27,13 @@ HRESULT EchoApo::Initialize(APOInit* pInit) {
     current.filterLen = 1024;
     current.mu = 0.1f;
     current.epsilon = 1e-6f;
-    AECParams ap; ap.sampleRate = (int)sampleRate; ap.channels = (int)channels; ap.filterLen = current.filterLen; ap.mu = current.mu; ap.epsilon = current.epsilon; ap.leak=0.0001f; ap.maxDelayMs=80; ap.corrBlock=1024; ap.dtdAlpha=2.0f; ap.dtdBeta=1.5f;
+    AECParams ap = defaultAECParams((int)sampleRate); ap.channels = (int)channels; ap.filterLen = current.filterLen; ap.mu = current.mu; ap.epsilon = current.epsilon;
     aec.initialize(ap);
     aecInit = true;
     AIParams ip; ip.sampleRate = (int)sampleRate; ip.channels = (int)channels;
     ai.initialize(ip);
     aiInit = true;
-    dcPrevIn = 0.0f; dcPrevOut = 0.0f; dcAlpha = 0.995f;
+    dcBlocker.reset((int)sampleRate, kDcCutoffHz);
     return S_OK;
 }
 HRESULT EchoApo::Reset() { return S_OK; }
@@ -49,23 +52,14 @@ HRESULT EchoApo::Process(UINT32 u32NumInputConnections, APO_CONNECTION** ppInput
     micBuf.resize(frames);
     refBuf.resize(frames);
     outBuf.resize(frames);
-    for (UINT32 i=0;i<frames;i++) {
-        float x = pi[i];
-        float y = x - dcPrevIn + dcAlpha * dcPrevOut;
-        dcPrevIn = x;
-        dcPrevOut = y;
-        micBuf[i] = y;
-        refBuf[i] = 0.0f;
-    }
+    std::copy(pi, pi + frames, micBuf.begin());
+    std::fill(refBuf.begin(), refBuf.end(), 0.0f);
+    dcBlocker.process(micBuf.data(), frames);
     if (aecInit) aec.process(micBuf.data(), refBuf.data(), outBuf.data(), frames);
     else outBuf = micBuf;
     if (aiInit) ai.process(outBuf.data(), frames);
-    for (UINT32 i=0;i<frames;i++) {
-        float v = outBuf[i];
-        if (v > 0.99f) v = 0.99f;
-        if (v < -0.99f) v = -0.99f;
-        po[i] = v;
-    }
+    clampSamples(outBuf.data(), frames, 0.99f);
+    std::copy(outBuf.begin(), outBuf.end(), po);
     return S_OK;
 }
 HRESULT EchoApo::UnlockForProcess() { return S_OK; }
@@ -73,7 +67,7 @@ HRESULT EchoApo::SetEffectsParameters(GUID* pEffectId, void* pParameters, UINT32
     if (!pParameters || cbParameters < sizeof(ApoParams)) return E_INVALIDARG;
     ApoParams* pr = reinterpret_cast<ApoParams*>(pParameters);
     current = *pr;
-    AECParams ap; ap.sampleRate = (int)sampleRate; ap.channels = (int)channels; ap.filterLen = current.filterLen; ap.mu = current.mu; ap.epsilon = current.epsilon; ap.leak=0.0001f; ap.maxDelayMs=80; ap.corrBlock=1024; ap.dtdAlpha=2.0f; ap.dtdBeta=1.5f;
+    AECParams ap = defaultAECParams((int)sampleRate); ap.channels = (int)channels; ap.filterLen = current.filterLen; ap.mu = current.mu; ap.epsilon = current.epsilon;
     aec.initialize(ap);
     AIParams ip; ip.sampleRate = (int)sampleRate; ip.channels = (int)channels;
     ai.initialize(ip);
@@ -9,6 +9,7 @@
 #include <vector>
 #include "../src/aec_core/AECProcessor.h"
 #include "../src/aec_core/AIEnhancer.h"
+#include "../src/audio_io/SampleConvert.h"
 #include "ApoParams.h"
 typedef long long HRTIME;
 struct APOInit { int reserved; };
@@ -48,9 +49,7 @@ private:
     std::vector<float> micBuf;
     std::vector<float> outBuf;
     ApoParams current;
-    float dcPrevIn;
-    float dcPrevOut;
-    float dcAlpha;
+    DcBlocker dcBlocker;
 };
 class EchoApoClassFactory : public IClassFactory {
 public:
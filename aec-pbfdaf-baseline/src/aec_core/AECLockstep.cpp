@@ -0,0 +1,528 @@
+#include "AECLockstep.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+static const size_t kL = AECLockstep::kLanes;
+
+static inline float sq(float x) { return x * x; }
+
+// Control constants of AECProcessor
+static const float kPsdAlpha = 0.95f;
+static const int kDtdHoldBlocks = 10;
+static const int kLagConfirmBlocks = 3;
+static const int kLagJitter = 2;
+
+static inline int lagMinStep(int sampleRate) {
+    return std::max(kLagJitter, sampleRate / 2000);
+}
+
+// Filter window starts ~1 ms ahead of the estimated echo peak (see AECProcessor)
+static inline int filterLag(int lag, int sampleRate) {
+    int margin = sampleRate / 1000;
+    return lag > margin ? lag - margin : 0;
+}
+
+template <typename T>
+static void fillLane(std::vector<T>& v, size_t lane, T value) {
+    for (size_t j = lane; j < v.size(); j += kL) v[j] = value;
+}
+
+// Per-bin loops over all lanes at once (n = bins * kLanes). __restrict: they touch more
+// arrays than the compiler will check for overlap at run time before vectorizing.
+static void accumulatePower(const float* __restrict xr, const float* __restrict xi, float* __restrict power, size_t n) {
+    for (size_t j = 0; j < n; ++j) power[j] += xr[j] * xr[j] + xi[j] * xi[j];
+}
+
+// Smoothed mic, reference, cross and normalization PSDs; coh gets each bin's coherence
+static void smoothSpectra(const float* __restrict dr, const float* __restrict di,
+                          const float* __restrict xr, const float* __restrict xi, const float* __restrict xPower,
+                          float* __restrict psdMic, float* __restrict psdRef, float* __restrict crossRe,
+                          float* __restrict crossIm, float* __restrict psd, float* __restrict coh, size_t n) {
+    const float a = kPsdAlpha, b = 1.0f - kPsdAlpha;
+    for (size_t j = 0; j < n; ++j) {
+        psdMic[j] = a * psdMic[j] + b * (dr[j] * dr[j] + di[j] * di[j]);
+        psdRef[j] = a * psdRef[j] + b * (xr[j] * xr[j] + xi[j] * xi[j]);
+        // D * conj(X)
+        crossRe[j] = a * crossRe[j] + b * (dr[j] * xr[j] + di[j] * xi[j]);
+        crossIm[j] = a * crossIm[j] + b * (di[j] * xr[j] - dr[j] * xi[j]);
+        psd[j] = a * psd[j] + b * xPower[j];
+        coh[j] = (crossRe[j] * crossRe[j] + crossIm[j] * crossIm[j]) / (psdRef[j] * psdMic[j] + 1e-9f);
+    }
+}
+
+static void multiplyAccumulate(const float* __restrict xr, const float* __restrict xi,
+                               const float* __restrict wr, const float* __restrict wi,
+                               float* __restrict yr, float* __restrict yi, size_t n) {
+    for (size_t j = 0; j < n; ++j) {
+        yr[j] += xr[j] * wr[j] - xi[j] * wi[j];
+        yi[j] += xr[j] * wi[j] + xi[j] * wr[j];
+    }
+}
+
+// W += step E conj(X)
+static void adaptPartition(float* __restrict wr, float* __restrict wi, const float* __restrict xr,
+                           const float* __restrict xi, const float* __restrict er, const float* __restrict ei,
+                           const float* __restrict step, size_t n) {
+    for (size_t j = 0; j < n; ++j) {
+        wr[j] += step[j] * (er[j] * xr[j] + ei[j] * xi[j]);
+        wi[j] += step[j] * (ei[j] * xr[j] - er[j] * xi[j]);
+    }
+}
+
+static void subtract(const float* __restrict a, const float* __restrict b, float* __restrict out, size_t n) {
+    for (size_t j = 0; j < n; ++j) out[j] = a[j] - b[j];
+}
+
+// c[l] += sum_n feed[n * stride + l] * ring[n * stride + l]
+static void correlateLanes(const float* __restrict feed, const float* __restrict ring, size_t count,
+                           size_t stride, float* __restrict c) {
+    for (size_t n = 0; n < count; ++n) {
+        for (size_t l = 0; l < kL; ++l) c[l] += feed[n * stride + l] * ring[n * stride + l];
+    }
+}
+
+// One lane: sum_n feed[n * kL] * ring[n * kL]
+static float correlateLane(const float* feed, const float* ring, size_t count) {
+    float c = 0.0f;
+    for (size_t n = 0; n < count; ++n) c += feed[n * kL] * ring[n * kL];
+    return c;
+}
+
+AECLockstep::AECLockstep() :
+    fdafM(0), fdafN(0), bins(0), numPartitions(0), ringCap(0), ringIdx(0), corrCount(0), maxLag(0),
+    blkIdx(0), outRead(0), outCount(0), xHead(0), constraintIdx(0)
+{
+    params = AECParams();
+    statsSeq.store(0);
+    atomicMu.store(0.05f);
+    atomicDtdAlpha.store(2.0f);
+    atomicFreezeBlocks.store(5);
+}
+
+void AECLockstep::initialize(const AECParams& p) {
+    params = p;
+    fdafM = 256;
+    fdafN = fdafM * 2;
+    size_t alignedLen = ((size_t)std::max(1, params.filterLen) + fdafM - 1) / fdafM * fdafM;
+    numPartitions = std::max<size_t>(1, alignedLen / fdafM);
+    fft.init(fdafN);
+    bins = fft.bins();
+    const size_t KL = bins * kL;
+
+    maxLag = params.maxDelayMs * params.sampleRate / 1000;
+    int corrBlock = std::max(1, params.corrBlock);
+    params.corrBlock = corrBlock;
+    ringCap = (size_t)std::max(0, maxLag) + (size_t)corrBlock + fdafM;
+    refRing.assign(ringCap * kL, 0.0f);
+    ringIdx = 0;
+    micFeed.assign((size_t)corrBlock * kL, 0.0f);
+    corrCount = 0;
+    micPow.assign(kL, 0.0f);
+    refPow.assign(kL, 0.0f);
+    lag.assign(kL, 0);
+    lagCandidate.assign(kL, 0);
+    lagHits.assign(kL, 0);
+    delayUpdates.assign(kL, 0);
+
+    blkMic.assign(fdafM * kL, 0.0f);
+    blkRef.assign(fdafM * kL, 0.0f);
+    refPrev.assign(fdafM * kL, 0.0f);
+    micPrev.assign(fdafM * kL, 0.0f);
+    blkIdx = 0;
+    outBlock.assign(fdafM * kL, 0.0f);
+    outRead = 0;
+    outCount = 0;
+    frame.assign(fdafN * kL, 0.0f);
+
+    Xre.assign(numPartitions * KL, 0.0f);
+    Xim.assign(numPartitions * KL, 0.0f);
+    Wre.assign(numPartitions * KL, 0.0f);
+    Wim.assign(numPartitions * KL, 0.0f);
+    xHead = 0;
+    Dre.assign(KL, 0.0f);
+    Dim.assign(KL, 0.0f);
+    Yre.assign(KL, 0.0f);
+    Yim.assign(KL, 0.0f);
+    Ere.assign(KL, 0.0f);
+    Eim.assign(KL, 0.0f);
+    xPower.assign(KL, 0.0f);
+    psd.assign(KL, 100.0f);
+    psdMic.assign(KL, 1e-9f);
+    psdRef.assign(KL, 1e-9f);
+    psdCrossRe.assign(KL, 0.0f);
+    psdCrossIm.assign(KL, 0.0f);
+    constraintIdx = 0;
+
+    adapt.assign(kL, 1.0f);
+    micE.assign(kL, 0.0f);
+    refE.assign(kL, 0.0f);
+    errE.assign(kL, 0.0f);
+    instantErle.assign(kL, 0.0f);
+    avgErle.assign(kL, 0.0f);
+    maxErle.assign(kL, 0.0f);
+    convergedTimeMs.assign(kL, 0.0f);
+    coherence.assign(kL, 0.0f);
+    dtdHold.assign(kL, 0);
+    delayFreeze.assign(kL, 0);
+    totalBlocks.assign(kL, 0);
+
+    atomicMu.store(params.mu);
+    atomicDtdAlpha.store(params.dtdAlpha);
+    loadMonitor.reset(params.sampleRate);
+    statsBuf.assign(kL, AECStats());
+    publishStats();
+}
+
+void AECLockstep::resetLane(size_t l) {
+    if (l >= kL) return;
+    fillLane(refRing, l, 0.0f);
+    fillLane(micFeed, l, 0.0f);
+    micPow[l] = 0.0f;
+    refPow[l] = 0.0f;
+    lag[l] = 0;
+    lagCandidate[l] = 0;
+    lagHits[l] = 0;
+    delayUpdates[l] = 0;
+    fillLane(blkMic, l, 0.0f);
+    fillLane(blkRef, l, 0.0f);
+    fillLane(refPrev, l, 0.0f);
+    fillLane(micPrev, l, 0.0f);
+    fillLane(outBlock, l, 0.0f);
+    fillLane(Xre, l, 0.0f);
+    fillLane(Xim, l, 0.0f);
+    fillLane(Wre, l, 0.0f);
+    fillLane(Wim, l, 0.0f);
+    fillLane(psd, l, 100.0f);
+    fillLane(psdMic, l, 1e-9f);
+    fillLane(psdRef, l, 1e-9f);
+    fillLane(psdCrossRe, l, 0.0f);
+    fillLane(psdCrossIm, l, 0.0f);
+    adapt[l] = 1.0f;
+    micE[l] = refE[l] = errE[l] = 0.0f;
+    instantErle[l] = avgErle[l] = maxErle[l] = convergedTimeMs[l] = 0.0f;
+    coherence[l] = 0.0f;
+    dtdHold[l] = 0;
+    delayFreeze[l] = 0;
+    totalBlocks[l] = 0;
+    publishStats();
+}
+
+void AECLockstep::setMu(float val) { atomicMu.store(val); }
+void AECLockstep::setDtdAlpha(float val) { atomicDtdAlpha.store(val); }
+void AECLockstep::setFreezeBlocks(int blocks) { atomicFreezeBlocks.store(blocks); }
+
+int AECLockstep::getLatency() const {
+    return fdafM > 0 ? (int)fdafM - 1 : 0;
+}
+
+void AECLockstep::process(const float* const* mic, const float* const* ref, float* const* out, size_t frames) {
+    LoadMonitor::Scope load(loadMonitor, frames);
+    size_t readLag[kL];
+    for (size_t l = 0; l < kL; ++l) readLag[l] = (size_t)filterLag(lag[l], params.sampleRate);
+
+    for (size_t i = 0; i < frames; ++i) {
+        float m[kL];
+        float* ring = &refRing[ringIdx * kL];
+        for (size_t l = 0; l < kL; ++l) {
+            bool live = mic[l] && ref[l];
+            ring[l] = live ? ref[l][i] : 0.0f;
+            m[l] = live ? mic[l][i] : 0.0f;
+        }
+
+        // Correlation block for the lag search
+        float* feed = &micFeed[corrCount * kL];
+        for (size_t l = 0; l < kL; ++l) {
+            feed[l] = m[l];
+            micPow[l] += sq(m[l]);
+            refPow[l] += sq(ring[l]);
+        }
+
+        // Reference at each lane's lag (a gather: the lags differ)
+        float* br = &blkRef[blkIdx * kL];
+        float* bm = &blkMic[blkIdx * kL];
+        for (size_t l = 0; l < kL; ++l) {
+            size_t pos = ringIdx >= readLag[l] ? ringIdx - readLag[l] : ringIdx + ringCap - readLag[l];
+            br[l] = refRing[pos * kL + l];
+            bm[l] = m[l];
+        }
+        if (++ringIdx == ringCap) ringIdx = 0;
+
+        if (++corrCount >= (size_t)params.corrBlock) {
+            updateDelay();
+            for (size_t l = 0; l < kL; ++l) readLag[l] = (size_t)filterLag(lag[l], params.sampleRate);
+            corrCount = 0;
+            std::fill(micPow.begin(), micPow.end(), 0.0f);
+            std::fill(refPow.begin(), refPow.end(), 0.0f);
+        }
+
+        if (++blkIdx >= fdafM) {
+            performBlock();
+            blkIdx = 0;
+            outRead = 0;
+            outCount = fdafM;
+        }
+
+        // Output: the most recent block, one sample per input sample
+        const float* ob = &outBlock[outRead * kL];
+        for (size_t l = 0; l < kL; ++l) {
+            if (out[l]) out[l][i] = outCount > 0 ? ob[l] : 0.0f;
+        }
+        if (outCount > 0) {
+            outRead++;
+            outCount--;
+        }
+    }
+}
+
+// Same search as AECProcessor::updateDelay: coarse (every 4th lag and sample), a fine
+// search around the peak, then kLagConfirmBlocks consistent estimates. The coarse pass
+// shares ring positions across lanes, so it runs on all of them at once.
+void AECLockstep::updateDelay() {
+    if (maxLag <= 0) return;
+    const int bs = params.corrBlock;
+    const size_t base = ringIdx + 2 * ringCap - (size_t)bs;
+    float bestCorr[kL];
+    int bestLag[kL];
+    for (size_t l = 0; l < kL; ++l) {
+        bestCorr[l] = 0.0f;
+        bestLag[l] = lag[l];
+    }
+    for (int d = 0; d < maxLag; d += 4) {
+        float c[kL] = {};
+        size_t pos = (base - (size_t)d) % ringCap;
+        for (size_t i = 0; i < (size_t)bs;) {
+            // Every 4th sample, up to the end of the ring or the block
+            size_t run = std::min(((size_t)bs - i + 3) / 4, (ringCap - pos + 3) / 4);
+            correlateLanes(&micFeed[i * kL], &refRing[pos * kL], run, 4 * kL, c);
+            i += 4 * run;
+            pos += 4 * run;
+            if (pos >= ringCap) pos -= ringCap;
+        }
+        for (size_t l = 0; l < kL; ++l) {
+            float a = std::abs(c[l]);
+            if (a > bestCorr[l]) {
+                bestCorr[l] = a;
+                bestLag[l] = d;
+            }
+        }
+    }
+
+    for (size_t l = 0; l < kL; ++l) {
+        // As AECProcessor: no search during double talk or without far-end signal
+        if (dtdHold[l] > 0 || refPow[l] <= 1e-6f) continue;
+        int start = std::max(0, bestLag[l] - 4);
+        int end = std::min(maxLag, bestLag[l] + 4);
+        float best = 0.0f;
+        int found = bestLag[l];
+        for (int d = start; d <= end; ++d) {
+            float c = 0.0f;
+            size_t pos = (base - (size_t)d) % ringCap;
+            for (size_t i = 0; i < (size_t)bs;) {
+                size_t run = std::min((size_t)bs - i, ringCap - pos);
+                c += correlateLane(&micFeed[i * kL + l], &refRing[pos * kL + l], run);
+                i += run;
+                pos += run;
+                if (pos >= ringCap) pos -= ringCap;
+            }
+            if (std::abs(c) > best) {
+                best = std::abs(c);
+                found = d;
+            }
+        }
+
+        if (std::abs(found - lagCandidate[l]) <= kLagJitter) {
+            lagHits[l]++;
+        } else {
+            lagCandidate[l] = found;
+            lagHits[l] = 1;
+        }
+        if (lagHits[l] >= kLagConfirmBlocks && std::abs(lagCandidate[l] - lag[l]) >= lagMinStep(params.sampleRate)) {
+            lag[l] = lagCandidate[l];
+            laneLagChanged(l);
+        }
+    }
+}
+
+// The reference history no longer matches the new alignment. Unlike AECProcessor the
+// block phase is shared and stays; the lane's filter adapts on after the freeze.
+void AECLockstep::laneLagChanged(size_t l) {
+    delayFreeze[l] = atomicFreezeBlocks.load() * (int)fdafM;
+    delayUpdates[l]++;
+    fillLane(Xre, l, 0.0f);
+    fillLane(Xim, l, 0.0f);
+    fillLane(refPrev, l, 0.0f);
+}
+
+void AECLockstep::performBlock() {
+    const size_t M = fdafM;
+    const size_t KL = bins * kL;
+    const size_t P = numPartitions;
+    const size_t ML = M * kL;
+
+    // 1. Newest reference spectrum into the oldest partition slot
+    xHead = (xHead + P - 1) % P;
+    float* x0r = &Xre[xHead * KL];
+    float* x0i = &Xim[xHead * KL];
+    std::copy(refPrev.begin(), refPrev.end(), frame.begin());
+    std::copy(blkRef.begin(), blkRef.end(), frame.begin() + ML);
+    fft.forward(frame.data(), x0r, x0i);
+    std::copy(blkRef.begin(), blkRef.end(), refPrev.begin());
+
+    // 2. Power over all partitions
+    std::fill(xPower.begin(), xPower.end(), 0.0f);
+    for (size_t p = 0; p < P; ++p) accumulatePower(&Xre[p * KL], &Xim[p * KL], xPower.data(), KL);
+
+    // 3. Mic spectrum, smoothed PSDs and mic/ref coherence
+    std::copy(micPrev.begin(), micPrev.end(), frame.begin());
+    std::copy(blkMic.begin(), blkMic.end(), frame.begin() + ML);
+    fft.forward(frame.data(), Dre.data(), Dim.data());
+    std::copy(blkMic.begin(), blkMic.end(), micPrev.begin());
+    smoothSpectra(Dre.data(), Dim.data(), x0r, x0i, xPower.data(), psdMic.data(), psdRef.data(),
+                  psdCrossRe.data(), psdCrossIm.data(), psd.data(), Yre.data(), KL);
+    float cohSum[kL] = {};
+    for (size_t k = 0; k < bins; ++k) {
+        for (size_t l = 0; l < kL; ++l) cohSum[l] += Yre[k * kL + l];
+    }
+    for (size_t l = 0; l < kL; ++l) coherence[l] = cohSum[l] / (float)bins;
+
+    // 4. Echo estimate Y = sum_p X[p] W[p]
+    std::fill(Yre.begin(), Yre.end(), 0.0f);
+    std::fill(Yim.begin(), Yim.end(), 0.0f);
+    for (size_t p = 0; p < P; ++p) {
+        size_t slot = (xHead + p) % P;
+        multiplyAccumulate(&Xre[slot * KL], &Xim[slot * KL], &Wre[p * KL], &Wim[p * KL], Yre.data(), Yim.data(), KL);
+    }
+    fft.inverse(Yre.data(), Yim.data(), frame.data());
+
+    // 5. Overlap-save output and the block's energies
+    subtract(blkMic.data(), frame.data() + ML, outBlock.data(), ML);
+    float sumE2[kL] = {}, sumY2[kL] = {}, sumRef2[kL] = {};
+    for (size_t i = 0; i < M; ++i) {
+        const float* y = &frame[ML + i * kL];
+        const float* r = &blkRef[i * kL];
+        const float* e = &outBlock[i * kL];
+        for (size_t l = 0; l < kL; ++l) {
+            sumE2[l] += e[l] * e[l];
+            sumY2[l] += y[l] * y[l];
+            sumRef2[l] += r[l] * r[l];
+        }
+    }
+    blockControl(sumY2, sumE2, sumRef2);
+
+    bool any = false;
+    for (size_t l = 0; l < kL; ++l) any = any || adapt[l] > 0.0f;
+    if (any) {
+        // 6. Error spectrum of [0, e]
+        std::fill(frame.begin(), frame.begin() + ML, 0.0f);
+        std::copy(outBlock.begin(), outBlock.end(), frame.begin() + ML);
+        fft.forward(frame.data(), Ere.data(), Eim.data());
+
+        // 7. W += mu E conj(X) / P_est; a frozen lane has a zero step (xPower is scratch)
+        float mu = atomicMu.load();
+        float* step = xPower.data();
+        for (size_t k = 0; k < bins; ++k) {
+            for (size_t l = 0; l < kL; ++l) step[k * kL + l] = mu * adapt[l] / (psd[k * kL + l] + 1e-9f);
+        }
+        for (size_t p = 0; p < P; ++p) {
+            size_t slot = (xHead + p) % P;
+            adaptPartition(&Wre[p * KL], &Wim[p * KL], &Xre[slot * KL], &Xim[slot * KL], Ere.data(), Eim.data(), step, KL);
+        }
+
+        // 8. Gradient constraint on one partition per block, adapting lanes only
+        size_t p = constraintIdx;
+        constraintIdx = (constraintIdx + 1) % P;
+        float* wr = &Wre[p * KL];
+        float* wi = &Wim[p * KL];
+        fft.inverse(wr, wi, frame.data());
+        std::fill(frame.begin() + ML, frame.end(), 0.0f);
+        fft.forward(frame.data(), Yre.data(), Yim.data());
+        for (size_t k = 0; k < bins; ++k) {
+            for (size_t l = 0; l < kL; ++l) {
+                size_t j = k * kL + l;
+                wr[j] = adapt[l] > 0.0f ? Yre[j] : wr[j];
+                wi[j] = adapt[l] > 0.0f ? Yim[j] : wi[j];
+            }
+        }
+    }
+
+    publishStats();
+}
+
+// AECProcessor::blockStats per lane: ERLE, double talk and the adaptation mask
+void AECLockstep::blockControl(const float* sumY2, const float* sumE2, const float* sumRef2) {
+    float dtdAlpha = atomicDtdAlpha.load();
+    for (size_t l = 0; l < kL; ++l) {
+        micE[l] = 0.95f * micE[l] + 0.05f * (sumY2[l] + sumE2[l]);
+        errE[l] = 0.95f * errE[l] + 0.05f * sumE2[l];
+        refE[l] = 0.95f * refE[l] + 0.05f * sumRef2[l];
+
+        float curErle = (sumY2[l] + sumE2[l]) / (sumE2[l] + 1e-9f);
+        instantErle[l] = std::max(0.0f, 10.0f * std::log10(curErle + 1e-9f));
+        totalBlocks[l]++;
+
+        if (micE[l] > dtdAlpha * refE[l] && refE[l] > 1e-5f) dtdHold[l] = kDtdHoldBlocks;
+        else if (dtdHold[l] > 0) dtdHold[l]--;
+        bool dtdActive = dtdHold[l] > 0;
+
+        if (!dtdActive && refE[l] > 1e-6f && totalBlocks[l] > 50) {
+            avgErle[l] = 0.99f * avgErle[l] + 0.01f * instantErle[l];
+            if (avgErle[l] > maxErle[l]) maxErle[l] = avgErle[l];
+            if (avgErle[l] > 10.0f && convergedTimeMs[l] == 0.0f) {
+                convergedTimeMs[l] = (float)totalBlocks[l] * (float)fdafM / (float)params.sampleRate * 1000.0f;
+            }
+        }
+        if (instantErle[l] > maxErle[l]) maxErle[l] = instantErle[l];
+
+        bool freeze = dtdActive || delayFreeze[l] > 0;
+        delayFreeze[l] = std::max(0, delayFreeze[l] - (int)fdafM);
+        adapt[l] = freeze ? 0.0f : 1.0f;
+    }
+}
+
+void AECLockstep::publishStats() {
+    uint32_t seq = statsSeq.load(std::memory_order_relaxed);
+    statsSeq.store(seq + 1, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_release);
+    float mu = atomicMu.load(std::memory_order_relaxed);
+    for (size_t l = 0; l < kL; ++l) {
+        AECStats& s = statsBuf[l];
+        s.erle = instantErle[l];
+        s.instantErle = instantErle[l];
+        s.maxErle = maxErle[l];
+        s.avgErle = avgErle[l];
+        s.convergedTimeMs = convergedTimeMs[l];
+        s.micE = micE[l];
+        s.refE = refE[l];
+        s.errE = errE[l];
+        s.freeze = adapt[l] == 0.0f;
+        s.dtd = s.freeze;
+        s.coherence = coherence[l];
+        s.currentLag = lag[l];
+        s.currentLagMs = (float)lag[l] * 1000.0f / (float)params.sampleRate;
+        s.mu = mu;
+        s.dtdFreezeActive = dtdHold[l] > 0;
+        s.delayFreezeActive = delayFreeze[l] > 0;
+        s.delayUpdateCount = delayUpdates[l];
+        s.lastDelayChangeTime = 0.0f;
+        s.warmStart = 0;
+        s.driftPpm = 0.0f;
+    }
+    statsSeq.store(seq + 2, std::memory_order_release);
+}
+
+AECStats AECLockstep::getStats(size_t lane) const {
+    AECStats s = AECStats();
+    if (lane >= kL || statsBuf.size() != kL) return s;
+    uint32_t seq;
+    do {
+        seq = statsSeq.load(std::memory_order_acquire);
+        s = statsBuf[lane];
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while (seq % 2 != 0 || seq != statsSeq.load(std::memory_order_relaxed));
+    return s;
+}
+
+AECLoadStats AECLockstep::getLoadStats() const {
+    return loadMonitor.getStats();
+}
@@ -0,0 +1,113 @@
+#pragma once
+// kLanes independent echo cancellers with the same parameters, run in lockstep: one
+// session per lane, with every state array interleaved across the lanes (element i of
+// lane l at [i * kLanes + l]). The per-sample, per-bin, FFT and delay-search loops all
+// run over the lanes as their innermost loop, which vectorizes regardless of the layout
+// and the per-session branches. It is the PBFDAF canceller of AECProcessor (block size,
+// normalization, gradient constraint, double-talk rule, lag search and confirmation);
+// per-lane decisions (double talk, freeze after a lag change, the new lag) become masks
+// and per-lane counters. The spectra keep only the N/2 + 1 bins of the real signals.
+// Not available here: time-domain, subband, variable step size, proportionate update,
+// drift compensation, post-filters, warm start and snapshots.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "AECProcessor.h"
+#include "FftUtil.h"
+#include "LoadMonitor.h"
+
+class AECLockstep {
+public:
+    static const size_t kLanes = 8; // One AVX2 register of floats per interleaved element
+
+    AECLockstep();
+    void initialize(const AECParams& p);
+    // Lane l reads mic[l] and ref[l] and writes out[l]; every lane advances by frames.
+    // A null mic (or ref) is an idle lane, fed silence, with no output. Real-time safe.
+    void process(const float* const* mic, const float* const* ref, float* const* out, size_t frames);
+    // Restart one lane's canceller for a new session; processing thread only
+    void resetLane(size_t lane);
+
+    // Output delay of process() relative to its input, in samples (as AECProcessor)
+    int getLatency() const;
+    size_t partitions() const { return numPartitions; }
+
+    // Thread-safe
+    AECStats getStats(size_t lane) const;
+    AECLoadStats getLoadStats() const;
+    void setMu(float val);
+    void setDtdAlpha(float val);
+    void setFreezeBlocks(int blocks);
+
+private:
+    AECLockstep(const AECLockstep&) = delete;
+    AECLockstep& operator=(const AECLockstep&) = delete;
+
+    void performBlock();
+    void blockControl(const float* sumY2, const float* sumE2, const float* sumRef2);
+    void updateDelay();
+    void laneLagChanged(size_t lane);
+    void publishStats();
+
+    AECParams params;
+    size_t fdafM;
+    size_t fdafN;
+    size_t bins;
+    size_t numPartitions;
+    LaneRealFft<kLanes> fft;
+
+    // Reference delay line and correlation block (shared write position)
+    std::vector<float> refRing;
+    size_t ringCap;
+    size_t ringIdx;
+    std::vector<float> micFeed;
+    size_t corrCount;
+    int maxLag;
+    std::vector<float> micPow;
+    std::vector<float> refPow;
+    std::vector<int> lag;
+    std::vector<int> lagCandidate;
+    std::vector<int> lagHits;
+    std::vector<int> delayUpdates;
+
+    // Block buffers (shared block phase)
+    std::vector<float> blkMic;
+    std::vector<float> blkRef;
+    std::vector<float> refPrev;
+    std::vector<float> micPrev;
+    size_t blkIdx;
+    std::vector<float> outBlock;
+    size_t outRead;
+    size_t outCount;
+    std::vector<float> frame;        // fdafN samples per lane
+
+    // Spectra: [partition][bin][lane]; partition p of X is slot (xHead + p) % numPartitions
+    std::vector<float> Xre, Xim;
+    std::vector<float> Wre, Wim;
+    size_t xHead;
+    std::vector<float> Dre, Dim;     // Mic spectrum
+    std::vector<float> Yre, Yim;
+    std::vector<float> Ere, Eim;
+    std::vector<float> xPower;
+    std::vector<float> psd;          // Normalization power
+    std::vector<float> psdMic, psdRef, psdCrossRe, psdCrossIm;
+    size_t constraintIdx;
+
+    // Per-lane control and measurements
+    std::vector<float> adapt;        // 1: adapt this block, 0: frozen
+    std::vector<float> micE, refE, errE;
+    std::vector<float> instantErle, avgErle, maxErle, convergedTimeMs;
+    std::vector<float> coherence;
+    std::vector<int> dtdHold;        // Blocks
+    std::vector<int> delayFreeze;    // Samples
+    std::vector<uint64_t> totalBlocks;
+
+    LoadMonitor loadMonitor;
+    std::atomic<uint32_t> statsSeq;
+    std::vector<AECStats> statsBuf;
+    std::atomic<float> atomicMu;
+    std::atomic<float> atomicDtdAlpha;
+    std::atomic<int> atomicFreezeBlocks;
+};
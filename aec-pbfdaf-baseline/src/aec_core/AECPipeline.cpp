@@ -0,0 +1,40 @@
+#include "AECPipeline.h"
+
+AECPipeline::AECPipeline() : pipelineMode(PipelineMode::AecOnly) {}
+
+void AECPipeline::initialize(const AECParams& p, PipelineMode mode) {
+    pipelineMode = mode;
+    canceller.initialize(p);
+    setupStages(p);
+}
+
+void AECPipeline::initialize(const AECParams& p, PipelineMode mode, const AECEchoPath& warmStart) {
+    pipelineMode = mode;
+    canceller.initialize(p, warmStart);
+    setupStages(p);
+}
+
+void AECPipeline::setupStages(const AECParams& p) {
+    // Fused suppression works on the PBFDAF error spectrum
+    if (pipelineMode == PipelineMode::Fused && canceller.filterMode() != AECFilterMode::Pbfdaf) {
+        pipelineMode = PipelineMode::Cascade;
+    }
+    canceller.setFusedSuppression(pipelineMode == PipelineMode::Fused);
+    if (pipelineMode == PipelineMode::Cascade) {
+        AIParams ip;
+        ip.sampleRate = p.sampleRate;
+        ip.channels = 1;
+        enhancer.initialize(ip);
+    }
+}
+
+void AECPipeline::process(const float* mic, const float* ref, float* out, size_t frames) {
+    canceller.process(mic, ref, out, frames);
+    if (pipelineMode == PipelineMode::Cascade) enhancer.process(out, frames);
+}
+
+int AECPipeline::getLatency() const {
+    int latency = canceller.getLatency();
+    if (pipelineMode == PipelineMode::Cascade) latency += enhancer.getLatency();
+    return latency;
+}
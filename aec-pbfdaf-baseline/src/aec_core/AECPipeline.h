@@ -0,0 +1,42 @@
+#pragma once
+// Echo cancellation followed by noise suppression behind one process() call.
+// Cascade runs AIEnhancer on the canceller output with its own STFT; Fused applies
+// the same gain inside the canceller to its error spectrum, saving the enhancer's
+// analysis FFT and a block of latency (a time-domain canceller has no error spectrum,
+// so Fused runs as Cascade there). Every mode has the same output contract:
+// out[i + getLatency()] corresponds to mic[i].
+
+#include <cstddef>
+#include "AECProcessor.h"
+#include "AIEnhancer.h"
+
+enum class PipelineMode {
+    AecOnly,
+    Cascade,
+    Fused
+};
+
+class AECPipeline {
+public:
+    AECPipeline();
+    void initialize(const AECParams& p, PipelineMode mode);
+    // Initialize, then start the canceller from a cached echo path
+    void initialize(const AECParams& p, PipelineMode mode, const AECEchoPath& warmStart);
+    // Real-time safe
+    void process(const float* mic, const float* ref, float* out, size_t frames);
+
+    // Output delay of process() relative to its input, in samples
+    int getLatency() const;
+    PipelineMode mode() const { return pipelineMode; }
+
+    // Stats, load, snapshots and echo-path export go through the canceller
+    AECProcessor& aec() { return canceller; }
+    const AECProcessor& aec() const { return canceller; }
+
+private:
+    void setupStages(const AECParams& p);
+
+    PipelineMode pipelineMode;
+    AECProcessor canceller;
+    AIEnhancer enhancer;
+};
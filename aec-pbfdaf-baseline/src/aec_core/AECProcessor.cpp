@@ -3,23 +3,107 @@
 #include <cmath>
 #include <algorithm>
 #include <cstring>
+#include <cstdlib>
 
 static inline float sq(float x) { return x * x; }
 
-AECProcessor::AECProcessor() : 
-    xIndex(0), xPowerSum(0.0f), 
-    delayIdx(0), currentLag(0), maxLag(0), lastLag(0),
+static const int kLagConfirmBlocks = 3;
+static const int kLagJitter = 2;
+
+// Shifts smaller than half the filterLag() margin stay inside the filter window and
+// are left to the adaptive filter instead of clearing its history.
+static inline int lagMinStep(int sampleRate) {
+    return std::max(kLagJitter, sampleRate / 2000);
+}
+
+// Warm-start probation, in far-end single-talk blocks. A path that adds echo is dropped
+// at once; otherwise the verdict waits until the lag estimator has confirmed the
+// alignment (the cached lag or a new one). A fresh filter needs seconds to reach
+// kWarmMinGainDb, so clearing it this early means the path is right.
+static const int kWarmEarlyBlocks = 8;
+static const int kWarmProbeBlocks = 32;
+static const float kWarmMaxWaitSec = 1.5f; // Judge even without a confirmed lag after this
+static const float kWarmMinGainDb = 6.0f;
+
+// Residual echo suppression (post-filter)
+static const float kResAlpha = 0.8f;      // PSD smoothing per block
+static const float kResLeak = 0.1f;       // Residual echo bound: -10 dB below the echo estimate
+static const float kResOverdrive = 2.0f;
+static const float kResFloorGain = 0.05f; // -26 dB
+
+// Drift compensation: lag estimates with a normalized correlation peak below this are
+// not precise enough for the drift fit
+static const float kDriftMinCorr = 0.3f;
+
+// Subband mode
+static const size_t kSubbandChunk = 480;     // Full-rate samples per analysis pass
+static const float kHighFloorGain = 0.03f;   // -30 dB
+static const float kHighGainSmooth = 0.005f; // Per full-rate sample (~5 ms at 48 kHz)
+
+// Variable step size: smoothing of the per-bin statistics (~10 blocks), and the
+// default upper bound, kVssMaxScale * params.mu but no more than kVssMaxMu (larger
+// steps diverge on long recordings with a filter tail longer than the model)
+static const float kVssAlpha = 0.9f;
+static const float kVssMaxScale = 4.0f;
+static const float kVssMaxMu = 0.35f;
+
+// Proportionate update: IPNLMS alpha, and the largest partition gain. The step
+// normalization lags speech onsets, so a long filter (many partitions) would otherwise
+// put several times mu on the direct-path partition and diverge.
+static const float kPropAlpha = -0.5f;
+static const float kPropMaxGain = 3.0f;
+
+// Time-domain modes
+static const size_t kDotWidth = 8;           // Partial sums per dot product; tdLen is a multiple
+static const size_t kBlockNlmsLen = 4;       // Samples per block NLMS update
+// The summed block update diverges on speech once mu * kBlockNlmsLen passes ~1
+static const float kBlockNlmsMaxStep = 1.0f;
+static const float kNlmsPowerFloor = 1e-6f;  // Per-tap regularization of the step (-60 dBFS)
+
+// The filter window starts ~1 ms ahead of the estimated echo peak. An estimate that is
+// even one sample late would otherwise push the direct path outside the (causal)
+// filter, capping ERLE at the direct-to-reverberant ratio.
+static inline int filterLag(int lag, int sampleRate) {
+    int margin = sampleRate / 1000;
+    return lag > margin ? lag - margin : 0;
+}
+
+AECParams defaultAECParams(int sampleRate) {
+    AECParams p;
+    p.sampleRate = sampleRate;
+    p.channels = 1;
+    p.filterLen = 1024;
+    p.mu = 0.1f;
+    p.epsilon = 1e-6f;
+    p.leak = 0.0001f;
+    p.maxDelayMs = 80;
+    p.corrBlock = 1024;
+    p.dtdAlpha = 2.0f;
+    p.dtdBeta = 1.5f;
+    return p;
+}
+
+AECProcessor::AECProcessor() :
+    tdRequested(AECFilterMode::Pbfdaf), tdMode(AECFilterMode::Pbfdaf), tdLen(0), tdRing(0),
+    xIndex(0), xPowerSum(0.0f), tdFill(0), tdStatsFill(0),
+    tdSumY2(0.0f), tdSumE2(0.0f), tdSumRef2(0.0f), tdSumM2(0.0f),
+    delayIdx(0), currentLag(0), maxLag(0), lastLag(0), lagCandidate(0), lagCandidateHits(0),
     instantErle(0.0f), maxErle(0.0f), avgErle(0.0f), convergedTimeMs(0.0f), lastDelayChangeTime(0.0f),
+    warmState(0), warmBlocks(0), warmWaitBlocks(0), warmMicSum(0.0f), warmErrSum(0.0f),
     blockSize(0), blockCount(0), micPowerSum(0.0f), refPowerSum(0.0f),
     errPowerSum(0.0f), yPowerSum(0.0f), freeze(false), 
-    muDynamic(0.0f), muMin(0.0f), muMax(0.0f), iirAlpha(0.0f), 
+    muDynamic(0.0f), iirAlpha(0.0f), 
     micE(0.0f), refE(0.0f), errE(0.0f), 
     freezeBlocks(0), dtdFreezeSamples(0), delayFreezeSamples(0), delayUpdateCounter(0), totalBlocks(0),
     fdafM(0), fdafN(0), numPartitions(0), constraintIdx(0), fdafBufIdx(0), 
     outFifoRead(0), outFifoWrite(0), outFifoCount(0),
-    coherence(0.0f), farEndEnergy(0.0f)
+    coherence(0.0f), farEndEnergy(0.0f), fusedNs(false), resEnabled(false),
+    vssEnabled(false), driftEnabled(false), driftRate(0.0), lagDrift(0.0), streamPos(0.0),
+    subbandRequested(false), subbandFactor(1), sbHighIdx(0), sbHighGain(1.0f)
 {
+    kernels = &genericFdafKernels();
     statsSeq.store(0);
+    statsBuf = AECStats();
     // Initialize atomic parameters with defaults
     atomicMu.store(0.05f);
     atomicMuMin.store(0.01f);
@@ -31,6 +115,24 @@ AECProcessor::AECProcessor() :
 
 void AECProcessor::initialize(const AECParams& p) {
     params = p;
+    subbandFactor = subbandRequested && SubbandFilter::supported(p.sampleRate)
+                        ? p.sampleRate / SubbandFilter::kLowRate : 1;
+    if (subbandFactor > 1) {
+        // The canceller sees the low band only: same tail and correlation span in ms
+        params.sampleRate = SubbandFilter::kLowRate;
+        params.filterLen = (p.filterLen + subbandFactor - 1) / subbandFactor;
+        params.corrBlock = std::max(1, p.corrBlock / subbandFactor);
+        subband.initialize(p.sampleRate);
+        size_t lowMax = kSubbandChunk / subbandFactor + 1;
+        sbLowMic.assign(lowMax, 0.0f);
+        sbLowRef.assign(lowMax, 0.0f);
+        sbLowErr.assign(lowMax, 0.0f);
+        sbHigh.assign(kSubbandChunk, 0.0f);
+        // Longest canceller latency (with a post-filter) in full-rate samples, plus one
+        sbHighDelay.assign((size_t)subbandFactor * 512 + 1, 0.0f);
+        sbHighIdx = 0;
+        sbHighGain = 1.0f;
+    }
     
     // --- Common Setup ---
     maxLag = (int)(params.maxDelayMs * params.sampleRate / 1000);
@@ -40,12 +142,23 @@ void AECProcessor::initialize(const AECParams& p) {
     delayIdx = 0;
     currentLag = 0;
     lastLag = 0;
+    lagCandidate = 0;
+    lagCandidateHits = 0;
     
-    // --- Time Domain Setup (Legacy) ---
-    w.assign(params.filterLen, 0.0f);
-    x.assign(params.filterLen, 0.0f);
+    // --- Time Domain Setup ---
+    tdMode = tdRequested;
+    tdLen = ((size_t)std::max(1, params.filterLen) + kDotWidth - 1) / kDotWidth * kDotWidth;
+    // The windows of every sample in an update block must still be in the line
+    tdRing = tdLen + (tdMode == AECFilterMode::BlockNlms ? kBlockNlmsLen : 1);
+    w.assign(tdLen, 0.0f);
+    x.assign(2 * tdRing, 0.0f);
     xIndex = 0;
     xPowerSum = 0.0f;
+    tdStep.assign(kBlockNlmsLen, 0.0f);
+    tdFill = 0;
+    tdStatsFill = 0;
+    tdSumY2 = 0.0f; tdSumE2 = 0.0f; tdSumRef2 = 0.0f; tdSumM2 = 0.0f;
+    tdWarm.clear();
     
     // --- Frequency Domain Setup (PBFDAF) ---
     fdafM = 256; // Block size
@@ -62,8 +175,17 @@ void AECProcessor::initialize(const AECParams& p) {
     fdafBufIdx = 0;
     
     // Resize State
-    X_freq.assign(numPartitions, std::vector<std::complex<float>>(fdafN, {0.0f, 0.0f}));
-    W_freq.assign(numPartitions, std::vector<std::complex<float>>(fdafN, {0.0f, 0.0f}));
+    X_freq.init(numPartitions, fdafN, params.historyPrecision);
+    W_freq.init(numPartitions, fdafN, params.weightPrecision);
+    if (params.historyPrecision != SpectrumPrecision::Float32) xNewest.assign(fdafN, {0.0f, 0.0f});
+    else std::vector<std::complex<float>>().swap(xNewest);
+    propGain.assign(numPartitions, 1.0f);
+    kernels = &selectFdafKernels(fdafN, numPartitions, params.historyPrecision, params.weightPrecision);
+    xParts.assign(numPartitions, nullptr);
+    wParts.assign(numPartitions, nullptr);
+    xPower.assign(fdafN, 0.0f);
+    adaptDen.assign(fdafN, 0.0f);
+    adaptStep.assign(fdafN, 0.0f);
     E_freq.assign(fdafN, {0.0f, 0.0f});
     Y_freq.assign(fdafN, {0.0f, 0.0f});
     fftScratch.resize(fdafN);
@@ -87,9 +209,10 @@ void AECProcessor::initialize(const AECParams& p) {
     micPowerSum = 0.0f; refPowerSum = 0.0f; errPowerSum = 0.0f; yPowerSum = 0.0f;
     freeze = false;
     
+    // Variable step size range; setMuRange after initialize overrides it
     muDynamic = params.mu;
-    muMin = params.mu * 0.1f;
-    muMax = params.mu * 1.0f;
+    atomicMuMin.store(params.mu);
+    atomicMuMax.store(std::max(params.mu, std::min(kVssMaxMu, params.mu * kVssMaxScale)));
     
     iirAlpha = 0.95f; // For DTD energy smoothing
     micE = 0.0f; refE = 0.0f; errE = 0.0f;
@@ -109,55 +232,100 @@ void AECProcessor::initialize(const AECParams& p) {
     atomicDtdBeta.store(params.dtdBeta);
     
     micPrev.assign(fdafM, 0.0f);
+    refPrev.assign(fdafM, 0.0f);
+    resetPostFilter();
+    vssCross.assign(fdafN, {0.0f, 0.0f});
+    vssErrPsd.assign(fdafN, 0.0f);
+    vssRefPsd.assign(fdafN, 0.0f);
+    vssMu.assign(fdafN, params.mu);
+    drift.reset(params.sampleRate);
+    driftRate = 0.0;
+    lagDrift = 0.0;
+    streamPos = 0.0;
     avgErle = 0.0f;
     totalBlocks = 0;
+    warmState = 0;
+    warmBlocks = 0;
+    warmWaitBlocks = 0;
+    warmMicSum = 0.0f;
+    warmErrSum = 0.0f;
+
+    loadMonitor.reset(params.sampleRate * subbandFactor);
 }
 
 void AECProcessor::setMu(float val) { atomicMu.store(val); }
 void AECProcessor::setMuRange(float min, float max) { atomicMuMin.store(min); atomicMuMax.store(max); }
 void AECProcessor::setDtdParams(float alpha, float beta) { atomicDtdAlpha.store(alpha); atomicDtdBeta.store(beta); }
 void AECProcessor::setFreezeBlocks(int blocks) { atomicFreezeBlocks.store(blocks); }
+void AECProcessor::setDeadlineBudgetUs(float us) { loadMonitor.setBudgetUs(us); }
 
-// Cyclic dot product helper for time-domain
-static inline float dot_cyclic(const std::vector<float>& w, const std::vector<float>& x, size_t head) {
-    size_t n = w.size();
-    float sum = 0.0f;
-    // Split loop: head -> 0, n-1 -> head+1
-    // x is filled backwards? No, typically x is circular buffer.
-    // If x[head] is newest. x[head-1] is older.
-    // w[0] corresponds to newest x.
-    
-    // Part 1: i from 0 to head
-    // w[i] * x[head - i]
-    for (size_t i = 0; i <= head; ++i) {
-        sum += w[i] * x[head - i];
-    }
-    // Part 2: i from head+1 to n-1
-    // w[i] * x[n + head - i]
-    for (size_t i = head + 1; i < n; ++i) {
-        sum += w[i] * x[n + head - i];
+void AECProcessor::setFilterMode(AECFilterMode mode) { tdRequested = mode; }
+void AECProcessor::setVariableStepSize(bool on) { vssEnabled = on; }
+
+// n is a multiple of kDotWidth. Independent partial sums: a single running sum is a
+// serial dependency the compiler may not reorder, so it would not vectorize.
+static inline float dotProduct(const float* a, const float* b, size_t n) {
+    float acc[kDotWidth] = {};
+    for (size_t i = 0; i < n; i += kDotWidth) {
+        for (size_t k = 0; k < kDotWidth; ++k) acc[k] += a[i + k] * b[i + k];
     }
+    float sum = 0.0f;
+    for (size_t k = 0; k < kDotWidth; ++k) sum += acc[k];
     return sum;
 }
 
+static inline void axpy(float* y, const float* x, float a, size_t n) {
+    for (size_t i = 0; i < n; ++i) y[i] += a * x[i];
+}
+
 void AECProcessor::process(const float* mic, const float* ref, float* out, size_t frames) {
-    // Dispatch to PBFDAF implementation as the primary baseline
-    processFrequencyDomain(mic, ref, out, frames);
+    LoadMonitor::Scope load(loadMonitor, frames);
+    if (subbandFactor > 1) {
+        processSubband(mic, ref, out, frames);
+        return;
+    }
+    processCanceller(mic, ref, out, frames);
 }
 
-void AECProcessor::processFrequencyDomain(const float* mic, const float* ref, float* out, size_t frames) {
-    // Load atomic parameters once per block
-    float curMu = atomicMu.load(std::memory_order_relaxed);
-    float curDtdAlpha = atomicDtdAlpha.load(std::memory_order_relaxed);
-    
-    // Delay Estimation Logic (Shared with Time Domain)
-    // We update delay estimation continuously using raw streams
-    
+void AECProcessor::processCanceller(const float* mic, const float* ref, float* out, size_t frames) {
+    // PBFDAF is the primary baseline
+    if (tdMode == AECFilterMode::Pbfdaf) processFrequencyDomain(mic, ref, out, frames);
+    else processTimeDomain(mic, ref, out, frames);
+}
+
+void AECProcessor::processSubband(const float* mic, const float* ref, float* out, size_t frames) {
+    size_t cap = sbHighDelay.size();
+    size_t highLag = (size_t)subbandFactor * (size_t)coreLatency();
+    for (size_t done = 0; done < frames;) {
+        size_t n = std::min(kSubbandChunk, frames - done);
+        size_t nLow = subband.analyze(mic + done, ref + done, n, sbLowMic.data(), sbLowRef.data(), sbHigh.data());
+        processCanceller(sbLowMic.data(), sbLowRef.data(), sbLowErr.data(), nLow);
+        subband.synthesize(sbLowErr.data(), out + done, n);
+
+        // Upper band: attenuated by as much as the canceller removes from the low band
+        // (instantErle is ~0 dB without far-end echo and during double talk)
+        float target = std::pow(10.0f, -instantErle / 20.0f);
+        target = std::max(target, kHighFloorGain);
+        for (size_t i = 0; i < n; ++i) {
+            sbHighDelay[sbHighIdx] = sbHigh[i];
+            float high = sbHighDelay[(sbHighIdx + cap - highLag) % cap];
+            sbHighIdx = (sbHighIdx + 1) % cap;
+            sbHighGain += kHighGainSmooth * (target - sbHighGain);
+            out[done + i] += sbHighGain * high;
+        }
+        done += n;
+    }
+}
+
+// Delay estimation, shared by all filter modes. We update it continuously using the
+// raw streams; afterwards refDelay holds this call's reference up to delayIdx.
+void AECProcessor::trackDelay(const float* mic, const float* ref, size_t frames) {
     // Update Ring Buffers for Delay Estimation
     size_t cap = refDelay.size();
     for (size_t i = 0; i < frames; ++i) {
         // Feed delay line
         refDelay[delayIdx] = ref[i];
+        streamPos += 1.0;
         
         // Feed correlation buffers
         if (blockCount < blockSize) {
@@ -184,13 +352,34 @@ void AECProcessor::processFrequencyDomain(const float* mic, const float* ref, fl
                 // Delay changed
                 delayFreezeSamples = atomicFreezeBlocks.load() * fdafM; // Roughly convert blocks to samples
                 lastLag = currentLag;
+                lagDrift = 0.0;
                 delayUpdateCounter++;
-                // In Frequency Domain, changing delay means resetting X_freq history or realigning
+                // Changing delay means resetting the reference history or realigning.
                 // For simplicity, we just clear history to avoid glitches
-                for(auto& v : X_freq) std::fill(v.begin(), v.end(), std::complex<float>(0,0));
-                std::fill(fdafRefBuf.begin(), fdafRefBuf.end(), 0.0f);
-                std::fill(fdafMicBuf.begin(), fdafMicBuf.end(), 0.0f);
-                fdafBufIdx = 0;
+                if (tdMode == AECFilterMode::Pbfdaf) {
+                    X_freq.clear();
+                    std::fill(xNewest.begin(), xNewest.end(), std::complex<float>(0,0));
+                    std::fill(fdafRefBuf.begin(), fdafRefBuf.end(), 0.0f);
+                    std::fill(fdafMicBuf.begin(), fdafMicBuf.end(), 0.0f);
+                    std::fill(refPrev.begin(), refPrev.end(), 0.0f);
+                    fdafBufIdx = 0;
+                } else {
+                    std::fill(x.begin(), x.end(), 0.0f);
+                    xPowerSum = 0.0f;
+                    tdFill = 0;
+                }
+                // A warm-start path is lag-relative, so the imported filter is put back
+                // (adaptation at the wrong alignment has smeared it) and probation restarts
+                if (warmState == 1) {
+                    if (tdMode == AECFilterMode::Pbfdaf) {
+                        for (size_t p = 0; p < W_freq.size(); ++p) W_freq.write(p, W_warm[p].data());
+                    } else {
+                        std::copy(tdWarm.begin(), tdWarm.end(), w.begin());
+                    }
+                    warmBlocks = 0;
+                    warmMicSum = 0.0f;
+                    warmErrSum = 0.0f;
+                }
                 // Reset Output FIFO to avoid stale data? No, keep it flowing to avoid clicks.
             }
             
@@ -198,22 +387,41 @@ void AECProcessor::processFrequencyDomain(const float* mic, const float* ref, fl
             micPowerSum = 0.0f; refPowerSum = 0.0f;
         }
     }
+}
+
+// Reference for sample i of the call, at the current (drift-following) lag
+float AECProcessor::delayedRef(size_t i, size_t frames) {
+    // Calculate read index based on current estimated lag
+    size_t cap = refDelay.size();
+    int writePos = (int)delayIdx - (int)frames + (int)i;
+    while(writePos < 0) writePos += cap;
+    while(writePos >= (int)cap) writePos -= cap;
+
+    if (driftEnabled) advanceDrift();
+    int fLag = filterLag(currentLag, params.sampleRate);
+    int readPos = writePos - fLag;
+    while(readPos < 0) readPos += cap;
+    while(readPos >= (int)cap) readPos -= cap;
+
+    float rdel = refDelay[readPos];
+    // Fractional read needs kHalfTaps samples after the read position
+    if (driftEnabled && fLag > FractionalDelay::kHalfTaps) {
+        double pos = (double)readPos - lagDrift;
+        if (pos < 0.0) pos += (double)cap;
+        rdel = fracDelay.read(refDelay.data(), cap, pos);
+    }
+    return rdel;
+}
+
+void AECProcessor::processFrequencyDomain(const float* mic, const float* ref, float* out, size_t frames) {
+    trackDelay(mic, ref, frames);
 
     // Main Processing Loop
     size_t fifoCap = outputFifo.size();
     
     for (size_t i = 0; i < frames; ++i) {
         // 1. Get Delayed Reference
-        // Calculate read index based on current estimated lag
-        int writePos = (int)delayIdx - (int)frames + (int)i;
-        while(writePos < 0) writePos += cap;
-        while(writePos >= (int)cap) writePos -= cap;
-        
-        int readPos = writePos - currentLag;
-        while(readPos < 0) readPos += cap;
-        while(readPos >= (int)cap) readPos -= cap;
-        
-        float rdel = refDelay[readPos];
+        float rdel = delayedRef(i, frames);
         float mval = mic[i];
         
         // 2. Accumulate into Block Buffer
@@ -250,55 +458,57 @@ void AECProcessor::processFrequencyDomain(const float* mic, const float* ref, fl
 
 void AECProcessor::performBlockFdaf() {
     // 1. Shift History X_freq
-    if (numPartitions > 0) {
-        std::rotate(X_freq.rbegin(), X_freq.rbegin() + 1, X_freq.rend());
-    }
+    X_freq.rotate();
 
-    // 2. FFT of Reference Input
-    std::fill(fftScratch.begin(), fftScratch.end(), std::complex<float>(0,0));
+    // 2. FFT of Reference Input (overlap-save frame: previous block + current block)
     for(size_t i=0; i<fdafM; ++i) {
-        fftScratch[i] = { x[i], 0.0f }; // Old Ref
-        // This 'x' usage is confusing because 'x' is time-domain ring buffer for legacy.
-        // In PBFDAF, we should use 'fdafRefBuf'.
-        // But 'x' is not updated in processFrequencyDomain properly for this purpose unless we share logic.
-        // Actually, 'fdafRefBuf' holds the CURRENT block.
-        // Correct implementation would take fdafRefBuf.
-        fftScratch[i] = { fdafRefBuf[i], 0.0f }; 
+        fftScratch[i] = { refPrev[i], 0.0f };
+        fftScratch[fdafM + i] = { fdafRefBuf[i], 0.0f };
     }
     FftUtil::fft(fftScratch);
+    std::copy(fdafRefBuf.begin(), fdafRefBuf.end(), refPrev.begin());
     
-    // Store in X_freq[0]
-    for(size_t k=0; k<fdafN; ++k) X_freq[0][k] = fftScratch[k];
+    // Store in X_freq[0] (the statistics below read it at full precision)
+    X_freq.write(0, fftScratch.data());
+    if (!xNewest.empty()) std::copy(fftScratch.begin(), fftScratch.end(), xNewest.begin());
+    const std::complex<float>* x0 = newestRef();
     
     // 3. Filter Calculation (Convolution in Freq Domain)
     // Y = sum(X[p] * W[p])
     // But first, update Power Spectral Density for normalization (MDF/FDAF)
     
+    for (size_t p = 0; p < numPartitions; ++p) {
+        xParts[p] = X_freq.data(p);
+        wParts[p] = W_freq.data(p);
+    }
+    kernels->partitionPower(xParts.data(), xPower.data(), fdafN, numPartitions);
+
     // Coherence Calc (Simplified)
     // Calculate P_mic, P_ref, P_cross
     float cohSum = 0.0f;
     float alpha = 0.95f; // Smoothing
     
     // Mic FFT for coherence
-    std::fill(fftScratch.begin(), fftScratch.end(), std::complex<float>(0,0));
-    for(size_t i=0; i<fdafM; ++i) fftScratch[i] = { fdafMicBuf[i], 0.0f };
+    for(size_t i=0; i<fdafM; ++i) {
+        fftScratch[i] = { micPrev[i], 0.0f };
+        fftScratch[fdafM + i] = { fdafMicBuf[i], 0.0f };
+    }
     FftUtil::fft(fftScratch);
+    std::copy(fdafMicBuf.begin(), fdafMicBuf.end(), micPrev.begin());
+    if (resEnabled) std::copy(fftScratch.begin(), fftScratch.begin() + D_freq.size(), D_freq.begin());
     
     for(size_t k=0; k<fdafN; ++k) {
         float magMic2 = std::norm(fftScratch[k]);
-        float magRef2 = std::norm(X_freq[0][k]);
+        float magRef2 = std::norm(x0[k]);
         
         psd_mic[k] = alpha * psd_mic[k] + (1.0f - alpha) * magMic2;
         psd_ref[k] = alpha * psd_ref[k] + (1.0f - alpha) * magRef2;
         
-        std::complex<float> cross = fftScratch[k] * std::conj(X_freq[0][k]);
+        std::complex<float> cross = fftScratch[k] * std::conj(x0[k]);
         psd_cross[k] = alpha * psd_cross[k] + (1.0f - alpha) * cross;
         
         // Normalization power (P_est)
-        float magX2 = 0.0f;
-        for(size_t p=0; p<numPartitions; ++p) magX2 += std::norm(X_freq[p][k]);
-        
-        powerSpectralDensity[k] = alpha * powerSpectralDensity[k] + (1.0f - alpha) * magX2;
+        powerSpectralDensity[k] = alpha * powerSpectralDensity[k] + (1.0f - alpha) * xPower[k];
 
         // Coherence for this bin
         float num = std::norm(psd_cross[k]); // |P_xd|^2
@@ -308,12 +518,7 @@ void AECProcessor::performBlockFdaf() {
     coherence = cohSum / (float)fdafN;
 
     // 5. Convolution (Filter)
-    std::fill(Y_freq.begin(), Y_freq.end(), std::complex<float>(0,0));
-    for(size_t p=0; p<numPartitions; ++p) {
-        for(size_t k=0; k<fdafN; ++k) {
-            Y_freq[k] += X_freq[p][k] * W_freq[p][k];
-        }
-    }
+    kernels->convolve(xParts.data(), wParts.data(), Y_freq.data(), fdafN, numPartitions);
     
     // 6. IFFT to get linear output
     for(size_t k=0; k<fdafN; ++k) fftScratch[k] = Y_freq[k];
@@ -323,6 +528,7 @@ void AECProcessor::performBlockFdaf() {
     float sumE2 = 0.0f;
     float sumY2 = 0.0f;
     float sumRef2 = 0.0f;
+    float sumM2 = 0.0f;
     
     for(size_t i=0; i<fdafM; ++i) {
         float y_val = fftScratch[fdafM + i].real();
@@ -334,8 +540,80 @@ void AECProcessor::performBlockFdaf() {
         sumE2 += sq(e_val);
         sumY2 += sq(y_val); 
         sumRef2 += sq(fdafRefBuf[i]); 
+        sumM2 += sq(m_val);
     }
+    blockStats(sumY2, sumE2, sumRef2, sumM2);
     
+    // Error spectrum: needed for adaptation, and every block by the post-filter
+    bool postFilter = fusedNs || resEnabled;
+    if (!freeze || postFilter) {
+        std::fill(fftScratch.begin(), fftScratch.end(), std::complex<float>(0,0));
+        for(size_t i=0; i<fdafM; ++i) {
+            fftScratch[fdafM + i] = { olaBuffer[i], 0.0f }; // Pad with zeros at front? 
+            // Overlap-save update: [0, e] -> FFT -> ...
+        }
+        FftUtil::fft(fftScratch);
+        for(size_t k=0; k<fdafN; ++k) E_freq[k] = fftScratch[k];
+    }
+
+    if (!freeze) {
+        float mu = atomicMu.load();
+        
+        // Update weights (PBFDAF update rule: W += mu * E * conj(X) / P_est)
+        if (params.proportionate) updatePartitionGains();
+        for(size_t k=0; k<fdafN; ++k) adaptDen[k] = powerSpectralDensity[k] + 1e-9f;
+        if (vssEnabled) {
+            updateStepSizes();
+            // With the partition gains on top, the step stays within the range bound
+            float cap = params.proportionate ? atomicMuMax.load(std::memory_order_relaxed) : INFINITY;
+            for(size_t p=0; p<numPartitions; ++p) {
+                float g = params.proportionate ? propGain[p] : 1.0f;
+                for(size_t k=0; k<fdafN; ++k) adaptStep[k] = std::min(cap, vssMu[k] * g);
+                kernels->adapt(W_freq.data(p), X_freq.data(p), E_freq.data(), adaptDen.data(),
+                               adaptStep.data(), 0.0f, fdafN);
+            }
+        } else {
+            for(size_t p=0; p<numPartitions; ++p) {
+                float step = params.proportionate ? mu * propGain[p] : mu;
+                kernels->adapt(W_freq.data(p), X_freq.data(p), E_freq.data(), adaptDen.data(),
+                               nullptr, step, fdafN);
+            }
+        }
+        
+        // Gradient Constraint (Linear Convolution Constraint)
+        // Enforce that the time-domain impulse response of the adaptive filter has zero padding.
+        // This is critical for PBFDAF correctness (avoids circular convolution artifacts).
+        // Optimization: Apply to one partition per block (Round-Robin) to save CPU.
+        if (numPartitions > 0) {
+            size_t p = constraintIdx;
+            constraintIdx = (constraintIdx + 1) % numPartitions;
+
+            // 1. Transform W_freq[p] to time domain
+            W_freq.read(p, fftScratch.data());
+            FftUtil::ifft(fftScratch);
+            
+            // 2. Zero out the second half (enforce causality/linear convolution)
+            // Ideally we should also zero out the first few samples if there is a system delay,
+            // but just zeroing the tail (circular wrap-around part) is the main requirement.
+            for(size_t i=fdafM; i<fdafN; ++i) {
+                fftScratch[i] = {0.0f, 0.0f};
+            }
+            
+            // 3. Transform back to frequency domain
+            FftUtil::fft(fftScratch);
+            W_freq.write(p, fftScratch.data());
+        }
+    }
+    
+    // The stats above describe the canceller; the post-filter only changes the output
+    if (postFilter) postFilterBlock();
+
+    publishStats();
+}
+
+// Per-block ERLE, double-talk and warm-start bookkeeping from the block's energies;
+// sets freeze for the block's adaptation. Shared by all filter modes.
+void AECProcessor::blockStats(float sumY2, float sumE2, float sumRef2, float sumM2) {
     // Stats Update
     micE = 0.95f * micE + 0.05f * (sumY2 + sumE2); 
     errE = 0.95f * errE + 0.05f * sumE2;
@@ -375,57 +653,44 @@ void AECProcessor::performBlockFdaf() {
     }
     
     if (instantErle > maxErle) maxErle = instantErle;
-    
-    freeze = dtdActive || (delayFreezeSamples > 0);
-    if (delayFreezeSamples > 0) delayFreezeSamples--;
-    
-    if (!freeze) {
-        float mu = atomicMu.load();
-        
-        // Transform error to frequency domain
-        std::fill(fftScratch.begin(), fftScratch.end(), std::complex<float>(0,0));
-        for(size_t i=0; i<fdafM; ++i) {
-            fftScratch[fdafM + i] = { olaBuffer[i], 0.0f }; // Pad with zeros at front? 
-            // Overlap-save update: [0, e] -> FFT -> ...
-        }
-        FftUtil::fft(fftScratch);
-        for(size_t k=0; k<fdafN; ++k) E_freq[k] = fftScratch[k];
-        
-        // Update weights
-        for(size_t p=0; p<numPartitions; ++p) {
-            for(size_t k=0; k<fdafN; ++k) {
-                // PBFDAF Update Rule
-                std::complex<float> num = fftScratch[k] * std::conj(X_freq[p][k]);
-                float den = powerSpectralDensity[k] + 1e-9f;
-                W_freq[p][k] += mu * num / den;
-            }
-        }
-        
-        // Gradient Constraint (Linear Convolution Constraint)
-        // Enforce that the time-domain impulse response of the adaptive filter has zero padding.
-        // This is critical for PBFDAF correctness (avoids circular convolution artifacts).
-        // Optimization: Apply to one partition per block (Round-Robin) to save CPU.
-        if (numPartitions > 0) {
-            size_t p = constraintIdx;
-            constraintIdx = (constraintIdx + 1) % numPartitions;
 
-            // 1. Transform W_freq[p] to time domain
-            for(size_t k=0; k<fdafN; ++k) fftScratch[k] = W_freq[p][k];
-            FftUtil::ifft(fftScratch);
-            
-            // 2. Zero out the second half (enforce causality/linear convolution)
-            // Ideally we should also zero out the first few samples if there is a system delay,
-            // but just zeroing the tail (circular wrap-around part) is the main requirement.
-            for(size_t i=fdafM; i<fdafN; ++i) {
-                fftScratch[i] = {0.0f, 0.0f};
+    // Warm-start probation: the imported path must cancel far-end echo on its own
+    bool lagConfirmed = lagCandidateHits >= kLagConfirmBlocks &&
+                        std::abs(lagCandidate - currentLag) < lagMinStep(params.sampleRate);
+    int maxWaitBlocks = (int)(kWarmMaxWaitSec * (float)params.sampleRate / (float)fdafM);
+    if (warmState == 1 && warmWaitBlocks < maxWaitBlocks) warmWaitBlocks++;
+    if (warmState == 1 && !dtdActive && refE > 1e-6f) {
+        bool judge = lagConfirmed || warmWaitBlocks >= maxWaitBlocks;
+        warmMicSum += sumM2;
+        warmErrSum += sumE2;
+        warmBlocks++;
+        float gainDb = 10.0f * std::log10((warmMicSum + 1e-9f) / (warmErrSum + 1e-9f));
+        if ((warmBlocks >= kWarmEarlyBlocks && gainDb < 0.0f) ||
+            (judge && warmBlocks >= kWarmProbeBlocks && gainDb < kWarmMinGainDb)) {
+            // Stale path: continue like a cold start. An unconfirmed cached lag goes too; the
+            // estimator may not move off it while the filter still fits part of the echo.
+            clearFilter();
+            if (!lagConfirmed) {
+                currentLag = 0;
+                lagCandidate = 0;
+                lagCandidateHits = 0;
+            }
+            warmState = -1;
+        } else if (judge && warmBlocks >= kWarmProbeBlocks) {
+            warmState = 2;
+            if (gainDb > avgErle) avgErle = gainDb;
+            if (avgErle > 10.0f && convergedTimeMs == 0.0f) {
+                convergedTimeMs = (float)totalBlocks * (float)fdafM / (float)params.sampleRate * 1000.0f;
             }
-            
-            // 3. Transform back to frequency domain
-            FftUtil::fft(fftScratch);
-            for(size_t k=0; k<fdafN; ++k) W_freq[p][k] = fftScratch[k];
         }
     }
     
+    freeze = dtdActive || (delayFreezeSamples > 0);
+    if (delayFreezeSamples > 0) delayFreezeSamples -= fdafM;
+    if (delayFreezeSamples < 0) delayFreezeSamples = 0;
+}
+
+void AECProcessor::publishStats() {
     // Update thread-safe stats
     uint32_t seq = statsSeq.load(std::memory_order_relaxed);
     statsSeq.store(seq + 1, std::memory_order_release);
@@ -441,11 +706,71 @@ void AECProcessor::performBlockFdaf() {
     statsBuf.coherence = coherence; // Add this to stats struct if possible?
     statsBuf.currentLag = currentLag;
     statsBuf.currentLagMs = (float)currentLag * 1000.0f / (float)params.sampleRate;
-    statsBuf.mu = atomicMu.load();
+    statsBuf.mu = vssEnabled ? muDynamic : atomicMu.load();
+    statsBuf.freeze = freeze;
+    statsBuf.dtdFreezeActive = dtdFreezeSamples > 0;
+    statsBuf.delayFreezeActive = delayFreezeSamples > 0;
+    statsBuf.delayUpdateCount = delayUpdateCounter;
+    statsBuf.warmStart = warmState;
+    statsBuf.driftPpm = (float)(driftRate * 1e6);
     
     statsSeq.store(seq + 2, std::memory_order_release);
 }
 
+// MDF-IPNLMS: g_p = (1 - a)/2 + (1 + a) * P * |W_p| / (2 * sum |W|), mean 1 over the
+// partitions. a = -1 is the uniform update, a -> 1 fully proportionate; the uniform
+// share keeps partitions that are still near zero adapting.
+void AECProcessor::updatePartitionGains() {
+    float total = 0.0f;
+    for (size_t p = 0; p < numPartitions; ++p) {
+        // Complex arrays are laid out as (re, im) float pairs; fftScratch is free here
+        const float* v = reinterpret_cast<const float*>(W_freq.view(p, fftScratch.data()));
+        propGain[p] = std::sqrt(dotProduct(v, v, 2 * (size_t)fdafN));
+        total += propGain[p];
+    }
+    if (total <= 1e-9f) {
+        std::fill(propGain.begin(), propGain.end(), 1.0f);
+        return;
+    }
+    float uniform = 0.5f * (1.0f - kPropAlpha);
+    float scale = 0.5f * (1.0f + kPropAlpha) * (float)numPartitions / total;
+    for (size_t p = 0; p < numPartitions; ++p) propGain[p] = std::min(kPropMaxGain, uniform + scale * propGain[p]);
+}
+
+void AECProcessor::updateStepSizes() {
+    float lo = atomicMuMin.load(std::memory_order_relaxed);
+    float hi = std::max(lo, atomicMuMax.load(std::memory_order_relaxed));
+    float sum = 0.0f;
+    const std::complex<float>* x0 = newestRef();
+    for (size_t k = 0; k < (size_t)fdafN; ++k) {
+        vssCross[k] = kVssAlpha * vssCross[k] + (1.0f - kVssAlpha) * (E_freq[k] * std::conj(x0[k]));
+        vssErrPsd[k] = kVssAlpha * vssErrPsd[k] + (1.0f - kVssAlpha) * std::norm(E_freq[k]);
+        vssRefPsd[k] = kVssAlpha * vssRefPsd[k] + (1.0f - kVssAlpha) * std::norm(x0[k]);
+        // Share of the error that is still linear echo of the reference: near 1 at call
+        // start and after a path change, small once converged or under near-end speech/noise
+        float coh = std::min(1.0f, std::norm(vssCross[k]) / (vssErrPsd[k] * vssRefPsd[k] + 1e-12f));
+        vssMu[k] = lo + (hi - lo) * coh;
+        sum += vssMu[k];
+    }
+    muDynamic = sum / (float)fdafN;
+}
+
+// Moves the read lag along the fitted drift; whole samples go into currentLag without
+// the realignment a lag change normally triggers, since the read position is continuous
+void AECProcessor::advanceDrift() {
+    lagDrift += driftRate;
+    if (lagDrift >= 0.5 && currentLag < maxLag) {
+        currentLag++;
+        lagDrift -= 1.0;
+    } else if (lagDrift <= -0.5 && currentLag > 0) {
+        currentLag--;
+        lagDrift += 1.0;
+    } else {
+        return;
+    }
+    lastLag = currentLag;
+}
+
 void AECProcessor::updateDelay() {
     if (maxLag <= 0) return;
     size_t cap = refDelay.size();
@@ -471,6 +796,7 @@ void AECProcessor::updateDelay() {
     int start = bestLag - 4; if (start < 0) start = 0;
     int end = bestLag + 4; if (end > maxLag) end = maxLag;
     maxCorr = 0.0f;
+    float fineCorr[9] = {};
     
     for (int lag = start; lag <= end; ++lag) {
         float corr = 0.0f;
@@ -480,149 +806,123 @@ void AECProcessor::updateDelay() {
              while (rIdx >= (int)cap) rIdx -= cap;
              corr += micDelay[i] * refDelay[rIdx];
         }
+        fineCorr[lag - start] = corr;
         if (std::abs(corr) > maxCorr) {
             maxCorr = std::abs(corr);
             bestLag = lag;
         }
     }
+
+    // Sub-sample peak (parabola through the neighbours) for the drift fit
+    int peak = bestLag - start;
+    if (driftEnabled && bestLag > start && bestLag < end) {
+        float refE = 0.0f;
+        for (int i = 0; i < blockSize; ++i) {
+            int rIdx = (int)delayIdx - (int)blockSize + i - bestLag;
+            while (rIdx < 0) rIdx += cap;
+            refE += sq(refDelay[rIdx]);
+        }
+        float sign = fineCorr[peak] < 0.0f ? -1.0f : 1.0f;
+        float c0 = sign * fineCorr[peak - 1], c1 = sign * fineCorr[peak], c2 = sign * fineCorr[peak + 1];
+        float den = c0 - 2.0f * c1 + c2;
+        if (maxCorr > kDriftMinCorr * std::sqrt(micPowerSum * refE) && den < 0.0f) {
+            double frac = 0.5 * (double)(c0 - c2) / (double)den;
+            drift.addObservation(streamPos - 0.5 * blockSize, (double)bestLag + frac);
+            driftRate = drift.slope();
+        }
+    }
     
-    currentLag = bestLag;
+    // Confirmation: a new lag must win kLagConfirmBlocks estimates in a row (within
+    // +-kLagJitter) before it replaces currentLag. Single-block outliers at speech
+    // onsets and +-1 sample jitter would otherwise clear the filter history.
+    if (std::abs(bestLag - lagCandidate) <= kLagJitter) {
+        lagCandidateHits++;
+    } else {
+        lagCandidate = bestLag;
+        lagCandidateHits = 1;
+    }
+    if (lagCandidateHits >= kLagConfirmBlocks && std::abs(lagCandidate - currentLag) >= lagMinStep(params.sampleRate)) {
+        currentLag = lagCandidate;
+    }
 }
 
+// Sample-accurate NLMS on a mirrored delay line: each sample is written twice, tdRing
+// apart, so the tdLen newest samples (newest first) are always the contiguous range
+// x[xIndex, xIndex + tdLen) and the filter and update run as plain vector loops.
 void AECProcessor::processTimeDomain(const float* mic, const float* ref, float* out, size_t frames) {
-    float curMu = atomicMu.load(std::memory_order_relaxed);
-    float curEpsilon = params.epsilon; 
-    
-    size_t cap = refDelay.size();
-    size_t n = w.size();
-    if (n == 0) return; // Safety
+    trackDelay(mic, ref, frames);
 
+    float mu = atomicMu.load(std::memory_order_relaxed);
+    bool block = tdMode == AECFilterMode::BlockNlms;
+    if (block) mu = std::min(mu, kBlockNlmsMaxStep / (float)kBlockNlmsLen);
+    float reg = params.epsilon + kNlmsPowerFloor * (float)tdLen;
     for (size_t i = 0; i < frames; ++i) {
-        // --- Delay Estimation Logic ---
-        refDelay[delayIdx] = ref[i];
-        
-        if (blockCount < blockSize) {
-            refFeed[blockCount] = ref[i];
-            micDelay[blockCount] = mic[i];
-            micPowerSum += sq(mic[i]);
-            refPowerSum += sq(ref[i]);
-        }
-        
-        delayIdx++;
-        if (delayIdx >= cap) delayIdx = 0;
-        
-        blockCount++;
-        if (blockCount >= blockSize) {
-            bool dtdActive = (dtdFreezeSamples > 0);
-            if (!dtdActive && refPowerSum > 1e-6f) {
-                updateDelay();
-            }
-            if (currentLag != lastLag) {
-                delayFreezeSamples = atomicFreezeBlocks.load() * blockSize;
-                lastLag = currentLag;
-                delayUpdateCounter++;
-                // Realign x buffer logic could go here (clear x to avoid glitch)
-                // std::fill(x.begin(), x.end(), 0.0f);
-                // xPowerSum = 0.0f;
-            }
-            blockCount = 0;
-            micPowerSum = 0.0f; refPowerSum = 0.0f;
-        }
-        
-        // --- NLMS Processing ---
-        
-        // 1. Get Delayed Reference
-        int readPos = (int)delayIdx - 1 - currentLag;
-        while(readPos < 0) readPos += cap;
-        while(readPos >= (int)cap) readPos -= cap;
-        
-        float r_val = refDelay[readPos];
-        float m_val = mic[i];
-        
-        // 2. Update x ring buffer
-        float x_oldest = x[xIndex];
-        xPowerSum -= (x_oldest * x_oldest);
-        
-        x[xIndex] = r_val;
-        xPowerSum += (r_val * r_val);
-        if (xPowerSum < 0.0f) xPowerSum = 0.0f;
-        
-        // 3. Filter (Dot Product)
-        float y_val = dot_cyclic(w, x, xIndex);
-        
-        // 4. Error
-        float e_val = m_val - y_val;
-        out[i] = e_val;
-        
-        // 5. Update Weights (NLMS)
-        if (!freeze && dtdFreezeSamples == 0) {
-            float norm = xPowerSum + curEpsilon;
-            float step = (curMu * e_val) / norm;
-            
-            for(size_t j=0; j<n; ++j) {
-                int x_idx = (int)xIndex - (int)j;
-                if (x_idx < 0) x_idx += n;
-                w[j] += step * x[x_idx];
-            }
+        float r = delayedRef(i, frames);
+        xIndex = (xIndex == 0 ? tdRing : xIndex) - 1;
+        float leaving = x[xIndex + tdLen];
+        x[xIndex] = r;
+        x[xIndex + tdRing] = r;
+        xPowerSum += sq(r) - sq(leaving);
+
+        const float* win = x.data() + xIndex;
+        float y = dotProduct(w.data(), win, tdLen);
+        float m = mic[i];
+        float e = m - y;
+        out[i] = e;
+
+        // freeze holds for the whole statistics block, as in the PBFDAF path
+        float step = freeze ? 0.0f : mu * e / (std::max(xPowerSum, 0.0f) + reg);
+        if (block) {
+            tdStep[tdFill++] = step;
+            if (tdFill == kBlockNlmsLen) applyBlockNlms();
+        } else if (step != 0.0f) {
+            axpy(w.data(), win, step, tdLen);
         }
-        
-        xIndex++;
-        if (xIndex >= n) xIndex = 0;
-        
-        // 6. Stats (Fast approximate)
-        micE = 0.999f * micE + 0.001f * sq(m_val);
-        errE = 0.999f * errE + 0.001f * sq(e_val);
-        refE = 0.999f * refE + 0.001f * sq(r_val);
-        
-        // Simple DTD Logic
-        float dtdThresh = atomicDtdAlpha.load(std::memory_order_relaxed);
-        bool isDtd = (micE > dtdThresh * refE) && (refE > 1e-6f);
-        if (isDtd) {
-            dtdFreezeSamples = 100; // Hold DTD state briefly
-        } else if (dtdFreezeSamples > 0) {
-            dtdFreezeSamples--;
+
+        tdSumY2 += sq(y);
+        tdSumE2 += sq(e);
+        tdSumRef2 += sq(r);
+        tdSumM2 += sq(m);
+        if (++tdStatsFill >= fdafM) {
+            blockStats(tdSumY2, tdSumE2, tdSumRef2, tdSumM2);
+            publishStats();
+            tdStatsFill = 0;
+            tdSumY2 = 0.0f; tdSumE2 = 0.0f; tdSumRef2 = 0.0f; tdSumM2 = 0.0f;
+            // The running sum drifts with rounding; start each block from the exact energy
+            xPowerSum = dotProduct(win, win, tdLen);
         }
     }
-    
-    // Update Stats Buffer
-    if (errE > 1e-12f) {
-        instantErle = 10.0f * std::log10((micE + 1e-12f) / errE);
-    } else {
-        instantErle = 0.0f;
+}
+
+// Block NLMS: the taps stayed fixed over the block, and the summed per-sample updates
+// are applied in one go. Sample k (oldest first) has its window tdFill - 1 - k samples
+// behind the newest, so four of them are folded into each pass over the taps.
+void AECProcessor::applyBlockNlms() {
+    const float* base = x.data() + xIndex;
+    float* wp = w.data();
+    size_t n = tdLen;
+    size_t k = 0;
+    for (; k + 4 <= tdFill; k += 4) {
+        float s0 = tdStep[k], s1 = tdStep[k + 1], s2 = tdStep[k + 2], s3 = tdStep[k + 3];
+        if (s0 == 0.0f && s1 == 0.0f && s2 == 0.0f && s3 == 0.0f) continue;
+        const float* x0 = base + (tdFill - 1 - k);
+        const float* x1 = x0 - 1;
+        const float* x2 = x0 - 2;
+        const float* x3 = x0 - 3;
+        for (size_t j = 0; j < n; ++j) wp[j] += s0 * x0[j] + s1 * x1[j] + s2 * x2[j] + s3 * x3[j];
     }
+    for (; k < tdFill; ++k) {
+        if (tdStep[k] != 0.0f) axpy(wp, base + (tdFill - 1 - k), tdStep[k], n);
+    }
+    tdFill = 0;
+}
 
-    // Calculate Average ERLE (Gated for Far-End Single-Talk)
-    // We only update average if:
-    // 1. Reference is active (refE > -60dB approx)
-    // 2. No Double-Talk detected (isDtd is false)
-    // 3. System has converged slightly (ignore first few blocks)
-    // dtdFreezeSamples > 0 is our current DTD flag.
-    bool dtdActive = (dtdFreezeSamples > 0);
-    if (!dtdActive && refE > 1e-6f && totalBlocks > 50) {
-        // Slow smoothing (approx 0.5s - 1s time constant)
-        // instantErle is computed every block (e.g. 4ms)
-        // alpha = 0.01 -> 100 blocks ~ 400ms
-        avgErle = 0.99f * avgErle + 0.01f * instantErle;
-        if (avgErle > maxErle) maxErle = avgErle;
+void AECProcessor::clearFilter() {
+    if (tdMode == AECFilterMode::Pbfdaf) {
+        W_freq.clear();
+    } else {
+        std::fill(w.begin(), w.end(), 0.0f);
     }
-    totalBlocks++;
-    
-    uint32_t seq = statsSeq.load(std::memory_order_relaxed);
-    statsSeq.store(seq + 1, std::memory_order_release);
-    
-    statsBuf.erle = instantErle;
-    statsBuf.maxErle = maxErle;
-    statsBuf.avgErle = avgErle; // Now holding the Gated Average ERLE
-    statsBuf.micE = micE;
-    statsBuf.refE = refE;
-    statsBuf.errE = errE;
-    statsBuf.currentLag = currentLag;
-    statsBuf.currentLagMs = (float)currentLag * 1000.0f / (float)params.sampleRate;
-    statsBuf.mu = curMu;
-    statsBuf.dtd = (dtdFreezeSamples > 0);
-    statsBuf.freeze = freeze || statsBuf.dtd;
-    
-    statsSeq.store(seq + 2, std::memory_order_release);
 }
 
 AECStats AECProcessor::getStats() const {
@@ -633,5 +933,406 @@ AECStats AECProcessor::getStats() const {
         s = statsBuf;
         std::atomic_thread_fence(std::memory_order_acquire);
     } while (seq % 2 != 0 || seq != statsSeq.load(std::memory_order_relaxed));
+    if (subbandFactor > 1) s.currentLag *= subbandFactor;
     return s;
-}
\ No newline at end of file
+}
+
+int AECProcessor::getLatency() const {
+    if (subbandFactor > 1) return subbandFactor * coreLatency() + subband.delay();
+    return coreLatency();
+}
+
+// Latency of the canceller itself, in samples at params.sampleRate
+int AECProcessor::coreLatency() const {
+    // Time-domain modes: each output sample is computed as its input arrives
+    if (tdMode != AECFilterMode::Pbfdaf) return 0;
+    // A block is processed as its last sample arrives; its first sample leaves on that same call
+    int latency = fdafM > 0 ? fdafM - 1 : 0;
+    // The post-filter completes a block once the next one has been analysed
+    return (fusedNs || resEnabled) ? latency + fdafM : latency;
+}
+
+void AECProcessor::setSubband(bool on) {
+    subbandRequested = on;
+}
+
+void AECProcessor::setDriftCompensation(bool on) {
+    driftEnabled = on;
+    drift.reset(params.sampleRate);
+    driftRate = 0.0;
+    lagDrift = 0.0;
+}
+
+void AECProcessor::setFusedSuppression(bool on) {
+    fusedNs = on;
+    resetPostFilter();
+}
+
+void AECProcessor::setResidualSuppression(bool on) {
+    resEnabled = on;
+    resetPostFilter();
+}
+
+void AECProcessor::resetPostFilter() {
+    if (fdafM <= 0) return; // Allocated by initialize
+    size_t bins = (size_t)fdafM + 1;
+    nsGain.initialize(bins);
+    postFft.init(fdafN);
+    postPrev.assign(bins, {0.0f, 0.0f});
+    postRaw.assign(bins, {0.0f, 0.0f});
+    postSpec.assign(bins, {0.0f, 0.0f});
+    postFrame.assign(fdafN, 0.0f);
+    postTail.assign(fdafM, 0.0f);
+    D_freq.assign(bins, {0.0f, 0.0f});
+    resEchoPsd.assign(bins, 0.0f);
+    resErrPsd.assign(bins, 0.0f);
+    resGain.assign(bins, 1.0f);
+}
+
+// Replaces the error block in olaBuffer with the post-filtered previous block.
+// The STFT frame is [e_prev, e] under a periodic Hann window at a hop of one block,
+// built from spectra the canceller already has: FFT([0, e]) is E_freq, and
+// FFT([e_prev, 0]) is the previous block's E_freq times (-1)^k. The window is a
+// 3-tap convolution in frequency, and Hann analysis with plain overlap-add
+// synthesis reconstructs exactly at unit gain.
+void AECProcessor::postFilterBlock() {
+    size_t bins = postPrev.size();
+    for (size_t k = 0; k < bins; ++k) {
+        postRaw[k] = (k & 1) ? E_freq[k] - postPrev[k] : E_freq[k] + postPrev[k];
+        postPrev[k] = E_freq[k];
+    }
+    if (resEnabled) {
+        // The frame matches the mic and reference frames behind psd_mic / psd_ref /
+        // psd_cross, so e = m - y makes D - E the echo estimate on the same frame.
+        // Residual echo is the part of the error coherent with the reference, capped
+        // by a leakage fraction of the echo estimate so near-end speech in double talk
+        // (low coherence, error far above the echo estimate) passes.
+        for (size_t k = 0; k < bins; ++k) {
+            float y2 = std::norm(D_freq[k] - postRaw[k]);
+            float e2 = std::norm(postRaw[k]);
+            resEchoPsd[k] = kResAlpha * resEchoPsd[k] + (1.0f - kResAlpha) * y2;
+            resErrPsd[k] = kResAlpha * resErrPsd[k] + (1.0f - kResAlpha) * e2;
+            float coh = std::norm(psd_cross[k]) / (psd_ref[k] * psd_mic[k] + 1e-9f);
+            float residual = std::min(coh, 1.0f) * std::min(resErrPsd[k], kResLeak * resEchoPsd[k]);
+            float g = 1.0f - kResOverdrive * residual / (resErrPsd[k] + 1e-12f);
+            resGain[k] = std::max(kResFloorGain, g);
+        }
+    }
+    for (size_t k = 0; k < bins; ++k) {
+        // Real frame: the spectrum is conjugate-symmetric around DC and Nyquist
+        std::complex<float> left = k > 0 ? postRaw[k - 1] : std::conj(postRaw[1]);
+        std::complex<float> right = k + 1 < bins ? postRaw[k + 1] : std::conj(postRaw[k - 1]);
+        postSpec[k] = 0.5f * postRaw[k] - 0.25f * (left + right);
+    }
+    if (resEnabled) {
+        for (size_t k = 0; k < bins; ++k) postSpec[k] *= resGain[k];
+    }
+    if (fusedNs) nsGain.apply(postSpec.data());
+    postFft.inverse(postSpec.data(), postFrame.data());
+    for (size_t i = 0; i < (size_t)fdafM; ++i) {
+        olaBuffer[i] = postTail[i] + postFrame[i];
+        postTail[i] = postFrame[fdafM + i];
+    }
+}
+
+void AECProcessor::saveSnapshot(AECSnapshot& s) const {
+    s.sampleRate = params.sampleRate;
+    s.filterLen = params.filterLen;
+    s.maxLag = maxLag;
+    s.corrBlock = params.corrBlock;
+    s.numPartitions = numPartitions;
+
+    // assign() reuses the snapshot's storage when it is saved repeatedly
+    // Spectra in float whatever their storage precision; X_freq[0] at full precision
+    s.W_freq.resize(W_freq.size());
+    for (size_t p = 0; p < W_freq.size(); ++p) {
+        s.W_freq[p].resize(W_freq.bins());
+        W_freq.read(p, s.W_freq[p].data());
+    }
+    s.X_freq.resize(X_freq.size());
+    for (size_t p = 0; p < X_freq.size(); ++p) {
+        s.X_freq[p].resize(X_freq.bins());
+        X_freq.read(p, s.X_freq[p].data());
+    }
+    if (!xNewest.empty() && !s.X_freq.empty()) s.X_freq[0].assign(xNewest.begin(), xNewest.end());
+    s.powerSpectralDensity.assign(powerSpectralDensity.begin(), powerSpectralDensity.end());
+    s.psd_ref.assign(psd_ref.begin(), psd_ref.end());
+    s.psd_mic.assign(psd_mic.begin(), psd_mic.end());
+    s.psd_cross.assign(psd_cross.begin(), psd_cross.end());
+    s.vssCross.assign(vssCross.begin(), vssCross.end());
+    s.vssErrPsd.assign(vssErrPsd.begin(), vssErrPsd.end());
+    s.vssRefPsd.assign(vssRefPsd.begin(), vssRefPsd.end());
+    s.vssMu.assign(vssMu.begin(), vssMu.end());
+    s.w.assign(w.begin(), w.end());
+    s.x.assign(x.begin(), x.end());
+    s.refDelay.assign(refDelay.begin(), refDelay.end());
+    s.refFeed.assign(refFeed.begin(), refFeed.end());
+    s.micDelay.assign(micDelay.begin(), micDelay.end());
+    s.fdafMicBuf.assign(fdafMicBuf.begin(), fdafMicBuf.end());
+    s.fdafRefBuf.assign(fdafRefBuf.begin(), fdafRefBuf.end());
+    s.micPrev.assign(micPrev.begin(), micPrev.end());
+    s.refPrev.assign(refPrev.begin(), refPrev.end());
+    s.outputFifo.assign(outputFifo.begin(), outputFifo.end());
+
+    s.muDynamic = muDynamic;
+    s.xIndex = xIndex;
+    s.xPowerSum = xPowerSum;
+    s.filterMode = (int)tdMode;
+    s.tdStep.assign(tdStep.begin(), tdStep.end());
+    s.tdFill = tdFill;
+    s.tdStatsFill = tdStatsFill;
+    s.tdSumY2 = tdSumY2;
+    s.tdSumE2 = tdSumE2;
+    s.tdSumRef2 = tdSumRef2;
+    s.tdSumM2 = tdSumM2;
+    s.tdWarm.assign(tdWarm.begin(), tdWarm.end());
+    s.delayIdx = delayIdx;
+    s.currentLag = currentLag;
+    s.lastLag = lastLag;
+    s.lagCandidate = lagCandidate;
+    s.lagCandidateHits = lagCandidateHits;
+    s.blockCount = blockCount;
+    s.micPowerSum = micPowerSum;
+    s.refPowerSum = refPowerSum;
+    s.fdafBufIdx = fdafBufIdx;
+    s.constraintIdx = constraintIdx;
+    s.outFifoRead = outFifoRead;
+    s.outFifoWrite = outFifoWrite;
+    s.outFifoCount = outFifoCount;
+    s.micE = micE;
+    s.refE = refE;
+    s.errE = errE;
+    s.coherence = coherence;
+    s.farEndEnergy = farEndEnergy;
+    s.freeze = freeze;
+    s.dtdFreezeSamples = dtdFreezeSamples;
+    s.delayFreezeSamples = delayFreezeSamples;
+    s.delayUpdateCounter = delayUpdateCounter;
+    s.totalBlocks = totalBlocks;
+    s.instantErle = instantErle;
+    s.maxErle = maxErle;
+    s.avgErle = avgErle;
+    s.convergedTimeMs = convergedTimeMs;
+    s.warmState = warmState;
+    s.W_warm = W_warm;
+    s.warmBlocks = warmBlocks;
+    s.warmWaitBlocks = warmWaitBlocks;
+    s.warmMicSum = warmMicSum;
+    s.warmErrSum = warmErrSum;
+    s.drift = drift;
+    s.driftRate = driftRate;
+    s.lagDrift = lagDrift;
+    s.streamPos = streamPos;
+}
+
+bool AECProcessor::restoreSnapshot(const AECSnapshot& s) {
+    if (fusedNs || resEnabled || subbandFactor > 1) return false;
+    if (s.sampleRate != params.sampleRate || s.filterLen != params.filterLen || s.maxLag != maxLag ||
+        s.corrBlock != params.corrBlock || s.numPartitions != numPartitions || s.filterMode != (int)tdMode) return false;
+    if (s.refDelay.size() != refDelay.size() || s.outputFifo.size() != outputFifo.size() ||
+        s.W_freq.size() != W_freq.size() || s.X_freq.size() != X_freq.size() ||
+        s.w.size() != w.size() || s.x.size() != x.size() || s.tdStep.size() != tdStep.size() ||
+        s.vssMu.size() != vssMu.size()) return false;
+
+    for (size_t p = 0; p < W_freq.size(); ++p) {
+        if (s.W_freq[p].size() != W_freq.bins()) return false;
+    }
+    for (size_t p = 0; p < X_freq.size(); ++p) {
+        if (s.X_freq[p].size() != X_freq.bins()) return false;
+    }
+
+    for (size_t p = 0; p < W_freq.size(); ++p) W_freq.write(p, s.W_freq[p].data());
+    for (size_t p = 0; p < X_freq.size(); ++p) X_freq.write(p, s.X_freq[p].data());
+    if (!xNewest.empty() && !s.X_freq.empty()) std::copy(s.X_freq[0].begin(), s.X_freq[0].end(), xNewest.begin());
+    std::copy(s.powerSpectralDensity.begin(), s.powerSpectralDensity.end(), powerSpectralDensity.begin());
+    std::copy(s.psd_ref.begin(), s.psd_ref.end(), psd_ref.begin());
+    std::copy(s.psd_mic.begin(), s.psd_mic.end(), psd_mic.begin());
+    std::copy(s.psd_cross.begin(), s.psd_cross.end(), psd_cross.begin());
+    std::copy(s.vssCross.begin(), s.vssCross.end(), vssCross.begin());
+    std::copy(s.vssErrPsd.begin(), s.vssErrPsd.end(), vssErrPsd.begin());
+    std::copy(s.vssRefPsd.begin(), s.vssRefPsd.end(), vssRefPsd.begin());
+    std::copy(s.vssMu.begin(), s.vssMu.end(), vssMu.begin());
+    std::copy(s.w.begin(), s.w.end(), w.begin());
+    std::copy(s.x.begin(), s.x.end(), x.begin());
+    std::copy(s.refDelay.begin(), s.refDelay.end(), refDelay.begin());
+    std::copy(s.refFeed.begin(), s.refFeed.end(), refFeed.begin());
+    std::copy(s.micDelay.begin(), s.micDelay.end(), micDelay.begin());
+    std::copy(s.fdafMicBuf.begin(), s.fdafMicBuf.end(), fdafMicBuf.begin());
+    std::copy(s.fdafRefBuf.begin(), s.fdafRefBuf.end(), fdafRefBuf.begin());
+    std::copy(s.micPrev.begin(), s.micPrev.end(), micPrev.begin());
+    std::copy(s.refPrev.begin(), s.refPrev.end(), refPrev.begin());
+    std::copy(s.outputFifo.begin(), s.outputFifo.end(), outputFifo.begin());
+
+    muDynamic = s.muDynamic;
+    xIndex = s.xIndex;
+    xPowerSum = s.xPowerSum;
+    std::copy(s.tdStep.begin(), s.tdStep.end(), tdStep.begin());
+    tdFill = s.tdFill;
+    tdStatsFill = s.tdStatsFill;
+    tdSumY2 = s.tdSumY2;
+    tdSumE2 = s.tdSumE2;
+    tdSumRef2 = s.tdSumRef2;
+    tdSumM2 = s.tdSumM2;
+    tdWarm = s.tdWarm;
+    delayIdx = s.delayIdx;
+    currentLag = s.currentLag;
+    lastLag = s.lastLag;
+    lagCandidate = s.lagCandidate;
+    lagCandidateHits = s.lagCandidateHits;
+    blockCount = s.blockCount;
+    micPowerSum = s.micPowerSum;
+    refPowerSum = s.refPowerSum;
+    fdafBufIdx = s.fdafBufIdx;
+    constraintIdx = s.constraintIdx;
+    outFifoRead = s.outFifoRead;
+    outFifoWrite = s.outFifoWrite;
+    outFifoCount = s.outFifoCount;
+    micE = s.micE;
+    refE = s.refE;
+    errE = s.errE;
+    coherence = s.coherence;
+    farEndEnergy = s.farEndEnergy;
+    freeze = s.freeze;
+    dtdFreezeSamples = s.dtdFreezeSamples;
+    delayFreezeSamples = s.delayFreezeSamples;
+    delayUpdateCounter = s.delayUpdateCounter;
+    totalBlocks = s.totalBlocks;
+    instantErle = s.instantErle;
+    maxErle = s.maxErle;
+    avgErle = s.avgErle;
+    convergedTimeMs = s.convergedTimeMs;
+    warmState = s.warmState;
+    W_warm = s.W_warm;
+    warmBlocks = s.warmBlocks;
+    warmWaitBlocks = s.warmWaitBlocks;
+    warmMicSum = s.warmMicSum;
+    warmErrSum = s.warmErrSum;
+    drift = s.drift;
+    driftRate = driftEnabled ? s.driftRate : 0.0;
+    lagDrift = driftEnabled ? s.lagDrift : 0.0;
+    streamPos = s.streamPos;
+    lastDelayChangeTime = 0.0f;
+
+    // Publish the restored state so getStats() reflects it before the next block
+    uint32_t seq = statsSeq.load(std::memory_order_relaxed);
+    statsSeq.store(seq + 1, std::memory_order_release);
+    statsBuf.erle = instantErle;
+    statsBuf.maxErle = maxErle;
+    statsBuf.avgErle = avgErle;
+    statsBuf.convergedTimeMs = convergedTimeMs;
+    statsBuf.currentLag = currentLag;
+    statsBuf.currentLagMs = (float)currentLag * 1000.0f / (float)params.sampleRate;
+    statsBuf.delayUpdateCount = delayUpdateCounter;
+    statsBuf.warmStart = warmState;
+    statsBuf.driftPpm = (float)(driftRate * 1e6);
+    statsSeq.store(seq + 2, std::memory_order_release);
+    return true;
+}
+
+void AECProcessor::initialize(const AECParams& p, const AECEchoPath& warmStart) {
+    initialize(p);
+    importEchoPath(warmStart);
+}
+
+void AECProcessor::exportEchoPath(AECEchoPath& path) const {
+    path.sampleRate = params.sampleRate;
+    path.filterLen = params.filterLen;
+    path.lag = currentLag;
+    path.erleDb = avgErle;
+    path.taps.assign((size_t)numPartitions * fdafM, 0.0f);
+    if (tdMode != AECFilterMode::Pbfdaf) {
+        std::copy(w.begin(), w.begin() + std::min(w.size(), path.taps.size()), path.taps.begin());
+        return;
+    }
+    // Constrained time-domain taps: the first half of each partition's impulse response
+    std::vector<std::complex<float>> buf(fdafN);
+    for (int p = 0; p < numPartitions; ++p) {
+        W_freq.read(p, buf.data());
+        FftUtil::ifft(buf);
+        for (int i = 0; i < fdafM; ++i) path.taps[(size_t)p * fdafM + i] = buf[i].real();
+    }
+}
+
+bool AECProcessor::importEchoPath(const AECEchoPath& path) {
+    if (path.sampleRate != params.sampleRate || path.filterLen != params.filterLen ||
+        path.taps.size() != (size_t)numPartitions * fdafM || path.lag < 0 || path.lag >= maxLag) return false;
+    for (float t : path.taps) {
+        if (!std::isfinite(t)) return false;
+    }
+
+    if (tdMode != AECFilterMode::Pbfdaf) {
+        std::copy(path.taps.begin(), path.taps.begin() + std::min(w.size(), path.taps.size()), w.begin());
+        tdWarm = w;
+    } else {
+        std::vector<std::complex<float>> buf(fdafN);
+        W_warm.resize(numPartitions);
+        for (int p = 0; p < numPartitions; ++p) {
+            std::fill(buf.begin(), buf.end(), std::complex<float>(0,0));
+            for (int i = 0; i < fdafM; ++i) buf[i] = { path.taps[(size_t)p * fdafM + i], 0.0f };
+            FftUtil::fft(buf);
+            W_freq.write(p, buf.data());
+            W_warm[p] = buf;
+        }
+    }
+    // Start at the cached delay; the estimator still moves it if the device latency changed
+    currentLag = path.lag;
+    lastLag = path.lag;
+    lagCandidate = path.lag;
+    lagCandidateHits = 0;
+    lagDrift = 0.0;
+    warmState = 1;
+    warmBlocks = 0;
+    warmWaitBlocks = 0;
+    warmMicSum = 0.0f;
+    warmErrSum = 0.0f;
+
+    uint32_t seq = statsSeq.load(std::memory_order_relaxed);
+    statsSeq.store(seq + 1, std::memory_order_release);
+    statsBuf.currentLag = currentLag;
+    statsBuf.currentLagMs = (float)currentLag * 1000.0f / (float)params.sampleRate;
+    statsBuf.warmStart = warmState;
+    statsSeq.store(seq + 2, std::memory_order_release);
+    return true;
+}
+
+template <class T>
+static size_t heapBytes(const std::vector<T>& v) { return v.capacity() * sizeof(T); }
+
+size_t AECProcessor::memoryFootprint() const {
+    size_t n = sizeof(*this);
+    // Time domain and delay estimation
+    n += heapBytes(w) + heapBytes(x) + heapBytes(tdStep) + heapBytes(tdWarm);
+    n += heapBytes(refDelay) + heapBytes(refFeed) + heapBytes(micDelay);
+    // PBFDAF
+    n += X_freq.memoryBytes() + W_freq.memoryBytes() + heapBytes(xNewest) + heapBytes(W_warm);
+    for (const auto& v : W_warm) n += heapBytes(v);
+    n += heapBytes(fdafMicBuf) + heapBytes(fdafRefBuf) + heapBytes(micPrev) + heapBytes(refPrev);
+    n += heapBytes(E_freq) + heapBytes(Y_freq) + heapBytes(fftScratch) + heapBytes(olaBuffer);
+    n += heapBytes(powerSpectralDensity) + heapBytes(psd_ref) + heapBytes(psd_mic) + heapBytes(psd_cross);
+    n += heapBytes(outputFifo) + heapBytes(propGain) + heapBytes(xParts) + heapBytes(wParts);
+    n += heapBytes(xPower) + heapBytes(adaptDen) + heapBytes(adaptStep);
+    n += heapBytes(vssCross) + heapBytes(vssErrPsd) + heapBytes(vssRefPsd) + heapBytes(vssMu);
+    // Post-filter, drift, subband
+    n += nsGain.memoryBytes() + postFft.memoryBytes();
+    n += heapBytes(postPrev) + heapBytes(postRaw) + heapBytes(postSpec) + heapBytes(postFrame);
+    n += heapBytes(postTail) + heapBytes(D_freq) + heapBytes(resEchoPsd) + heapBytes(resErrPsd) + heapBytes(resGain);
+    n += fracDelay.memoryBytes() + subband.memoryBytes();
+    n += heapBytes(sbLowMic) + heapBytes(sbLowRef) + heapBytes(sbLowErr) + heapBytes(sbHigh) + heapBytes(sbHighDelay);
+    return n;
+}
+
+size_t AECProcessor::memoryFootprint(const AECParams& p) {
+    AECProcessor a;
+    a.initialize(p);
+    return a.memoryFootprint();
+}
+
+// X_freq[0] at full precision
+const std::complex<float>* AECProcessor::newestRef() const {
+    if (xNewest.empty()) return static_cast<const std::complex<float>*>(X_freq.data(0));
+    return xNewest.data();
+}
+
+AECLoadStats AECProcessor::getLoadStats() const {
+    return loadMonitor.getStats();
+}
@@ -1,6 +1,7 @@
 #pragma once
 // This implementation is intended as a real-time Partitioned-Block Frequency-Domain Adaptive Filter (PBFDAF) AEC baseline. 
-// Focused on correctness, low-delay and measurability. No non-linear post-processing.
+// Focused on correctness, low-delay and measurability. Non-linear post-processing (residual
+// echo and noise suppression) is optional and off by default.
 // Real-time capable, lock-free statistics, and thread-safe parameter tuning.
 
 #include <vector>
@@ -8,6 +9,14 @@
 #include <cstddef>
 #include <complex>
 #include <atomic>
+#include "LoadMonitor.h"
+#include "FftUtil.h"
+#include "SpectralGain.h"
+#include "SubbandFilter.h"
+#include "DriftEstimator.h"
+#include "FractionalDelay.h"
+#include "FdafKernels.h"
+#include "SpectrumStore.h"
 // #include <mutex> // Removed mutex for lock-free design
 
 struct AECParams {
@@ -21,6 +30,28 @@ struct AECParams {
     int corrBlock;
     float dtdAlpha;
     float dtdBeta;
+    bool proportionate = false; // PBFDAF: weight each partition's update by its share of
+                                // the filter (MDF-IPNLMS) for sparse echo paths
+    // PBFDAF storage of the reference spectrum history and of the filter weights.
+    // Float16/BFloat16 halve their memory and the bandwidth of the per-bin loops; the
+    // arithmetic stays in float. Half-width weights also round each update, which
+    // limits how far the filter converges (see README).
+    SpectrumPrecision historyPrecision = SpectrumPrecision::Float32;
+    SpectrumPrecision weightPrecision = SpectrumPrecision::Float32;
+};
+
+// Mono, 1024-tap filter (64 ms at 16 kHz), mu 0.1, 80 ms delay search. Callers override
+// the fields their front end exposes.
+AECParams defaultAECParams(int sampleRate);
+
+// Adaptive filter structure. The time-domain modes filter every sample as it arrives,
+// so the canceller adds no latency; their cost grows with filterLen per sample, which
+// suits short (headset) echo paths.
+enum class AECFilterMode {
+    Pbfdaf,   // Partitioned-block frequency-domain filter (default)
+    Nlms,     // Sample-by-sample NLMS
+    BlockNlms // NLMS with the taps held for a few samples and the summed update applied
+              // in one pass (fewer passes over the taps; mu is capped at 0.25)
 };
 
 struct AECStats {
@@ -33,7 +64,7 @@ struct AECStats {
     int currentLag;
     float currentLagMs;
     bool freeze;
-    float mu;
+    float mu;               // Mean per-bin step with variable step size
     bool dtdFreezeActive;
     bool delayFreezeActive;
     int delayUpdateCount;
@@ -44,17 +75,182 @@ struct AECStats {
     float maxErle;
     float avgErle;
     float convergedTimeMs;
+    int warmStart; // Imported echo path: 0 none, 1 on probation, 2 confirmed, -1 rejected
+    float driftPpm; // Reference clock drift being compensated (0 until estimated, or when off)
+};
+
+// Converged echo path in a portable form: time-domain taps relative to the
+// (margin-adjusted) lag, so it survives a changed device latency as long as the
+// lag estimator finds the new delay. See EchoPathCache for persistence.
+struct AECEchoPath {
+    int sampleRate = 0;
+    int filterLen = 0;
+    int lag = 0;          // Estimated echo delay in samples
+    float erleDb = 0.0f;  // Average ERLE when exported
+    std::vector<float> taps; // One 256-tap block per filter partition
+};
+
+// Complete adaptive and streaming state of an AECProcessor (filter, PSDs, lag,
+// delay lines, block buffers and output FIFO). Restoring it into a processor
+// initialized with the same params resumes processing exactly where the
+// snapshot was taken. Not real-time safe: saving allocates on first use.
+struct AECSnapshot {
+    // Layout check
+    int sampleRate = 0;
+    int filterLen = 0;
+    int maxLag = 0;
+    int corrBlock = 0;
+    int numPartitions = 0;
+
+    // Adaptive filter and spectra
+    std::vector<std::vector<std::complex<float>>> W_freq;
+    std::vector<std::vector<std::complex<float>>> X_freq;
+    std::vector<float> powerSpectralDensity;
+    std::vector<float> psd_ref;
+    std::vector<float> psd_mic;
+    std::vector<std::complex<float>> psd_cross;
+    std::vector<std::complex<float>> vssCross;
+    std::vector<float> vssErrPsd;
+    std::vector<float> vssRefPsd;
+    std::vector<float> vssMu;
+    float muDynamic = 0.0f;
+    std::vector<float> w;
+    std::vector<float> x;
+    size_t xIndex = 0;
+    float xPowerSum = 0.0f;
+    int filterMode = 0;
+    std::vector<float> tdStep;
+    size_t tdFill = 0;
+    int tdStatsFill = 0;
+    float tdSumY2 = 0.0f;
+    float tdSumE2 = 0.0f;
+    float tdSumRef2 = 0.0f;
+    float tdSumM2 = 0.0f;
+    std::vector<float> tdWarm;
+
+    // Delay estimation
+    std::vector<float> refDelay;
+    std::vector<float> refFeed;
+    std::vector<float> micDelay;
+    size_t delayIdx = 0;
+    int currentLag = 0;
+    int lastLag = 0;
+    int lagCandidate = 0;
+    int lagCandidateHits = 0;
+    int blockCount = 0;
+    float micPowerSum = 0.0f;
+    float refPowerSum = 0.0f;
+
+    // Block framing and output
+    std::vector<float> fdafMicBuf;
+    std::vector<float> fdafRefBuf;
+    size_t fdafBufIdx = 0;
+    std::vector<float> micPrev;
+    std::vector<float> refPrev;
+    int constraintIdx = 0;
+    std::vector<float> outputFifo;
+    size_t outFifoRead = 0;
+    size_t outFifoWrite = 0;
+    size_t outFifoCount = 0;
+
+    // Detector and statistics
+    float micE = 0.0f;
+    float refE = 0.0f;
+    float errE = 0.0f;
+    float coherence = 0.0f;
+    float farEndEnergy = 0.0f;
+    bool freeze = false;
+    int dtdFreezeSamples = 0;
+    int delayFreezeSamples = 0;
+    int delayUpdateCounter = 0;
+    int totalBlocks = 0;
+    float instantErle = 0.0f;
+    float maxErle = 0.0f;
+    float avgErle = 0.0f;
+    float convergedTimeMs = 0.0f;
+    int warmState = 0;
+    std::vector<std::vector<std::complex<float>>> W_warm;
+    int warmBlocks = 0;
+    int warmWaitBlocks = 0;
+    float warmMicSum = 0.0f;
+    float warmErrSum = 0.0f;
+    DriftEstimator drift;
+    double driftRate = 0.0;
+    double lagDrift = 0.0;
+    double streamPos = 0.0;
 };
 
 class AECProcessor {
 public:
     AECProcessor();
     void initialize(const AECParams& p);
+    // Initialize, then start from a cached echo path (ignored if it does not fit p)
+    void initialize(const AECParams& p, const AECEchoPath& warmStart);
     void process(const float* mic, const float* ref, float* out, size_t frames);
     
     // Thread-safe stats getter
     AECStats getStats() const;
 
+    // Output delay of process() relative to its input, in samples
+    int getLatency() const;
+
+    // Post-filter stages on the canceller's own spectra (not real-time safe; kept across
+    // initialize). Either one resynthesizes the output once, adding one block of latency.
+    // Fused suppression applies the enhancer's noise gain (instead of a second STFT stage);
+    // residual echo suppression applies per-bin gains from the mic/ref coherence.
+    void setFusedSuppression(bool on);
+    bool fusedSuppression() const { return fusedNs; }
+    void setResidualSuppression(bool on);
+    bool residualSuppression() const { return resEnabled; }
+
+    // Subband mode (takes effect at the next initialize; 32 and 48 kHz only, other rates
+    // run full band). The canceller runs on the 0-8 kHz band decimated to 16 kHz with
+    // the same tail length in ms; the upper band only gets a gain that follows the low
+    // band's echo attenuation. Stats and lags stay in full-rate samples.
+    void setSubband(bool on);
+    bool subbandActive() const { return subbandFactor > 1; }
+
+    // Clock-drift compensation (not real-time safe; kept across initialize). The echo
+    // delay is measured to a fraction of a sample at each lag estimate, a drift rate is
+    // fitted over the last ~30 s, and the reference is read from the delay line at a
+    // fractional lag that follows it, so a slow drift no longer steps currentLag (each
+    // step clears the filter history).
+    void setDriftCompensation(bool on);
+    bool driftCompensation() const { return driftEnabled; }
+
+    // Filter structure (takes effect at the next initialize). The post-filter stages
+    // need the PBFDAF spectra and are skipped in the time-domain modes.
+    void setFilterMode(AECFilterMode mode);
+    AECFilterMode filterMode() const { return tdMode; }
+
+    // Per-bin PBFDAF step between the setMuRange bounds (default [mu, min(4 mu, 0.35)],
+    // reset by initialize), large while the error is still coherent with the
+    // reference and small once it is not. Off: the fixed setMu step. No effect in the
+    // time-domain modes.
+    void setVariableStepSize(bool on);
+    bool variableStepSize() const { return vssEnabled; }
+
+    // Checkpointing (not real-time safe). restoreSnapshot fails if the snapshot was
+    // taken from a processor initialized with a different layout, and while a post-filter
+    // stage or subband mode is on (their state is not part of the snapshot).
+    void saveSnapshot(AECSnapshot& s) const;
+    bool restoreSnapshot(const AECSnapshot& s);
+
+    // Warm start (not real-time safe). An imported path is on probation: it is
+    // dropped if far-end single-talk ERLE does not confirm it within ~0.5 s.
+    void exportEchoPath(AECEchoPath& path) const;
+    bool importEchoPath(const AECEchoPath& path);
+
+    // Memory held by this canceller (object and heap) as initialized, in bytes
+    size_t memoryFootprint() const;
+    // Same for a canceller initialized with p in the default modes (PBFDAF, full band).
+    // Not real-time safe: builds one.
+    static size_t memoryFootprint(const AECParams& p);
+
+    // Real-time load of process() (RTF, per-call percentiles, deadline misses)
+    AECLoadStats getLoadStats() const;
+    void setDeadlineBudgetUs(float us);
+
     // Runtime parameter setters (thread-safe)
     void setMu(float val);
     void setMuRange(float min, float max);
@@ -62,18 +258,47 @@ public:
     void setFreezeBlocks(int blocks);
 
 private:
+    friend struct AECBenchAccess; // aec_bench drives the internal kernels directly
+
+    void processCanceller(const float* mic, const float* ref, float* out, size_t frames);
     void processTimeDomain(const float* mic, const float* ref, float* out, size_t frames);
     void processFrequencyDomain(const float* mic, const float* ref, float* out, size_t frames);
+    void trackDelay(const float* mic, const float* ref, size_t frames);
+    float delayedRef(size_t i, size_t frames);
     void performBlockFdaf();
+    void applyBlockNlms();
+    void blockStats(float sumY2, float sumE2, float sumRef2, float sumM2);
+    void publishStats();
+    void updateStepSizes();
+    void updatePartitionGains();
+    void clearFilter();
+    void processSubband(const float* mic, const float* ref, float* out, size_t frames);
+    int coreLatency() const;
+    void resetPostFilter();
+    void postFilterBlock();
     void updateDelay();
+    void advanceDrift();
+    const std::complex<float>* newestRef() const;
 
     AECParams params;
     
-    // --- Time Domain Legacy ---
+    // --- Time domain (NLMS / block NLMS) ---
+    AECFilterMode tdRequested;
+    AECFilterMode tdMode;
+    size_t tdLen;                  // Taps, filterLen rounded up to the dot product width
+    size_t tdRing;                 // Delay line length: tdLen + the update block
     std::vector<float> w;
-    std::vector<float> x;
+    std::vector<float> x;          // Mirrored delay line, x[i] == x[i + tdRing]; newest sample at xIndex
     size_t xIndex;
-    float xPowerSum;
+    float xPowerSum;               // Energy of the tdLen newest samples
+    std::vector<float> tdStep;     // Block NLMS: step of each sample in the block, oldest first
+    size_t tdFill;
+    int tdStatsFill;               // Samples in the current statistics block (fdafM long)
+    float tdSumY2;
+    float tdSumE2;
+    float tdSumRef2;
+    float tdSumM2;
+    std::vector<float> tdWarm;     // Imported path while on probation
     // --------------------------
 
     // --- Common Delay / Buffer ---
@@ -84,6 +309,8 @@ private:
     int currentLag;
     int maxLag;
     int lastLag;
+    int lagCandidate;
+    int lagCandidateHits;
     // -----------------------------
 
     // --- Stats / Runtime ---
@@ -92,6 +319,11 @@ private:
     float avgErle;
     float convergedTimeMs;
     float lastDelayChangeTime;
+    int warmState;
+    int warmBlocks;
+    int warmWaitBlocks;
+    float warmMicSum;
+    float warmErrSum;
 
     int blockSize;
     int blockCount;
@@ -102,9 +334,7 @@ private:
     bool freeze;
     
     // Dynamic params
-    float muDynamic;
-    float muMin;
-    float muMax;
+    float muDynamic;     // Mean per-bin step of the last update (variable step size)
     float iirAlpha;
     float micE;
     float refE;
@@ -124,8 +354,10 @@ private:
     std::vector<float> fdafMicBuf;
     std::vector<float> fdafRefBuf;
     size_t fdafBufIdx;
-    std::vector<std::vector<std::complex<float>>> X_freq;
-    std::vector<std::vector<std::complex<float>>> W_freq;
+    SpectrumStore X_freq;         // Partition 0 is the newest block
+    SpectrumStore W_freq;
+    std::vector<std::complex<float>> xNewest; // X_freq[0] at full precision (reduced-precision history only)
+    std::vector<std::vector<std::complex<float>>> W_warm; // Imported path while on probation
     std::vector<std::complex<float>> E_freq;
     std::vector<std::complex<float>> Y_freq;
     std::vector<std::complex<float>> fftScratch;
@@ -141,6 +373,61 @@ private:
     size_t outFifoWrite;
     size_t outFifoCount;
     std::vector<float> micPrev;
+    std::vector<float> refPrev;
+
+    // Post-filter: STFT frames [previous error block, error block]
+    bool fusedNs;
+    bool resEnabled;
+    SpectralGain nsGain;
+    RealFft postFft;
+    std::vector<std::complex<float>> postPrev;  // Previous block's error spectrum (half)
+    std::vector<std::complex<float>> postRaw;   // Unwindowed frame spectrum
+    std::vector<std::complex<float>> postSpec;  // Hann-windowed frame spectrum
+    std::vector<float> postFrame;
+    std::vector<float> postTail;                // Second half of the last synthesized frame
+    std::vector<std::complex<float>> D_freq;    // Mic frame spectrum (half), as for psd_mic
+    std::vector<float> resEchoPsd;              // Echo estimate power per bin
+    std::vector<float> resErrPsd;               // Error power per bin
+    std::vector<float> resGain;
+
+    std::vector<float> propGain; // Proportionate update, per partition
+
+    // Per-bin loops, specialized for the layout when one matches (FdafKernels)
+    const FdafKernels* kernels;
+    std::vector<const void*> xParts;
+    std::vector<const void*> wParts;
+    std::vector<float> xPower;    // sum_p |X_p|^2
+    std::vector<float> adaptDen;
+    std::vector<float> adaptStep; // Per-bin step (variable step size)
+
+    // Variable step size
+    bool vssEnabled;
+    std::vector<std::complex<float>> vssCross;
+    std::vector<float> vssErrPsd;
+    std::vector<float> vssRefPsd;
+    std::vector<float> vssMu;
+
+    // Drift compensation: the reference is read at currentLag + lagDrift
+    bool driftEnabled;
+    DriftEstimator drift;
+    FractionalDelay fracDelay;
+    double driftRate;                         // Lag change per sample
+    double lagDrift;                          // Fractional part, within +-0.5
+    double streamPos;                         // Input samples since initialize
+
+    // Subband mode: params describe the decimated low band the canceller runs on
+    bool subbandRequested;
+    int subbandFactor;                        // 1: full band
+    SubbandFilter subband;
+    std::vector<float> sbLowMic;
+    std::vector<float> sbLowRef;
+    std::vector<float> sbLowErr;
+    std::vector<float> sbHigh;
+    std::vector<float> sbHighDelay;           // Upper band waiting for the canceller latency
+    size_t sbHighIdx;
+    float sbHighGain;
+
+    LoadMonitor loadMonitor;
 
     // Atomics
     std::atomic<uint32_t> statsSeq;
@@ -1,17 +1,31 @@
 #pragma once
 #include <vector>
+#include <complex>
+#include <cstddef>
+#include "FftUtil.h"
+#include "SpectralGain.h"
 #include "../../APO/ApoParams.h"
 class AIEnhancer {
 public:
     AIEnhancer();
     void initialize(const AIParams& p);
+    // Real-time safe: no allocation
     void process(float* inout, size_t frames);
+    // Output delay of process() relative to its input, in samples (one FFT frame)
+    int getLatency() const;
 private:
+    void processFrame();
+
     AIParams params;
+    RealFft fft;
     std::vector<float> window;
-    std::vector<float> noise;
-    std::vector<float> ola;
-    std::vector<float> acc;
-    size_t accIndex;
+    SpectralGain gain;
+    std::vector<float> frame;   // Windowed analysis / synthesis frame
+    std::vector<std::complex<float>> spec;
+    std::vector<float> ola;     // Circular overlap-add output, olaRead is the next sample out
+    std::vector<float> acc;     // Circular analysis history, accWrite is the oldest sample
+    size_t olaRead;
+    size_t accWrite;
+    size_t pending;             // Input samples still needed before the next frame
     bool initialized;
 };
@@ -0,0 +1,105 @@
+#include "DriftEstimator.h"
+#include <cmath>
+#include <algorithm>
+
+static const double kForgetSec = 30.0;     // Observation weight decays by 1/e over this
+static const double kMinSpanSec = 6.0;
+static const int kMinObservations = 24;
+static const double kOutlierSec = 0.0002;  // Farther than this from the line is an outlier
+static const int kStepObservations = 3;    // Consecutive outliers that mean a real delay step
+static const double kMaxSlope = 500e-6;    // Beyond any real device pair
+static const double kMaxSlopeError = 5e-6; // Standard error of the fitted slope
+
+void DriftEstimator::reset(int sampleRate) {
+    *this = DriftEstimator();
+    rate = sampleRate > 0 ? (double)sampleRate : 16000.0;
+}
+
+bool DriftEstimator::valid() const {
+    return count >= kMinObservations && lastT - firstT >= kMinSpanSec * rate;
+}
+
+static inline bool solve(double sumW, double sumT, double sumD, double sumTT, double sumTD, double& a, double& b) {
+    double det = sumW * sumTT - sumT * sumT;
+    if (sumW <= 0.0 || det <= 1e-9 * sumW * sumTT) return false;
+    b = (sumW * sumTD - sumT * sumD) / det;
+    a = (sumD - b * sumT) / sumW;
+    return true;
+}
+
+double DriftEstimator::slope() const {
+    double a, b;
+    if (!valid() || !solve(sumW, sumT, sumD, sumTT, sumTD, a, b)) return 0.0;
+    // A noisy fit (few or scattered observations) or an implausible rate is no estimate
+    double ssr = std::max(0.0, sumDD - a * sumD - b * sumTD);
+    double det = sumW * sumTT - sumT * sumT;
+    double varB = ssr / std::max(1.0, sumW - 2.0) * sumW / det;
+    if (varB > kMaxSlopeError * kMaxSlopeError || std::fabs(b) > kMaxSlope) return 0.0;
+    return b;
+}
+
+double DriftEstimator::predict(double t) const {
+    double a, b;
+    if (!solve(sumW, sumT, sumD, sumTT, sumTD, a, b)) return sumW > 0.0 ? sumD / sumW : 0.0;
+    return a + b * (t - origin);
+}
+
+void DriftEstimator::addObservation(double t, double delay) {
+    if (count == 0) {
+        origin = t;
+        firstT = t;
+    } else {
+        // Outlier gate against the current line (or mean, before a slope exists)
+        // (speech periodicity gives strong side peaks). Outliers that agree with each
+        // other several times in a row are a real step instead.
+        double tol = kOutlierSec * rate;
+        double r = delay - predict(t);
+        if (std::fabs(r) > tol) {
+            if (outliers > 0 && std::fabs(r - pendingShift / (double)outliers) <= tol) {
+                pendingShift += r;
+                outliers++;
+            } else {
+                pendingShift = r;
+                outliers = 1;
+            }
+            if (outliers < kStepObservations) return;
+            if (slope() == 0.0) {
+                // No trusted line yet (it may have started on a side peak): start over
+                double rateKeep = rate;
+                reset(0);
+                rate = rateKeep;
+                addObservation(t, delay);
+                return;
+            }
+            // Move the line to the new delay and keep the slope
+            double shift = pendingShift / (double)outliers;
+            sumDD += 2.0 * shift * sumD + shift * shift * sumW;
+            sumD += shift * sumW;
+            sumTD += shift * sumT;
+            pendingShift = 0.0;
+            outliers = 0;
+            return;
+        }
+        pendingShift = 0.0;
+        outliers = 0;
+        double decay = std::exp(-(t - lastT) / (kForgetSec * rate));
+        sumW *= decay; sumT *= decay; sumD *= decay; sumTT *= decay; sumTD *= decay; sumDD *= decay;
+        // Keep the origin near the weighted data so the sums stay well conditioned
+        double shift = t - origin;
+        if (shift > 4.0 * kForgetSec * rate) {
+            sumTT += -2.0 * shift * sumT + shift * shift * sumW;
+            sumTD -= shift * sumD;
+            sumT -= shift * sumW;
+            origin = t;
+        }
+    }
+    double x = t - origin;
+    sumW += 1.0;
+    sumT += x;
+    sumD += delay;
+    sumTT += x * x;
+    sumTD += x * delay;
+    sumDD += delay * delay;
+    lastT = t;
+    count++;
+}
@@ -0,0 +1,33 @@
+#pragma once
+// Clock-drift estimate between the reference and mic streams from a series of
+// sub-sample echo-delay measurements: weighted least-squares line through
+// (time, delay) with exponential forgetting. The slope is the drift in samples per
+// sample. A persistent step in the delay (a real path change) re-bases the line
+// instead of bending it. Plain data, so AECSnapshot can copy it.
+
+#include <cstdint>
+
+class DriftEstimator {
+public:
+    void reset(int sampleRate);
+    // t: stream position in samples; delay: measured echo delay in samples
+    void addObservation(double t, double delay);
+    // True once enough observations over a long enough span are in
+    bool valid() const;
+    // Delay drift in samples per sample (ppm * 1e-6); 0 until valid and while the
+    // fit is too uncertain
+    double slope() const;
+    // Fitted delay at stream position t
+    double predict(double t) const;
+    int observations() const { return count; }
+
+private:
+    double rate = 16000.0;
+    double sumW = 0.0, sumT = 0.0, sumD = 0.0, sumTT = 0.0, sumTD = 0.0, sumDD = 0.0; // Weighted sums
+    double origin = 0.0;   // t origin of the sums, moved forward to keep them well conditioned
+    double lastT = 0.0;
+    double firstT = 0.0;   // First observation since reset
+    double pendingShift = 0.0; // Sum of the residuals of the current outlier run
+    int outliers = 0;      // Consecutive, mutually consistent observations far from the line
+    int count = 0;
+};
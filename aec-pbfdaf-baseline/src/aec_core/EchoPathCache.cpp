@@ -0,0 +1,163 @@
+#include "EchoPathCache.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#ifndef NOMINMAX
+#define NOMINMAX 1
+#endif
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// File layout (little-endian): magic, version, key, sampleRate, filterLen, lag,
+// erleDb, tap count, taps (float32), then an FNV-1a checksum of everything before it.
+static const char kMagic[4] = { 'A', 'E', 'P', 'C' };
+static const uint32_t kVersion = 1;
+static const uint32_t kMaxTaps = 1u << 20;
+
+static uint64_t fnv1a(const void* data, size_t n, uint64_t h = 1469598103934665603ull) {
+    const unsigned char* p = (const unsigned char*)data;
+    for (size_t i = 0; i < n; ++i) {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+template <typename T>
+static void put(std::vector<unsigned char>& b, const T& v) {
+    const unsigned char* p = (const unsigned char*)&v;
+    b.insert(b.end(), p, p + sizeof(T));
+}
+
+template <typename T>
+static bool get(const std::vector<unsigned char>& b, size_t& pos, T& v) {
+    if (b.size() - pos < sizeof(T)) return false;
+    memcpy(&v, b.data() + pos, sizeof(T));
+    pos += sizeof(T);
+    return true;
+}
+
+EchoPathCache::EchoPathCache(const std::string& dir) : dir(dir) {}
+
+uint64_t EchoPathCache::fingerprint(const std::string& micId, const std::string& spkId, const AECParams& p) {
+    uint64_t h = fnv1a(micId.data(), micId.size());
+    h = fnv1a("\0", 1, h); // Separator: ("ab", "c") and ("a", "bc") differ
+    h = fnv1a(spkId.data(), spkId.size(), h);
+    int32_t layout[3] = { p.sampleRate, p.filterLen, p.maxDelayMs };
+    return fnv1a(layout, sizeof(layout), h);
+}
+
+std::string EchoPathCache::entryPath(uint64_t key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.aep", (unsigned long long)key);
+    if (dir.empty()) return name;
+    char last = dir.back();
+    return (last == '/' || last == '\\') ? dir + name : dir + "/" + name;
+}
+
+bool EchoPathCache::load(uint64_t key, AECEchoPath& path) const {
+    FILE* f = fopen(entryPath(key).c_str(), "rb");
+    if (!f) return false;
+    std::vector<unsigned char> b;
+    unsigned char chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        b.insert(b.end(), chunk, chunk + n);
+        if (b.size() > kMaxTaps * sizeof(float) + 64) break;
+    }
+    fclose(f);
+
+    if (b.size() < sizeof(kMagic) + sizeof(uint64_t) || memcmp(b.data(), kMagic, sizeof(kMagic)) != 0) return false;
+    uint64_t sum;
+    memcpy(&sum, b.data() + b.size() - sizeof(sum), sizeof(sum));
+    if (fnv1a(b.data(), b.size() - sizeof(sum)) != sum) return false;
+
+    size_t pos = sizeof(kMagic);
+    uint32_t version = 0, count = 0;
+    uint64_t storedKey = 0;
+    int32_t sampleRate = 0, filterLen = 0, lag = 0;
+    float erleDb = 0.0f;
+    if (!get(b, pos, version) || version != kVersion) return false;
+    if (!get(b, pos, storedKey) || storedKey != key) return false;
+    if (!get(b, pos, sampleRate) || !get(b, pos, filterLen) || !get(b, pos, lag) ||
+        !get(b, pos, erleDb) || !get(b, pos, count)) return false;
+    if (count > kMaxTaps || b.size() - sizeof(sum) - pos != (size_t)count * sizeof(float)) return false;
+
+    path.sampleRate = sampleRate;
+    path.filterLen = filterLen;
+    path.lag = lag;
+    path.erleDb = erleDb;
+    path.taps.resize(count);
+    if (count > 0) memcpy(path.taps.data(), b.data() + pos, (size_t)count * sizeof(float));
+    return true;
+}
+
+static std::atomic<uint32_t> gTmpCounter(0);
+
+static unsigned long processId() {
+#ifdef _WIN32
+    return (unsigned long)_getpid();
+#else
+    return (unsigned long)getpid();
+#endif
+}
+
+// Atomic replace: rename() on POSIX; on Windows rename() fails when the target exists,
+// so MoveFileExW (paths in the ANSI code page, as fopen reads them)
+static bool replaceFile(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+    auto wide = [](const std::string& s) {
+        int n = MultiByteToWideChar(CP_ACP, 0, s.c_str(), -1, nullptr, 0);
+        std::wstring w(n > 0 ? (size_t)n : 1, L'\0');
+        if (n > 0) MultiByteToWideChar(CP_ACP, 0, s.c_str(), -1, &w[0], n);
+        return w;
+    };
+    return MoveFileExW(wide(from).c_str(), wide(to).c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+bool EchoPathCache::store(uint64_t key, const AECEchoPath& path) const {
+    if (path.taps.size() > kMaxTaps) return false;
+    std::vector<unsigned char> b;
+    b.reserve(64 + path.taps.size() * sizeof(float));
+    b.insert(b.end(), kMagic, kMagic + sizeof(kMagic));
+    put(b, kVersion);
+    put(b, key);
+    put(b, (int32_t)path.sampleRate);
+    put(b, (int32_t)path.filterLen);
+    put(b, (int32_t)path.lag);
+    put(b, path.erleDb);
+    put(b, (uint32_t)path.taps.size());
+    const unsigned char* t = (const unsigned char*)path.taps.data();
+    b.insert(b.end(), t, t + path.taps.size() * sizeof(float));
+    put(b, fnv1a(b.data(), b.size()));
+
+    if (!dir.empty()) {
+#ifdef _WIN32
+        _mkdir(dir.c_str());
+#else
+        mkdir(dir.c_str(), 0755);
+#endif
+    }
+    // Write a temporary file of this writer's own (processes and threads storing the
+    // same key must not share one) and rename it over the entry, so a crash never
+    // leaves a torn or missing entry
+    std::string target = entryPath(key);
+    std::string tmp = target + "." + std::to_string(processId()) + "." +
+                      std::to_string(gTmpCounter.fetch_add(1)) + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+    bool ok = fwrite(b.data(), 1, b.size(), f) == b.size();
+    ok = fclose(f) == 0 && ok;
+    if (!ok || !replaceFile(tmp, target)) { remove(tmp.c_str()); return false; }
+    return true;
+}
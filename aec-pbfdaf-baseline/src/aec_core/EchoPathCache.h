@@ -0,0 +1,28 @@
+#pragma once
+// On-disk cache of converged echo paths (AECEchoPath), one small binary file per
+// device pair / sample rate / filter layout, so a call on known hardware can start
+// from yesterday's filter instead of from zero.
+
+#include <cstdint>
+#include <string>
+#include "AECProcessor.h"
+
+class EchoPathCache {
+public:
+    explicit EchoPathCache(const std::string& dir);
+
+    // Key over everything an echo path depends on: the capture and render endpoints
+    // (stable device ids, not display names), the sample rate and the filter layout
+    static uint64_t fingerprint(const std::string& micId, const std::string& spkId, const AECParams& p);
+
+    // False if there is no entry or it is corrupt / written for another key
+    bool load(uint64_t key, AECEchoPath& path) const;
+    // Replaces the entry atomically (write to a per-writer temporary file, then rename
+    // over it); creates the directory if needed
+    bool store(uint64_t key, const AECEchoPath& path) const;
+
+    std::string entryPath(uint64_t key) const;
+
+private:
+    std::string dir;
+};
@@ -0,0 +1,139 @@
+#include "FdafKernels.h"
+
+typedef std::complex<float> cf;
+
+// Storage formats: element type, widening load, rounding store
+struct StoreF32 {
+    typedef float T;
+    static const SpectrumPrecision kPrecision = SpectrumPrecision::Float32;
+    static inline float load(float v) { return v; }
+    static inline float store(float v) { return v; }
+};
+struct StoreF16 {
+    typedef uint16_t T;
+    static const SpectrumPrecision kPrecision = SpectrumPrecision::Float16;
+    static inline float load(uint16_t v) { return halfToFloat(v); }
+    static inline uint16_t store(float v) { return floatToHalf(v); }
+};
+struct StoreBF16 {
+    typedef uint16_t T;
+    static const SpectrumPrecision kPrecision = SpectrumPrecision::BFloat16;
+    static inline float load(uint16_t v) { return bf16ToFloat(v); }
+    static inline uint16_t store(float v) { return floatToBf16(v); }
+};
+
+// kBins/kParts == 0: sizes from the arguments
+template <class XS, size_t kBins, size_t kParts>
+static void partitionPowerT(const void* const* X, float* power, size_t bins, size_t partitions) {
+    typedef typename XS::T XT;
+    const size_t n = kBins ? kBins : bins;
+    const size_t parts = kParts ? kParts : partitions;
+    const XT* x0 = static_cast<const XT*>(X[0]);
+    for (size_t k = 0; k < n; ++k) {
+        float xr = XS::load(x0[2 * k]), xi = XS::load(x0[2 * k + 1]);
+        power[k] = xr * xr + xi * xi;
+    }
+    for (size_t p = 1; p < parts; ++p) {
+        const XT* x = static_cast<const XT*>(X[p]);
+        for (size_t k = 0; k < n; ++k) {
+            float xr = XS::load(x[2 * k]), xi = XS::load(x[2 * k + 1]);
+            power[k] += xr * xr + xi * xi;
+        }
+    }
+}
+
+template <class XS, class WS, size_t kBins, size_t kParts>
+static void convolveT(const void* const* X, const void* const* W, cf* Y, size_t bins, size_t partitions) {
+    typedef typename XS::T XT;
+    typedef typename WS::T WT;
+    const size_t n = kBins ? kBins : bins;
+    const size_t parts = kParts ? kParts : partitions;
+    float* y = reinterpret_cast<float*>(Y);
+    for (size_t k = 0; k < 2 * n; ++k) y[k] = 0.0f;
+    for (size_t p = 0; p < parts; ++p) {
+        const XT* x = static_cast<const XT*>(X[p]);
+        const WT* w = static_cast<const WT*>(W[p]);
+        for (size_t k = 0; k < n; ++k) {
+            float xr = XS::load(x[2 * k]), xi = XS::load(x[2 * k + 1]);
+            float wr = WS::load(w[2 * k]), wi = WS::load(w[2 * k + 1]);
+            y[2 * k] += xr * wr - xi * wi;
+            y[2 * k + 1] += xr * wi + xi * wr;
+        }
+    }
+}
+
+template <class XS, class WS, size_t kBins>
+static void adaptT(void* W, const void* X, const cf* E, const float* den, const float* step, float mu, size_t bins) {
+    typedef typename XS::T XT;
+    typedef typename WS::T WT;
+    const size_t n = kBins ? kBins : bins;
+    WT* w = static_cast<WT*>(W);
+    const XT* x = static_cast<const XT*>(X);
+    const float* e = reinterpret_cast<const float*>(E);
+    if (step) {
+        for (size_t k = 0; k < n; ++k) {
+            float xr = XS::load(x[2 * k]), xi = XS::load(x[2 * k + 1]);
+            float gr = e[2 * k] * xr + e[2 * k + 1] * xi;
+            float gi = e[2 * k + 1] * xr - e[2 * k] * xi;
+            w[2 * k] = WS::store(WS::load(w[2 * k]) + step[k] * gr / den[k]);
+            w[2 * k + 1] = WS::store(WS::load(w[2 * k + 1]) + step[k] * gi / den[k]);
+        }
+        return;
+    }
+    for (size_t k = 0; k < n; ++k) {
+        float xr = XS::load(x[2 * k]), xi = XS::load(x[2 * k + 1]);
+        float gr = e[2 * k] * xr + e[2 * k + 1] * xi;
+        float gi = e[2 * k + 1] * xr - e[2 * k] * xi;
+        w[2 * k] = WS::store(WS::load(w[2 * k]) + mu * gr / den[k]);
+        w[2 * k + 1] = WS::store(WS::load(w[2 * k + 1]) + mu * gi / den[k]);
+    }
+}
+
+template <class XS, class WS, size_t kBins, size_t kParts>
+static constexpr FdafKernels makeKernels() {
+    return { kBins, kParts, XS::kPrecision, WS::kPrecision,
+             &partitionPowerT<XS, kBins, kParts>, &convolveT<XS, WS, kBins, kParts>, &adaptT<XS, WS, kBins> };
+}
+
+// 256-sample blocks with filterLen 1024, 2048 and 4096 at 16 kHz, and the generic set,
+// for one pair of precisions (constant-initialized, so usable from other static
+// initializers)
+template <class XS, class WS>
+struct KernelTable {
+    static constexpr FdafKernels specialized[] = {
+        makeKernels<XS, WS, 512, 4>(),
+        makeKernels<XS, WS, 512, 8>(),
+        makeKernels<XS, WS, 512, 16>(),
+    };
+    static constexpr FdafKernels generic = makeKernels<XS, WS, 0, 0>();
+
+    static const FdafKernels& select(size_t bins, size_t partitions) {
+        for (const FdafKernels& k : specialized) {
+            if (k.bins == bins && k.partitions == partitions) return k;
+        }
+        return generic;
+    }
+};
+
+template <class XS>
+static const FdafKernels& selectWeights(SpectrumPrecision weights, size_t bins, size_t partitions) {
+    switch (weights) {
+    case SpectrumPrecision::Float16: return KernelTable<XS, StoreF16>::select(bins, partitions);
+    case SpectrumPrecision::BFloat16: return KernelTable<XS, StoreBF16>::select(bins, partitions);
+    default: return KernelTable<XS, StoreF32>::select(bins, partitions);
+    }
+}
+
+const FdafKernels& selectFdafKernels(size_t bins, size_t partitions, SpectrumPrecision history,
+                                     SpectrumPrecision weights) {
+    switch (history) {
+    case SpectrumPrecision::Float16: return selectWeights<StoreF16>(weights, bins, partitions);
+    case SpectrumPrecision::BFloat16: return selectWeights<StoreBF16>(weights, bins, partitions);
+    default: return selectWeights<StoreF32>(weights, bins, partitions);
+    }
+}
+
+// No layout matches bins 0
+const FdafKernels& genericFdafKernels(SpectrumPrecision history, SpectrumPrecision weights) {
+    return selectFdafKernels(0, 0, history, weights);
+}
@@ -0,0 +1,38 @@
+#pragma once
+// The PBFDAF per-bin loops (partition power, filtering, weight update) as templates
+// on the FFT size and partition count. Instantiations for the common layouts give the
+// optimizer constant trip counts to unroll the partition sums and vectorize the bins;
+// any other layout takes the same code with runtime sizes. Complex values are worked
+// on as (re, im) float pairs: std::complex multiplication carries a NaN-recovery branch
+// that keeps the loops scalar. The arithmetic and summation order match the plain
+// std::complex loops, so every instantiation gives bit-identical results.
+// Each set also fixes the storage precision of the reference history X and the
+// weights W (SpectrumStore); the partition pointers point to values in that format.
+
+#include <complex>
+#include <cstddef>
+#include "SpectrumStore.h"
+
+struct FdafKernels {
+    size_t bins;        // FFT size this set is specialized for (0: any)
+    size_t partitions;  // Partition count (0: any)
+    SpectrumPrecision history;
+    SpectrumPrecision weights;
+
+    // power[k] = sum_p |X[p][k]|^2
+    void (*partitionPower)(const void* const* X, float* power, size_t bins, size_t partitions);
+    // Y[k] = sum_p X[p][k] * W[p][k]
+    void (*convolve)(const void* const* X, const void* const* W, std::complex<float>* Y,
+                     size_t bins, size_t partitions);
+    // W[k] += step[k] * E[k] * conj(X[k]) / den[k] for one partition; step == nullptr:
+    // the scalar mu for every bin
+    void (*adapt)(void* W, const void* X, const std::complex<float>* E,
+                  const float* den, const float* step, float mu, size_t bins);
+};
+
+// Specialized set for the layout and precisions, or the generic one
+const FdafKernels& selectFdafKernels(size_t bins, size_t partitions,
+                                     SpectrumPrecision history = SpectrumPrecision::Float32,
+                                     SpectrumPrecision weights = SpectrumPrecision::Float32);
+const FdafKernels& genericFdafKernels(SpectrumPrecision history = SpectrumPrecision::Float32,
+                                      SpectrumPrecision weights = SpectrumPrecision::Float32);
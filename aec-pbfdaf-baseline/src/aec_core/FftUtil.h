@@ -3,6 +3,7 @@
 #include <complex>
 #include <cmath>
 #include <algorithm>
+#include <cstdint>
 
 // Compact, header-only FFT implementation for AEC/NS
 // Uses Cooley-Tukey radix-2 algorithm
@@ -66,3 +67,266 @@ public:
         for(size_t i=0; i<in.size(); ++i) out[i] = in[i].real();
     }
 };
+
+// Real-input FFT of size n (power of two) computed through an n/2-point complex FFT.
+// Bit-reversal and twiddle tables plus scratch are built by init(); forward() and
+// inverse() neither allocate nor evaluate trigonometric functions.
+class RealFft {
+public:
+    void init(size_t size) {
+        n = size;
+        m = size / 2;
+        buf.assign(m, {0.0f, 0.0f});
+        bitrev.assign(m, 0);
+        for (size_t i = 1, j = 0; i < m; ++i) {
+            size_t k = m >> 1;
+            for (; j & k; k >>= 1) j ^= k;
+            j ^= k;
+            bitrev[i] = (uint32_t)j;
+        }
+        const float pi = 3.14159265358979323846f;
+        twiddle.resize(m / 2 > 0 ? m / 2 : 1);
+        for (size_t j = 0; j < twiddle.size(); ++j) {
+            float a = -2.0f * pi * (float)j / (float)m;
+            twiddle[j] = { std::cos(a), std::sin(a) };
+        }
+        twiddleInv.resize(twiddle.size());
+        for (size_t j = 0; j < twiddle.size(); ++j) twiddleInv[j] = std::conj(twiddle[j]);
+        post.resize(m + 1);
+        for (size_t k = 0; k <= m; ++k) {
+            float a = -2.0f * pi * (float)k / (float)n;
+            post[k] = { std::cos(a), std::sin(a) };
+        }
+    }
+
+    size_t size() const { return n; }
+    size_t bins() const { return m + 1; }
+    // Heap memory held
+    size_t memoryBytes() const {
+        return (buf.capacity() + twiddle.capacity() + twiddleInv.capacity() + post.capacity()) *
+                   sizeof(std::complex<float>) + bitrev.capacity() * sizeof(uint32_t);
+    }
+
+    // n real samples -> n/2 + 1 bins (DC .. Nyquist)
+    void forward(const float* in, std::complex<float>* out) {
+        for (size_t k = 0; k < m; ++k) buf[k] = { in[2 * k], in[2 * k + 1] };
+        transform(false);
+        // Split the packed even/odd spectra: X[k] = E[k] + W^k O[k]
+        for (size_t k = 0; k <= m; ++k) {
+            std::complex<float> a = buf[k == m ? 0 : k];
+            std::complex<float> b = std::conj(buf[k == 0 ? 0 : m - k]);
+            std::complex<float> even = 0.5f * (a + b);
+            std::complex<float> odd = std::complex<float>(0.0f, -0.5f) * (a - b);
+            out[k] = even + post[k] * odd;
+        }
+    }
+
+    // n/2 + 1 bins -> n real samples, including the 1/n scale (exact inverse of forward)
+    void inverse(const std::complex<float>* in, float* out) {
+        for (size_t k = 0; k < m; ++k) {
+            std::complex<float> a = in[k];
+            std::complex<float> b = std::conj(in[m - k]);
+            std::complex<float> even = 0.5f * (a + b);
+            std::complex<float> odd = 0.5f * (a - b) * std::conj(post[k]);
+            buf[k] = even + std::complex<float>(0.0f, 1.0f) * odd;
+        }
+        transform(true);
+        float scale = 1.0f / (float)m;
+        for (size_t k = 0; k < m; ++k) {
+            out[2 * k] = buf[k].real() * scale;
+            out[2 * k + 1] = buf[k].imag() * scale;
+        }
+    }
+
+private:
+    // In-place radix-2 complex FFT of buf (unscaled; conjugated twiddles when inverse)
+    void transform(bool inverse) {
+        const std::complex<float>* tw = inverse ? twiddleInv.data() : twiddle.data();
+        for (size_t i = 1; i < m; ++i) {
+            if (i < bitrev[i]) std::swap(buf[i], buf[bitrev[i]]);
+        }
+        for (size_t len = 2; len <= m; len <<= 1) {
+            size_t half = len / 2;
+            size_t step = m / len;
+            for (size_t i = 0; i < m; i += len) {
+                for (size_t j = 0; j < half; ++j) {
+                    const std::complex<float> w = tw[j * step];
+                    std::complex<float> u = buf[i + j];
+                    std::complex<float> v = buf[i + j + half] * w;
+                    buf[i + j] = u + v;
+                    buf[i + j + half] = u - v;
+                }
+            }
+        }
+    }
+
+    size_t n = 0;
+    size_t m = 0;
+    std::vector<std::complex<float>> buf;
+    std::vector<std::complex<float>> twiddle;
+    std::vector<std::complex<float>> twiddleInv;
+    std::vector<std::complex<float>> post;
+    std::vector<uint32_t> bitrev;
+};
+
+// RealFft over L signals at once. Signals and spectra are interleaved: sample i of
+// signal l at [i * L + l], bin k at [k * L + l] (separate real and imaginary arrays).
+// The twiddles are stored once per lane, so each butterfly group of a stage is one
+// contiguous loop over half * L values and vectorizes across the signals. The loops
+// sit in helpers with __restrict pointers: they touch up to six arrays, more than the
+// compiler will check for overlap at run time.
+template <size_t L>
+class LaneRealFft {
+public:
+    void init(size_t size) {
+        n = size;
+        m = size / 2;
+        bufRe.assign(m * L, 0.0f);
+        bufIm.assign(m * L, 0.0f);
+        bitrev.assign(m, 0);
+        for (size_t i = 1, j = 0; i < m; ++i) {
+            size_t k = m >> 1;
+            for (; j & k; k >>= 1) j ^= k;
+            j ^= k;
+            bitrev[i] = (uint32_t)j;
+        }
+        const float pi = 3.14159265358979323846f;
+        // Stage with butterfly span len: half = len / 2 twiddles, at offset half - 1
+        twRe.assign(m > 1 ? (m - 1) * L : L, 0.0f);
+        twIm.assign(twRe.size(), 0.0f);
+        twImInv.assign(twRe.size(), 0.0f);
+        for (size_t len = 2; len <= m; len <<= 1) {
+            size_t half = len / 2;
+            for (size_t j = 0; j < half; ++j) {
+                float a = -2.0f * pi * (float)j / (float)len;
+                for (size_t l = 0; l < L; ++l) {
+                    twRe[(half - 1 + j) * L + l] = std::cos(a);
+                    twIm[(half - 1 + j) * L + l] = std::sin(a);
+                    twImInv[(half - 1 + j) * L + l] = -std::sin(a);
+                }
+            }
+        }
+        postRe.resize(m + 1);
+        postIm.resize(m + 1);
+        for (size_t k = 0; k <= m; ++k) {
+            float a = -2.0f * pi * (float)k / (float)n;
+            postRe[k] = std::cos(a);
+            postIm[k] = std::sin(a);
+        }
+    }
+
+    size_t size() const { return n; }
+    size_t bins() const { return m + 1; }
+
+    // n real samples per signal -> n/2 + 1 bins (DC .. Nyquist)
+    void forward(const float* in, float* re, float* im) {
+        for (size_t k = 0; k < m; ++k) {
+            std::copy(in + 2 * k * L, in + (2 * k + 1) * L, &bufRe[k * L]);
+            std::copy(in + (2 * k + 1) * L, in + (2 * k + 2) * L, &bufIm[k * L]);
+        }
+        transform(false);
+        for (size_t k = 0; k <= m; ++k) {
+            size_t a = k == m ? 0 : k;
+            size_t b = k == 0 ? 0 : m - k;
+            splitBins(&bufRe[a * L], &bufIm[a * L], &bufRe[b * L], &bufIm[b * L], postRe[k], postIm[k],
+                      re + k * L, im + k * L);
+        }
+    }
+
+    // n/2 + 1 bins per signal -> n real samples, including the 1/n scale
+    void inverse(const float* re, const float* im, float* out) {
+        for (size_t k = 0; k < m; ++k) {
+            mergeBins(re + k * L, im + k * L, re + (m - k) * L, im + (m - k) * L, postRe[k], postIm[k],
+                      &bufRe[k * L], &bufIm[k * L]);
+        }
+        transform(true);
+        const float scale = 1.0f / (float)m;
+        for (size_t k = 0; k < m; ++k) {
+            scaleOut(&bufRe[k * L], &bufIm[k * L], scale, out + 2 * k * L, out + (2 * k + 1) * L);
+        }
+    }
+
+private:
+    // X[k] = E[k] + W^k O[k] from a = buf[k], b = conj(buf[m - k]):
+    // even = (a + b) / 2, odd = -i (a - b) / 2
+    static void splitBins(const float* __restrict ar, const float* __restrict ai,
+                          const float* __restrict br, const float* __restrict bi, float pr, float pi,
+                          float* __restrict outRe, float* __restrict outIm) {
+        for (size_t l = 0; l < L; ++l) {
+            float er = 0.5f * (ar[l] + br[l]), ei = 0.5f * (ai[l] - bi[l]);
+            float orr = 0.5f * (ai[l] + bi[l]), oi = -0.5f * (ar[l] - br[l]);
+            outRe[l] = er + pr * orr - pi * oi;
+            outIm[l] = ei + pr * oi + pi * orr;
+        }
+    }
+
+    // Inverse of splitBins: a = in[k], b = conj(in[m - k]); buf = even + i odd with
+    // odd = (a - b) conj(post[k]) / 2
+    static void mergeBins(const float* __restrict ar, const float* __restrict ai,
+                          const float* __restrict br, const float* __restrict bi, float pr, float pi,
+                          float* __restrict xr, float* __restrict xi) {
+        for (size_t l = 0; l < L; ++l) {
+            float er = 0.5f * (ar[l] + br[l]), ei = 0.5f * (ai[l] - bi[l]);
+            float dr = ar[l] - br[l], di = ai[l] + bi[l];
+            float orr = 0.5f * (dr * pr + di * pi), oi = 0.5f * (di * pr - dr * pi);
+            xr[l] = er - oi;
+            xi[l] = ei + orr;
+        }
+    }
+
+    static void scaleOut(const float* __restrict xr, const float* __restrict xi, float scale,
+                         float* __restrict even, float* __restrict odd) {
+        for (size_t l = 0; l < L; ++l) {
+            even[l] = xr[l] * scale;
+            odd[l] = xi[l] * scale;
+        }
+    }
+
+    // u, v = u + w v, u - w v over one butterfly group (u and v do not overlap)
+    static void butterflies(float* __restrict ur, float* __restrict ui, float* __restrict vr,
+                            float* __restrict vi, const float* __restrict wr, const float* __restrict wi,
+                            size_t span) {
+        for (size_t t = 0; t < span; ++t) {
+            float tr = vr[t] * wr[t] - vi[t] * wi[t];
+            float ti = vr[t] * wi[t] + vi[t] * wr[t];
+            vr[t] = ur[t] - tr;
+            vi[t] = ui[t] - ti;
+            ur[t] += tr;
+            ui[t] += ti;
+        }
+    }
+
+    // In-place radix-2 complex FFT of buf (unscaled; conjugated twiddles when inverse)
+    void transform(bool inverse) {
+        float* xr = bufRe.data();
+        float* xi = bufIm.data();
+        for (size_t i = 1; i < m; ++i) {
+            size_t j = bitrev[i];
+            if (i < j) {
+                std::swap_ranges(xr + i * L, xr + (i + 1) * L, xr + j * L);
+                std::swap_ranges(xi + i * L, xi + (i + 1) * L, xi + j * L);
+            }
+        }
+        const std::vector<float>& twI = inverse ? twImInv : twIm;
+        for (size_t len = 2; len <= m; len <<= 1) {
+            const size_t half = len / 2;
+            const size_t span = half * L;
+            const float* wr = &twRe[(half - 1) * L];
+            const float* wi = &twI[(half - 1) * L];
+            for (size_t i = 0; i < m; i += len) {
+                butterflies(xr + i * L, xi + i * L, xr + i * L + span, xi + i * L + span, wr, wi, span);
+            }
+        }
+    }
+
+    size_t n = 0;
+    size_t m = 0;
+    std::vector<float> bufRe;
+    std::vector<float> bufIm;
+    std::vector<float> twRe;         // Per stage and lane (see init)
+    std::vector<float> twIm;
+    std::vector<float> twImInv;
+    std::vector<float> postRe;
+    std::vector<float> postIm;
+    std::vector<uint32_t> bitrev;
+};
@@ -0,0 +1,45 @@
+#include "FractionalDelay.h"
+#include <cmath>
+
+static const int kPhases = 64;
+static const int kTaps = 2 * FractionalDelay::kHalfTaps;
+
+FractionalDelay::FractionalDelay() {
+    const double pi = 3.14159265358979323846;
+    table.assign((size_t)(kPhases + 1) * kTaps, 0.0f);
+    for (int p = 0; p <= kPhases; ++p) {
+        double f = (double)p / (double)kPhases;
+        // Tap j weighs sample floor(pos) - kHalfTaps + 1 + j
+        for (int j = 0; j < kTaps; ++j) {
+            double x = (double)(j - kHalfTaps + 1) - f;
+            double sinc = std::fabs(x) < 1e-9 ? 1.0 : std::sin(pi * x) / (pi * x);
+            double u = (x + kHalfTaps) / (2.0 * kHalfTaps); // Window over [-kHalfTaps, kHalfTaps]
+            double w = 0.42 - 0.5 * std::cos(2.0 * pi * u) + 0.08 * std::cos(4.0 * pi * u);
+            table[(size_t)p * kTaps + j] = (float)(sinc * w);
+        }
+    }
+}
+
+float FractionalDelay::read(const float* buf, size_t cap, double pos) const {
+    double base = std::floor(pos);
+    double ph = (pos - base) * (double)kPhases;
+    int p = (int)ph;
+    if (p >= kPhases) p = kPhases - 1;
+    float a = (float)(ph - (double)p);
+    const float* h0 = table.data() + (size_t)p * kTaps;
+    const float* h1 = h0 + kTaps;
+
+    long start = (long)base - kHalfTaps + 1;
+    if (start < 0) start += (long)cap;
+    float sum = 0.0f;
+    if ((size_t)start + kTaps <= cap) {
+        const float* x = buf + start;
+        for (int j = 0; j < kTaps; ++j) sum += (h0[j] + a * (h1[j] - h0[j])) * x[j];
+    } else {
+        for (int j = 0; j < kTaps; ++j) {
+            size_t idx = ((size_t)start + (size_t)j) % cap;
+            sum += (h0[j] + a * (h1[j] - h0[j])) * buf[idx];
+        }
+    }
+    return sum;
+}
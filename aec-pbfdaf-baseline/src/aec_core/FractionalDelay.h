@@ -0,0 +1,21 @@
+#pragma once
+// Band-limited fractional-delay read from a ring buffer: 16-tap Blackman-windowed
+// sinc, tabulated in 64 phases with linear interpolation between neighbouring
+// phases. At a whole-sample position it returns that sample exactly.
+
+#include <vector>
+#include <cstddef>
+
+class FractionalDelay {
+public:
+    static const int kHalfTaps = 8;   // Samples needed on each side of the read position
+
+    FractionalDelay();
+    // Value of ring 'buf' (capacity cap) at index pos, 0 <= pos < cap
+    float read(const float* buf, size_t cap, double pos) const;
+    // Heap memory held
+    size_t memoryBytes() const { return table.capacity() * sizeof(float); }
+
+private:
+    std::vector<float> table; // kPhases + 1 rows of 2 * kHalfTaps taps
+};
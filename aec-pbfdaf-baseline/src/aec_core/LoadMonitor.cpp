@@ -0,0 +1,110 @@
+#include "LoadMonitor.h"
+#include <cmath>
+#include <cstring>
+
+static const double kRtfTimeConstantNs = 1.0e9; // ~1 s smoothing for the moving RTF
+
+LoadMonitor::LoadMonitor() : sampleRate(0), rtfSmoothed(0.0) {
+    statsSeq.store(0);
+    atomicBudgetUs.store(0.0f);
+    std::memset(&statsBuf, 0, sizeof(statsBuf));
+    std::memset(hist, 0, sizeof(hist));
+}
+
+void LoadMonitor::reset(int sr) {
+    uint32_t seq = statsSeq.load(std::memory_order_relaxed);
+    statsSeq.store(seq + 1, std::memory_order_release);
+
+    sampleRate = sr;
+    rtfSmoothed = 0.0;
+    std::memset(&statsBuf, 0, sizeof(statsBuf));
+    std::memset(hist, 0, sizeof(hist));
+
+    statsSeq.store(seq + 2, std::memory_order_release);
+}
+
+void LoadMonitor::setBudgetUs(float us) { atomicBudgetUs.store(us > 0.0f ? us : 0.0f); }
+
+int LoadMonitor::binIndex(double ns) {
+    if (ns < 1.0) return 0;
+    int exp = 0;
+    double mant = std::frexp(ns, &exp); // ns = mant * 2^exp, mant in [0.5, 1)
+    int bin = (exp - 1) * kBinsPerOctave + (int)((mant * 2.0 - 1.0) * kBinsPerOctave);
+    if (bin < 0) bin = 0;
+    if (bin >= kNumBins) bin = kNumBins - 1;
+    return bin;
+}
+
+double LoadMonitor::binCenterNs(int bin) {
+    int octave = bin / kBinsPerOctave;
+    int sub = bin % kBinsPerOctave;
+    return std::ldexp(1.0 + ((double)sub + 0.5) / (double)kBinsPerOctave, octave);
+}
+
+void LoadMonitor::begin() {
+    t0 = std::chrono::steady_clock::now();
+}
+
+void LoadMonitor::end(size_t frames) {
+    auto t1 = std::chrono::steady_clock::now();
+    double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+    double audioNs = sampleRate > 0 ? (double)frames * 1.0e9 / (double)sampleRate : 0.0;
+
+    float budgetUs = atomicBudgetUs.load(std::memory_order_relaxed);
+    double deadlineNs = budgetUs > 0.0f ? (double)budgetUs * 1000.0 : audioNs;
+
+    // Time-weighted EWMA so the window is ~1 s of audio regardless of call size
+    double callRtf = audioNs > 0.0 ? ns / audioNs : 0.0;
+    if (audioNs > 0.0) {
+        double a = audioNs / (audioNs + kRtfTimeConstantNs);
+        rtfSmoothed = statsBuf.calls == 0 ? callRtf : (1.0 - a) * rtfSmoothed + a * callRtf;
+    }
+
+    uint32_t seq = statsSeq.load(std::memory_order_relaxed);
+    statsSeq.store(seq + 1, std::memory_order_release);
+
+    hist[binIndex(ns)]++;
+    statsBuf.calls++;
+    statsBuf.frames += frames;
+    if (deadlineNs > 0.0 && ns > deadlineNs) statsBuf.deadlineMisses++;
+    statsBuf.lastUs = (float)(ns * 1e-3);
+    if (statsBuf.lastUs > statsBuf.maxUs) statsBuf.maxUs = statsBuf.lastUs;
+    if ((float)callRtf > statsBuf.peakRtf) statsBuf.peakRtf = (float)callRtf;
+    statsBuf.rtf = (float)rtfSmoothed;
+    statsBuf.budgetUs = budgetUs;
+
+    statsSeq.store(seq + 2, std::memory_order_release);
+}
+
+AECLoadStats LoadMonitor::getStats() const {
+    AECLoadStats s;
+    uint32_t h[kNumBins];
+    uint32_t seq;
+    do {
+        seq = statsSeq.load(std::memory_order_acquire);
+        s = statsBuf;
+        std::memcpy(h, hist, sizeof(h));
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while (seq % 2 != 0 || seq != statsSeq.load(std::memory_order_relaxed));
+
+    // Percentiles from the histogram (~4% resolution)
+    s.p50Us = 0.0f;
+    s.p99Us = 0.0f;
+    if (s.calls > 0) {
+        uint64_t total = 0;
+        for (int i = 0; i < kNumBins; ++i) total += h[i];
+        uint64_t r50 = (total * 50 + 99) / 100;
+        uint64_t r99 = (total * 99 + 99) / 100;
+        uint64_t cum = 0;
+        bool got50 = false;
+        for (int i = 0; i < kNumBins; ++i) {
+            cum += h[i];
+            if (!got50 && cum >= r50) { s.p50Us = (float)(binCenterNs(i) * 1e-3); got50 = true; }
+            if (cum >= r99) { s.p99Us = (float)(binCenterNs(i) * 1e-3); break; }
+        }
+        // The histogram bin can overshoot the true worst case
+        if (s.p50Us > s.maxUs) s.p50Us = s.maxUs;
+        if (s.p99Us > s.maxUs) s.p99Us = s.maxUs;
+    }
+    return s;
+}
@@ -0,0 +1,65 @@
+#pragma once
+// Real-time load monitor: measures the wall-clock cost of each processing call
+// against the audio time it covers. Timing and publication are allocation-free;
+// statistics are published lock-free with the same sequence scheme as AECStats.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+struct AECLoadStats {
+    float rtf;          // Moving real-time factor (processing time / audio time, ~1 s window)
+    float peakRtf;      // Worst single-call real-time factor
+    float p50Us;        // Median time per call
+    float p99Us;        // 99th percentile time per call
+    float maxUs;        // Worst-case time per call
+    float lastUs;       // Time of the most recent call
+    float budgetUs;     // Deadline budget (0 = audio duration of each call)
+    uint64_t calls;
+    uint64_t deadlineMisses;
+    uint64_t frames;
+};
+
+class LoadMonitor {
+public:
+    LoadMonitor();
+    void reset(int sampleRate);
+
+    // Per-call deadline. <= 0 means "the audio duration of the call".
+    void setBudgetUs(float us);
+
+    void begin();
+    void end(size_t frames);
+
+    // Thread-safe stats getter
+    AECLoadStats getStats() const;
+
+    // RAII helper around begin()/end()
+    class Scope {
+    public:
+        Scope(LoadMonitor& m, size_t frames) : mon(m), n(frames) { mon.begin(); }
+        ~Scope() { mon.end(n); }
+    private:
+        LoadMonitor& mon;
+        size_t n;
+    };
+
+private:
+    // Log-spaced histogram: 8 bins per octave of nanoseconds, up to ~17 s
+    static const int kBinsPerOctave = 8;
+    static const int kOctaves = 34;
+    static const int kNumBins = kBinsPerOctave * kOctaves;
+
+    static int binIndex(double ns);
+    static double binCenterNs(int bin);
+
+    int sampleRate;
+    std::chrono::steady_clock::time_point t0;
+    double rtfSmoothed;
+
+    std::atomic<uint32_t> statsSeq;
+    std::atomic<float> atomicBudgetUs;
+    AECLoadStats statsBuf;
+    uint32_t hist[kNumBins];
+};
@@ -0,0 +1,32 @@
+#include "SpectralGain.h"
+#include <algorithm>
+#include <cmath>
+
+static const float kNoiseAdapt = 0.1f;
+static const float kFloorGain = 0.1f;
+static const float kNoiseInit = 1e-3f;
+
+void SpectralGain::initialize(size_t bins) {
+    noise.assign(bins, kNoiseInit);
+}
+
+void SpectralGain::apply(std::complex<float>* spec) {
+    // Interleaved (re, im) floats; branch-free so the compiler vectorizes it
+    float* s = reinterpret_cast<float*>(spec);
+    float* n = noise.data();
+    size_t bins = noise.size();
+    for (size_t k = 0; k < bins; ++k) {
+        float re = s[2 * k];
+        float im = s[2 * k + 1];
+        float s2 = re * re + im * im;
+        float mag = std::sqrt(s2);
+        float nEst = n[k];
+        // Tracks the magnitude downwards only: the blend is below nEst exactly when mag is
+        n[k] = std::min(nEst, kNoiseAdapt * mag + (1.0f - kNoiseAdapt) * nEst);
+        float n2 = nEst * nEst;
+        float h = s2 / (s2 + n2 + 1e-12f);
+        float g = kFloorGain + (1.0f - kFloorGain) * h;
+        s[2 * k] = re * g;
+        s[2 * k + 1] = im * g;
+    }
+}
@@ -0,0 +1,20 @@
+#pragma once
+// Noise-suppression gain shared by AIEnhancer and the fused AEC stage: Wiener-style
+// gain against a minimum-tracking noise magnitude estimate, with a gain floor. Spectra
+// are the DC .. Nyquist bins of 512-point Hann-windowed frames at a 256-sample hop.
+
+#include <vector>
+#include <complex>
+#include <cstddef>
+
+class SpectralGain {
+public:
+    void initialize(size_t bins);
+    // In place; real-time safe
+    void apply(std::complex<float>* spec);
+    size_t bins() const { return noise.size(); }
+    size_t memoryBytes() const { return noise.capacity() * sizeof(float); }
+
+private:
+    std::vector<float> noise; // Noise magnitude per bin
+};
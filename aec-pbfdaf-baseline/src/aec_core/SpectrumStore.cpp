@@ -0,0 +1,94 @@
+#include "SpectrumStore.h"
+#include <algorithm>
+
+const char* spectrumPrecisionName(SpectrumPrecision p) {
+    switch (p) {
+    case SpectrumPrecision::Float16: return "fp16";
+    case SpectrumPrecision::BFloat16: return "bf16";
+    default: return "f32";
+    }
+}
+
+bool parseSpectrumPrecision(const std::string& name, SpectrumPrecision& p) {
+    if (name == "f32") p = SpectrumPrecision::Float32;
+    else if (name == "fp16") p = SpectrumPrecision::Float16;
+    else if (name == "bf16") p = SpectrumPrecision::BFloat16;
+    else return false;
+    return true;
+}
+
+SpectrumStore::SpectrumStore() : prec(SpectrumPrecision::Float32), count(0), len(0), head(0) {}
+
+void SpectrumStore::init(size_t n, size_t bins, SpectrumPrecision p) {
+    prec = p;
+    count = n;
+    len = bins;
+    head = 0;
+    // Only the vector in use holds memory
+    if (prec == SpectrumPrecision::Float32) {
+        full.assign(count * len, {0.0f, 0.0f});
+        std::vector<uint16_t>().swap(packed);
+    } else {
+        packed.assign(2 * count * len, 0);
+        std::vector<std::complex<float>>().swap(full);
+    }
+}
+
+size_t SpectrumStore::memoryBytes() const {
+    return full.capacity() * sizeof(full[0]) + packed.capacity() * sizeof(packed[0]);
+}
+
+void SpectrumStore::clear() {
+    // +0.0 is all zero bits in the three formats
+    std::fill(full.begin(), full.end(), std::complex<float>(0.0f, 0.0f));
+    std::fill(packed.begin(), packed.end(), (uint16_t)0);
+}
+
+void* SpectrumStore::data(size_t i) {
+    if (prec == SpectrumPrecision::Float32) return full.data() + slot(i) * len;
+    return packed.data() + slot(i) * 2 * len;
+}
+
+const void* SpectrumStore::data(size_t i) const {
+    if (prec == SpectrumPrecision::Float32) return full.data() + slot(i) * len;
+    return packed.data() + slot(i) * 2 * len;
+}
+
+void SpectrumStore::read(size_t i, std::complex<float>* dst) const {
+    if (prec == SpectrumPrecision::Float32) {
+        const std::complex<float>* src = full.data() + slot(i) * len;
+        std::copy(src, src + len, dst);
+        return;
+    }
+    const uint16_t* src = packed.data() + slot(i) * 2 * len;
+    float* d = reinterpret_cast<float*>(dst);
+    if (prec == SpectrumPrecision::Float16) {
+        for (size_t k = 0; k < 2 * len; ++k) d[k] = halfToFloat(src[k]);
+    } else {
+        for (size_t k = 0; k < 2 * len; ++k) d[k] = bf16ToFloat(src[k]);
+    }
+}
+
+void SpectrumStore::write(size_t i, const std::complex<float>* src) {
+    if (prec == SpectrumPrecision::Float32) {
+        std::copy(src, src + len, full.data() + slot(i) * len);
+        return;
+    }
+    uint16_t* dst = packed.data() + slot(i) * 2 * len;
+    const float* s = reinterpret_cast<const float*>(src);
+    if (prec == SpectrumPrecision::Float16) {
+        for (size_t k = 0; k < 2 * len; ++k) dst[k] = floatToHalf(s[k]);
+    } else {
+        for (size_t k = 0; k < 2 * len; ++k) dst[k] = floatToBf16(s[k]);
+    }
+}
+
+const std::complex<float>* SpectrumStore::view(size_t i, std::complex<float>* scratch) const {
+    if (prec == SpectrumPrecision::Float32) return full.data() + slot(i) * len;
+    read(i, scratch);
+    return scratch;
+}
+
+void SpectrumStore::rotate() {
+    if (count > 0) head = slot(count - 1);
+}
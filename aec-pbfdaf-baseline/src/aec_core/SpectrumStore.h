@@ -0,0 +1,101 @@
+#pragma once
+// Storage for the PBFDAF partition spectra in float or a 16-bit format. The half-width
+// formats halve the memory of the reference history and weights and the bandwidth of
+// the per-bin loops over them; all arithmetic stays in float (values are widened on
+// load and rounded to nearest-even on store).
+//   Float16:  IEEE binary16, 11-bit significand, range 6.1e-5 .. 65504 (no subnormals)
+//   BFloat16: the upper half of a float, 8-bit significand, full float range
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+enum class SpectrumPrecision { Float32, Float16, BFloat16 };
+
+// "f32", "fp16", "bf16" (command-line options)
+const char* spectrumPrecisionName(SpectrumPrecision p);
+bool parseSpectrumPrecision(const std::string& name, SpectrumPrecision& p);
+
+// Branch-free conversions (the kernels rely on them vectorizing)
+static inline float halfToFloat(uint16_t h) {
+    // Exponent and significand into float position, rebiased by a multiply (also
+    // normalizes the subnormals)
+    uint32_t bits = (uint32_t)(h & 0x7fffu) << 13;
+    float f;
+    memcpy(&f, &bits, 4);
+    f *= 0x1p112f;
+    memcpy(&bits, &f, 4);
+    if ((h & 0x7c00u) == 0x7c00u) bits |= 0x7f800000u; // Inf, NaN
+    bits |= (uint32_t)(h & 0x8000u) << 16;
+    memcpy(&f, &bits, 4);
+    return f;
+}
+
+// Integer-only, with every case computed and one selected, so the loops stay
+// branch-free. Magnitudes below 2^-14 (6.1e-5, the subnormal range) are stored as
+// zero: rounding them needs a float add the compiler will not speculate.
+static inline uint16_t floatToHalf(float f) {
+    uint32_t x;
+    memcpy(&x, &f, 4);
+    uint32_t sign = (x >> 16) & 0x8000u;
+    x &= 0x7fffffffu;
+    // Rebias, round to nearest even
+    uint32_t normal = (x + 0xc8000fffu + ((x >> 13) & 1u)) >> 13;
+    // 65536 and above, Inf, NaN
+    uint32_t big = x > 0x7f800000u ? 0x7e00u : 0x7c00u;
+    uint32_t o = x < 0x38800000u ? 0u : (x >= 0x47800000u ? big : normal);
+    return (uint16_t)(o | sign);
+}
+
+static inline float bf16ToFloat(uint16_t h) {
+    uint32_t bits = (uint32_t)h << 16;
+    float f;
+    memcpy(&f, &bits, 4);
+    return f;
+}
+
+static inline uint16_t floatToBf16(float f) {
+    uint32_t x;
+    memcpy(&x, &f, 4);
+    uint32_t rounded = (x + 0x7fffu + ((x >> 16) & 1u)) >> 16;
+    uint32_t nan = (x >> 16) | 0x40u; // Stays NaN
+    return (uint16_t)((x & 0x7fffffffu) > 0x7f800000u ? nan : rounded);
+}
+
+// count spectra of bins complex values, stored as (re, im) pairs in the chosen
+// precision. The spectra sit in a ring of slots, so rotate() (the history shift)
+// moves no data. Real-time safe after init.
+class SpectrumStore {
+public:
+    SpectrumStore();
+    void init(size_t count, size_t bins, SpectrumPrecision p);
+    SpectrumPrecision precision() const { return prec; }
+    size_t size() const { return count; }
+    size_t bins() const { return len; }
+    // Heap memory held
+    size_t memoryBytes() const;
+
+    void clear();
+    // Spectrum i in the storage format: float or uint16_t (re, im) pairs
+    void* data(size_t i);
+    const void* data(size_t i) const;
+    void read(size_t i, std::complex<float>* dst) const;
+    void write(size_t i, const std::complex<float>* src);
+    // Spectrum i as floats: in place with Float32, else decoded into scratch (bins values)
+    const std::complex<float>* view(size_t i, std::complex<float>* scratch) const;
+    // Spectrum count - 1 becomes spectrum 0 (keeping its old values), the others move up one
+    void rotate();
+
+private:
+    size_t slot(size_t i) const { size_t s = head + i; return s >= count ? s - count : s; }
+
+    SpectrumPrecision prec;
+    size_t count;
+    size_t len;
+    size_t head;
+    std::vector<std::complex<float>> full;
+    std::vector<uint16_t> packed;
+};
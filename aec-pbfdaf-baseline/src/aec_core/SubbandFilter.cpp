@@ -0,0 +1,122 @@
+#include "SubbandFilter.h"
+#include <cmath>
+#include <algorithm>
+
+// Blackman-windowed sinc with the 6 dB point below the 8 kHz low-band Nyquist; the
+// transition (~1.8 kHz at 24 taps per decimation step per side) ends near 8 kHz, so
+// little aliases into the band the canceller models.
+static const float kCutoffHz = 7100.0f;
+static const int kHalfTapsPerStep = 24;
+
+bool SubbandFilter::supported(int sampleRate) {
+    return sampleRate > kLowRate && sampleRate % kLowRate == 0 && sampleRate / kLowRate <= 3;
+}
+
+SubbandFilter::SubbandFilter() : decim(1), halfLen(0), polyLen(0), micDelayIdx(0), anaPhase(0), synPhase(0) {}
+
+void SubbandFilter::History::init(size_t n) {
+    len = n;
+    buf.assign(2 * n, 0.0f);
+    pos = 0;
+}
+
+void SubbandFilter::History::push(float v) {
+    pos = (pos + len - 1) % len;
+    buf[pos] = v;
+    buf[pos + len] = v;
+}
+
+float SubbandFilter::dot(const float* a, const float* b, size_t n) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < n; ++i) sum += a[i] * b[i];
+    return sum;
+}
+
+void SubbandFilter::initialize(int sampleRate) {
+    decim = supported(sampleRate) ? sampleRate / kLowRate : 1;
+    halfLen = kHalfTapsPerStep * decim;
+    int len = 2 * halfLen + 1;
+
+    const double pi = 3.14159265358979323846;
+    double fc = (double)kCutoffHz / (double)sampleRate;
+    taps.assign(len, 0.0f);
+    double sum = 0.0;
+    for (int i = 0; i < len; ++i) {
+        double t = (double)(i - halfLen);
+        double sinc = t == 0.0 ? 2.0 * fc : std::sin(2.0 * pi * fc * t) / (pi * t);
+        double w = 0.42 - 0.5 * std::cos(2.0 * pi * i / (len - 1)) + 0.08 * std::cos(4.0 * pi * i / (len - 1));
+        taps[i] = (float)(sinc * w);
+        sum += taps[i];
+    }
+    for (auto& v : taps) v = (float)(v / sum);
+
+    // Branch q holds taps q, q + decim, ...: the output q samples after a low-band sample
+    polyLen = (size_t)(len + decim - 1) / decim;
+    poly.assign((size_t)decim * polyLen, 0.0f);
+    for (int q = 0; q < decim; ++q) {
+        for (size_t m = 0; m < polyLen; ++m) {
+            size_t i = (size_t)q + m * decim;
+            if (i < (size_t)len) poly[q * polyLen + m] = (float)decim * taps[i];
+        }
+    }
+
+    micIn.init(len);
+    refIn.init(len);
+    micLow.init(polyLen);
+    outLow.init(polyLen);
+    micDelay.assign(2 * halfLen, 0.0f);
+    micDelayIdx = 0;
+    anaPhase = 0;
+    synPhase = 0;
+}
+
+size_t SubbandFilter::lowCount(size_t frames) const {
+    return ((size_t)anaPhase + frames) / (size_t)decim;
+}
+
+float SubbandFilter::interpolate(History& h, int phase) const {
+    return dot(poly.data() + (size_t)phase * polyLen, h.view(), polyLen);
+}
+
+size_t SubbandFilter::analyze(const float* mic, const float* ref, size_t frames,
+                              float* lowMic, float* lowRef, float* highMic) {
+    size_t nLow = 0;
+    int phase = anaPhase;
+    for (size_t i = 0; i < frames; ++i) {
+        micIn.push(mic[i]);
+        refIn.push(ref[i]);
+        // Only every decim-th output of the decimation filter is computed
+        if (++phase == decim) {
+            phase = 0;
+            lowMic[nLow] = dot(taps.data(), micIn.view(), taps.size());
+            lowRef[nLow] = dot(taps.data(), refIn.view(), taps.size());
+            micLow.push(lowMic[nLow]);
+            nLow++;
+        }
+        // High band: the input delayed like the low band, minus the low band
+        float delayed = micDelay[micDelayIdx];
+        micDelay[micDelayIdx] = mic[i];
+        micDelayIdx = (micDelayIdx + 1) % micDelay.size();
+        highMic[i] = delayed - interpolate(micLow, phase);
+    }
+    anaPhase = phase;
+    return nLow;
+}
+
+void SubbandFilter::synthesize(const float* low, float* out, size_t frames) {
+    int phase = synPhase;
+    for (size_t i = 0; i < frames; ++i) {
+        if (++phase == decim) {
+            phase = 0;
+            outLow.push(*low++);
+        }
+        out[i] = interpolate(outLow, phase);
+    }
+    synPhase = phase;
+}
+
+size_t SubbandFilter::memoryBytes() const {
+    size_t n = taps.capacity() + poly.capacity() + micDelay.capacity() + micIn.buf.capacity() +
+               refIn.buf.capacity() + micLow.buf.capacity() + outLow.buf.capacity();
+    return n * sizeof(float);
+}
@@ -0,0 +1,56 @@
+#pragma once
+// Two-band split of a 32 or 48 kHz stream for subband echo cancellation. The low
+// band (0-8 kHz) is decimated to 16 kHz with a polyphase linear-phase FIR; the high
+// band is the complement (delayed input minus the reconstructed low band), so with
+// an untouched low band, low + high reproduce the input exactly, delayed by delay().
+// Real-time safe after initialize.
+
+#include <vector>
+#include <cstddef>
+
+class SubbandFilter {
+public:
+    static const int kLowRate = 16000;
+    // Rates that split into an integer number of 16 kHz low-band samples
+    static bool supported(int sampleRate);
+
+    SubbandFilter();
+    void initialize(int sampleRate);
+    int factor() const { return decim; }
+    // Full-rate delay of analysis + synthesis (both bands)
+    int delay() const { return 2 * halfLen; }
+    // Low-band samples produced by the next 'frames' input samples
+    size_t lowCount(size_t frames) const;
+
+    // mic/ref -> low-band mic/ref (lowCount(frames) samples) and the full-rate mic high band
+    size_t analyze(const float* mic, const float* ref, size_t frames,
+                   float* lowMic, float* lowRef, float* highMic);
+    // Low band back to full rate; consumes the low samples analyze() produced for 'frames'
+    void synthesize(const float* low, float* out, size_t frames);
+    // Heap memory held
+    size_t memoryBytes() const;
+
+private:
+    struct History {
+        std::vector<float> buf; // Doubled ring: [pos, pos + len) is newest-first
+        size_t pos = 0;
+        size_t len = 0;
+        void init(size_t n);
+        void push(float v);
+        const float* view() const { return buf.data() + pos; }
+    };
+    static float dot(const float* a, const float* b, size_t n);
+    float interpolate(History& h, int phase) const;
+
+    int decim;
+    int halfLen;
+    std::vector<float> taps;   // Decimation prototype, unit DC gain
+    std::vector<float> poly;   // Interpolation branches: decim rows of polyLen taps (gain decim)
+    size_t polyLen;
+    History micIn, refIn;      // Full-rate analysis histories
+    History micLow, outLow;    // Low-rate synthesis histories (mic reconstruction, output)
+    std::vector<float> micDelay; // Ring aligning the input with its low-band reconstruction
+    size_t micDelayIdx;
+    int anaPhase;              // Input samples since the last low-band sample
+    int synPhase;
+};
@@ -0,0 +1,218 @@
+#include "WasapiBackend.h"
+#include "DeviceUtil.h"
+#include "../audio_io/SampleConvert.h"
+#include <avrt.h>
+
+// How long mic frames wait for their loopback packet before the reference is
+// taken as silent (loopback packets are ~10 ms apart while something plays)
+static const int kHoldMs = 30;
+// Output the recorder queues while the disk is slow
+static const int kWriterQueueMs = 2000;
+
+static bool get_default_device(EDataFlow flow, IMMDevice** dev) {
+    IMMDeviceEnumerator* en = nullptr;
+    HRESULT hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL, IID_PPV_ARGS(&en));
+    if (FAILED(hr)) return false;
+    hr = en->GetDefaultAudioEndpoint(flow, eConsole, dev);
+    en->Release();
+    return SUCCEEDED(hr);
+}
+
+// Endpoint id string: stable across reboots, unlike the index or the display name
+static std::string device_id(IMMDevice* dev) {
+    LPWSTR id = nullptr;
+    if (FAILED(dev->GetId(&id)) || !id) return std::string();
+    int n = WideCharToMultiByte(CP_UTF8, 0, id, -1, nullptr, 0, nullptr, nullptr);
+    std::string s(n > 1 ? n - 1 : 0, '\0');
+    if (n > 1) WideCharToMultiByte(CP_UTF8, 0, id, -1, &s[0], n, nullptr, nullptr);
+    CoTaskMemFree(id);
+    return s;
+}
+
+// The recorder opens its file through the C runtime (ANSI code page path)
+static std::string ansi_path(const std::wstring& w) {
+    int n = WideCharToMultiByte(CP_ACP, 0, w.c_str(), (int)w.size(), nullptr, 0, nullptr, nullptr);
+    std::string s(n > 0 ? n : 0, '\0');
+    if (n > 0) WideCharToMultiByte(CP_ACP, 0, w.c_str(), (int)w.size(), &s[0], n, nullptr, nullptr);
+    return s;
+}
+
+WasapiBackend::WasapiBackend(int mic, int spk, int sampleRate, const std::wstring& out, WavOutputFormat fmt) :
+    micIndex(mic), spkIndex(spk), requestedRate(sampleRate), outPath(out), outFormat(fmt),
+    comInit(false), micDev(nullptr), spkDev(nullptr), micClient(nullptr), loopClient(nullptr),
+    micCap(nullptr), loopCap(nullptr), micFmt(nullptr), spkFmt(nullptr), micEvent(nullptr),
+    rate(0) {
+    mmTask[0] = mmTask[1] = nullptr;
+}
+
+WasapiBackend::~WasapiBackend() {
+    stop();
+}
+
+bool WasapiBackend::start(std::string& err) {
+    if (rate > 0) { err = "Backend already started"; return false; }
+    // The calling thread may already be in a COM apartment (a GUI thread); WASAPI
+    // interfaces are usable from the engine's threads either way
+    HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    comInit = SUCCEEDED(hr);
+
+    bool found = micIndex >= 0 ? GetDeviceByIndex(eCapture, micIndex, &micDev) : get_default_device(eCapture, &micDev);
+    if (!found) { err = "Capture device not found"; release(); return false; }
+    found = spkIndex >= 0 ? GetDeviceByIndex(eRender, spkIndex, &spkDev) : get_default_device(eRender, &spkDev);
+    if (!found) { err = "Render device not found"; release(); return false; }
+    micEndpoint = device_id(micDev);
+    spkEndpoint = device_id(spkDev);
+
+    if (FAILED(micDev->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr, (void**)&micClient)) ||
+        FAILED(spkDev->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr, (void**)&loopClient))) {
+        err = "Cannot activate audio client"; release(); return false;
+    }
+    if (FAILED(micClient->GetMixFormat(&micFmt)) || FAILED(loopClient->GetMixFormat(&spkFmt))) {
+        err = "Cannot get mix format"; release(); return false;
+    }
+    // Shared-mode mix formats are IEEE float (possibly wrapped in WAVE_FORMAT_EXTENSIBLE)
+    if (micFmt->wBitsPerSample != 32 || spkFmt->wBitsPerSample != 32 ||
+        (micFmt->wFormatTag != WAVE_FORMAT_IEEE_FLOAT && micFmt->wFormatTag != WAVE_FORMAT_EXTENSIBLE) ||
+        (spkFmt->wFormatTag != WAVE_FORMAT_IEEE_FLOAT && spkFmt->wFormatTag != WAVE_FORMAT_EXTENSIBLE)) {
+        err = "Mix format is not float"; release(); return false;
+    }
+    if (requestedRate > 0) {
+        micFmt->nSamplesPerSec = requestedRate;
+        spkFmt->nSamplesPerSec = requestedRate;
+        micFmt->nAvgBytesPerSec = requestedRate * micFmt->nBlockAlign;
+        spkFmt->nAvgBytesPerSec = requestedRate * spkFmt->nBlockAlign;
+    }
+
+    // Mic packets signal an event (no polling); the loopback stream is drained on
+    // each mic packet, as it only delivers packets while something is playing
+    REFERENCE_TIME dur = 10000000;
+    micEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    if (!micEvent ||
+        FAILED(micClient->Initialize(AUDCLNT_SHAREMODE_SHARED, AUDCLNT_STREAMFLAGS_EVENTCALLBACK, dur, 0, micFmt, nullptr)) ||
+        FAILED(micClient->SetEventHandle(micEvent)) ||
+        FAILED(loopClient->Initialize(AUDCLNT_SHAREMODE_SHARED, AUDCLNT_STREAMFLAGS_LOOPBACK, dur, 0, spkFmt, nullptr))) {
+        err = "Cannot initialize audio clients"; release(); return false;
+    }
+    if (FAILED(micClient->GetService(__uuidof(IAudioCaptureClient), (void**)&micCap)) ||
+        FAILED(loopClient->GetService(__uuidof(IAudioCaptureClient), (void**)&loopCap))) {
+        err = "Cannot get capture service"; release(); return false;
+    }
+
+    int sr = (int)micFmt->nSamplesPerSec;
+    if (!outPath.empty()) {
+        if (!writer.open(ansi_path(outPath), sr, 1, outFormat, kWriterQueueMs, err)) { release(); return false; }
+    }
+    // Packets are ~10 ms; one second of headroom keeps capture() allocation-free
+    jitter.reset(sr, 1000, kHoldMs);
+    mixBuf.assign(sr, 0.0f);
+    micGains.assign(micFmt->nChannels, 1.0f / (float)micFmt->nChannels);
+    spkGains.assign(spkFmt->nChannels, 1.0f / (float)spkFmt->nChannels);
+    micBuf.assign(sr, 0.0f);
+    spkBuf.assign(sr, 0.0f);
+
+    if (FAILED(micClient->Start()) || FAILED(loopClient->Start())) {
+        err = "Cannot start audio clients"; release(); return false;
+    }
+    rate = sr;
+    return true;
+}
+
+void WasapiBackend::stop() {
+    if (micClient) micClient->Stop();
+    if (loopClient) loopClient->Stop();
+    release();
+}
+
+void WasapiBackend::release() {
+    writer.close();
+    if (micCap) micCap->Release();
+    if (loopCap) loopCap->Release();
+    if (micFmt) CoTaskMemFree(micFmt);
+    if (spkFmt) CoTaskMemFree(spkFmt);
+    if (micClient) micClient->Release();
+    if (loopClient) loopClient->Release();
+    if (micDev) micDev->Release();
+    if (spkDev) spkDev->Release();
+    if (micEvent) CloseHandle(micEvent);
+    micCap = loopCap = nullptr;
+    micFmt = spkFmt = nullptr;
+    micClient = loopClient = nullptr;
+    micDev = spkDev = nullptr;
+    micEvent = nullptr;
+    if (comInit) CoUninitialize();
+    comInit = false;
+    rate = 0;
+}
+
+void WasapiBackend::threadStarted(bool captureThread) {
+    CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    DWORD taskIndex = 0;
+    mmTask[captureThread ? 0 : 1] = AvSetMmThreadCharacteristicsW(L"Pro Audio", &taskIndex);
+}
+
+void WasapiBackend::threadStopping(bool captureThread) {
+    HANDLE& task = mmTask[captureThread ? 0 : 1];
+    if (task) AvRevertMmThreadCharacteristics(task);
+    task = nullptr;
+    CoUninitialize();
+}
+
+// Downmixes one packet of a capture client into the jitter buffer
+bool WasapiBackend::drain(IAudioCaptureClient* cap, const WAVEFORMATEX* fmt, bool isRef) {
+    BYTE* data = nullptr; UINT32 frames = 0; DWORD flags = 0;
+    UINT64 devPos = 0, qpc = 0;
+    if (FAILED(cap->GetBuffer(&data, &frames, &flags, &devPos, &qpc))) return false;
+    bool silent = (flags & AUDCLNT_BUFFERFLAGS_SILENT) != 0;
+    if (frames > mixBuf.size()) frames = (UINT32)mixBuf.size();
+    if (!silent) downmix((const float*)data, (int)fmt->nChannels, isRef ? spkGains.data() : micGains.data(), mixBuf.data(), frames);
+    // QPC position is in 100 ns units
+    int64_t timeNs = (flags & AUDCLNT_BUFFERFLAGS_TIMESTAMP_ERROR) ? -1 : (int64_t)qpc * 100;
+    const float* x = silent ? nullptr : mixBuf.data();
+    if (isRef) jitter.pushRef(x, frames, timeNs, (int64_t)devPos);
+    else jitter.pushMic(x, frames, timeNs, (int64_t)devPos);
+    cap->ReleaseBuffer(frames);
+    return true;
+}
+
+int WasapiBackend::capture(const float** mic, const float** ref, int timeoutMs) {
+    UINT32 pkt = 0;
+    if (FAILED(micCap->GetNextPacketSize(&pkt))) return -1;
+    if (pkt == 0) {
+        DWORD w = WaitForSingleObject(micEvent, (DWORD)(timeoutMs > 0 ? timeoutMs : 0));
+        if (w == WAIT_FAILED) return -1;
+        if (FAILED(micCap->GetNextPacketSize(&pkt))) return -1;
+        if (pkt == 0) return 0;
+    }
+    // Both streams go through the jitter buffer, which aligns them on their
+    // timestamps; the loopback stream only delivers packets while something plays
+    while (pkt > 0) {
+        if (!drain(micCap, micFmt, false)) return -1;
+        if (FAILED(micCap->GetNextPacketSize(&pkt))) return -1;
+    }
+    UINT32 loopPkt = 0;
+    while (SUCCEEDED(loopCap->GetNextPacketSize(&loopPkt)) && loopPkt > 0) {
+        if (!drain(loopCap, spkFmt, true)) return -1;
+    }
+    size_t frames = jitter.pull(micBuf.data(), spkBuf.data(), micBuf.size());
+    *mic = micBuf.data();
+    *ref = spkBuf.data();
+    return (int)frames;
+}
+
+bool WasapiBackend::getJitterStats(JitterStats& s) const {
+    if (rate <= 0) return false;
+    s = jitter.getStats();
+    return true;
+}
+
+bool WasapiBackend::getWriterStats(AsyncWavStats& s) const {
+    if (outPath.empty()) return false;
+    s = writer.getStats();
+    return true;
+}
+
+bool WasapiBackend::render(const float* out, size_t frames) {
+    // Recording never blocks processing; a dropped block is counted by the writer
+    if (writer.isOpen()) writer.write(out, frames);
+    return true;
+}
@@ -0,0 +1,70 @@
+#pragma once
+// WASAPI device pair for RealtimeEngine: shared-mode mic capture (event driven)
+// plus loopback capture of the render endpoint as the reference, downmixed to
+// mono and aligned by a JitterBuffer on their QPC timestamps and device
+// positions. Processed output is recorded to a WAV file off the processing thread.
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <mmdeviceapi.h>
+#include <audioclient.h>
+#include <string>
+#include <vector>
+#include "../realtime/AudioBackend.h"
+
+class WasapiBackend : public AudioBackend {
+public:
+    // Index < 0: default endpoint. sampleRate <= 0: mix format rate.
+    WasapiBackend(int micIndex, int spkIndex, int sampleRate, const std::wstring& outPath,
+                  WavOutputFormat outFormat = WavOutputFormat::Int16);
+    ~WasapiBackend();
+
+    const char* name() const override { return "wasapi"; }
+    bool start(std::string& err) override;
+    void stop() override;
+    int sampleRate() const override { return rate; }
+    int capture(const float** mic, const float** ref, int timeoutMs) override;
+    bool render(const float* out, size_t frames) override;
+    void threadStarted(bool captureThread) override;
+    void threadStopping(bool captureThread) override;
+    std::string micId() const override { return micEndpoint; }
+    std::string refId() const override { return spkEndpoint; }
+    bool getJitterStats(JitterStats& s) const override;
+    bool getWriterStats(AsyncWavStats& s) const override;
+
+private:
+    WasapiBackend(const WasapiBackend&) = delete;
+    WasapiBackend& operator=(const WasapiBackend&) = delete;
+    void release();
+    bool drain(IAudioCaptureClient* cap, const WAVEFORMATEX* fmt, bool isRef);
+
+    int micIndex;
+    int spkIndex;
+    int requestedRate;
+    std::wstring outPath;
+    WavOutputFormat outFormat;
+
+    bool comInit;
+    IMMDevice* micDev;
+    IMMDevice* spkDev;
+    IAudioClient* micClient;
+    IAudioClient* loopClient;
+    IAudioCaptureClient* micCap;
+    IAudioCaptureClient* loopCap;
+    WAVEFORMATEX* micFmt;
+    WAVEFORMATEX* spkFmt;
+    HANDLE micEvent;
+    HANDLE mmTask[2];  // Scheduling class of the capture / processing thread
+
+    int rate;
+    std::string micEndpoint;
+    std::string spkEndpoint;
+    JitterBuffer jitter;
+    std::vector<float> mixBuf;
+    std::vector<float> micGains;  // Equal-weight mono downmix
+    std::vector<float> spkGains;
+    std::vector<float> micBuf;
+    std::vector<float> spkBuf;
+    AsyncWavWriter writer;
+};
@@ -1,79 +1,22 @@
 #include <windows.h>
 #include <mmdeviceapi.h>
-#include <audioclient.h>
-#include <avrt.h>
 #include <vector>
 #include <string>
 #include <cstdio>
-#include <cmath>
 #include "../aec_core/AECProcessor.h"
-#include "../aec_core/AIEnhancer.h"
+#include "../aec_core/EchoPathCache.h"
+#include "../realtime/RealtimeEngine.h"
+#include "WasapiBackend.h"
 #include "DeviceUtil.h"
-struct WavWriter {
-    HANDLE h;
-    DWORD dataBytes;
-    int sr;
-    int ch;
-    WavWriter() : h(INVALID_HANDLE_VALUE), dataBytes(0), sr(0), ch(0) {}
-    bool open(const wchar_t* path, int sampleRate, int channels) {
-        h = CreateFileW(path, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
-        if (h == INVALID_HANDLE_VALUE) return false;
-        sr = sampleRate; ch = channels; dataBytes = 0;
-        DWORD dw;
-        DWORD riffsz = 0;
-        WriteFile(h, "RIFF", 4, &dw, nullptr);
-        WriteFile(h, &riffsz, 4, &dw, nullptr);
-        WriteFile(h, "WAVE", 4, &dw, nullptr);
-        WriteFile(h, "fmt ", 4, &dw, nullptr);
-        DWORD fmtsz = 16; WriteFile(h, &fmtsz, 4, &dw, nullptr);
-        WORD audiofmt = 1; WriteFile(h, &audiofmt, 2, &dw, nullptr);
-        WORD outChannels = (WORD)ch; WriteFile(h, &outChannels, 2, &dw, nullptr);
-        DWORD samplerate = (DWORD)sr; WriteFile(h, &samplerate, 4, &dw, nullptr);
-        WORD bps = 16;
-        WORD blockalign = outChannels*(bps/8);
-        DWORD byterate = samplerate*blockalign;
-        WriteFile(h, &byterate, 4, &dw, nullptr);
-        WriteFile(h, &blockalign, 2, &dw, nullptr);
-        WriteFile(h, &bps, 2, &dw, nullptr);
-        WriteFile(h, "data", 4, &dw, nullptr);
-        DWORD datasz = 0; WriteFile(h, &datasz, 4, &dw, nullptr);
-        return true;
-    }
-    void write(const float* data, size_t frames) {
-        std::vector<short> pcm(frames*ch);
-        for (size_t i=0;i<frames*ch;i++) {
-            float v = data[i];
-            if (v>1.0f) v=1.0f; if (v<-1.0f) v=-1.0f;
-            pcm[i] = (short)std::lround(v*32767.0f);
-        }
-        DWORD dw;
-        WriteFile(h, pcm.data(), (DWORD)(pcm.size()*2), &dw, nullptr);
-        dataBytes += dw;
-    }
-    void close() {
-        if (h==INVALID_HANDLE_VALUE) return;
-        DWORD dw;
-        LARGE_INTEGER pos; pos.QuadPart = 4;
-        SetFilePointerEx(h, pos, nullptr, FILE_BEGIN);
-        DWORD riffsz = 36 + dataBytes;
-        WriteFile(h, &riffsz, 4, &dw, nullptr);
-        pos.QuadPart = 40;
-        SetFilePointerEx(h, pos, nullptr, FILE_BEGIN);
-        WriteFile(h, &dataBytes, 4, &dw, nullptr);
-        CloseHandle(h); h = INVALID_HANDLE_VALUE;
-    }
-};
-static bool get_default_device(EDataFlow flow, IMMDevice** dev) {
-    IMMDeviceEnumerator* en = nullptr;
-    HRESULT hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL, IID_PPV_ARGS(&en));
-    if (FAILED(hr)) return false;
-    hr = en->GetDefaultAudioEndpoint(flow, eConsole, dev);
-    en->Release();
-    return SUCCEEDED(hr);
-}
 static int watoi(const wchar_t* s) {
     return (int)wcstol(s, nullptr, 10);
 }
+static std::string narrow(const std::wstring& w, UINT codePage) {
+    int n = WideCharToMultiByte(codePage, 0, w.c_str(), (int)w.size(), nullptr, 0, nullptr, nullptr);
+    std::string s(n > 0 ? n : 0, '\0');
+    if (n > 0) WideCharToMultiByte(codePage, 0, w.c_str(), (int)w.size(), &s[0], n, nullptr, nullptr);
+    return s;
+}
 int wmain(int argc, wchar_t** argv) {
     HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
     if (FAILED(hr)) return 1;
@@ -82,12 +25,14 @@ int wmain(int argc, wchar_t** argv) {
     int durationMs = 10000;
     int sampleRateOverride = 0;
     std::wstring outPath = L"out_realtime.wav";
+    WavOutputFormat outFormat = WavOutputFormat::Int16;
     int filterLenOverride = 0;
     float muOverride = -1.0f;
     float epsOverride = -1.0f;
     float alphaOverride = -1.0f;
     float betaOverride = -1.0f;
     int freezeOverride = -1;
+    std::wstring warmCacheDir;
     for (int i=1;i<argc;i++) {
         std::wstring a = argv[i];
         if (a == L"--list") {
@@ -108,6 +53,8 @@ int wmain(int argc, wchar_t** argv) {
             sampleRateOverride = watoi(argv[++i]);
         } else if (a == L"--out" && i+1 < argc) {
             outPath = argv[++i];
+        } else if (a == L"--float") {
+            outFormat = WavOutputFormat::Float32;
         } else if (a == L"--filter" && i+1 < argc) {
             filterLenOverride = watoi(argv[++i]);
         } else if (a == L"--mu" && i+1 < argc) {
@@ -120,148 +67,85 @@ int wmain(int argc, wchar_t** argv) {
             betaOverride = (float)wcstod(argv[++i], nullptr);
         } else if (a == L"--freeze" && i+1 < argc) {
             freezeOverride = watoi(argv[++i]);
+        } else if (a == L"--warm-cache" && i+1 < argc) {
+            warmCacheDir = argv[++i];
         }
     }
-    IMMDevice* micDev=nullptr; IMMDevice* spkDev=nullptr;
-    if (micIndex >= 0) {
-        if (!GetDeviceByIndex(eCapture, micIndex, &micDev)) return 2;
-    } else {
-        if (!get_default_device(eCapture, &micDev)) return 2;
-    }
-    if (spkIndex >= 0) {
-        if (!GetDeviceByIndex(eRender, spkIndex, &spkDev)) return 3;
-    } else {
-        if (!get_default_device(eRender, &spkDev)) return 3;
+    WasapiBackend backend(micIndex, spkIndex, sampleRateOverride, outPath, outFormat);
+    std::string err;
+    if (!backend.start(err)) {
+        wprintf(L"Audio setup failed: %hs\n", err.c_str());
+        CoUninitialize();
+        return 2;
     }
-    IAudioClient* micClient=nullptr; IAudioClient* loopClient=nullptr;
-    hr = micDev->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr, (void**)&micClient);
-    if (FAILED(hr)) return 4;
-    hr = spkDev->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr, (void**)&loopClient);
-    if (FAILED(hr)) return 5;
-    WAVEFORMATEX* micFmt=nullptr; WAVEFORMATEX* spkFmt=nullptr;
-    hr = micClient->GetMixFormat(&micFmt); if (FAILED(hr)) return 6;
-    hr = loopClient->GetMixFormat(&spkFmt); if (FAILED(hr)) return 7;
-    if (micFmt->wFormatTag != WAVE_FORMAT_IEEE_FLOAT || spkFmt->wFormatTag != WAVE_FORMAT_IEEE_FLOAT) return 8;
-    if (sampleRateOverride > 0) {
-        micFmt->nSamplesPerSec = sampleRateOverride;
-        spkFmt->nSamplesPerSec = sampleRateOverride;
-        micFmt->nAvgBytesPerSec = sampleRateOverride * micFmt->nBlockAlign;
-        spkFmt->nAvgBytesPerSec = sampleRateOverride * spkFmt->nBlockAlign;
-    }
-    REFERENCE_TIME dur = 10000000;
-    hr = micClient->Initialize(AUDCLNT_SHAREMODE_SHARED, 0, dur, 0, micFmt, nullptr);
-    if (FAILED(hr)) return 11;
-    hr = loopClient->Initialize(AUDCLNT_SHAREMODE_SHARED, AUDCLNT_STREAMFLAGS_LOOPBACK, dur, 0, spkFmt, nullptr);
-    if (FAILED(hr)) return 12;
-    IAudioCaptureClient* micCap=nullptr; IAudioCaptureClient* loopCap=nullptr;
-    hr = micClient->GetService(__uuidof(IAudioCaptureClient), (void**)&micCap);
-    if (FAILED(hr)) return 13;
-    hr = loopClient->GetService(__uuidof(IAudioCaptureClient), (void**)&loopCap);
-    if (FAILED(hr)) return 14;
-    hr = micClient->Start(); if (FAILED(hr)) return 15;
-    hr = loopClient->Start(); if (FAILED(hr)) return 16;
-    int sr = (int)micFmt->nSamplesPerSec;
-    int chSrc = (int)micFmt->nChannels;
-    int ch = 1;
-    LARGE_INTEGER qpcFreq;
-    QueryPerformanceFrequency(&qpcFreq);
-    double ticksPerFrame = (double)qpcFreq.QuadPart / (double)sr;
-    AECProcessor aec;
-    AECParams p;
-    p.sampleRate=sr; p.channels=ch; p.filterLen=2048; p.mu=0.1f; p.epsilon=1e-6f;
-    p.leak = 0.0001f; p.maxDelayMs = 80; p.corrBlock = 1024; p.dtdAlpha = 2.0f; p.dtdBeta = 1.5f;
+    RealtimeConfig cfg = defaultRealtimeConfig();
+    cfg.aec.sampleRate = backend.sampleRate();
+    cfg.durationMs = durationMs;
+    AECParams& p = cfg.aec;
     if (filterLenOverride > 0) p.filterLen = filterLenOverride;
     if (muOverride >= 0.0f) p.mu = muOverride;
     if (epsOverride >= 0.0f) p.epsilon = epsOverride;
-    aec.initialize(p);
-    AIParams aip;
-    aip.sampleRate = sr;
-    aip.channels = ch;
-    AIEnhancer ai; ai.initialize(aip);
-    WavWriter ww; if (!ww.open(outPath.c_str(), sr, ch)) return 17;
-    HANDLE hTask = AvSetMmThreadCharacteristicsW(L"Pro Audio", nullptr);
-    UINT32 micFrameSize = micFmt->nBlockAlign;
-    UINT32 spkFrameSize = spkFmt->nBlockAlign;
-    std::vector<float> micBuf;
-    std::vector<float> spkBuf;
-    std::vector<float> outBuf;
-    DWORD totalMs = (DWORD)durationMs;
-    DWORD startTick = GetTickCount();
-    while (GetTickCount() - startTick < totalMs) {
-        UINT32 pkt=0;
-        hr = micCap->GetNextPacketSize(&pkt);
-        if (FAILED(hr)) break;
-        if (pkt==0) { Sleep(1); continue; }
-        BYTE* micData=nullptr; UINT32 micFrames=0; DWORD micFlags=0;
-        UINT64 micPos=0, micQPC=0;
-        hr = micCap->GetBuffer(&micData, &micFrames, &micFlags, &micPos, &micQPC);
-        if (FAILED(hr)) break;
-        UINT32 loopPkt=0; hr = loopCap->GetNextPacketSize(&loopPkt);
-        BYTE* loopData=nullptr; UINT32 loopFrames=0; DWORD loopFlags=0;
-        UINT64 loopPos=0, loopQPC=0;
-        if (loopPkt>0) {
-            hr = loopCap->GetBuffer(&loopData, &loopFrames, &loopFlags, &loopPos, &loopQPC);
-            if (FAILED(hr)) { micCap->ReleaseBuffer(micFrames); break; }
-        } else {
-            loopFrames = micFrames;
-        }
-        UINT32 micOff = 0, loopOff = 0;
-        if (loopPkt>0) {
-            LONGLONG delta = (LONGLONG)loopQPC - (LONGLONG)micQPC;
-            int shift = (int)llround((double)delta / ticksPerFrame);
-            if (shift > 0) {
-                if ((UINT32)shift > loopFrames) shift = (int)loopFrames;
-                loopOff = (UINT32)shift;
-            } else if (shift < 0) {
-                shift = -shift;
-                if ((UINT32)shift > micFrames) shift = (int)micFrames;
-                micOff = (UINT32)shift;
-            }
-        }
-        UINT32 framesMic = micFrames - micOff;
-        UINT32 framesLoop = loopFrames - loopOff;
-        UINT32 frames = framesMic < framesLoop ? framesMic : framesLoop;
-        micBuf.resize(frames);
-        spkBuf.resize(frames);
-        outBuf.resize(frames);
-        const float* micF = (const float*)micData;
-        const float* loopF = loopPkt>0 ? (const float*)loopData : micF;
-        for (UINT32 i=0;i<frames;i++) {
-            float sm=0.0f, sl=0.0f;
-            for (int c=0;c<chSrc;c++) {
-                sm += micF[(i+micOff)*chSrc + c];
-                sl += loopF[(i+loopOff)*chSrc + c];
-            }
-            micBuf[i] = sm / (float)chSrc;
-            spkBuf[i] = sl / (float)chSrc;
-        }
-        aec.process(micBuf.data(), spkBuf.data(), outBuf.data(), frames);
-        ai.process(outBuf.data(), frames);
-        ww.write(outBuf.data(), frames);
-        micCap->ReleaseBuffer(micFrames);
-        if (loopPkt>0) loopCap->ReleaseBuffer(loopFrames);
+    if (alphaOverride > 0.0f) p.dtdAlpha = alphaOverride;
+    if (betaOverride > 0.0f) p.dtdBeta = betaOverride;
+    // Warm start from the echo path this device pair converged to last time
+    EchoPathCache warmCache(narrow(warmCacheDir, CP_ACP));
+    uint64_t warmKey = EchoPathCache::fingerprint(backend.micId(), backend.refId(), p);
+    AECEchoPath warmPath;
+    if (!warmCacheDir.empty() && warmCache.load(warmKey, warmPath)) cfg.warmStart = &warmPath;
+    RealtimeEngine engine;
+    if (!engine.start(backend, cfg, err)) {
+        wprintf(L"Engine start failed: %hs\n", err.c_str());
+        backend.stop();
+        CoUninitialize();
+        return 3;
     }
-    
+    if (freezeOverride > 0) engine.aec().setFreezeBlocks(freezeOverride);
+    engine.wait();
+    AECProcessor& aec = engine.aec();
+
     // Print Metrics
     AECStats s = aec.getStats();
     wprintf(L"\n--- AEC Performance Metrics ---\n");
     wprintf(L"Avg ERLE: %.2f dB\n", s.avgErle);
     wprintf(L"Max ERLE: %.2f dB\n", s.maxErle);
     wprintf(L"Convergence Time: %.2f ms\n", s.convergedTimeMs);
-    wprintf(L"-----------------------------\n");
+    if (!warmCacheDir.empty()) {
+        static const wchar_t* const kWarm[] = { L"rejected", L"none", L"probing", L"confirmed" };
+        wprintf(L"Warm Start: %s\n", kWarm[s.warmStart + 1]);
+        // Only converged paths are worth starting the next call from
+        if (s.avgErle >= 10.0f) {
+            aec.exportEchoPath(warmPath);
+            if (!warmCache.store(warmKey, warmPath)) wprintf(L"Warm cache write failed\n");
+        }
+    }
+    AECLoadStats la = aec.getLoadStats();
+    AECLoadStats lc = engine.getChainLoadStats();
+    RealtimeStats rs = engine.getStats();
+    wprintf(L"AEC Load: RTF %.3f, p50 %.1f us, p99 %.1f us, max %.1f us, misses %llu/%llu\n",
+        la.rtf, la.p50Us, la.p99Us, la.maxUs, (unsigned long long)la.deadlineMisses, (unsigned long long)la.calls);
+    wprintf(L"Chain Load: RTF %.3f, p50 %.1f us, p99 %.1f us, max %.1f us, misses %llu/%llu\n",
+        lc.rtf, lc.p50Us, lc.p99Us, lc.maxUs, (unsigned long long)lc.deadlineMisses, (unsigned long long)lc.calls);
+    wprintf(L"Capture: %llu frames, dropped %llu in %llu packets, max ring fill %llu\n",
+        (unsigned long long)rs.capturedFrames, (unsigned long long)rs.droppedFrames,
+        (unsigned long long)rs.droppedPackets, (unsigned long long)rs.maxFillFrames);
+    JitterStats js;
+    if (backend.getJitterStats(js)) {
+        wprintf(L"Alignment: ref underrun %llu, mic gaps %llu, late %llu, overrun %llu frames, %llu resyncs, align error mean %.2f ms, max %.2f ms\n",
+            (unsigned long long)js.refUnderrunFrames, (unsigned long long)js.micGapFrames,
+            (unsigned long long)js.lateFrames, (unsigned long long)js.overrunFrames,
+            (unsigned long long)js.resyncs, js.alignErrorMs, js.maxAlignErrorMs);
+    }
 
-    ww.close();
-    if (hTask) AvRevertMmThreadCharacteristics(hTask);
-    micClient->Stop();
-    loopClient->Stop();
-    micCap->Release();
-    loopCap->Release();
-    CoTaskMemFree(micFmt);
-    CoTaskMemFree(spkFmt);
-    micClient->Release();
-    loopClient->Release();
-    micDev->Release();
-    spkDev->Release();
+    // Stopping drains the recorder queue, so its counters are final after it
+    backend.stop();
+    AsyncWavStats ws;
+    if (backend.getWriterStats(ws)) {
+        wprintf(L"Output: %llu frames written in %llu batches, dropped %llu frames in %llu blocks, max queue %llu frames%s\n",
+            (unsigned long long)ws.writtenFrames, (unsigned long long)ws.batches,
+            (unsigned long long)ws.droppedFrames, (unsigned long long)ws.droppedBlocks,
+            (unsigned long long)ws.maxQueueFrames, ws.ioError ? L", write error" : L"");
+    }
+    wprintf(L"-----------------------------\n");
     CoUninitialize();
     return 0;
 }
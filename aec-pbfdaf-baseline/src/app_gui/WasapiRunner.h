@@ -3,10 +3,11 @@
 #define NOMINMAX
 #endif
 #include <windows.h>
-#include <mmdeviceapi.h>
-#include <audioclient.h>
+#include <memory>
 #include <string>
 #include "../aec_core/AECProcessor.h"
+#include "../realtime/RealtimeEngine.h"
+#include "WasapiBackend.h"
 
 struct RunnerParams {
     int micIndex;
@@ -21,17 +22,21 @@ struct RunnerParams {
     float dtdBeta;
     int freezeBlocks;
 };
+// GUI front end of RealtimeEngine on the WASAPI backend
 class WasapiRunner {
 public:
     WasapiRunner();
+    ~WasapiRunner();
     bool start(const RunnerParams& p);
     void stop();
     bool isRunning() const;
     RunnerParams getParams() const;
-    AECProcessor* getProcessor() { return &aec; }
+    AECProcessor* getProcessor() { return &engine.aec(); }
+    // Load of the whole per-block chain (AEC + enhancer + writer)
+    AECLoadStats getChainLoadStats() const { return engine.getChainLoadStats(); }
+    RealtimeStats getEngineStats() const { return engine.getStats(); }
 private:
-    HANDLE hThread;
     RunnerParams params;
-    volatile bool running;
-    AECProcessor aec;
+    std::unique_ptr<WasapiBackend> backend;
+    RealtimeEngine engine;
 };
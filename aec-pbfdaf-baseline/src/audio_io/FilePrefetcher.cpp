@@ -0,0 +1,154 @@
+#include "FilePrefetcher.h"
+#include <cstdio>
+#include <vector>
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+#ifdef AEC_HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+// Requests submitted together per io_uring round trip
+static const size_t kRingBatch = 32;
+
+FilePrefetcher::FilePrefetcher() : running(false), useRing(false), ring(nullptr) {
+    issued.store(0);
+    bytes.store(0);
+}
+
+FilePrefetcher::~FilePrefetcher() { stop(); }
+
+bool FilePrefetcher::start() {
+    stop();
+#ifdef AEC_HAVE_LIBURING
+    io_uring* r = new io_uring;
+    if (io_uring_queue_init((unsigned)kRingBatch, r, 0) == 0) {
+        ring = r;
+        useRing = true;
+    } else {
+        delete r; // Kernel without io_uring (or blocked by seccomp): thread fallback
+    }
+#endif
+    running = true;
+    worker = std::thread(&FilePrefetcher::run, this);
+    return true;
+}
+
+void FilePrefetcher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        running = false;
+        queue.clear();
+    }
+    cv.notify_all();
+    if (worker.joinable()) worker.join();
+#ifdef AEC_HAVE_LIBURING
+    if (ring) {
+        io_uring_queue_exit((io_uring*)ring);
+        delete (io_uring*)ring;
+    }
+#endif
+    ring = nullptr;
+    useRing = false;
+}
+
+void FilePrefetcher::enqueue(const std::string& path) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!running) return;
+        queue.push_back(path);
+    }
+    cv.notify_one();
+}
+
+const char* FilePrefetcher::backend() const {
+    if (useRing) return "io_uring";
+#if defined(__linux__)
+    return "thread+fadvise";
+#else
+    return "thread+read";
+#endif
+}
+
+void FilePrefetcher::run() {
+    std::deque<std::string> batch;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [this] { return !running || !queue.empty(); });
+            if (!running) return;
+            while (!queue.empty() && batch.size() < kRingBatch) {
+                batch.push_back(std::move(queue.front()));
+                queue.pop_front();
+            }
+        }
+        issueBatch(batch);
+        batch.clear();
+    }
+}
+
+void FilePrefetcher::issueBatch(std::deque<std::string>& batch) {
+#ifdef AEC_HAVE_LIBURING
+    if (useRing) {
+        io_uring* r = (io_uring*)ring;
+        std::vector<int> fds;
+        fds.reserve(batch.size());
+        for (const std::string& path : batch) {
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) continue;
+            struct stat st;
+            if (fstat(fd, &st) != 0 || st.st_size <= 0) { ::close(fd); continue; }
+            io_uring_sqe* sqe = io_uring_get_sqe(r);
+            if (!sqe) { ::close(fd); break; }
+            io_uring_prep_fadvise(sqe, fd, 0, (off_t)st.st_size, POSIX_FADV_WILLNEED);
+            fds.push_back(fd);
+            bytes.fetch_add((uint64_t)st.st_size, std::memory_order_relaxed);
+        }
+        if (!fds.empty()) {
+            io_uring_submit(r);
+            for (size_t i = 0; i < fds.size(); ++i) {
+                io_uring_cqe* cqe = nullptr;
+                if (io_uring_wait_cqe(r, &cqe) != 0) break;
+                io_uring_cqe_seen(r, cqe);
+            }
+            issued.fetch_add(fds.size(), std::memory_order_relaxed);
+        }
+        for (int fd : fds) ::close(fd);
+        return;
+    }
+#endif
+    for (const std::string& path : batch) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (!running) return;
+        }
+        issueOne(path);
+    }
+}
+
+void FilePrefetcher::issueOne(const std::string& path) {
+#if defined(__linux__)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        posix_fadvise(fd, 0, st.st_size, POSIX_FADV_WILLNEED);
+        issued.fetch_add(1, std::memory_order_relaxed);
+        bytes.fetch_add((uint64_t)st.st_size, std::memory_order_relaxed);
+    }
+    ::close(fd);
+#else
+    // No read-ahead hint available: pull the file through a small scratch buffer
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return;
+    std::vector<char> buf(256 * 1024);
+    uint64_t total = 0;
+    size_t n;
+    while ((n = fread(buf.data(), 1, buf.size(), f)) > 0) total += n;
+    fclose(f);
+    issued.fetch_add(1, std::memory_order_relaxed);
+    bytes.fetch_add(total, std::memory_order_relaxed);
+#endif
+}
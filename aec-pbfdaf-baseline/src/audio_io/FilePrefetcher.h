@@ -0,0 +1,44 @@
+#pragma once
+// Asynchronous read-ahead of whole files into the OS page cache, so that a
+// later open/mmap of an upcoming input does not stall a worker on disk I/O.
+// Uses io_uring (fadvise WILLNEED, batched) when built with liburing, else a
+// background thread issuing posix_fadvise or plain sequential reads.
+
+#include <cstdint>
+#include <string>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+
+class FilePrefetcher {
+public:
+    FilePrefetcher();
+    ~FilePrefetcher();
+    bool start();
+    // Drops queued requests that have not been issued yet
+    void stop();
+    // Non-blocking hint; unknown or unreadable paths are skipped
+    void enqueue(const std::string& path);
+    const char* backend() const;
+    uint64_t filesIssued() const { return issued.load(std::memory_order_relaxed); }
+    uint64_t bytesIssued() const { return bytes.load(std::memory_order_relaxed); }
+
+private:
+    FilePrefetcher(const FilePrefetcher&) = delete;
+    FilePrefetcher& operator=(const FilePrefetcher&) = delete;
+    void run();
+    void issueBatch(std::deque<std::string>& batch);
+    void issueOne(const std::string& path);
+
+    std::thread worker;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<std::string> queue;
+    bool running;
+    bool useRing;
+    void* ring; // io_uring*, only with liburing
+    std::atomic<uint64_t> issued;
+    std::atomic<uint64_t> bytes;
+};
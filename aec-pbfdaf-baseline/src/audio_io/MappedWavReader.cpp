@@ -0,0 +1,263 @@
+#include "MappedWavReader.h"
+#include <cstring>
+#include <algorithm>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX 1
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// Consumed pages are handed back to the OS in steps of this size
+static const uint64_t kReleaseStep = 8ull << 20;
+
+static inline uint16_t rd16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static inline uint32_t rd32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+static inline uint64_t rd64(const uint8_t* p) { return (uint64_t)rd32(p) | ((uint64_t)rd32(p + 4) << 32); }
+
+// ---------------------------------------------------------------------------
+// MappedFile
+
+#ifdef _WIN32
+MappedFile::MappedFile() : mapping(nullptr), ptr(nullptr), len(0) {}
+#else
+MappedFile::MappedFile() : ptr(nullptr), len(0) {}
+#endif
+
+MappedFile::~MappedFile() { close(); }
+
+#ifdef _WIN32
+bool MappedFile::mapHandle(void* h) {
+    LARGE_INTEGER sz;
+    if (!GetFileSizeEx((HANDLE)h, &sz) || sz.QuadPart <= 0 || (uint64_t)sz.QuadPart > (uint64_t)SIZE_MAX) {
+        CloseHandle((HANDLE)h);
+        return false;
+    }
+    HANDLE m = CreateFileMappingW((HANDLE)h, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle((HANDLE)h); // The mapping keeps the file open
+    if (!m) return false;
+    void* v = MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+    if (!v) { CloseHandle(m); return false; }
+    mapping = m;
+    ptr = (const uint8_t*)v;
+    len = (uint64_t)sz.QuadPart;
+    return true;
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    HANDLE h = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                           FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (h == INVALID_HANDLE_VALUE) return false;
+    return mapHandle(h);
+}
+
+bool MappedFile::open(const std::wstring& path) {
+    close();
+    HANDLE h = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                           FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (h == INVALID_HANDLE_VALUE) return false;
+    return mapHandle(h);
+}
+
+void MappedFile::close() {
+    if (ptr) UnmapViewOfFile(ptr);
+    if (mapping) CloseHandle((HANDLE)mapping);
+    mapping = nullptr;
+    ptr = nullptr;
+    len = 0;
+}
+
+void MappedFile::release(uint64_t, uint64_t) {
+    // Clean file-backed pages are trimmed by the working-set manager on Windows
+}
+#else
+bool MappedFile::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0 ||
+        (uint64_t)st.st_size > (uint64_t)SIZE_MAX) {
+        ::close(fd);
+        return false;
+    }
+    void* v = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping keeps the file open
+    if (v == MAP_FAILED) return false;
+    madvise(v, (size_t)st.st_size, MADV_SEQUENTIAL);
+    ptr = (const uint8_t*)v;
+    len = (uint64_t)st.st_size;
+    return true;
+}
+
+void MappedFile::close() {
+    if (ptr) munmap((void*)ptr, (size_t)len);
+    ptr = nullptr;
+    len = 0;
+}
+
+void MappedFile::release(uint64_t offset, uint64_t bytes) {
+    if (!ptr) return;
+    uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+    uint64_t a = (offset + page - 1) / page * page;
+    uint64_t b = std::min(offset + bytes, len) / page * page;
+    if (b > a) madvise((void*)(ptr + a), (size_t)(b - a), MADV_DONTNEED);
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// MappedWavReader
+
+static const uint16_t kFormatPcm = 1;
+static const uint16_t kFormatFloat = 3;
+static const uint16_t kFormatExtensible = 0xFFFE;
+// KSDATAFORMAT_SUBTYPE_* GUIDs share everything after the format code
+static const uint8_t kSubFormatTail[12] = { 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 };
+
+MappedWavReader::MappedWavReader()
+    : fmt(WavSampleFormat::Int16), dataPtr(nullptr), dataOffset(0), bytesPerFrame(0), cursor(0), released(0) {
+    std::memset(&inf, 0, sizeof(inf));
+}
+
+bool MappedWavReader::open(const std::string& path) {
+    close();
+    if (!file.open(path)) return false;
+    if (!parse()) { close(); return false; }
+    return true;
+}
+
+#ifdef _WIN32
+bool MappedWavReader::open(const std::wstring& path) {
+    close();
+    if (!file.open(path)) return false;
+    if (!parse()) { close(); return false; }
+    return true;
+}
+#endif
+
+void MappedWavReader::close() {
+    file.close();
+    std::memset(&inf, 0, sizeof(inf));
+    dataPtr = nullptr;
+    dataOffset = 0;
+    bytesPerFrame = 0;
+    cursor = 0;
+    released = 0;
+}
+
+bool MappedWavReader::parse() {
+    const uint8_t* p = file.data();
+    uint64_t n = file.size();
+    if (n < 12) return false;
+    bool rf64 = std::memcmp(p, "RF64", 4) == 0 || std::memcmp(p, "BW64", 4) == 0;
+    if (!rf64 && std::memcmp(p, "RIFF", 4) != 0) return false;
+    if (std::memcmp(p + 8, "WAVE", 4) != 0) return false;
+
+    bool fmtok = false, dataok = false, haveDs64 = false;
+    uint16_t tag = 0, blockalign = 0;
+    uint64_t ds64Data = 0, dataBytes = 0;
+    uint64_t pos = 12;
+    while (pos + 8 <= n) {
+        const uint8_t* c = p + pos;
+        uint64_t sz = rd32(c + 4);
+        pos += 8;
+        const uint8_t* b = p + pos;
+        uint64_t avail = n - pos;
+        if (std::memcmp(c, "ds64", 4) == 0) {
+            // riffSize(8) dataSize(8) sampleCount(8) [table]
+            if (sz < 24 || avail < 24) return false;
+            ds64Data = rd64(b + 8);
+            haveDs64 = true;
+        } else if (std::memcmp(c, "fmt ", 4) == 0) {
+            if (sz < 16 || avail < 16) return false;
+            tag = rd16(b);
+            inf.channels = rd16(b + 2);
+            inf.sampleRate = (int)rd32(b + 4);
+            blockalign = rd16(b + 12);
+            inf.bitsPerSample = rd16(b + 14);
+            if (tag == kFormatExtensible) {
+                if (sz < 40 || avail < 40 || rd16(b + 16) < 22) return false;
+                if (std::memcmp(b + 28, kSubFormatTail, sizeof(kSubFormatTail)) != 0 || rd16(b + 26) != 0) return false;
+                tag = rd16(b + 24);
+            }
+            fmtok = true;
+        } else if (std::memcmp(c, "data", 4) == 0) {
+            if (rf64 && sz == 0xFFFFFFFFu) {
+                if (!haveDs64) return false;
+                sz = ds64Data;
+            } else if (sz == 0 || sz == 0xFFFFFFFFu) {
+                sz = avail; // Streamed WAV: data runs to EOF
+            }
+            dataOffset = pos;
+            dataBytes = std::min(sz, avail); // Truncated recordings keep what is there
+            dataok = true;
+            break;
+        }
+        if (sz > avail) break;
+        pos += sz + (sz & 1);
+    }
+    if (!fmtok || !dataok || inf.channels <= 0 || inf.sampleRate <= 0) return false;
+
+    if (tag == kFormatPcm && inf.bitsPerSample == 16) fmt = WavSampleFormat::Int16;
+    else if (tag == kFormatPcm && inf.bitsPerSample == 24) fmt = WavSampleFormat::Int24;
+    else if (tag == kFormatPcm && inf.bitsPerSample == 32) fmt = WavSampleFormat::Int32;
+    else if (tag == kFormatFloat && inf.bitsPerSample == 32) fmt = WavSampleFormat::Float32;
+    else return false;
+    inf.isFloat = (fmt == WavSampleFormat::Float32);
+
+    bytesPerFrame = (size_t)inf.channels * (size_t)(inf.bitsPerSample / 8);
+    if (blockalign != bytesPerFrame) return false;
+    dataPtr = p + dataOffset;
+    inf.frames = dataBytes / bytesPerFrame;
+    mixGains.assign((size_t)inf.channels, 1.0f / (float)inf.channels);
+    return true;
+}
+
+size_t MappedWavReader::clampFrames(uint64_t frame, size_t frames) const {
+    if (!dataPtr || frame >= inf.frames) return 0;
+    uint64_t left = inf.frames - frame;
+    return (uint64_t)frames > left ? (size_t)left : frames;
+}
+
+size_t MappedWavReader::readMonoAt(uint64_t frame, float* dst, size_t frames) const {
+    size_t n = clampFrames(frame, frames);
+    if (n == 0) return 0;
+    decodeDownmix(fmt, frameData(frame), inf.channels, mixGains.data(), dst, n);
+    return n;
+}
+
+size_t MappedWavReader::readInterleavedAt(uint64_t frame, float* dst, size_t frames) const {
+    size_t n = clampFrames(frame, frames);
+    if (n == 0) return 0;
+    decodeSamples(fmt, frameData(frame), dst, n * (size_t)inf.channels);
+    return n;
+}
+
+void MappedWavReader::releaseConsumed() {
+    uint64_t consumed = cursor * bytesPerFrame;
+    if (consumed < released + kReleaseStep) return; // Also covers seeks backwards
+    file.release(dataOffset + released, consumed - released);
+    released = consumed;
+}
+
+size_t MappedWavReader::readMono(float* dst, size_t frames) {
+    size_t n = readMonoAt(cursor, dst, frames);
+    cursor += n;
+    releaseConsumed();
+    return n;
+}
+
+size_t MappedWavReader::readInterleaved(float* dst, size_t frames) {
+    size_t n = readInterleavedAt(cursor, dst, frames);
+    cursor += n;
+    releaseConsumed();
+    return n;
+}
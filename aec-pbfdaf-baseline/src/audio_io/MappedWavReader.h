@@ -0,0 +1,79 @@
+#pragma once
+// Memory-mapped WAV reader. The chunk table is parsed in place and sample frames
+// are exposed straight from the mapping; conversion to float happens lazily,
+// only for the frames a caller asks for.
+// Supports PCM int16/int24/int32, IEEE float32, WAVE_FORMAT_EXTENSIBLE and RF64.
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "SampleConvert.h"
+#include "WavFile.h"
+
+// Read-only view of a whole file (mmap / CreateFileMapping)
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+    bool open(const std::string& path);
+#ifdef _WIN32
+    bool open(const std::wstring& path);
+#endif
+    void close();
+    const uint8_t* data() const { return ptr; }
+    uint64_t size() const { return len; }
+    // Hint that [offset, offset + bytes) is no longer needed (sequential batch reads)
+    void release(uint64_t offset, uint64_t bytes);
+
+private:
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+#ifdef _WIN32
+    bool mapHandle(void* file);
+    void* mapping;
+#endif
+    const uint8_t* ptr;
+    uint64_t len;
+};
+
+class MappedWavReader {
+public:
+    MappedWavReader();
+    bool open(const std::string& path);
+#ifdef _WIN32
+    bool open(const std::wstring& path);
+#endif
+    void close();
+    const WavInfo& info() const { return inf; }
+    WavSampleFormat format() const { return fmt; }
+
+    // Raw interleaved frames inside the mapping (no copy)
+    const uint8_t* frameData(uint64_t frame) const { return dataPtr + frame * bytesPerFrame; }
+    size_t frameBytes() const { return bytesPerFrame; }
+
+    // Sequential reads from the cursor; return frames converted (0 at end)
+    size_t readMono(float* dst, size_t frames);
+    size_t readInterleaved(float* dst, size_t frames);
+    void seek(uint64_t frame) { cursor = frame < inf.frames ? frame : inf.frames; }
+    uint64_t tell() const { return cursor; }
+
+    // Random access without moving the cursor
+    size_t readMonoAt(uint64_t frame, float* dst, size_t frames) const;
+    size_t readInterleavedAt(uint64_t frame, float* dst, size_t frames) const;
+
+private:
+    bool parse();
+    size_t clampFrames(uint64_t frame, size_t frames) const;
+    void releaseConsumed();
+
+    MappedFile file;
+    WavInfo inf;
+    WavSampleFormat fmt;
+    const uint8_t* dataPtr;
+    uint64_t dataOffset;
+    size_t bytesPerFrame;
+    std::vector<float> mixGains; // Equal-weight mono downmix
+    uint64_t cursor;
+    uint64_t released;
+};
@@ -0,0 +1,231 @@
+#include "SampleConvert.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
+// decodeDownmix converts this many samples at a time before mixing them
+static const size_t kMixChunk = 1024;
+
+// ---------------------------------------------------------------------------
+// Per-format loads and stores, so each conversion loop is a single branch-free body
+
+template <WavSampleFormat F> struct SampleIo;
+
+template <> struct SampleIo<WavSampleFormat::Int16> {
+    static const size_t bytes = 2;
+    static float load(const uint8_t* p) {
+        int16_t v;
+        std::memcpy(&v, p, 2);
+        return (float)v * (1.0f / 32768.0f);
+    }
+    static void store(uint8_t* p, int32_t v) {
+        int16_t s = (int16_t)v;
+        std::memcpy(p, &s, 2);
+    }
+};
+template <> struct SampleIo<WavSampleFormat::Int24> {
+    static const size_t bytes = 3;
+    static float load(const uint8_t* p) {
+        int32_t v = (int32_t)(((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24)) >> 8;
+        return (float)v * (1.0f / 8388608.0f);
+    }
+    static void store(uint8_t* p, int32_t v) {
+        p[0] = (uint8_t)v;
+        p[1] = (uint8_t)(v >> 8);
+        p[2] = (uint8_t)(v >> 16);
+    }
+};
+template <> struct SampleIo<WavSampleFormat::Int32> {
+    static const size_t bytes = 4;
+    static float load(const uint8_t* p) {
+        int32_t v;
+        std::memcpy(&v, p, 4);
+        return (float)v * (1.0f / 2147483648.0f);
+    }
+    static void store(uint8_t* p, int32_t v) { std::memcpy(p, &v, 4); }
+};
+template <> struct SampleIo<WavSampleFormat::Float32> {
+    static const size_t bytes = 4;
+    static float load(const uint8_t* p) {
+        float v;
+        std::memcpy(&v, p, 4);
+        return v;
+    }
+};
+
+size_t sampleBytes(WavSampleFormat f) {
+    switch (f) {
+    case WavSampleFormat::Int16: return 2;
+    case WavSampleFormat::Int24: return 3;
+    default: return 4;
+    }
+}
+
+template <WavSampleFormat F>
+static void decodeT(const uint8_t* src, float* dst, size_t n) {
+    for (size_t i = 0; i < n; ++i) dst[i] = SampleIo<F>::load(src + i * SampleIo<F>::bytes);
+}
+
+void decodeSamples(WavSampleFormat f, const uint8_t* src, float* dst, size_t samples) {
+    switch (f) {
+    case WavSampleFormat::Int16: decodeT<WavSampleFormat::Int16>(src, dst, samples); break;
+    case WavSampleFormat::Int24: decodeT<WavSampleFormat::Int24>(src, dst, samples); break;
+    case WavSampleFormat::Int32: decodeT<WavSampleFormat::Int32>(src, dst, samples); break;
+    case WavSampleFormat::Float32: decodeT<WavSampleFormat::Float32>(src, dst, samples); break;
+    }
+}
+
+// Stateless integer hash of the sample counter: unlike a recurrence it does not
+// serialize the loop
+static inline uint32_t hash32(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// Difference of two uniforms: triangular on (-1, 1) LSB
+static inline float tpdf(uint32_t counter) {
+    uint32_t h = hash32(counter);
+    return (float)((int32_t)(h & 0xFFFFu) - (int32_t)(h >> 16)) * (1.0f / 65536.0f);
+}
+
+// x (already scaled) rounded half away from zero as lround does, then clamped to
+// +-scale. Clamping after scaling, as min/max, is what lets the loops vectorize.
+template <typename T>
+static inline int32_t quantize(T x, T scale) {
+    return (int32_t)std::min(scale, std::max(-scale, x + std::copysign((T)0.5, x)));
+}
+
+template <WavSampleFormat F>
+static void encodeT(const float* src, uint8_t* dst, size_t n, uint32_t* dither) {
+    const size_t b = SampleIo<F>::bytes;
+    // int32 full scale does not fit a float mantissa
+    typedef typename std::conditional<F == WavSampleFormat::Int32, double, float>::type Acc;
+    const Acc scale = F == WavSampleFormat::Int16 ? (Acc)32767.0 : F == WavSampleFormat::Int24 ? (Acc)8388607.0 : (Acc)2147483647.0;
+    if (!dither) {
+        for (size_t i = 0; i < n; ++i) SampleIo<F>::store(dst + i * b, quantize((Acc)src[i] * scale, scale));
+        return;
+    }
+    uint32_t c = *dither;
+    for (size_t i = 0; i < n; ++i) {
+        Acc x = (Acc)src[i] * scale + (Acc)tpdf(c + (uint32_t)i);
+        SampleIo<F>::store(dst + i * b, quantize(x, scale));
+    }
+    *dither = c + (uint32_t)n;
+}
+
+void encodeSamples(WavSampleFormat f, const float* src, uint8_t* dst, size_t samples, uint32_t* dither) {
+    switch (f) {
+    case WavSampleFormat::Int16: encodeT<WavSampleFormat::Int16>(src, dst, samples, dither); break;
+    case WavSampleFormat::Int24: encodeT<WavSampleFormat::Int24>(src, dst, samples, dither); break;
+    case WavSampleFormat::Int32: encodeT<WavSampleFormat::Int32>(src, dst, samples, dither); break;
+    case WavSampleFormat::Float32: std::memcpy(dst, src, samples * 4); break;
+    }
+}
+
+void floatToInt16(const float* src, int16_t* dst, size_t samples, uint32_t* dither) {
+    encodeT<WavSampleFormat::Int16>(src, (uint8_t*)dst, samples, dither);
+}
+
+void int16ToFloat(const int16_t* src, float* dst, size_t samples) {
+    for (size_t i = 0; i < samples; ++i) dst[i] = (float)src[i] * (1.0f / 32768.0f);
+}
+
+void interleave(const float* const* channels, int numChannels, float* dst, size_t frames) {
+    size_t ch = (size_t)numChannels;
+    for (size_t c = 0; c < ch; ++c) {
+        const float* s = channels[c];
+        for (size_t i = 0; i < frames; ++i) dst[i * ch + c] = s[i];
+    }
+}
+
+void deinterleave(const float* src, int numChannels, float* const* channels, size_t frames) {
+    size_t ch = (size_t)numChannels;
+    if (ch == 2) {
+        float* a = channels[0];
+        float* b = channels[1];
+        for (size_t i = 0; i < frames; ++i) {
+            a[i] = src[2 * i];
+            b[i] = src[2 * i + 1];
+        }
+        return;
+    }
+    for (size_t c = 0; c < ch; ++c) {
+        float* d = channels[c];
+        for (size_t i = 0; i < frames; ++i) d[i] = src[i * ch + c];
+    }
+}
+
+void downmix(const float* src, int numChannels, const float* gains, float* dst, size_t frames) {
+    size_t ch = (size_t)numChannels;
+    if (ch == 1) {
+        float g = gains[0];
+        for (size_t i = 0; i < frames; ++i) dst[i] = src[i] * g;
+        return;
+    }
+    if (ch == 2) {
+        float g0 = gains[0], g1 = gains[1];
+        for (size_t i = 0; i < frames; ++i) dst[i] = src[2 * i] * g0 + src[2 * i + 1] * g1;
+        return;
+    }
+    // Channel by channel keeps the inner loop unit-stride in dst
+    float g0 = gains[0];
+    for (size_t i = 0; i < frames; ++i) dst[i] = src[i * ch] * g0;
+    for (size_t c = 1; c < ch; ++c) {
+        float g = gains[c];
+        for (size_t i = 0; i < frames; ++i) dst[i] += src[i * ch + c] * g;
+    }
+}
+
+void decodeDownmix(WavSampleFormat f, const uint8_t* src, int numChannels, const float* gains,
+                   float* dst, size_t frames) {
+    size_t ch = (size_t)std::max(1, numChannels);
+    size_t bytesPerFrame = sampleBytes(f) * ch;
+    if (ch > kMixChunk) {
+        for (size_t i = 0; i < frames; ++i) {
+            float s = 0.0f, v = 0.0f;
+            for (size_t c = 0; c < ch; ++c) {
+                decodeSamples(f, src + i * bytesPerFrame + c * sampleBytes(f), &v, 1);
+                s += v * gains[c];
+            }
+            dst[i] = s;
+        }
+        return;
+    }
+    float tmp[kMixChunk];
+    size_t step = std::max<size_t>(1, kMixChunk / ch);
+    for (size_t done = 0; done < frames;) {
+        size_t n = std::min(step, frames - done);
+        decodeSamples(f, src + done * bytesPerFrame, tmp, n * ch);
+        downmix(tmp, (int)ch, gains, dst + done, n);
+        done += n;
+    }
+}
+
+void clampSamples(float* x, size_t samples, float limit) {
+    for (size_t i = 0; i < samples; ++i) x[i] = std::min(limit, std::max(-limit, x[i]));
+}
+
+DcBlocker::DcBlocker() : r(0.995f), x1(0.0f), y1(0.0f) {}
+
+void DcBlocker::reset(int sampleRate, float cutoffHz) {
+    r = sampleRate > 0 ? std::exp(-2.0f * 3.14159265358979f * cutoffHz / (float)sampleRate) : 0.995f;
+    x1 = 0.0f;
+    y1 = 0.0f;
+}
+
+void DcBlocker::process(float* x, size_t samples) {
+    float px = x1, py = y1;
+    for (size_t i = 0; i < samples; ++i) {
+        float v = x[i];
+        py = v - px + r * py;
+        px = v;
+        x[i] = py;
+    }
+    x1 = px;
+    y1 = py;
+}
@@ -0,0 +1,46 @@
+#pragma once
+// Sample format conversion and channel mixing shared by every I/O path (WAV
+// files, raw pipes, capture backends). The loops run over contiguous arrays and
+// are branch-free, so the compiler vectorizes them at the target's SIMD width;
+// there is no per-sample lround, division or byte assembly. Integer samples are
+// little-endian byte streams (any alignment), as in the rest of the I/O code.
+
+#include <cstddef>
+#include <cstdint>
+
+enum class WavSampleFormat { Int16, Int24, Int32, Float32 };
+
+size_t sampleBytes(WavSampleFormat f);
+
+// Bytes -> float, full scale = 1.0
+void decodeSamples(WavSampleFormat f, const uint8_t* src, float* dst, size_t samples);
+// Float -> bytes, clamped to full scale and rounded to nearest. dither != nullptr:
+// integer formats get +-1 LSB triangular dither; *dither is the running noise
+// counter (any start value, advanced by samples).
+void encodeSamples(WavSampleFormat f, const float* src, uint8_t* dst, size_t samples,
+                   uint32_t* dither = nullptr);
+void floatToInt16(const float* src, int16_t* dst, size_t samples, uint32_t* dither = nullptr);
+void int16ToFloat(const int16_t* src, float* dst, size_t samples);
+
+void interleave(const float* const* channels, int numChannels, float* dst, size_t frames);
+void deinterleave(const float* src, int numChannels, float* const* channels, size_t frames);
+// dst[i] = sum_c gains[c] * src[i * numChannels + c]
+void downmix(const float* src, int numChannels, const float* gains, float* dst, size_t frames);
+// Bytes straight to a mono mix (a per-format decode fused with downmix)
+void decodeDownmix(WavSampleFormat f, const uint8_t* src, int numChannels, const float* gains,
+                   float* dst, size_t frames);
+void clampSamples(float* x, size_t samples, float limit);
+
+// One-pole DC blocker, y[n] = x[n] - x[n-1] + r * y[n-1]. Recursive in time, so
+// only the coefficient math is shared; cheap next to the conversions.
+class DcBlocker {
+public:
+    DcBlocker();
+    void reset(int sampleRate, float cutoffHz = 20.0f);
+    void process(float* x, size_t samples);
+
+private:
+    float r;
+    float x1;
+    float y1;
+};
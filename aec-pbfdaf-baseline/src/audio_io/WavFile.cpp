@@ -0,0 +1,162 @@
+#include "WavFile.h"
+#include "SampleConvert.h"
+#include <cstring>
+#include <algorithm>
+
+static bool readU32(FILE* f, uint32_t& v) {
+    uint8_t b[4];
+    if (fread(b, 1, 4, f) != 4) return false;
+    v = (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+    return true;
+}
+
+static void putU16(uint8_t* p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void putU32(uint8_t* p, uint32_t v) { for (int i = 0; i < 4; ++i) p[i] = (uint8_t)(v >> (8 * i)); }
+
+WavFileReader::WavFileReader() : f(nullptr), remaining(0) {
+    std::memset(&inf, 0, sizeof(inf));
+}
+
+WavFileReader::~WavFileReader() { close(); }
+
+void WavFileReader::close() {
+    if (f) fclose(f);
+    f = nullptr;
+    remaining = 0;
+}
+
+bool WavFileReader::open(const std::string& path) {
+    close();
+    std::memset(&inf, 0, sizeof(inf));
+    f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+
+    char id[4];
+    uint32_t sz = 0;
+    // RF64 (> 4 GB): the ds64 chunk is skipped and the data chunk runs to EOF
+    if (fread(id, 1, 4, f) != 4 || (std::memcmp(id, "RIFF", 4) != 0 && std::memcmp(id, "RF64", 4) != 0)) { close(); return false; }
+    if (!readU32(f, sz)) { close(); return false; }
+    if (fread(id, 1, 4, f) != 4 || std::memcmp(id, "WAVE", 4) != 0) { close(); return false; }
+
+    bool fmtok = false;
+    uint16_t audiofmt = 0, blockalign = 0;
+    while (true) {
+        if (fread(id, 1, 4, f) != 4 || !readU32(f, sz)) { close(); return false; }
+        if (std::memcmp(id, "fmt ", 4) == 0) {
+            uint8_t b[16];
+            if (sz < 16 || fread(b, 1, 16, f) != 16) { close(); return false; }
+            audiofmt = (uint16_t)(b[0] | (b[1] << 8));
+            inf.channels = b[2] | (b[3] << 8);
+            inf.sampleRate = (int)((uint32_t)b[4] | ((uint32_t)b[5] << 8) | ((uint32_t)b[6] << 16) | ((uint32_t)b[7] << 24));
+            blockalign = (uint16_t)(b[12] | (b[13] << 8));
+            inf.bitsPerSample = b[14] | (b[15] << 8);
+            if (sz > 16 && fseek(f, (long)(sz - 16 + (sz & 1)), SEEK_CUR) != 0) { close(); return false; }
+            fmtok = true;
+        } else if (std::memcmp(id, "data", 4) == 0) {
+            break;
+        } else {
+            if (fseek(f, (long)(sz + (sz & 1)), SEEK_CUR) != 0) { close(); return false; }
+        }
+    }
+    if (!fmtok || inf.channels <= 0 || inf.sampleRate <= 0) { close(); return false; }
+    inf.isFloat = (audiofmt == 3);
+    bool ok = (audiofmt == 1 && inf.bitsPerSample == 16) || (audiofmt == 3 && inf.bitsPerSample == 32);
+    if (!ok || blockalign != inf.channels * inf.bitsPerSample / 8) { close(); return false; }
+    mixGains.assign((size_t)inf.channels, 1.0f / (float)inf.channels);
+
+    // Streamed WAVs carry 0 or 0xFFFFFFFF as the data size: read until EOF
+    if (sz == 0 || sz == 0xFFFFFFFFu) {
+        inf.frames = 0;
+        remaining = UINT64_MAX;
+    } else {
+        inf.frames = sz / blockalign;
+        remaining = inf.frames;
+    }
+    return true;
+}
+
+size_t WavFileReader::readMono(float* dst, size_t frames) {
+    if (!f || remaining == 0) return 0;
+    if ((uint64_t)frames > remaining) frames = (size_t)remaining;
+    size_t bytesPerFrame = (size_t)inf.channels * (size_t)inf.bitsPerSample / 8;
+    if (raw.size() < frames * bytesPerFrame) raw.resize(frames * bytesPerFrame);
+    size_t got = fread(raw.data(), bytesPerFrame, frames, f);
+    if (got < frames) remaining = 0;
+    else if (remaining != UINT64_MAX) remaining -= got;
+
+    decodeDownmix(inf.isFloat ? WavSampleFormat::Float32 : WavSampleFormat::Int16, raw.data(),
+                  inf.channels, mixGains.data(), dst, got);
+    return got;
+}
+
+WavFileWriter::WavFileWriter() : f(nullptr), ch(0), dataBytes(0) {}
+
+WavFileWriter::~WavFileWriter() { close(); }
+
+bool WavFileWriter::open(const std::string& path, int sampleRate, int channels) {
+    close();
+    f = fopen(path.c_str(), "wb");
+    if (!f) return false;
+    ch = channels;
+    dataBytes = 0;
+    uint8_t h[44];
+    uint16_t bps = 16;
+    uint16_t blockalign = (uint16_t)(channels * (bps / 8));
+    std::memcpy(h, "RIFF", 4); putU32(h + 4, 0);
+    std::memcpy(h + 8, "WAVE", 4);
+    std::memcpy(h + 12, "fmt ", 4); putU32(h + 16, 16);
+    putU16(h + 20, 1); putU16(h + 22, (uint16_t)channels);
+    putU32(h + 24, (uint32_t)sampleRate); putU32(h + 28, (uint32_t)sampleRate * blockalign);
+    putU16(h + 32, blockalign); putU16(h + 34, bps);
+    std::memcpy(h + 36, "data", 4); putU32(h + 40, 0);
+    return fwrite(h, 1, 44, f) == 44;
+}
+
+void WavFileWriter::convert(const float* data, size_t n) {
+    if (pcm.size() < n) pcm.resize(n);
+    floatToInt16(data, pcm.data(), n);
+}
+
+bool WavFileWriter::write(const float* data, size_t frames) {
+    if (!f) return false;
+    size_t n = frames * (size_t)ch;
+    convert(data, n);
+    size_t w = fwrite(pcm.data(), 2, n, f);
+    dataBytes += (uint64_t)w * 2;
+    return w == n;
+}
+
+static bool seek64(FILE* f, uint64_t pos) {
+#ifdef _WIN32
+    return _fseeki64(f, (long long)pos, SEEK_SET) == 0;
+#else
+    return fseeko(f, (off_t)pos, SEEK_SET) == 0;
+#endif
+}
+
+bool WavFileWriter::writeAt(uint64_t frame, const float* data, size_t frames) {
+    if (!f) return false;
+    size_t n = frames * (size_t)ch;
+    uint64_t offset = frame * (uint64_t)ch * 2;
+    if (!seek64(f, 44 + offset)) return false;
+    convert(data, n);
+    size_t w = fwrite(pcm.data(), 2, n, f);
+    dataBytes = std::max(dataBytes, offset + (uint64_t)w * 2);
+    return w == n;
+}
+
+bool WavFileWriter::close() {
+    if (!f) return true;
+    // Sizes saturate at 4 GB; readers treat the data chunk as running to EOF
+    uint32_t datasz = dataBytes > 0xFFFFFFF0ull ? 0xFFFFFFFFu : (uint32_t)dataBytes;
+    uint32_t riffsz = dataBytes > 0xFFFFFFF0ull ? 0xFFFFFFFFu : 36u + datasz;
+    uint8_t b[4];
+    bool ok = true;
+    putU32(b, riffsz);
+    ok = ok && fseek(f, 4, SEEK_SET) == 0 && fwrite(b, 1, 4, f) == 4;
+    putU32(b, datasz);
+    ok = ok && fseek(f, 40, SEEK_SET) == 0 && fwrite(b, 1, 4, f) == 4;
+    ok = (fclose(f) == 0) && ok;
+    f = nullptr;
+    return ok;
+}
@@ -0,0 +1,56 @@
+#pragma once
+// Portable streaming WAV reader/writer. Reads and writes in caller-sized chunks
+// so memory use is bounded by the chunk size, not the recording length.
+
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+struct WavInfo {
+    int sampleRate;
+    int channels;
+    int bitsPerSample;
+    bool isFloat;
+    uint64_t frames;
+};
+
+class WavFileReader {
+public:
+    WavFileReader();
+    ~WavFileReader();
+    bool open(const std::string& path);
+    void close();
+    const WavInfo& info() const { return inf; }
+
+    // Reads up to 'frames' frames, downmixed to mono. Returns frames read (0 at end).
+    size_t readMono(float* dst, size_t frames);
+
+private:
+    FILE* f;
+    WavInfo inf;
+    uint64_t remaining;
+    std::vector<uint8_t> raw;
+    std::vector<float> mixGains;
+};
+
+class WavFileWriter {
+public:
+    WavFileWriter();
+    ~WavFileWriter();
+    // 16-bit PCM output; the header sizes are fixed up on close()
+    bool open(const std::string& path, int sampleRate, int channels);
+    bool write(const float* interleaved, size_t frames);
+    // Positional write (frame offset from the start of the data chunk). Not
+    // synchronized; concurrent callers must serialize. Gaps read back as silence.
+    bool writeAt(uint64_t frame, const float* interleaved, size_t frames);
+    bool close();
+
+private:
+    FILE* f;
+    int ch;
+    uint64_t dataBytes;
+    std::vector<int16_t> pcm;
+    void convert(const float* interleaved, size_t n);
+};
@@ -0,0 +1,487 @@
+// aec_bench: microbenchmarks for the hot kernels of aec_core and the I/O sample conversions.
+// Reports ns per call, samples/sec and the real-time multiple, optionally as JSON.
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <complex>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include "../aec_core/AECProcessor.h"
+#include "../aec_core/AIEnhancer.h"
+#include "../aec_core/AECPipeline.h"
+#include "../aec_core/AECLockstep.h"
+#include "../aec_core/FftUtil.h"
+#include "../audio_io/SampleConvert.h"
+
+// Friend of AECProcessor: drives the private kernels without going through process()
+struct AECBenchAccess {
+    static void fillBlock(AECProcessor& a, uint32_t& seed);
+    static void blockFdaf(AECProcessor& a) { a.performBlockFdaf(); }
+    static bool specialized(const AECProcessor& a) { return a.kernels->bins != 0; }
+    static void useGenericKernels(AECProcessor& a) {
+        a.kernels = &genericFdafKernels(a.kernels->history, a.kernels->weights);
+    }
+    static void fillDelayLines(AECProcessor& a, uint32_t& seed);
+    static void updateDelay(AECProcessor& a) { a.updateDelay(); }
+    static void frequencyDomain(AECProcessor& a, const float* mic, const float* ref, float* out, size_t frames) {
+        a.processFrequencyDomain(mic, ref, out, frames);
+    }
+    static void timeDomain(AECProcessor& a, const float* mic, const float* ref, float* out, size_t frames) {
+        a.processTimeDomain(mic, ref, out, frames);
+    }
+    static int blockLen(const AECProcessor& a) { return a.fdafM; }
+};
+
+static inline float noise(uint32_t& s) {
+    s = s * 1664525u + 1013904223u;
+    return (float)((int32_t)s) * (1.0f / 2147483648.0f) * 0.5f;
+}
+
+void AECBenchAccess::fillBlock(AECProcessor& a, uint32_t& seed) {
+    for (int i = 0; i < a.fdafM; ++i) {
+        a.fdafRefBuf[i] = noise(seed);
+        a.fdafMicBuf[i] = 0.5f * a.fdafRefBuf[i] + 0.01f * noise(seed);
+    }
+}
+
+void AECBenchAccess::fillDelayLines(AECProcessor& a, uint32_t& seed) {
+    for (auto& v : a.refDelay) v = noise(seed);
+    for (auto& v : a.micDelay) v = noise(seed);
+}
+
+struct BenchResult {
+    std::string kernel;
+    std::string config;
+    double nsPerCall;
+    double samplesPerCall;
+    double samplesPerSec;
+    double rtMultiple;
+    uint64_t iterations;
+};
+
+struct BenchOptions {
+    int sampleRate;
+    double minTimeSec;
+    int repeats;
+    std::string filter;
+    std::string jsonPath;
+};
+
+static volatile float gSink = 0.0f;
+
+// Runs fn in batches until minTime has elapsed, repeats, keeps the fastest run.
+static BenchResult runBench(const BenchOptions& o, const std::string& kernel, const std::string& config,
+                            double samplesPerCall, const std::function<void()>& fn) {
+    using clock = std::chrono::steady_clock;
+    for (int i = 0; i < 3; ++i) fn(); // warm-up
+
+    double best = 1e30;
+    uint64_t bestIters = 0;
+    for (int r = 0; r < o.repeats; ++r) {
+        uint64_t iters = 0;
+        uint64_t batch = 1;
+        auto t0 = clock::now();
+        double elapsed = 0.0;
+        while (elapsed < o.minTimeSec) {
+            for (uint64_t i = 0; i < batch; ++i) fn();
+            iters += batch;
+            elapsed = std::chrono::duration<double>(clock::now() - t0).count();
+            if (batch < (1u << 16)) batch <<= 1;
+        }
+        double ns = elapsed * 1e9 / (double)iters;
+        if (ns < best) { best = ns; bestIters = iters; }
+    }
+
+    BenchResult res;
+    res.kernel = kernel;
+    res.config = config;
+    res.nsPerCall = best;
+    res.samplesPerCall = samplesPerCall;
+    res.samplesPerSec = samplesPerCall * 1e9 / best;
+    res.rtMultiple = res.samplesPerSec / (double)o.sampleRate;
+    res.iterations = bestIters;
+    printf("%-24s %-28s %12.0f ns %14.0f smp/s %10.1fx RT\n",
+           kernel.c_str(), config.c_str(), res.nsPerCall, res.samplesPerSec, res.rtMultiple);
+    fflush(stdout);
+    return res;
+}
+
+// --filter takes exact kernel names, comma-separated
+static bool selected(const BenchOptions& o, const std::string& kernel) {
+    if (o.filter.empty()) return true;
+    size_t pos = 0;
+    for (;;) {
+        size_t end = o.filter.find(',', pos);
+        if (o.filter.compare(pos, end == std::string::npos ? std::string::npos : end - pos, kernel) == 0) return true;
+        if (end == std::string::npos) return false;
+        pos = end + 1;
+    }
+}
+
+static AECParams defaultParams(int sampleRate, int filterLen, int maxDelayMs) {
+    AECParams p = defaultAECParams(sampleRate);
+    p.filterLen = filterLen;
+    p.maxDelayMs = maxDelayMs;
+    return p;
+}
+
+static void benchFft(const BenchOptions& o, std::vector<BenchResult>& out) {
+    uint32_t seed = 1;
+    for (size_t n = 64; n <= 8192; n <<= 1) {
+        // Each call transforms a copy of the same input: running in place on the previous
+        // output grows the values to Inf/NaN and times the slow path
+        std::vector<std::complex<float>> input(n), spectrum(n), buf(n);
+        for (auto& v : input) v = { noise(seed), 0.0f };
+        spectrum = input;
+        FftUtil::fft(spectrum);
+        std::string cfg = "n=" + std::to_string(n);
+        if (selected(o, "fft")) {
+            out.push_back(runBench(o, "fft", cfg, (double)n, [&]() {
+                std::copy(input.begin(), input.end(), buf.begin());
+                FftUtil::fft(buf);
+                gSink = gSink + buf[1].real() * 1e-30f;
+            }));
+        }
+        if (selected(o, "ifft")) {
+            out.push_back(runBench(o, "ifft", cfg, (double)n, [&]() {
+                std::copy(spectrum.begin(), spectrum.end(), buf.begin());
+                FftUtil::ifft(buf);
+                gSink = gSink + buf[1].real() * 1e-30f;
+            }));
+        }
+
+        // Out of place: the inputs are never written
+        RealFft rfft;
+        rfft.init(n);
+        std::vector<float> real(n), realOut(n);
+        std::vector<std::complex<float>> half(rfft.bins()), halfIn(rfft.bins());
+        for (auto& v : real) v = noise(seed);
+        rfft.forward(real.data(), halfIn.data());
+        if (selected(o, "rfft")) {
+            out.push_back(runBench(o, "rfft", cfg, (double)n, [&]() {
+                rfft.forward(real.data(), half.data());
+                gSink = gSink + half[1].real() * 1e-30f;
+            }));
+        }
+        if (selected(o, "irfft")) {
+            out.push_back(runBench(o, "irfft", cfg, (double)n, [&]() {
+                rfft.inverse(halfIn.data(), realOut.data());
+                gSink = gSink + realOut[1] * 1e-30f;
+            }));
+        }
+    }
+}
+
+static void benchBlockFdaf(const BenchOptions& o, std::vector<BenchResult>& out) {
+    if (!selected(o, "performBlockFdaf")) return;
+    // 0: default, 1: generic per-bin loops where the layout has a specialization,
+    // 2: proportionate update, 3-5: reduced-precision spectrum storage
+    for (int variant = 0; variant < 6; ++variant) {
+        for (int len = 256; len <= 8192; len <<= 1) {
+            AECProcessor aec;
+            AECParams p = defaultParams(o.sampleRate, len, 80);
+            p.proportionate = variant == 2;
+            if (variant == 3) p.historyPrecision = SpectrumPrecision::Float16;
+            if (variant == 4) p.historyPrecision = SpectrumPrecision::BFloat16;
+            if (variant == 5) {
+                p.historyPrecision = SpectrumPrecision::Float16;
+                p.weightPrecision = SpectrumPrecision::Float16;
+            }
+            aec.initialize(p);
+            if (variant == 1) {
+                if (!AECBenchAccess::specialized(aec)) continue;
+                AECBenchAccess::useGenericKernels(aec);
+            }
+            // Keep the adaptation path active (worst case): DTD never triggers
+            aec.setDtdParams(1e30f, 1.5f);
+            uint32_t seed = 7;
+            AECBenchAccess::fillBlock(aec, seed);
+            int m = AECBenchAccess::blockLen(aec);
+            const char* tag[] = { "", " generic", " proportionate", " fp16 history", " bf16 history", " fp16 X+W" };
+            std::string cfg = "filterLen=" + std::to_string(len) + tag[variant];
+            out.push_back(runBench(o, "performBlockFdaf", cfg, (double)m, [&]() {
+                AECBenchAccess::blockFdaf(aec);
+            }));
+        }
+    }
+}
+
+static void benchUpdateDelay(const BenchOptions& o, std::vector<BenchResult>& out) {
+    if (!selected(o, "updateDelay")) return;
+    const int delays[] = { 20, 40, 80, 160, 320, 500 };
+    for (int d : delays) {
+        AECParams p = defaultParams(o.sampleRate, 1024, d);
+        AECProcessor aec;
+        aec.initialize(p);
+        uint32_t seed = 3;
+        AECBenchAccess::fillDelayLines(aec, seed);
+        // One estimate per correlation block
+        out.push_back(runBench(o, "updateDelay", "maxDelayMs=" + std::to_string(d), (double)p.corrBlock, [&]() {
+            AECBenchAccess::updateDelay(aec);
+        }));
+    }
+}
+
+static void benchFrequencyDomain(const BenchOptions& o, std::vector<BenchResult>& out) {
+    if (!selected(o, "processFrequencyDomain")) return;
+    const size_t frames[] = { 1, 160, 256, 441, 480, 512, 1024 };
+    for (size_t n : frames) {
+        AECProcessor aec;
+        aec.initialize(defaultParams(o.sampleRate, 2048, 80));
+        // A few seconds of signal, cycled so the delay estimator sees real content
+        size_t total = (size_t)o.sampleRate * 2;
+        total -= total % n;
+        std::vector<float> mic(total), ref(total), res(n);
+        uint32_t seed = 11;
+        for (size_t i = 0; i < total; ++i) {
+            ref[i] = noise(seed);
+            mic[i] = (i >= 64 ? 0.5f * ref[i - 64] : 0.0f) + 0.01f * noise(seed);
+        }
+        size_t pos = 0;
+        out.push_back(runBench(o, "processFrequencyDomain", "filterLen=2048 frames=" + std::to_string(n), (double)n, [&]() {
+            AECBenchAccess::frequencyDomain(aec, mic.data() + pos, ref.data() + pos, res.data(), n);
+            pos += n;
+            if (pos >= total) pos = 0;
+        }));
+    }
+}
+
+// Time-domain modes at headset filter lengths, adapting on every sample
+static void benchTimeDomain(const BenchOptions& o, std::vector<BenchResult>& out) {
+    if (!selected(o, "processTimeDomain")) return;
+    const AECFilterMode modes[] = { AECFilterMode::Nlms, AECFilterMode::BlockNlms };
+    const char* names[] = { "nlms", "block" };
+    const size_t n = 160;
+    for (int len = 128; len <= 1024; len <<= 1) {
+        for (int m = 0; m < 2; ++m) {
+            AECProcessor aec;
+            aec.setFilterMode(modes[m]);
+            // No delay search (maxDelayMs 0), so the time is the filter's own
+            aec.initialize(defaultParams(o.sampleRate, len, 0));
+            aec.setDtdParams(1e30f, 1.5f);
+            size_t total = (size_t)o.sampleRate * 2;
+            total -= total % n;
+            std::vector<float> mic(total), ref(total), res(n);
+            uint32_t seed = 11;
+            for (size_t i = 0; i < total; ++i) {
+                ref[i] = noise(seed);
+                mic[i] = (i >= 64 ? 0.5f * ref[i - 64] : 0.0f) + 0.01f * noise(seed);
+            }
+            size_t pos = 0;
+            std::string cfg = std::string(names[m]) + " filterLen=" + std::to_string(len) + " frames=" + std::to_string(n);
+            out.push_back(runBench(o, "processTimeDomain", cfg, (double)n, [&]() {
+                AECBenchAccess::timeDomain(aec, mic.data() + pos, ref.data() + pos, res.data(), n);
+                pos += n;
+                if (pos >= total) pos = 0;
+            }));
+        }
+    }
+}
+
+static void benchEnhancer(const BenchOptions& o, std::vector<BenchResult>& out) {
+    if (!selected(o, "AIEnhancer")) return;
+    const size_t frames[] = { 1, 160, 256, 441, 480, 1024 };
+    for (size_t n : frames) {
+        AIParams ip;
+        ip.sampleRate = o.sampleRate;
+        ip.channels = 1;
+        AIEnhancer ai;
+        ai.initialize(ip);
+        std::vector<float> buf(n);
+        uint32_t seed = 5;
+        out.push_back(runBench(o, "AIEnhancer::process", "frames=" + std::to_string(n), (double)n, [&]() {
+            for (auto& v : buf) v = noise(seed);
+            ai.process(buf.data(), n);
+        }));
+    }
+}
+
+// Canceller plus noise suppression: the cascade pays the enhancer's own STFT on top
+static void benchPipeline(const BenchOptions& o, std::vector<BenchResult>& out) {
+    if (!selected(o, "AECPipeline")) return;
+    const PipelineMode modes[] = { PipelineMode::AecOnly, PipelineMode::Cascade, PipelineMode::Fused };
+    const char* names[] = { "aec", "cascade", "fused" };
+    const size_t n = 480;
+    for (int m = 0; m < 3; ++m) {
+        AECPipeline pipe;
+        pipe.initialize(defaultParams(o.sampleRate, 2048, 80), modes[m]);
+        size_t total = (size_t)o.sampleRate * 2;
+        total -= total % n;
+        std::vector<float> mic(total), ref(total), res(n);
+        uint32_t seed = 11;
+        for (size_t i = 0; i < total; ++i) {
+            ref[i] = noise(seed);
+            mic[i] = (i >= 64 ? 0.5f * ref[i - 64] : 0.0f) + 0.01f * noise(seed);
+        }
+        size_t pos = 0;
+        std::string cfg = std::string(names[m]) + " frames=" + std::to_string(n);
+        out.push_back(runBench(o, "AECPipeline::process", cfg, (double)n, [&]() {
+            pipe.process(mic.data() + pos, ref.data() + pos, res.data(), n);
+            pos += n;
+            if (pos >= total) pos = 0;
+        }));
+    }
+}
+
+// kLanes sessions in one lockstep engine; samples count over all lanes, so the rate
+// compares directly with processFrequencyDomain (one session per call)
+static void benchLockstep(const BenchOptions& o, std::vector<BenchResult>& out) {
+    if (!selected(o, "AECLockstep")) return;
+    const size_t L = AECLockstep::kLanes;
+    const size_t n = 480;
+    for (int len = 1024; len <= 4096; len <<= 1) {
+        AECLockstep ls;
+        ls.initialize(defaultParams(o.sampleRate, len, 80));
+        size_t total = (size_t)o.sampleRate * 2;
+        total -= total % n;
+        std::vector<std::vector<float>> mic(L, std::vector<float>(total)), ref(L, std::vector<float>(total));
+        std::vector<std::vector<float>> res(L, std::vector<float>(n));
+        uint32_t seed = 11;
+        for (size_t l = 0; l < L; ++l) {
+            size_t lag = 32 + 16 * l;
+            for (size_t i = 0; i < total; ++i) {
+                ref[l][i] = noise(seed);
+                mic[l][i] = (i >= lag ? 0.5f * ref[l][i - lag] : 0.0f) + 0.01f * noise(seed);
+            }
+        }
+        size_t pos = 0;
+        const float* m[AECLockstep::kLanes];
+        const float* r[AECLockstep::kLanes];
+        float* y[AECLockstep::kLanes];
+        std::string cfg = "lanes=" + std::to_string(L) + " filterLen=" + std::to_string(len) + " frames=" + std::to_string(n);
+        out.push_back(runBench(o, "AECLockstep::process", cfg, (double)(n * L), [&]() {
+            for (size_t l = 0; l < L; ++l) {
+                m[l] = mic[l].data() + pos;
+                r[l] = ref[l].data() + pos;
+                y[l] = res[l].data();
+            }
+            ls.process(m, r, y, n);
+            pos += n;
+            if (pos >= total) pos = 0;
+        }));
+    }
+}
+
+// Per-packet format conversion at small buffer sizes, next to the per-sample
+// lround loop it replaced
+static void benchConvert(const BenchOptions& o, std::vector<BenchResult>& out) {
+    const size_t frames[] = { 160, 480 };
+    for (size_t n : frames) {
+        std::string cfg = "frames=" + std::to_string(n);
+        std::vector<float> x(2 * n), y(2 * n);
+        std::vector<int16_t> pcm(2 * n);
+        std::vector<uint8_t> bytes(2 * n * 4);
+        uint32_t seed = 13;
+        for (auto& v : x) v = noise(seed);
+        if (selected(o, "floatToInt16")) {
+            out.push_back(runBench(o, "floatToInt16", cfg + " lround", (double)n, [&]() {
+                for (size_t i = 0; i < n; i++) {
+                    float v = std::max(-1.0f, std::min(1.0f, x[i]));
+                    pcm[i] = (int16_t)std::lround(v * 32767.0f);
+                }
+                gSink = gSink + (float)pcm[n - 1];
+            }));
+            out.push_back(runBench(o, "floatToInt16", cfg, (double)n, [&]() {
+                floatToInt16(x.data(), pcm.data(), n);
+                gSink = gSink + (float)pcm[n - 1];
+            }));
+            uint32_t dither = 0;
+            out.push_back(runBench(o, "floatToInt16", cfg + " dither", (double)n, [&]() {
+                floatToInt16(x.data(), pcm.data(), n, &dither);
+                gSink = gSink + (float)pcm[n - 1];
+            }));
+        }
+        if (selected(o, "decodeDownmix")) {
+            encodeSamples(WavSampleFormat::Int16, x.data(), bytes.data(), 2 * n);
+            const float gains[2] = { 0.5f, 0.5f };
+            out.push_back(runBench(o, "decodeDownmix", cfg + " int16 stereo", (double)n, [&]() {
+                decodeDownmix(WavSampleFormat::Int16, bytes.data(), 2, gains, y.data(), n);
+                gSink = gSink + y[n - 1];
+            }));
+            encodeSamples(WavSampleFormat::Int24, x.data(), bytes.data(), 2 * n);
+            out.push_back(runBench(o, "decodeDownmix", cfg + " int24 stereo", (double)n, [&]() {
+                decodeDownmix(WavSampleFormat::Int24, bytes.data(), 2, gains, y.data(), n);
+                gSink = gSink + y[n - 1];
+            }));
+        }
+        if (selected(o, "deinterleave")) {
+            float* const chans[2] = { y.data(), y.data() + n };
+            out.push_back(runBench(o, "deinterleave", cfg + " stereo", (double)n, [&]() {
+                deinterleave(x.data(), 2, chans, n);
+                gSink = gSink + y[n - 1];
+            }));
+        }
+    }
+}
+
+static bool writeJson(const std::string& path, const BenchOptions& o, const std::vector<BenchResult>& res) {
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) return false;
+    fprintf(f, "{\n  \"sampleRate\": %d,\n  \"results\": [\n", o.sampleRate);
+    for (size_t i = 0; i < res.size(); ++i) {
+        const BenchResult& r = res[i];
+        fprintf(f, "    {\"kernel\": \"%s\", \"config\": \"%s\", \"nsPerCall\": %.1f, \"samplesPerCall\": %.0f, "
+                   "\"samplesPerSec\": %.1f, \"rtMultiple\": %.2f, \"iterations\": %llu}%s\n",
+                r.kernel.c_str(), r.config.c_str(), r.nsPerCall, r.samplesPerCall, r.samplesPerSec,
+                r.rtMultiple, (unsigned long long)r.iterations, i + 1 < res.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+    return true;
+}
+
+static void usage() {
+    fprintf(stderr,
+        "Usage: aec_bench [--sr 48000] [--time sec] [--repeats n] [--filter kernel[,kernel...]] [--json out.json]\n"
+        "Kernels: fft, ifft, rfft, irfft, performBlockFdaf, updateDelay, processFrequencyDomain, processTimeDomain,\n"
+        "         AIEnhancer, AECPipeline, AECLockstep, floatToInt16, decodeDownmix, deinterleave\n");
+}
+
+int main(int argc, char** argv) {
+    BenchOptions o;
+    o.sampleRate = 48000;
+    o.minTimeSec = 0.2;
+    o.repeats = 3;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "--sr" && i + 1 < argc) {
+            o.sampleRate = atoi(argv[++i]);
+        } else if (a == "--time" && i + 1 < argc) {
+            o.minTimeSec = atof(argv[++i]);
+        } else if (a == "--repeats" && i + 1 < argc) {
+            o.repeats = atoi(argv[++i]);
+        } else if (a == "--filter" && i + 1 < argc) {
+            o.filter = argv[++i];
+        } else if (a == "--json" && i + 1 < argc) {
+            o.jsonPath = argv[++i];
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (o.sampleRate <= 0 || o.repeats <= 0 || o.minTimeSec <= 0.0) {
+        usage();
+        return 1;
+    }
+
+    std::vector<BenchResult> results;
+    benchFft(o, results);
+    benchBlockFdaf(o, results);
+    benchUpdateDelay(o, results);
+    benchFrequencyDomain(o, results);
+    benchTimeDomain(o, results);
+    benchEnhancer(o, results);
+    benchPipeline(o, results);
+    benchLockstep(o, results);
+    benchConvert(o, results);
+
+    if (!o.jsonPath.empty() && !writeJson(o.jsonPath, o, results)) {
+        fprintf(stderr, "JSON write error: %s\n", o.jsonPath.c_str());
+        return 2;
+    }
+    return 0;
+}
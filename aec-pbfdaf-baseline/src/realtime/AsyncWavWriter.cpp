@@ -0,0 +1,192 @@
+#include "AsyncWavWriter.h"
+#include "../audio_io/SampleConvert.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <numeric>
+
+// Samples start at this file offset, so every full batch lands page-aligned
+static const size_t kDataOffset = 4096;
+static const size_t kBatchBytes = 32 * 1024;
+// The writer thread re-checks the queue at least this often (a notify can race
+// with the start of its wait)
+static const int kPollMs = 10;
+// Header layout: RIFF, a JUNK chunk reserving the RF64 ds64 chunk, fmt, a JUNK
+// pad up to kDataOffset, then the data chunk header
+static const size_t kDs64Offset = 12;
+static const size_t kDs64Size = 28;
+static const size_t kFmtOffset = kDs64Offset + 8 + kDs64Size;
+static const size_t kPadOffset = kFmtOffset + 8 + 16;
+static const size_t kDataHeaderOffset = kDataOffset - 8;
+
+static void putU16(uint8_t* p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void putU32(uint8_t* p, uint32_t v) { for (int i = 0; i < 4; ++i) p[i] = (uint8_t)(v >> (8 * i)); }
+static void putU64(uint8_t* p, uint64_t v) { for (int i = 0; i < 8; ++i) p[i] = (uint8_t)(v >> (8 * i)); }
+
+AsyncWavWriter::AsyncWavWriter() :
+    f(nullptr), ch(0), format(WavOutputFormat::Int16), sampleBytes(2), batchSamples(0),
+    ioData(nullptr), dataBytes(0), closing(false),
+    written(0), droppedFrames(0), droppedBlocks(0), batches(0), maxQueue(0), failed(false) {}
+
+AsyncWavWriter::~AsyncWavWriter() {
+    close();
+}
+
+bool AsyncWavWriter::open(const std::string& path, int sampleRate, int channels, WavOutputFormat fmt,
+                          int queueMs, std::string& err) {
+    close();
+    if (sampleRate <= 0 || channels <= 0) { err = "Invalid output format"; return false; }
+    f = fopen(path.c_str(), "wb");
+    if (!f) { err = "Cannot open " + path; return false; }
+    // Batches are already large; stdio buffering would only split them up
+    setvbuf(f, nullptr, _IONBF, 0);
+    ch = channels;
+    format = fmt;
+    sampleBytes = fmt == WavOutputFormat::Float32 ? 4 : 2;
+    // Whole frames in a multiple of kBatchBytes (96 KB for 3 or 6 channels)
+    size_t unit = kBatchBytes / sampleBytes;
+    batchSamples = unit / std::gcd(unit, (size_t)channels) * (size_t)channels;
+
+    uint8_t h[kDataOffset];
+    std::memset(h, 0, sizeof(h));
+    uint16_t bps = (uint16_t)(sampleBytes * 8);
+    uint16_t blockalign = (uint16_t)(channels * sampleBytes);
+    std::memcpy(h, "RIFF", 4); putU32(h + 4, 0);
+    std::memcpy(h + 8, "WAVE", 4);
+    std::memcpy(h + kDs64Offset, "JUNK", 4); putU32(h + kDs64Offset + 4, (uint32_t)kDs64Size);
+    uint8_t* fm = h + kFmtOffset;
+    std::memcpy(fm, "fmt ", 4); putU32(fm + 4, 16);
+    putU16(fm + 8, fmt == WavOutputFormat::Float32 ? 3 : 1); putU16(fm + 10, (uint16_t)channels);
+    putU32(fm + 12, (uint32_t)sampleRate); putU32(fm + 16, (uint32_t)sampleRate * blockalign);
+    putU16(fm + 20, blockalign); putU16(fm + 22, bps);
+    std::memcpy(h + kPadOffset, "JUNK", 4); putU32(h + kPadOffset + 4, (uint32_t)(kDataHeaderOffset - kPadOffset - 8));
+    std::memcpy(h + kDataHeaderOffset, "data", 4); putU32(h + kDataHeaderOffset + 4, 0);
+    if (fwrite(h, 1, sizeof(h), f) != sizeof(h)) {
+        fclose(f);
+        f = nullptr;
+        err = "Write error: " + path;
+        return false;
+    }
+
+    size_t queueSamples = (size_t)sampleRate * (size_t)std::max(1, queueMs) / 1000 * (size_t)channels;
+    queue.reset(std::max(queueSamples, 2 * batchSamples));
+    staging.assign(batchSamples, 0.0f);
+    io.assign(batchSamples * sampleBytes + kDataOffset, 0);
+    uintptr_t base = (uintptr_t)io.data();
+    ioData = io.data() + ((kDataOffset - base % kDataOffset) % kDataOffset);
+    dataBytes = 0;
+    written.store(0);
+    droppedFrames.store(0);
+    droppedBlocks.store(0);
+    batches.store(0);
+    maxQueue.store(0);
+    failed.store(false);
+    closing = false;
+    worker = std::thread(&AsyncWavWriter::run, this);
+    return true;
+}
+
+bool AsyncWavWriter::write(const float* data, size_t frames) {
+    if (!f || frames == 0) return f != nullptr;
+    size_t n = frames * (size_t)ch;
+    if (failed.load(std::memory_order_relaxed) || !queue.push(data, n)) {
+        droppedFrames.fetch_add(frames, std::memory_order_relaxed);
+        droppedBlocks.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    size_t fill = queue.capacity() - queue.space();
+    if (fill / (size_t)ch > maxQueue.load(std::memory_order_relaxed)) maxQueue.store(fill / (size_t)ch, std::memory_order_relaxed);
+    if (fill >= batchSamples) cv.notify_one();
+    return true;
+}
+
+void AsyncWavWriter::run() {
+    while (true) {
+        bool last;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait_for(lock, std::chrono::milliseconds(kPollMs), [this] {
+                return closing || queue.available() >= batchSamples;
+            });
+            last = closing;
+        }
+        while (queue.available() >= batchSamples && !failed.load()) {
+            if (!writeBatch(batchSamples)) failed.store(true);
+        }
+        if (last) {
+            size_t rest = queue.available();
+            if (rest > 0 && !failed.load() && !writeBatch(rest)) failed.store(true);
+            return;
+        }
+    }
+}
+
+bool AsyncWavWriter::writeBatch(size_t samples) {
+    queue.pop(staging.data(), samples);
+    encodeSamples(format == WavOutputFormat::Float32 ? WavSampleFormat::Float32 : WavSampleFormat::Int16,
+                  staging.data(), ioData, samples);
+    size_t bytes = samples * sampleBytes;
+    size_t w = fwrite(ioData, 1, bytes, f);
+    dataBytes += w;
+    written.fetch_add((uint64_t)(w / sampleBytes / (size_t)ch), std::memory_order_relaxed);
+    batches.fetch_add(1, std::memory_order_relaxed);
+    return w == bytes;
+}
+
+static bool seek64(FILE* f, uint64_t pos) {
+#ifdef _WIN32
+    return _fseeki64(f, (long long)pos, SEEK_SET) == 0;
+#else
+    return fseeko(f, (off_t)pos, SEEK_SET) == 0;
+#endif
+}
+
+bool AsyncWavWriter::finishHeader() {
+    uint64_t riff = (uint64_t)kDataOffset - 8 + dataBytes;
+    uint8_t b[8 + kDs64Size];
+    bool ok = true;
+    if (riff <= 0xFFFFFFFFull) {
+        putU32(b, (uint32_t)riff);
+        ok = ok && seek64(f, 4) && fwrite(b, 1, 4, f) == 4;
+        putU32(b, (uint32_t)dataBytes);
+        ok = ok && seek64(f, kDataHeaderOffset + 4) && fwrite(b, 1, 4, f) == 4;
+        return ok;
+    }
+    // RF64: 32-bit sizes become 0xFFFFFFFF and the reserved chunk turns into ds64
+    ok = ok && seek64(f, 0) && fwrite("RF64\xFF\xFF\xFF\xFF", 1, 8, f) == 8;
+    std::memcpy(b, "ds64", 4);
+    putU32(b + 4, (uint32_t)kDs64Size);
+    putU64(b + 8, riff);
+    putU64(b + 16, dataBytes);
+    putU64(b + 24, dataBytes / sampleBytes / (uint64_t)ch);
+    putU32(b + 32, 0);
+    ok = ok && seek64(f, kDs64Offset) && fwrite(b, 1, sizeof(b), f) == sizeof(b);
+    putU32(b, 0xFFFFFFFFu);
+    ok = ok && seek64(f, kDataHeaderOffset + 4) && fwrite(b, 1, 4, f) == 4;
+    return ok;
+}
+
+bool AsyncWavWriter::close() {
+    if (!f) return true;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        closing = true;
+    }
+    cv.notify_one();
+    if (worker.joinable()) worker.join();
+    bool ok = !failed.load() && finishHeader();
+    ok = (fclose(f) == 0) && ok;
+    f = nullptr;
+    return ok;
+}
+
+AsyncWavStats AsyncWavWriter::getStats() const {
+    AsyncWavStats s;
+    s.writtenFrames = written.load(std::memory_order_relaxed);
+    s.droppedFrames = droppedFrames.load(std::memory_order_relaxed);
+    s.droppedBlocks = droppedBlocks.load(std::memory_order_relaxed);
+    s.batches = batches.load(std::memory_order_relaxed);
+    s.maxQueueFrames = maxQueue.load(std::memory_order_relaxed);
+    s.ioError = failed.load(std::memory_order_relaxed);
+    return s;
+}
@@ -0,0 +1,75 @@
+#pragma once
+// WAV recorder for the real-time path. write() copies a block into a lock-free
+// queue and returns; a background thread converts and writes the queue in large
+// batches at page-aligned file offsets. A block that does not fit (the disk
+// stalled for longer than the queue holds) is dropped and counted, never waited
+// for. Int16 or float32 samples; files past 4 GB get an RF64 header on close().
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SpscRing.h"
+
+enum class WavOutputFormat { Int16, Float32 };
+
+struct AsyncWavStats {
+    uint64_t writtenFrames;
+    uint64_t droppedFrames;
+    uint64_t droppedBlocks;
+    uint64_t batches;         // Write calls issued by the background thread
+    uint64_t maxQueueFrames;  // Deepest the queue got
+    bool ioError;             // A write failed; later blocks are dropped
+};
+
+class AsyncWavWriter {
+public:
+    AsyncWavWriter();
+    ~AsyncWavWriter();
+
+    // queueMs: audio the queue absorbs while the disk is slow
+    bool open(const std::string& path, int sampleRate, int channels, WavOutputFormat fmt,
+              int queueMs, std::string& err);
+    // Real-time safe (no locks, no allocation). False if the block was dropped.
+    bool write(const float* interleaved, size_t frames);
+    // Once the producer is done: writes what is queued, fixes up the header and
+    // joins the thread
+    bool close();
+    bool isOpen() const { return f != nullptr; }
+    // Valid after close() too
+    AsyncWavStats getStats() const;
+
+private:
+    AsyncWavWriter(const AsyncWavWriter&) = delete;
+    AsyncWavWriter& operator=(const AsyncWavWriter&) = delete;
+    void run();
+    bool writeBatch(size_t samples);
+    bool finishHeader();
+
+    FILE* f;
+    int ch;
+    WavOutputFormat format;
+    size_t sampleBytes;
+    size_t batchSamples;
+    SpscRing<float> queue;
+    std::vector<float> staging;
+    std::vector<uint8_t> io;   // Conversion buffer; ioData is its page-aligned start
+    uint8_t* ioData;
+    uint64_t dataBytes;
+
+    std::thread worker;
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool closing;
+
+    std::atomic<uint64_t> written;
+    std::atomic<uint64_t> droppedFrames;
+    std::atomic<uint64_t> droppedBlocks;
+    std::atomic<uint64_t> batches;
+    std::atomic<uint64_t> maxQueue;
+    std::atomic<bool> failed;
+};
@@ -0,0 +1,42 @@
+#pragma once
+// Capture/render side of the real-time path, independent of the audio API.
+// A backend delivers the near-end mic and the far-end (loopback) reference as
+// mono float packets already aligned to each other, and takes the processed
+// output back. RealtimeEngine calls capture() from its capture thread and
+// render() from its processing thread; start()/stop() belong to the owner.
+
+#include <cstddef>
+#include <string>
+#include "AsyncWavWriter.h"
+#include "JitterBuffer.h"
+
+class AudioBackend {
+public:
+    virtual ~AudioBackend() {}
+    virtual const char* name() const = 0;
+
+    // Opens the devices (or inputs) and starts capturing; sampleRate() is valid after
+    virtual bool start(std::string& err) = 0;
+    virtual void stop() = 0;
+    virtual int sampleRate() const = 0;
+
+    // Waits up to timeoutMs for the next packet. Returns its length in frames (0 on
+    // timeout, -1 at the end of the stream or on a device error); mic and ref point
+    // at the packet until the next call.
+    virtual int capture(const float** mic, const float** ref, int timeoutMs) = 0;
+    // Processed output, in capture order
+    virtual bool render(const float* out, size_t frames) = 0;
+
+    // Per-thread setup/teardown on the engine's threads (COM, scheduling class)
+    virtual void threadStarted(bool captureThread) { (void)captureThread; }
+    virtual void threadStopping(bool captureThread) { (void)captureThread; }
+
+    // Stable endpoint ids for EchoPathCache keys (empty when there are none)
+    virtual std::string micId() const { return std::string(); }
+    virtual std::string refId() const { return std::string(); }
+
+    // Mic/ref alignment counters, for backends that align through a JitterBuffer
+    virtual bool getJitterStats(JitterStats& s) const { (void)s; return false; }
+    // Output recorder counters, for backends that record through an AsyncWavWriter
+    virtual bool getWriterStats(AsyncWavStats& s) const { (void)s; return false; }
+};
@@ -0,0 +1,157 @@
+#include "FileBackend.h"
+#include <algorithm>
+#include <thread>
+
+// Output the recorder queues while the disk is slow
+static const int kWriterQueueMs = 2000;
+
+FileBackend::FileBackend() :
+    rate(0), packetMs(10), speed(1.0), outFormat(WavOutputFormat::Int16), writing(false),
+    simulate(false), jitterMs(0.0), refPacketMs(0), holdMs(0), refPos(0), rng(1),
+    packetFrames(0), pos(0), rendered(0), maxLate(0.0) {}
+
+static bool readAll(const std::string& path, std::vector<float>& dst, int& sampleRate) {
+    WavFileReader r;
+    if (!r.open(path)) return false;
+    sampleRate = r.info().sampleRate;
+    dst.resize((size_t)r.info().frames);
+    size_t got = 0;
+    while (got < dst.size()) {
+        size_t n = r.readMono(dst.data() + got, dst.size() - got);
+        if (n == 0) break;
+        got += n;
+    }
+    dst.resize(got);
+    return true;
+}
+
+bool FileBackend::openWav(const std::string& micPath, const std::string& refPath, std::string& err) {
+    int micRate = 0, refRate = 0;
+    if (!readAll(micPath, micSig, micRate)) { err = "Cannot read " + micPath; return false; }
+    if (!readAll(refPath, refSig, refRate)) { err = "Cannot read " + refPath; return false; }
+    if (micRate != refRate) { err = "Sample rate mismatch"; return false; }
+    rate = micRate;
+    return true;
+}
+
+void FileBackend::setSignals(const std::vector<float>& mic, const std::vector<float>& ref, int sampleRate) {
+    micSig = mic;
+    refSig = ref;
+    rate = sampleRate;
+}
+
+void FileBackend::setPacing(int ms, double x) {
+    packetMs = ms > 0 ? ms : 10;
+    speed = x > 0.0 ? x : 0.0;
+}
+
+void FileBackend::setDeviceSimulation(double jitter, int refMs, int hold) {
+    simulate = true;
+    jitterMs = jitter > 0.0 ? jitter : 0.0;
+    refPacketMs = refMs > 0 ? refMs : 10;
+    holdMs = hold > 0 ? hold : 0;
+}
+
+bool FileBackend::start(std::string& err) {
+    if (rate <= 0) { err = "No input signals"; return false; }
+    // Shorter input is padded with silence up to the longer one
+    size_t len = std::max(micSig.size(), refSig.size());
+    micSig.resize(len, 0.0f);
+    refSig.resize(len, 0.0f);
+    packetFrames = (size_t)std::max(1, rate * packetMs / 1000);
+    writing = false;
+    if (!outPath.empty()) {
+        if (!writer.open(outPath, rate, 1, outFormat, kWriterQueueMs, err)) return false;
+        writing = true;
+    }
+    if (simulate) {
+        jitter.reset(rate, 1000, holdMs);
+        micOut.assign((size_t)rate, 0.0f);
+        refOut.assign((size_t)rate, 0.0f);
+    }
+    refPos = 0;
+    rng = 1;
+    pos = 0;
+    rendered = 0;
+    maxLate = 0.0;
+    t0 = std::chrono::steady_clock::now();
+    return true;
+}
+
+void FileBackend::stop() {
+    if (writing) writer.close();
+    writing = false;
+}
+
+// Device timestamp of frame i, +-jitterMs (deterministic)
+static int64_t stampNs(size_t i, int rate, double jitterMs, uint32_t& rng) {
+    rng = rng * 1664525u + 1013904223u;
+    double u = (double)(rng >> 8) / (double)(1u << 24) * 2.0 - 1.0;
+    return (int64_t)((double)i * 1e9 / rate + u * jitterMs * 1e6);
+}
+
+int FileBackend::capture(const float** mic, const float** ref, int timeoutMs) {
+    if (pos >= micSig.size()) {
+        if (!simulate) return -1;
+        size_t got = jitter.pull(micOut.data(), refOut.data(), micOut.size(), true);
+        *mic = micOut.data();
+        *ref = refOut.data();
+        return got > 0 ? (int)got : -1;
+    }
+    size_t n = std::min(packetFrames, micSig.size() - pos);
+    if (speed > 0.0) {
+        // A packet is due once its last frame has "been recorded"
+        auto due = t0 + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>((double)(pos + n) / ((double)rate * speed)));
+        auto now = std::chrono::steady_clock::now();
+        auto limit = now + std::chrono::milliseconds(std::max(0, timeoutMs));
+        if (due > limit) {
+            std::this_thread::sleep_until(limit);
+            return 0;
+        }
+        if (due > now) std::this_thread::sleep_until(due);
+        double late = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - due).count();
+        maxLate = std::max(maxLate, late);
+    }
+    if (!simulate) {
+        *mic = micSig.data() + pos;
+        *ref = refSig.data() + pos;
+        pos += n;
+        return (int)n;
+    }
+
+    jitter.pushMic(micSig.data() + pos, n, stampNs(pos, rate, jitterMs, rng), (int64_t)pos);
+    pos += n;
+    // Reference packets completed by now; silent ones never arrive (loopback)
+    size_t refPacket = (size_t)std::max(1, rate * refPacketMs / 1000);
+    while (refPos < refSig.size() && (refPos + refPacket <= pos || pos >= micSig.size())) {
+        size_t m = std::min(refPacket, refSig.size() - refPos);
+        const float* r = refSig.data() + refPos;
+        bool silent = std::all_of(r, r + m, [](float v) { return v == 0.0f; });
+        if (!silent) jitter.pushRef(r, m, stampNs(refPos, rate, jitterMs, rng), (int64_t)refPos);
+        refPos += m;
+    }
+    size_t got = jitter.pull(micOut.data(), refOut.data(), micOut.size());
+    *mic = micOut.data();
+    *ref = refOut.data();
+    return (int)got;
+}
+
+bool FileBackend::render(const float* out, size_t frames) {
+    rendered += frames;
+    // A dropped block is counted by the writer; processing goes on
+    if (writing) writer.write(out, frames);
+    return true;
+}
+
+bool FileBackend::getWriterStats(AsyncWavStats& s) const {
+    if (outPath.empty()) return false;
+    s = writer.getStats();
+    return true;
+}
+
+bool FileBackend::getJitterStats(JitterStats& s) const {
+    if (!simulate) return false;
+    s = jitter.getStats();
+    return true;
+}
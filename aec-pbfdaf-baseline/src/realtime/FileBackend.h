@@ -0,0 +1,76 @@
+#pragma once
+// Deterministic stand-in for a device pair: plays mic/ref signals (WAV files or
+// buffers such as ScenarioGen output) as fixed-size packets paced against the
+// wall clock, and optionally writes the processed output to a WAV file. Runs the
+// whole real-time path on machines without audio hardware. With device
+// simulation, mic and reference arrive as separate timestamped packet streams
+// (loopback-style: silent reference packets are not delivered) and are
+// re-aligned by a JitterBuffer, as on a real device pair.
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "AudioBackend.h"
+#include "../audio_io/WavFile.h"
+
+class FileBackend : public AudioBackend {
+public:
+    FileBackend();
+
+    // Inputs (before start). Mono downmix; both files must have the same rate.
+    bool openWav(const std::string& micPath, const std::string& refPath, std::string& err);
+    void setSignals(const std::vector<float>& mic, const std::vector<float>& ref, int sampleRate);
+    // Output WAV (optional; without it output is counted and dropped), recorded
+    // off the processing thread
+    void setOutputPath(const std::string& path, WavOutputFormat fmt = WavOutputFormat::Int16) {
+        outPath = path;
+        outFormat = fmt;
+    }
+    // packetMs: audio per capture() packet; speed: 1 = real time, 2 = twice as fast,
+    // 0 = unpaced (as fast as the consumer can go; the rings will overrun)
+    void setPacing(int packetMs, double speed);
+    // Device simulation: reference packets of refPacketMs, both streams' timestamps
+    // jittered by up to +-jitterMs, mic frames wait up to holdMs for their reference
+    void setDeviceSimulation(double jitterMs, int refPacketMs, int holdMs);
+
+    const char* name() const override { return "file"; }
+    bool start(std::string& err) override;
+    void stop() override;
+    int sampleRate() const override { return rate; }
+    int capture(const float** mic, const float** ref, int timeoutMs) override;
+    bool render(const float* out, size_t frames) override;
+    bool getJitterStats(JitterStats& s) const override;
+    bool getWriterStats(AsyncWavStats& s) const override;
+
+    uint64_t renderedFrames() const { return rendered; }
+    // Latest a packet was handed out relative to its due time (pacing jitter)
+    double maxLateMs() const { return maxLate; }
+
+private:
+    std::vector<float> micSig;
+    std::vector<float> refSig;
+    int rate;
+    int packetMs;
+    double speed;
+    std::string outPath;
+    WavOutputFormat outFormat;
+    AsyncWavWriter writer;
+    bool writing;
+
+    bool simulate;
+    double jitterMs;
+    int refPacketMs;
+    int holdMs;
+    JitterBuffer jitter;
+    std::vector<float> micOut;
+    std::vector<float> refOut;
+    size_t refPos;
+    uint32_t rng;
+
+    size_t packetFrames;
+    size_t pos;
+    uint64_t rendered;
+    double maxLate;
+    std::chrono::steady_clock::time_point t0;
+};
@@ -0,0 +1,176 @@
+#include "JitterBuffer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+// Smoothed timestamp offset a stream may accumulate before it is resynchronized.
+// Below it, packet timestamp jitter does not move the samples.
+static const double kResyncToleranceMs = 2.0;
+// Per-packet weight of the timestamp offset average
+static const double kOffsetSmoothing = 0.02;
+
+// Deviation a stream's timestamps are allowed before it is moved
+double JitterBuffer::slack(const Stream& s) const {
+    return (double)tolFrames + 3.0 * s.spread;
+}
+
+JitterBuffer::JitterBuffer() :
+    rate(16000), mask(0), holdFrames(0), tolFrames(1), originNs(0), hasOrigin(false),
+    readPos(0), alignSum(0.0), alignCount(0), st() {}
+
+void JitterBuffer::reset(int sampleRate, int capacityMs, int holdMs) {
+    rate = sampleRate > 0 ? sampleRate : 16000;
+    size_t want = (size_t)std::max<int64_t>(1, (int64_t)rate * std::max(1, capacityMs) / 1000);
+    size_t cap = 1;
+    while (cap < want) cap <<= 1;
+    mask = cap - 1;
+    mic.buf.assign(cap, 0.0f);
+    ref.buf.assign(cap, 0.0f);
+    mic.write = ref.write = mic.next = ref.next = 0;
+    mic.devEnd = ref.devEnd = -1;
+    mic.offset = ref.offset = mic.spread = ref.spread = 0.0;
+    mic.started = ref.started = false;
+    holdFrames = (int64_t)rate * std::max(0, holdMs) / 1000;
+    tolFrames = std::max<int64_t>(1, (int64_t)std::llround(kResyncToleranceMs * rate / 1000.0));
+    originNs = 0;
+    hasOrigin = false;
+    readPos = 0;
+    alignSum = 0.0;
+    alignCount = 0;
+    st = JitterStats();
+}
+
+void JitterBuffer::pushMic(const float* x, size_t frames, int64_t timeNs, int64_t devicePos) {
+    push(mic, false, x, frames, timeNs, devicePos);
+}
+
+void JitterBuffer::pushRef(const float* x, size_t frames, int64_t timeNs, int64_t devicePos) {
+    push(ref, true, x, frames, timeNs, devicePos);
+}
+
+void JitterBuffer::push(Stream& s, bool isRef, const float* x, size_t frames, int64_t timeNs, int64_t devicePos) {
+    if (frames == 0 || mic.buf.empty()) return;
+    if (isRef) st.refFrames += frames;
+    else st.micFrames += frames;
+    // The timeline starts with the mic; earlier reference audio has nothing to pair with
+    if (isRef && !mic.started) { st.lateFrames += frames; return; }
+    if (!isRef && !hasOrigin && timeNs >= 0) {
+        originNs = timeNs - (int64_t)((double)mic.write * 1e9 / rate);
+        hasOrigin = true;
+    }
+    bool timed = timeNs >= 0 && hasOrigin;
+    double tsPos = timed ? (double)(timeNs - originNs) * rate * 1e-9 : 0.0;
+
+    int64_t pos;
+    if (!s.started) {
+        pos = timed ? std::llround(tsPos) : (isRef ? readPos : mic.write);
+    } else if (devicePos >= 0 && s.devEnd >= 0) {
+        // The device counter measures delivery gaps exactly
+        pos = s.next + (devicePos - s.devEnd);
+    } else if (timed) {
+        // Without it a gap is only as precise as this packet's timestamp, and is
+        // taken as one only beyond the stream's own timestamp spread
+        pos = std::llround(tsPos);
+        if ((double)std::llabs(pos - s.next) <= slack(s)) pos = s.next;
+        else s.offset = tsPos - (double)pos;
+    } else {
+        pos = s.next;
+    }
+    if (timed && s.started) {
+        double e = tsPos - (double)pos;
+        s.spread += kOffsetSmoothing * (std::fabs(e - s.offset) - s.spread);
+        s.offset += kOffsetSmoothing * (e - s.offset);
+        if (std::fabs(s.offset) > slack(s)) {
+            // The device clocks slid apart: move the stream onto its timestamps
+            int64_t shift = std::llround(s.offset);
+            pos += shift;
+            s.offset -= (double)shift;
+            st.resyncs++;
+        }
+    }
+    if (isRef && timed) {
+        double ms = 1000.0 * std::fabs(tsPos - (double)pos) / rate;
+        alignSum += ms;
+        alignCount++;
+        st.alignErrorMs = (float)(alignSum / (double)alignCount);
+        st.maxAlignErrorMs = std::max(st.maxAlignErrorMs, (float)ms);
+    }
+    if (!s.started) {
+        s.started = true;
+        s.write = s.next = pos;
+        if (!isRef) readPos = pos;
+    }
+    s.devEnd = devicePos >= 0 ? devicePos + (int64_t)frames : -1;
+
+    if (pos < s.next) {
+        // Overlaps what the stream already delivered
+        size_t drop = (size_t)std::min<int64_t>(s.next - pos, (int64_t)frames);
+        st.lateFrames += drop;
+        if (x) x += drop;
+        frames -= drop;
+        pos += (int64_t)drop;
+    }
+    if (pos > s.write) {
+        // Frames the device never delivered: silence
+        store(s, isRef, nullptr, s.write, (size_t)(pos - s.write));
+        if (isRef) st.refUnderrunFrames += (uint64_t)(pos - s.write);
+        else st.micGapFrames += (uint64_t)(pos - s.write);
+        s.write = pos;
+    }
+    store(s, isRef, x, pos, frames);
+    s.next = pos + (int64_t)frames;
+    s.write = std::max(s.write, s.next);
+}
+
+void JitterBuffer::store(Stream& s, bool isRef, const float* x, int64_t pos, size_t frames) {
+    int64_t cap = (int64_t)s.buf.size();
+    int64_t begin = pos;
+    int64_t end = pos + (int64_t)frames;
+    if (isRef) {
+        // Slots already emitted, or beyond what the ring holds ahead of the mic
+        if (begin < readPos) { st.lateFrames += (uint64_t)(std::min(end, readPos) - begin); begin = readPos; }
+        if (end > readPos + cap) { st.overrunFrames += (uint64_t)(end - std::max(begin, readPos + cap)); end = readPos + cap; }
+    } else if (end - readPos > cap) {
+        // pull() fell behind: drop the oldest mic frames (and their reference)
+        int64_t newRead = end - cap;
+        st.overrunFrames += (uint64_t)(newRead - readPos);
+        readPos = newRead;
+        begin = std::max(begin, readPos);
+    }
+    for (int64_t i = begin; i < end; i++) {
+        s.buf[(size_t)i & mask] = x ? x[i - pos] : 0.0f;
+    }
+}
+
+size_t JitterBuffer::pull(float* micOut, float* refOut, size_t maxFrames, bool flush) {
+    if (!mic.started) return 0;
+    int64_t end = std::min(mic.write, readPos + (int64_t)maxFrames);
+    int64_t refEnd = ref.started ? std::max(ref.write, readPos) : readPos;
+    if (refEnd < end) {
+        // Mic frames that waited holdMs without a reference get silence
+        int64_t forced = flush ? end : std::min(end, mic.write - holdFrames);
+        if (forced > refEnd) {
+            for (int64_t i = refEnd; i < forced; i++) ref.buf[(size_t)i & mask] = 0.0f;
+            st.refUnderrunFrames += (uint64_t)(forced - refEnd);
+            // Padding does not start the stream: its first packet is still placed by
+            // its own timestamp, or at the read position when it has none
+            ref.write = forced;
+            refEnd = forced;
+        }
+        end = std::min(end, refEnd);
+    }
+    if (end <= readPos) return 0;
+    size_t n = (size_t)(end - readPos);
+    for (size_t i = 0; i < n; i++) {
+        size_t k = (size_t)(readPos + (int64_t)i) & mask;
+        micOut[i] = mic.buf[k];
+        refOut[i] = ref.buf[k];
+    }
+    readPos = end;
+    st.emittedFrames += n;
+    return n;
+}
+
+size_t JitterBuffer::pending() const {
+    return mic.started ? (size_t)(mic.write - readPos) : 0;
+}
@@ -0,0 +1,74 @@
+#pragma once
+// Aligns the mic and reference capture streams by their device timestamps.
+// Each packet is placed on a common sample timeline (origin: the first mic
+// packet). Delivery gaps are measured by the device frame position when the
+// API reports one, else by the timestamp; a stream is otherwise continuous and
+// is resynchronized only when its smoothed timestamp offset (not one jittery
+// packet) slides beyond a small tolerance. Gaps become silence, overlapping
+// frames are dropped.
+// pull() emits continuous mic/ref blocks. Mic frames wait up to holdMs for their
+// reference; after that the reference is silence (loopback delivers no packets
+// while nothing plays), never a copy of the mic.
+// Single-threaded (the capture thread); allocation-free after reset().
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct JitterStats {
+    uint64_t micFrames;       // Received
+    uint64_t refFrames;
+    uint64_t emittedFrames;
+    uint64_t refUnderrunFrames; // Reference silence inserted (no packet within holdMs)
+    uint64_t micGapFrames;      // Mic silence inserted for timestamp gaps
+    uint64_t lateFrames;        // Arrived after their slot was emitted, or overlapped (dropped)
+    uint64_t overrunFrames;     // Dropped because pull() fell more than capacityMs behind
+    uint64_t resyncs;           // Smoothed timestamp offset beyond the tolerance (clock slip)
+    float alignErrorMs;         // Mean |reference timestamp - placed position|
+    float maxAlignErrorMs;
+};
+
+class JitterBuffer {
+public:
+    JitterBuffer();
+    void reset(int sampleRate, int capacityMs, int holdMs);
+
+    // timeNs: device time of the packet's first frame (any epoch shared by both
+    // streams); < 0 if the device flagged it invalid. devicePos: the device's own
+    // frame counter at the first frame (< 0 if unknown). mic/ref == nullptr: a
+    // silent packet.
+    void pushMic(const float* mic, size_t frames, int64_t timeNs, int64_t devicePos = -1);
+    void pushRef(const float* ref, size_t frames, int64_t timeNs, int64_t devicePos = -1);
+
+    // Up to maxFrames aligned frames; flush emits everything left (end of stream)
+    size_t pull(float* mic, float* ref, size_t maxFrames, bool flush = false);
+    size_t pending() const;
+    JitterStats getStats() const { return st; }
+
+private:
+    struct Stream {
+        std::vector<float> buf; // Ring indexed by timeline position
+        int64_t write = 0;      // End of the filled slots (pull() may pad the reference)
+        int64_t next = 0;       // Timeline position of the stream's next frame
+        int64_t devEnd = -1;    // Device position of the stream's next frame
+        double offset = 0.0;    // Smoothed timestamp - placed position, frames
+        double spread = 0.0;    // Smoothed |deviation from offset| (timestamp jitter)
+        bool started = false;
+    };
+    void push(Stream& s, bool isRef, const float* x, size_t frames, int64_t timeNs, int64_t devicePos);
+    double slack(const Stream& s) const;
+    void store(Stream& s, bool isRef, const float* x, int64_t pos, size_t frames);
+
+    int rate;
+    size_t mask;
+    int64_t holdFrames;
+    int64_t tolFrames;
+    int64_t originNs;
+    bool hasOrigin;
+    int64_t readPos;          // Next timeline position to emit
+    Stream mic;
+    Stream ref;
+    double alignSum;
+    uint64_t alignCount;
+    JitterStats st;
+};
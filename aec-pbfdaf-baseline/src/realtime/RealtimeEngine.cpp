@@ -0,0 +1,149 @@
+#include "RealtimeEngine.h"
+#include <algorithm>
+#include <chrono>
+
+// Capture polls the backend with this timeout so stop() is seen promptly
+static const int kCaptureTimeoutMs = 20;
+// The processing thread re-checks the rings at least this often (a notify can
+// race with the start of its wait)
+static const int kProcessWaitMs = 5;
+
+RealtimeConfig defaultRealtimeConfig() {
+    RealtimeConfig c;
+    c.aec = defaultAECParams(0);
+    c.aec.filterLen = 2048;
+    c.mode = PipelineMode::Cascade;
+    c.warmStart = nullptr;
+    c.blockMs = 10;
+    c.ringMs = 500;
+    c.durationMs = 0;
+    return c;
+}
+
+RealtimeEngine::RealtimeEngine() :
+    backend(nullptr), blockFrames(0), durationFrames(0),
+    stopRequested(false), captureDone(false), running(false),
+    captured(0), processed(0), droppedFrames(0), droppedPackets(0), maxFill(0) {}
+
+RealtimeEngine::~RealtimeEngine() {
+    stop();
+}
+
+bool RealtimeEngine::start(AudioBackend& b, const RealtimeConfig& cfg, std::string& err) {
+    if (running.load()) { err = "Engine already running"; return false; }
+    join(); // Threads of a run that ended on its own
+    int sr = b.sampleRate();
+    if (sr <= 0) { err = std::string("Backend not started: ") + b.name(); return false; }
+    backend = &b;
+
+    AECParams p = cfg.aec;
+    p.sampleRate = sr;
+    if (cfg.warmStart) pipeline.initialize(p, cfg.mode, *cfg.warmStart);
+    else pipeline.initialize(p, cfg.mode);
+    chainLoad.reset(sr);
+
+    blockFrames = (size_t)std::max(1, sr * std::max(1, cfg.blockMs) / 1000);
+    size_t ringFrames = std::max((size_t)sr * (size_t)std::max(0, cfg.ringMs) / 1000, 4 * blockFrames);
+    micRing.reset(ringFrames);
+    refRing.reset(ringFrames);
+    micBlock.assign(blockFrames, 0.0f);
+    refBlock.assign(blockFrames, 0.0f);
+    outBlock.assign(blockFrames, 0.0f);
+    durationFrames = cfg.durationMs > 0 ? (uint64_t)sr * (uint64_t)cfg.durationMs / 1000 : 0;
+
+    stopRequested.store(false);
+    captureDone.store(false);
+    captured.store(0);
+    processed.store(0);
+    droppedFrames.store(0);
+    droppedPackets.store(0);
+    maxFill.store(0);
+    running.store(true, std::memory_order_release);
+    processThread = std::thread(&RealtimeEngine::processLoop, this);
+    captureThread = std::thread(&RealtimeEngine::captureLoop, this);
+    return true;
+}
+
+void RealtimeEngine::stop() {
+    stopRequested.store(true, std::memory_order_release);
+    join();
+}
+
+void RealtimeEngine::wait() {
+    join();
+}
+
+void RealtimeEngine::join() {
+    if (captureThread.joinable()) captureThread.join();
+    if (processThread.joinable()) processThread.join();
+}
+
+RealtimeStats RealtimeEngine::getStats() const {
+    RealtimeStats s;
+    s.capturedFrames = captured.load(std::memory_order_relaxed);
+    s.processedFrames = processed.load(std::memory_order_relaxed);
+    s.droppedFrames = droppedFrames.load(std::memory_order_relaxed);
+    s.droppedPackets = droppedPackets.load(std::memory_order_relaxed);
+    s.maxFillFrames = maxFill.load(std::memory_order_relaxed);
+    return s;
+}
+
+void RealtimeEngine::captureLoop() {
+    backend->threadStarted(true);
+    uint64_t total = 0;
+    while (!stopRequested.load(std::memory_order_acquire)) {
+        const float* mic = nullptr;
+        const float* ref = nullptr;
+        int got = backend->capture(&mic, &ref, kCaptureTimeoutMs);
+        if (got < 0) break;
+        if (got == 0) continue;
+        size_t n = (size_t)got;
+        if (durationFrames > 0) n = (size_t)std::min<uint64_t>(n, durationFrames - total);
+        // The reference goes in last: the consumer sizes its reads by refRing, so it
+        // never sees a reference frame without its mic frame
+        if (micRing.space() >= n && refRing.space() >= n) {
+            micRing.push(mic, n);
+            refRing.push(ref, n);
+            wake.notify_one();
+        } else {
+            droppedFrames.fetch_add(n, std::memory_order_relaxed);
+            droppedPackets.fetch_add(1, std::memory_order_relaxed);
+        }
+        total += n;
+        captured.store(total, std::memory_order_relaxed);
+        if (durationFrames > 0 && total >= durationFrames) break;
+    }
+    captureDone.store(true, std::memory_order_release);
+    wake.notify_one();
+    backend->threadStopping(true);
+}
+
+void RealtimeEngine::processLoop() {
+    backend->threadStarted(false);
+    while (true) {
+        // Read the flag first: once capture is done, the fill seen next is final
+        bool done = captureDone.load(std::memory_order_acquire);
+        size_t avail = refRing.available();
+        size_t n = std::min(avail, blockFrames);
+        if (avail < blockFrames && !done) {
+            std::unique_lock<std::mutex> lock(wakeMtx);
+            wake.wait_for(lock, std::chrono::milliseconds(kProcessWaitMs), [this] {
+                return refRing.available() >= blockFrames || captureDone.load(std::memory_order_acquire);
+            });
+            continue;
+        }
+        if (n == 0) break; // Drained after the end of capture
+        if (avail > maxFill.load(std::memory_order_relaxed)) maxFill.store(avail, std::memory_order_relaxed);
+
+        micRing.pop(micBlock.data(), n);
+        refRing.pop(refBlock.data(), n);
+        chainLoad.begin();
+        pipeline.process(micBlock.data(), refBlock.data(), outBlock.data(), n);
+        bool ok = backend->render(outBlock.data(), n);
+        chainLoad.end(n);
+        processed.fetch_add(n, std::memory_order_relaxed);
+        if (!ok) stopRequested.store(true, std::memory_order_release);
+    }
+    backend->threadStopping(false);
+    running.store(false, std::memory_order_release);
+}
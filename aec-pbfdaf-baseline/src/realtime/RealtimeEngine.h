@@ -0,0 +1,92 @@
+#pragma once
+// Shared real-time loop for every audio backend. A capture thread pulls packets
+// from the backend into lock-free SPSC rings (mic and reference); a processing
+// thread takes fixed-size blocks from the rings, runs the AEC pipeline and hands
+// the output to the backend's render(). A slow processing thread therefore never
+// stalls capture: when the rings are full, whole packets are dropped and counted.
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AudioBackend.h"
+#include "SpscRing.h"
+#include "../aec_core/AECPipeline.h"
+#include "../aec_core/LoadMonitor.h"
+
+struct RealtimeConfig {
+    AECParams aec;                // sampleRate is taken from the backend
+    PipelineMode mode;            // Cascade: canceller + AIEnhancer, as the WASAPI tools always ran
+    const AECEchoPath* warmStart; // Cached echo path to start from (nullptr: cold start)
+    int blockMs;                  // Audio per pipeline call
+    int ringMs;                   // Capture ring capacity
+    int durationMs;               // Stop capturing after this much audio (<= 0: until stop() or end of stream)
+};
+
+RealtimeConfig defaultRealtimeConfig();
+
+struct RealtimeStats {
+    uint64_t capturedFrames;
+    uint64_t processedFrames;
+    uint64_t droppedFrames;   // Packets that did not fit in the rings
+    uint64_t droppedPackets;
+    uint64_t maxFillFrames;   // Highest ring fill seen by the processing thread
+};
+
+class RealtimeEngine {
+public:
+    RealtimeEngine();
+    ~RealtimeEngine();
+
+    // backend must be started; the engine does not own it
+    bool start(AudioBackend& backend, const RealtimeConfig& cfg, std::string& err);
+    // Stops capturing, drains what is already captured, joins both threads
+    void stop();
+    // Blocks until the stream ends or the duration is reached
+    void wait();
+    // False once the stream ended, the duration was reached or stop() was called
+    bool isRunning() const { return running.load(std::memory_order_acquire); }
+
+    RealtimeStats getStats() const;
+    // Canceller stats and setters stay usable from any thread while running
+    AECProcessor& aec() { return pipeline.aec(); }
+    const AECProcessor& aec() const { return pipeline.aec(); }
+    // Load of the whole per-block chain (pipeline + render)
+    AECLoadStats getChainLoadStats() const { return chainLoad.getStats(); }
+
+private:
+    RealtimeEngine(const RealtimeEngine&) = delete;
+    RealtimeEngine& operator=(const RealtimeEngine&) = delete;
+    void captureLoop();
+    void processLoop();
+    void join();
+
+    AudioBackend* backend;
+    AECPipeline pipeline;
+    LoadMonitor chainLoad;
+    size_t blockFrames;
+    uint64_t durationFrames;
+
+    SpscRing<float> micRing;
+    SpscRing<float> refRing;
+    std::vector<float> micBlock;
+    std::vector<float> refBlock;
+    std::vector<float> outBlock;
+
+    std::thread captureThread;
+    std::thread processThread;
+    std::mutex wakeMtx;
+    std::condition_variable wake;  // Capture -> processing; waits also time out
+    std::atomic<bool> stopRequested;
+    std::atomic<bool> captureDone;
+    std::atomic<bool> running;
+
+    std::atomic<uint64_t> captured;
+    std::atomic<uint64_t> processed;
+    std::atomic<uint64_t> droppedFrames;
+    std::atomic<uint64_t> droppedPackets;
+    std::atomic<uint64_t> maxFill;
+};
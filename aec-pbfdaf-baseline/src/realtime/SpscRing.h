@@ -0,0 +1,69 @@
+#pragma once
+// Lock-free single-producer / single-consumer ring of trivially copyable samples.
+// The producer only moves the write index and the consumer only the read index,
+// each published with release/acquire, so neither side ever blocks the other.
+// Capacity is rounded up to a power of two; storage is allocated by reset() only.
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+
+template <typename T>
+class SpscRing {
+public:
+    SpscRing() : mask(0), writeIdx(0), readIdx(0) {}
+
+    // Not thread-safe: call before either side starts
+    void reset(size_t minCapacity) {
+        size_t cap = 1;
+        while (cap < minCapacity) cap <<= 1;
+        buf.assign(cap, T());
+        mask = cap - 1;
+        writeIdx.store(0, std::memory_order_relaxed);
+        readIdx.store(0, std::memory_order_relaxed);
+    }
+    size_t capacity() const { return buf.size(); }
+
+    // Producer side
+    size_t space() const {
+        return buf.size() - (writeIdx.load(std::memory_order_relaxed) - readIdx.load(std::memory_order_acquire));
+    }
+    // All or nothing: false (and nothing written) if n does not fit
+    bool push(const T* src, size_t n) {
+        size_t w = writeIdx.load(std::memory_order_relaxed);
+        if (buf.size() - (w - readIdx.load(std::memory_order_acquire)) < n) return false;
+        size_t pos = w & mask;
+        size_t first = std::min(n, buf.size() - pos);
+        std::copy(src, src + first, buf.data() + pos);
+        std::copy(src + first, src + n, buf.data());
+        writeIdx.store(w + n, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    size_t available() const {
+        return writeIdx.load(std::memory_order_acquire) - readIdx.load(std::memory_order_relaxed);
+    }
+    // All or nothing: false (and nothing read) if fewer than n are available
+    bool pop(T* dst, size_t n) {
+        size_t r = readIdx.load(std::memory_order_relaxed);
+        if (writeIdx.load(std::memory_order_acquire) - r < n) return false;
+        size_t pos = r & mask;
+        size_t first = std::min(n, buf.size() - pos);
+        std::copy(buf.data() + pos, buf.data() + pos + first, dst);
+        std::copy(buf.data(), buf.data() + (n - first), dst + first);
+        readIdx.store(r + n, std::memory_order_release);
+        return true;
+    }
+
+private:
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    std::vector<T> buf;
+    size_t mask;
+    // Free-running indices on separate cache lines (producer / consumer)
+    alignas(64) std::atomic<size_t> writeIdx;
+    alignas(64) std::atomic<size_t> readIdx;
+};
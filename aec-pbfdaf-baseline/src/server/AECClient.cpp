@@ -0,0 +1,208 @@
+#include "AECClient.h"
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+AECClientSession::AECClientSession() : sessionId(-1), doorbell(-1), notify(-1), mem(nullptr), memBytes(0) {}
+
+AECClientSession::~AECClientSession() {
+    if (mem) munmap(mem, memBytes);
+    if (doorbell >= 0) close(doorbell);
+    if (notify >= 0) close(notify);
+}
+
+bool AECClientSession::submit(const float* mic, const float* ref, uint64_t tag) {
+    DaemonShmHeader* h = view.header();
+    uint64_t w = h->inWrite.load(std::memory_order_relaxed);
+    if (w - h->inRead.load(std::memory_order_acquire) >= view.ringBlocks()) return false;
+    const size_t B = view.blockFrames();
+    *view.inTag(w) = tag;
+    memcpy(view.inMic(w), mic, B * sizeof(float));
+    memcpy(view.inRef(w), ref, B * sizeof(float));
+    h->inWrite.store(w + 1, std::memory_order_release);
+    uint64_t one = 1;
+    ssize_t n = write(doorbell, &one, sizeof(one));
+    (void)n;
+    return true;
+}
+
+bool AECClientSession::receive(float* out, uint64_t& tag) {
+    DaemonShmHeader* h = view.header();
+    uint64_t r = h->outRead.load(std::memory_order_relaxed);
+    if (r == h->outWrite.load(std::memory_order_acquire)) return false;
+    tag = *view.outTag(r);
+    memcpy(out, view.outData(r), view.blockFrames() * sizeof(float));
+    h->outRead.store(r + 1, std::memory_order_release);
+    return true;
+}
+
+bool AECClientSession::waitOutput(int timeoutMs) {
+    DaemonShmHeader* h = view.header();
+    if (h->outRead.load(std::memory_order_relaxed) != h->outWrite.load(std::memory_order_acquire)) return true;
+    pollfd p;
+    p.fd = notify;
+    p.events = POLLIN;
+    p.revents = 0;
+    if (poll(&p, 1, timeoutMs) <= 0) return false;
+    clearNotify();
+    return true;
+}
+
+void AECClientSession::clearNotify() {
+    uint64_t count;
+    ssize_t n = read(notify, &count, sizeof(count));
+    (void)n;
+}
+
+AECClient::AECClient() : fd(-1) {}
+
+AECClient::~AECClient() { disconnect(); }
+
+bool AECClient::connect(const std::string& socketPath, std::string& err) {
+    disconnect();
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(addr.sun_path)) {
+        err = "bad socket path";
+        return false;
+    }
+    memcpy(addr.sun_path, socketPath.c_str(), socketPath.size());
+    fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0 || ::connect(fd, (const sockaddr*)&addr, sizeof(addr)) != 0) {
+        err = "connect " + socketPath + ": " + strerror(errno);
+        disconnect();
+        return false;
+    }
+    return true;
+}
+
+void AECClient::disconnect() {
+    std::lock_guard<std::mutex> lk(mtx);
+    if (fd >= 0) close(fd);
+    fd = -1;
+}
+
+bool AECClient::request(const DaemonRequest& rq, DaemonReply& rep, int* fds, std::string& err) {
+    std::lock_guard<std::mutex> lk(mtx);
+    if (fd < 0) { err = "not connected"; return false; }
+    if (send(fd, &rq, sizeof(rq), MSG_NOSIGNAL) != (ssize_t)sizeof(rq)) {
+        err = std::string("send: ") + strerror(errno);
+        return false;
+    }
+    iovec iov;
+    iov.iov_base = &rep;
+    iov.iov_len = sizeof(rep);
+    alignas(cmsghdr) char ctrl[CMSG_SPACE(3 * sizeof(int))];
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl;
+    msg.msg_controllen = sizeof(ctrl);
+    ssize_t n;
+    do {
+        n = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+    } while (n < 0 && errno == EINTR);
+    // Descriptors passed with the reply (only an open reply carries any)
+    int passed[3];
+    int got = 0;
+    for (cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+        if (cm->cmsg_level != SOL_SOCKET || cm->cmsg_type != SCM_RIGHTS) continue;
+        int count = (int)((cm->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+        for (int i = 0; i < count; ++i) {
+            int d;
+            memcpy(&d, CMSG_DATA(cm) + i * sizeof(int), sizeof(int));
+            if (got < 3) passed[got++] = d;
+            else close(d);
+        }
+    }
+    bool ok = n == (ssize_t)sizeof(rep) && rep.version == kDaemonProtocolVersion;
+    if (!ok) {
+        err = n == 0 ? "daemon closed the connection" : "bad reply from daemon";
+    } else if (rep.status != 0) {
+        rep.error[sizeof(rep.error) - 1] = '\0';
+        err = rep.error;
+        ok = false;
+    } else if (fds && got != 3) {
+        err = "daemon sent no session descriptors";
+        ok = false;
+    }
+    if (ok && fds) {
+        memcpy(fds, passed, sizeof(passed));
+    } else {
+        for (int i = 0; i < got; ++i) close(passed[i]);
+    }
+    return ok;
+}
+
+std::unique_ptr<AECClientSession> AECClient::openSession(const AECParams& p, PipelineMode mode, std::string& err) {
+    DaemonRequest rq;
+    memset(&rq, 0, sizeof(rq));
+    rq.version = kDaemonProtocolVersion;
+    rq.type = kDaemonOpen;
+    rq.session = -1;
+    rq.sampleRate = p.sampleRate;
+    rq.filterLen = p.filterLen;
+    rq.maxDelayMs = p.maxDelayMs;
+    rq.corrBlock = p.corrBlock;
+    rq.mu = p.mu;
+    rq.epsilon = p.epsilon;
+    rq.leak = p.leak;
+    rq.dtdAlpha = p.dtdAlpha;
+    rq.dtdBeta = p.dtdBeta;
+    rq.proportionate = p.proportionate ? 1 : 0;
+    rq.historyPrecision = (uint8_t)p.historyPrecision;
+    rq.weightPrecision = (uint8_t)p.weightPrecision;
+    rq.mode = (uint8_t)mode;
+    DaemonReply rep;
+    int fds[3] = { -1, -1, -1 };
+    if (!request(rq, rep, fds, err)) return nullptr;
+
+    std::unique_ptr<AECClientSession> s(new AECClientSession());
+    s->sessionId = rep.session;
+    s->doorbell = fds[1];
+    s->notify = fds[2];
+    s->memBytes = (size_t)rep.shmBytes;
+    void* mem = mmap(nullptr, s->memBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0);
+    close(fds[0]);
+    if (mem == MAP_FAILED) {
+        err = std::string("mmap: ") + strerror(errno);
+        return nullptr;
+    }
+    s->mem = mem;
+    const DaemonShmHeader* h = static_cast<const DaemonShmHeader*>(mem);
+    if (h->magic != kDaemonShmMagic || h->blockFrames != rep.blockFrames || h->ringBlocks != rep.ringBlocks ||
+        DaemonShmView::bytes(rep.blockFrames, rep.ringBlocks) != s->memBytes) {
+        err = "bad session memory layout";
+        return nullptr;
+    }
+    s->view.attach(mem, rep.blockFrames, rep.ringBlocks);
+    return s;
+}
+
+bool AECClient::closeSession(AECClientSession& s, std::string& err) {
+    DaemonRequest rq;
+    memset(&rq, 0, sizeof(rq));
+    rq.version = kDaemonProtocolVersion;
+    rq.type = kDaemonClose;
+    rq.session = s.sessionId;
+    DaemonReply rep;
+    return request(rq, rep, nullptr, err);
+}
+
+bool AECClient::getStats(const AECClientSession& s, DaemonSessionStats& st, std::string& err) {
+    DaemonRequest rq;
+    memset(&rq, 0, sizeof(rq));
+    rq.version = kDaemonProtocolVersion;
+    rq.type = kDaemonStats;
+    rq.session = s.sessionId;
+    DaemonReply rep;
+    if (!request(rq, rep, nullptr, err)) return false;
+    st = rep.stats;
+    return true;
+}
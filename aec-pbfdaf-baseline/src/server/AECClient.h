@@ -0,0 +1,69 @@
+#pragma once
+// Client side of aec_daemon (Linux). AECClient holds the control connection; each
+// opened session maps the daemon's shared-memory rings, so audio is written and read
+// in place with no system call besides the doorbell and notify eventfds.
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "DaemonProtocol.h"
+#include "../aec_core/AECPipeline.h"
+
+class AECClientSession {
+public:
+    ~AECClientSession();
+    int id() const { return sessionId; }
+    size_t blockFrames() const { return view.blockFrames(); }
+    size_t ringBlocks() const { return view.ringBlocks(); }
+
+    // One producer thread. blockFrames() frames of each; false if the input ring is
+    // full (the block is not sent). The tag comes back with the output block.
+    bool submit(const float* mic, const float* ref, uint64_t tag);
+    // One consumer thread. The next processed block in submission order; false if
+    // none is ready.
+    bool receive(float* out, uint64_t& tag);
+    // Waits up to timeoutMs (-1: no limit) until output may be ready
+    bool waitOutput(int timeoutMs);
+    // Readable when output may be ready (for the caller's own poll loop; receive()
+    // until it returns false, then clearNotify() before polling again)
+    int notifyFd() const { return notify; }
+    void clearNotify();
+
+private:
+    friend class AECClient;
+    AECClientSession();
+    AECClientSession(const AECClientSession&) = delete;
+    AECClientSession& operator=(const AECClientSession&) = delete;
+
+    int sessionId;
+    int doorbell;
+    int notify;
+    void* mem;
+    size_t memBytes;
+    DaemonShmView view;
+};
+
+class AECClient {
+public:
+    AECClient();
+    ~AECClient();
+
+    bool connect(const std::string& socketPath, std::string& err);
+    // Closes the connection; the daemon then closes every session opened on it
+    void disconnect();
+    bool isConnected() const { return fd >= 0; }
+
+    // Control requests (thread-safe, they block for the daemon's reply)
+    std::unique_ptr<AECClientSession> openSession(const AECParams& p, PipelineMode mode, std::string& err);
+    bool closeSession(AECClientSession& s, std::string& err);
+    bool getStats(const AECClientSession& s, DaemonSessionStats& st, std::string& err);
+
+private:
+    AECClient(const AECClient&) = delete;
+    AECClient& operator=(const AECClient&) = delete;
+    bool request(const DaemonRequest& rq, DaemonReply& rep, int* fds, std::string& err);
+
+    int fd;
+    std::mutex mtx;
+};
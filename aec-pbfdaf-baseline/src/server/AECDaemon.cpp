@@ -0,0 +1,489 @@
+#include "AECDaemon.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// epoll tags: kind in the high word, fd or session id in the low word
+enum EventKind : uint64_t { kEventListen = 1, kEventStop, kEventConnection, kEventDoorbell };
+
+static uint64_t eventTag(EventKind kind, int value) { return ((uint64_t)kind << 32) | (uint32_t)value; }
+
+struct AECDaemon::Session {
+    int id = -1;
+    int conn = -1;               // Connection fd
+    int memFd = -1;
+    int doorbell = -1;
+    int notify = -1;
+    void* mem = nullptr;
+    size_t memBytes = 0;
+    DaemonShmView view;
+    // The daemon's own ring indices; the copies in shared memory are only published
+    // to the client, which could overwrite them
+    uint64_t inRead = 0;         // I/O thread
+    uint64_t outWrite = 0;       // Workers, one at a time
+    std::atomic<uint64_t> blocks{0};
+    std::atomic<uint64_t> stalls{0};
+    std::atomic<uint64_t> droppedOutput{0};
+    std::atomic<bool> stalled{false}; // Input left in the ring for lack of pool queue space
+
+    ~Session() {
+        if (mem) munmap(mem, memBytes);
+        if (memFd >= 0) close(memFd);
+        if (doorbell >= 0) close(doorbell);
+        if (notify >= 0) close(notify);
+    }
+};
+
+struct AECDaemon::Connection {
+    int fd = -1;
+    std::vector<int> sessions;
+};
+
+AECDaemonConfig defaultAECDaemonConfig() {
+    AECDaemonConfig c;
+    c.socketPath = defaultDaemonSocketPath();
+    c.socketMode = 0600;
+    c.pool = defaultSessionPoolConfig();
+    c.ringBlocks = 16;
+    return c;
+}
+
+static bool setError(std::string& err, const std::string& what) {
+    err = what + ": " + strerror(errno);
+    return false;
+}
+
+static void replyError(DaemonReply& rep, const char* msg) {
+    rep.status = -1;
+    snprintf(rep.error, sizeof(rep.error), "%s", msg);
+}
+
+// Rejects parameters that would make the canceller allocate without bound or fail
+static const char* checkParams(const DaemonRequest& rq) {
+    if (rq.sampleRate < 8000 || rq.sampleRate > 48000) return "sample rate out of range";
+    if (rq.filterLen < 64 || rq.filterLen > 16384) return "filter length out of range";
+    if (rq.maxDelayMs < 0 || rq.maxDelayMs > 1000) return "max delay out of range";
+    if (rq.corrBlock < 64 || rq.corrBlock > 16384) return "correlation block out of range";
+    const float f[] = { rq.mu, rq.epsilon, rq.leak, rq.dtdAlpha, rq.dtdBeta };
+    for (float v : f) {
+        if (!std::isfinite(v) || v < 0.0f) return "bad canceller parameter";
+    }
+    if (rq.historyPrecision > (uint8_t)SpectrumPrecision::BFloat16 ||
+        rq.weightPrecision > (uint8_t)SpectrumPrecision::BFloat16) return "bad spectrum precision";
+    if (rq.mode > (uint8_t)PipelineMode::Fused) return "bad pipeline mode";
+    return nullptr;
+}
+
+AECDaemon::AECDaemon()
+    : listenFd(-1), epollFd(-1), stopFd(-1), running(false), stalls(0), droppedOutput(0), protocolErrors(0) {}
+
+AECDaemon::~AECDaemon() { stop(); }
+
+bool AECDaemon::start(const AECDaemonConfig& cfg, std::string& err) {
+    if (running.load()) { err = "daemon already running"; return false; }
+    if (cfg.ringBlocks <= 0) { err = "ring length must be positive"; return false; }
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (cfg.socketPath.empty() || cfg.socketPath.size() >= sizeof(addr.sun_path)) {
+        err = "bad socket path";
+        return false;
+    }
+    memcpy(addr.sun_path, cfg.socketPath.c_str(), cfg.socketPath.size());
+    config = cfg;
+
+    // A socket file nobody listens on is left over from a daemon that died
+    struct stat sb;
+    if (stat(addr.sun_path, &sb) == 0) {
+        if (!S_ISSOCK(sb.st_mode)) { err = cfg.socketPath + " exists and is not a socket"; return false; }
+        int probe = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        bool live = probe >= 0 && connect(probe, (const sockaddr*)&addr, sizeof(addr)) == 0;
+        if (probe >= 0) close(probe);
+        if (live) { err = "a daemon is already listening on " + cfg.socketPath; return false; }
+        unlink(addr.sun_path);
+    }
+
+    listenFd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) return setError(err, "socket");
+    // No connection is accepted before listen(), so the file is never reachable with
+    // the umask's permissions
+    if (bind(listenFd, (const sockaddr*)&addr, sizeof(addr)) != 0) {
+        setError(err, "bind " + cfg.socketPath);
+        close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    if (chmod(addr.sun_path, (mode_t)cfg.socketMode) != 0 || listen(listenFd, 64) != 0) {
+        setError(err, "listen " + cfg.socketPath);
+        close(listenFd);
+        unlink(addr.sun_path);
+        listenFd = -1;
+        return false;
+    }
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd < 0 || stopFd < 0) {
+        setError(err, "epoll");
+        stop();
+        return false;
+    }
+    epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.u64 = eventTag(kEventListen, listenFd);
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+    ev.data.u64 = eventTag(kEventStop, stopFd);
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, stopFd, &ev);
+
+    if (!pool.start(cfg.pool, err)) {
+        stop();
+        return false;
+    }
+    sessions.clear();
+    sessions.resize((size_t)cfg.pool.maxSessions);
+    stalls.store(0);
+    droppedOutput.store(0);
+    protocolErrors.store(0);
+    running.store(true, std::memory_order_release);
+    ioThread = std::thread(&AECDaemon::ioLoop, this);
+    return true;
+}
+
+void AECDaemon::stop() {
+    if (ioThread.joinable()) {
+        uint64_t one = 1;
+        ssize_t r = write(stopFd, &one, sizeof(one));
+        (void)r;
+        ioThread.join();
+    }
+    while (!connections.empty()) closeConnection(connections.back()->fd);
+    pool.stop();
+    if (listenFd >= 0) {
+        close(listenFd);
+        unlink(config.socketPath.c_str());
+    }
+    if (epollFd >= 0) close(epollFd);
+    if (stopFd >= 0) close(stopFd);
+    listenFd = epollFd = stopFd = -1;
+    running.store(false, std::memory_order_release);
+}
+
+void AECDaemon::ioLoop() {
+    epoll_event events[64];
+    for (;;) {
+        int n = epoll_wait(epollFd, events, 64, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        for (int i = 0; i < n; ++i) {
+            EventKind kind = (EventKind)(events[i].data.u64 >> 32);
+            int value = (int)(uint32_t)events[i].data.u64;
+            switch (kind) {
+            case kEventStop:
+                return;
+            case kEventListen:
+                acceptConnections();
+                break;
+            case kEventConnection: {
+                Connection* c = findConnection(value);
+                if (!c) break;
+                if (events[i].events & EPOLLIN) handleRequest(*c);
+                // Requests still queued are read first; the peer is gone once recv reports it
+                else if (events[i].events & (EPOLLHUP | EPOLLERR)) closeConnection(value);
+                break;
+            }
+            case kEventDoorbell:
+                pumpInput(value);
+                break;
+            }
+        }
+    }
+}
+
+void AECDaemon::acceptConnections() {
+    for (;;) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.u64 = eventTag(kEventConnection, fd);
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            close(fd);
+            continue;
+        }
+        std::unique_ptr<Connection> c(new Connection());
+        c->fd = fd;
+        std::lock_guard<std::mutex> lk(stateMtx);
+        connections.push_back(std::move(c));
+    }
+}
+
+AECDaemon::Connection* AECDaemon::findConnection(int fd) {
+    for (auto& c : connections) {
+        if (c->fd == fd) return c.get();
+    }
+    return nullptr;
+}
+
+void AECDaemon::handleRequest(Connection& c) {
+    DaemonRequest rq;
+    ssize_t n = recv(c.fd, &rq, sizeof(rq), MSG_DONTWAIT);
+    if (n < 0 && (errno == EAGAIN || errno == EINTR)) return;
+    if (n <= 0) {
+        closeConnection(c.fd);
+        return;
+    }
+    DaemonReply rep;
+    memset(&rep, 0, sizeof(rep));
+    rep.version = kDaemonProtocolVersion;
+    rep.session = -1;
+    rep.blockFrames = (uint32_t)pool.blockFrames();
+    rep.ringBlocks = (uint32_t)config.ringBlocks;
+    const int fd = c.fd;
+    int id = rq.session;
+    bool own = (size_t)n == sizeof(rq) && std::find(c.sessions.begin(), c.sessions.end(), id) != c.sessions.end();
+    if ((size_t)n != sizeof(rq) || rq.version != kDaemonProtocolVersion) {
+        replyError(rep, "protocol version mismatch");
+        protocolErrors.fetch_add(1, std::memory_order_relaxed);
+    } else if (rq.type == kDaemonOpen) {
+        if (openSession(c, rq, rep)) {
+            Session* s = sessions[rep.session].get();
+            bool sent = sendReply(fd, rep, s);
+            // The client holds its own descriptor now
+            close(s->memFd);
+            s->memFd = -1;
+            if (!sent) closeConnection(fd);
+            return;
+        }
+    } else if (rq.type == kDaemonClose && own) {
+        closeSession(id);
+        rep.session = id;
+    } else if (rq.type == kDaemonStats && own) {
+        sessionStats(id, rep.stats);
+        rep.session = id;
+    } else {
+        replyError(rep, rq.type == kDaemonClose || rq.type == kDaemonStats ? "no such session" : "bad request");
+        protocolErrors.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (!sendReply(fd, rep, nullptr)) closeConnection(fd);
+}
+
+bool AECDaemon::sendReply(int fd, const DaemonReply& rep, const Session* opened) {
+    iovec iov;
+    iov.iov_base = const_cast<DaemonReply*>(&rep);
+    iov.iov_len = sizeof(rep);
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    alignas(cmsghdr) char ctrl[CMSG_SPACE(3 * sizeof(int))];
+    if (opened) {
+        int fds[3] = { opened->memFd, opened->doorbell, opened->notify };
+        msg.msg_control = ctrl;
+        msg.msg_controllen = sizeof(ctrl);
+        cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+        cm->cmsg_level = SOL_SOCKET;
+        cm->cmsg_type = SCM_RIGHTS;
+        cm->cmsg_len = CMSG_LEN(sizeof(fds));
+        memcpy(CMSG_DATA(cm), fds, sizeof(fds));
+    }
+    // A client that does not read its replies is dropped rather than waited for
+    return sendmsg(fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL) == (ssize_t)sizeof(rep);
+}
+
+bool AECDaemon::openSession(Connection& c, const DaemonRequest& rq, DaemonReply& rep) {
+    if (const char* bad = checkParams(rq)) {
+        replyError(rep, bad);
+        protocolErrors.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    AECParams ap;
+    ap.sampleRate = rq.sampleRate;
+    ap.channels = 1;
+    ap.filterLen = rq.filterLen;
+    ap.mu = rq.mu;
+    ap.epsilon = rq.epsilon;
+    ap.leak = rq.leak;
+    ap.maxDelayMs = rq.maxDelayMs;
+    ap.corrBlock = rq.corrBlock;
+    ap.dtdAlpha = rq.dtdAlpha;
+    ap.dtdBeta = rq.dtdBeta;
+    ap.proportionate = rq.proportionate != 0;
+    ap.historyPrecision = (SpectrumPrecision)rq.historyPrecision;
+    ap.weightPrecision = (SpectrumPrecision)rq.weightPrecision;
+
+    std::unique_ptr<Session> s(new Session());
+    s->conn = c.fd;
+    s->memBytes = DaemonShmView::bytes(pool.blockFrames(), (size_t)config.ringBlocks);
+    // Sealed at its size: a client that could truncate the region would fault the
+    // daemon on its next access
+    s->memFd = memfd_create("aec-session", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (s->memFd < 0 || ftruncate(s->memFd, (off_t)s->memBytes) != 0 ||
+        fcntl(s->memFd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0) {
+        replyError(rep, "shared memory unavailable");
+        return false;
+    }
+    s->mem = mmap(nullptr, s->memBytes, PROT_READ | PROT_WRITE, MAP_SHARED, s->memFd, 0);
+    if (s->mem == MAP_FAILED) {
+        s->mem = nullptr;
+        replyError(rep, "shared memory unavailable");
+        return false;
+    }
+    s->doorbell = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    s->notify = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (s->doorbell < 0 || s->notify < 0) {
+        replyError(rep, "out of file descriptors");
+        return false;
+    }
+    s->view.attach(s->mem, pool.blockFrames(), (size_t)config.ringBlocks);
+    DaemonShmHeader* h = s->view.header();
+    h->magic = kDaemonShmMagic;
+    h->version = kDaemonProtocolVersion;
+    h->blockFrames = (uint32_t)pool.blockFrames();
+    h->ringBlocks = (uint32_t)config.ringBlocks;
+
+    Session* sp = s.get();
+    int id = pool.openSession(ap, (PipelineMode)rq.mode,
+        [this, sp](int, uint64_t tag, const float* out, size_t frames) { onOutput(*sp, tag, out, frames); });
+    if (id < 0) {
+        replyError(rep, "session limit reached");
+        return false;
+    }
+    s->id = id;
+    epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.u64 = eventTag(kEventDoorbell, id);
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, s->doorbell, &ev);
+    {
+        std::lock_guard<std::mutex> lk(stateMtx);
+        sessions[id] = std::move(s);
+        c.sessions.push_back(id);
+    }
+    rep.session = id;
+    rep.shmBytes = sp->memBytes;
+    return true;
+}
+
+void AECDaemon::closeSession(int id) {
+    std::unique_ptr<Session> s;
+    {
+        std::lock_guard<std::mutex> lk(stateMtx);
+        if (id < 0 || (size_t)id >= sessions.size() || !sessions[id]) return;
+        s = std::move(sessions[id]);
+        Connection* c = findConnection(s->conn);
+        if (c) c->sessions.erase(std::remove(c->sessions.begin(), c->sessions.end(), id), c->sessions.end());
+    }
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, s->doorbell, nullptr);
+    // Waits for a block in progress; the callback holds a pointer to s
+    pool.closeSession(id);
+}
+
+void AECDaemon::closeConnection(int fd) {
+    Connection* c = findConnection(fd);
+    if (!c) return;
+    while (!c->sessions.empty()) closeSession(c->sessions.back());
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    std::lock_guard<std::mutex> lk(stateMtx);
+    connections.erase(std::remove_if(connections.begin(), connections.end(),
+        [fd](const std::unique_ptr<Connection>& p) { return p->fd == fd; }), connections.end());
+}
+
+void AECDaemon::pumpInput(int id) {
+    if (id < 0 || (size_t)id >= sessions.size() || !sessions[id]) return;
+    Session& s = *sessions[id];
+    uint64_t count;
+    // Reset the doorbell before looking at the ring: a push after this rings it again
+    ssize_t r = read(s.doorbell, &count, sizeof(count));
+    (void)r;
+    uint64_t w = s.view.header()->inWrite.load(std::memory_order_acquire);
+    if (w - s.inRead > s.view.ringBlocks()) {
+        // The client broke the ring
+        protocolErrors.fetch_add(1, std::memory_order_relaxed);
+        closeSession(id);
+        return;
+    }
+    for (; s.inRead != w; ++s.inRead) {
+        const uint64_t n = s.inRead;
+        if (pool.submit(id, s.view.inMic(n), s.view.inRef(n), *s.view.inTag(n))) continue;
+        // Pool queue full: the rest waits in the ring (the client sees it fill up) and
+        // the next completed block rings the doorbell. Retried once after raising the
+        // flag, in case the worker emptied the queue before it could see it.
+        s.stalled.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!pool.submit(id, s.view.inMic(n), s.view.inRef(n), *s.view.inTag(n))) {
+            s.stalls.fetch_add(1, std::memory_order_relaxed);
+            stalls.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+    }
+    s.view.header()->inRead.store(s.inRead, std::memory_order_release);
+}
+
+void AECDaemon::onOutput(Session& s, uint64_t tag, const float* out, size_t frames) {
+    DaemonShmHeader* h = s.view.header();
+    uint64_t r = h->outRead.load(std::memory_order_acquire);
+    s.blocks.fetch_add(1, std::memory_order_relaxed);
+    if (s.outWrite - r >= s.view.ringBlocks()) {
+        s.droppedOutput.fetch_add(1, std::memory_order_relaxed);
+        droppedOutput.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        *s.view.outTag(s.outWrite) = tag;
+        memcpy(s.view.outData(s.outWrite), out, frames * sizeof(float));
+        ++s.outWrite;
+        h->outWrite.store(s.outWrite, std::memory_order_release);
+    }
+    uint64_t one = 1;
+    ssize_t n = write(s.notify, &one, sizeof(one));
+    // The I/O thread left input in the ring: there is room in the pool queue now
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (s.stalled.load(std::memory_order_relaxed) && s.stalled.exchange(false)) n = write(s.doorbell, &one, sizeof(one));
+    (void)n;
+}
+
+AECDaemonStats AECDaemon::getStats() const {
+    AECDaemonStats st;
+    {
+        std::lock_guard<std::mutex> lk(stateMtx);
+        st.connections = (int)connections.size();
+        st.sessions = 0;
+        for (const auto& s : sessions) st.sessions += s ? 1 : 0;
+    }
+    st.stalls = stalls.load(std::memory_order_relaxed);
+    st.droppedOutput = droppedOutput.load(std::memory_order_relaxed);
+    st.protocolErrors = protocolErrors.load(std::memory_order_relaxed);
+    st.pool = pool.getStats();
+    return st;
+}
+
+std::vector<int> AECDaemon::sessionIds() const {
+    std::vector<int> ids;
+    std::lock_guard<std::mutex> lk(stateMtx);
+    for (size_t i = 0; i < sessions.size(); ++i) {
+        if (sessions[i]) ids.push_back((int)i);
+    }
+    return ids;
+}
+
+bool AECDaemon::sessionStats(int id, DaemonSessionStats& st) {
+    // Holding the lock keeps the session from being closed (closeSession takes it first)
+    std::lock_guard<std::mutex> lk(stateMtx);
+    if (id < 0 || (size_t)id >= sessions.size() || !sessions[id]) return false;
+    const Session& s = *sessions[id];
+    AECProcessor* aec = pool.aec(id);
+    if (!aec) return false;
+    st.aec = aec->getStats();
+    st.blocks = s.blocks.load(std::memory_order_relaxed);
+    st.stalls = s.stalls.load(std::memory_order_relaxed);
+    st.droppedOutput = s.droppedOutput.load(std::memory_order_relaxed);
+    return true;
+}
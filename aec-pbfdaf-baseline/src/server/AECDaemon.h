@@ -0,0 +1,88 @@
+#pragma once
+// Local echo-cancellation service (Linux): a SessionPool behind a Unix domain socket,
+// so media processes on the same host share one worker pool. Clients open sessions
+// over the socket (see DaemonProtocol.h); each session's audio flows through a pair of
+// shared-memory rings. One I/O thread owns the socket and, when a client rings a
+// session's doorbell, moves its queued input blocks into the pool; the workers write
+// each completed block straight into the session's output ring and signal its notify
+// fd. Input is never dropped: while the session's pool queue is full its blocks stay
+// in the input ring, so an overloaded daemon shows up as submit() failing on the
+// client. A session is closed by request or when its client's connection closes.
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "DaemonProtocol.h"
+#include "SessionPool.h"
+
+struct AECDaemonConfig {
+    std::string socketPath;
+    int socketMode;          // Permissions of the socket file (0600: the daemon's user only)
+    SessionPoolConfig pool;  // pool.maxSessions bounds the sessions of all clients
+    int ringBlocks;          // Blocks per shared-memory ring
+};
+
+AECDaemonConfig defaultAECDaemonConfig();
+
+struct AECDaemonStats {
+    int connections;
+    int sessions;
+    uint64_t stalls;         // Over all sessions, open or closed
+    uint64_t droppedOutput;
+    uint64_t protocolErrors; // Bad requests and sessions closed for a corrupt ring
+    SessionPoolStats pool;
+};
+
+class AECDaemon {
+public:
+    AECDaemon();
+    ~AECDaemon();
+
+    // Binds the socket (replacing a stale one) and starts the pool and the I/O thread
+    bool start(const AECDaemonConfig& cfg, std::string& err);
+    bool isRunning() const { return running.load(std::memory_order_acquire); }
+    // Closes every session and connection, stops the pool, removes the socket
+    void stop();
+
+    AECDaemonStats getStats() const;
+    // Open session ids and their stats (not real-time safe)
+    std::vector<int> sessionIds() const;
+    bool sessionStats(int id, DaemonSessionStats& st);
+
+private:
+    struct Session;
+    struct Connection;
+
+    AECDaemon(const AECDaemon&) = delete;
+    AECDaemon& operator=(const AECDaemon&) = delete;
+    void ioLoop();
+    void acceptConnections();
+    void handleRequest(Connection& c);
+    bool openSession(Connection& c, const DaemonRequest& rq, DaemonReply& rep);
+    void closeSession(int id);
+    void closeConnection(int fd);
+    Connection* findConnection(int fd);
+    bool sendReply(int fd, const DaemonReply& rep, const Session* opened);
+    void pumpInput(int id);
+    void onOutput(Session& s, uint64_t tag, const float* out, size_t frames);
+
+    AECDaemonConfig config;
+    SessionPool pool;
+    std::thread ioThread;
+    int listenFd;
+    int epollFd;
+    int stopFd;
+    std::atomic<bool> running;
+    // Indexed by pool session id; changed only on the I/O thread. The workers reach a
+    // session through their callback, which the pool stops calling before it is freed.
+    std::vector<std::unique_ptr<Session>> sessions;
+    std::vector<std::unique_ptr<Connection>> connections;
+    mutable std::mutex stateMtx;  // sessions / connections for the stats getters
+    std::atomic<uint64_t> stalls;
+    std::atomic<uint64_t> droppedOutput;
+    std::atomic<uint64_t> protocolErrors;
+};
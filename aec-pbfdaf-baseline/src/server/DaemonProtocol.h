@@ -0,0 +1,129 @@
+#pragma once
+// Wire protocol of aec_daemon (Linux). Control messages travel over a SOCK_SEQPACKET
+// Unix domain socket, one request and one reply per message. Audio never does: each
+// session has a shared-memory region (a memfd created by the daemon) holding two
+// single-producer / single-consumer rings of fixed-size blocks, input (client ->
+// daemon) and output (daemon -> client). The open reply passes the memfd and two
+// eventfds: the doorbell the client signals after pushing input and the notify fd
+// the daemon signals after pushing output. Both processes must be built from the
+// same sources (the version is checked on every request).
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <type_traits>
+#include "../aec_core/AECProcessor.h"
+
+static const uint32_t kDaemonProtocolVersion = 1;
+static const uint32_t kDaemonShmMagic = 0x41454353; // "AECS"
+
+// Default socket: in the user's $XDG_RUNTIME_DIR (private to them), else /tmp
+inline std::string defaultDaemonSocketPath() {
+    const char* dir = getenv("XDG_RUNTIME_DIR");
+    return std::string(dir && *dir ? dir : "/tmp") + "/aec_daemon.sock";
+}
+
+enum DaemonRequestType : uint32_t {
+    kDaemonOpen = 1,   // Reply carries the memfd, doorbell and notify fds
+    kDaemonClose = 2,
+    kDaemonStats = 3,
+};
+
+struct DaemonRequest {
+    uint32_t version;
+    uint32_t type;
+    int32_t session;           // Close, Stats
+    // Open: canceller parameters (AECParams) and pipeline mode
+    int32_t sampleRate;
+    int32_t filterLen;
+    int32_t maxDelayMs;
+    int32_t corrBlock;
+    float mu;
+    float epsilon;
+    float leak;
+    float dtdAlpha;
+    float dtdBeta;
+    uint8_t proportionate;
+    uint8_t historyPrecision;  // SpectrumPrecision
+    uint8_t weightPrecision;
+    uint8_t mode;              // PipelineMode
+};
+
+struct DaemonSessionStats {
+    AECStats aec;
+    uint64_t blocks;           // Processed
+    uint64_t stalls;           // Times input waited in the ring: the pool queue was full
+    uint64_t droppedOutput;    // Completed blocks lost: the output ring was full
+};
+
+static_assert(std::is_trivially_copyable<DaemonSessionStats>::value, "stats are sent as bytes");
+
+struct DaemonReply {
+    uint32_t version;
+    int32_t status;            // 0: ok, else error holds the reason
+    int32_t session;
+    uint32_t blockFrames;      // Frames per block, the same for every session
+    uint32_t ringBlocks;       // Blocks per ring
+    uint64_t shmBytes;
+    DaemonSessionStats stats;  // Stats
+    char error[96];
+};
+
+// Start of the shared region. Each index is written by one side only and lives on
+// its own cache line; both count blocks from 0 and never wrap in practice.
+struct DaemonShmHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t blockFrames;
+    uint32_t ringBlocks;
+    alignas(64) std::atomic<uint64_t> inWrite;   // Client
+    alignas(64) std::atomic<uint64_t> inRead;    // Daemon
+    alignas(64) std::atomic<uint64_t> outWrite;  // Daemon
+    alignas(64) std::atomic<uint64_t> outRead;   // Client
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared-memory rings need lock-free 64-bit atomics");
+
+// Layout after the header: ringBlocks input slots (tag, mic block, ref block), then
+// ringBlocks output slots (tag, output block). Slots start on cache lines.
+class DaemonShmView {
+public:
+    static size_t inStride(size_t blockFrames) { return roundUp(16 + 2 * blockFrames * sizeof(float)); }
+    static size_t outStride(size_t blockFrames) { return roundUp(16 + blockFrames * sizeof(float)); }
+    static size_t bytes(size_t blockFrames, size_t ringBlocks) {
+        return roundUp(sizeof(DaemonShmHeader)) + ringBlocks * (inStride(blockFrames) + outStride(blockFrames));
+    }
+
+    DaemonShmView() : base(nullptr), frames(0), blocks(0) {}
+    void attach(void* mem, size_t blockFrames, size_t ringBlocks) {
+        base = static_cast<uint8_t*>(mem);
+        frames = blockFrames;
+        blocks = ringBlocks;
+    }
+    DaemonShmHeader* header() const { return reinterpret_cast<DaemonShmHeader*>(base); }
+    size_t blockFrames() const { return frames; }
+    size_t ringBlocks() const { return blocks; }
+
+    // Slot of block n (a free-running index)
+    uint64_t* inTag(uint64_t n) const { return reinterpret_cast<uint64_t*>(inSlot(n)); }
+    float* inMic(uint64_t n) const { return reinterpret_cast<float*>(inSlot(n) + 16); }
+    float* inRef(uint64_t n) const { return inMic(n) + frames; }
+    uint64_t* outTag(uint64_t n) const { return reinterpret_cast<uint64_t*>(outSlot(n)); }
+    float* outData(uint64_t n) const { return reinterpret_cast<float*>(outSlot(n) + 16); }
+
+private:
+    static size_t roundUp(size_t n) { return (n + 63) / 64 * 64; }
+    uint8_t* inSlot(uint64_t n) const {
+        return base + roundUp(sizeof(DaemonShmHeader)) + (size_t)(n % blocks) * inStride(frames);
+    }
+    uint8_t* outSlot(uint64_t n) const {
+        return base + roundUp(sizeof(DaemonShmHeader)) + blocks * inStride(frames) +
+               (size_t)(n % blocks) * outStride(frames);
+    }
+
+    uint8_t* base;
+    size_t frames;
+    size_t blocks;
+};
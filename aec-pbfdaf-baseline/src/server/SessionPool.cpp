@@ -0,0 +1,338 @@
+#include "SessionPool.h"
+#include <algorithm>
+#include <chrono>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX 1
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Blocks a session may process per run before it goes to the back of its home
+// queue, so one backlogged session cannot hold a worker from the others
+static const int kRunBlocks = 4;
+// An idle worker re-checks the queues at least this often (a wake-up for stealing
+// is best effort)
+static const std::chrono::milliseconds kIdleWait(2);
+
+enum SessionState { kFree = 0, kOpen, kClosing };
+
+struct SessionPool::Session {
+    AECPipeline pipe;
+    SessionCallback cb;
+    SpscRing<float> input;       // mic block then ref block
+    SpscRing<uint64_t> tags;     // Pushed after the block, so a tag means its block is there
+    SpscRing<float> output;
+    SpscRing<uint64_t> outTags;
+    int home = 0;
+    std::atomic<int> state{kFree};
+    // Set while the session is on a ready queue or being run: at most one worker has it
+    std::atomic<bool> queued{false};
+    std::atomic<uint64_t> submitted{0};
+    std::atomic<uint64_t> processed{0};
+    std::atomic<uint64_t> droppedOutput{0};
+};
+
+struct SessionPool::Worker {
+    std::mutex mtx;
+    std::condition_variable cv;
+    // Ready sessions, circular; owner pops the front, thieves the back. A session
+    // is queued at most once, so maxSessions slots never overflow.
+    std::vector<int> ready;
+    size_t head = 0;
+    size_t count = 0;
+    std::atomic<bool> idle{false};
+    int sessions = 0;            // Sessions homed here (under openMtx)
+    std::vector<float> in;       // Scratch: mic and ref of the block being processed
+    std::vector<float> out;
+    std::atomic<uint64_t> blocks{0};
+    std::atomic<uint64_t> steals{0};
+    std::thread thread;
+};
+
+SessionPoolConfig defaultSessionPoolConfig() {
+    SessionPoolConfig c;
+    c.workers = 0;
+    c.blockFrames = 160;   // 10 ms at 16 kHz
+    c.queueBlocks = 8;
+    c.maxSessions = 1024;
+    c.pinWorkers = false;
+    return c;
+}
+
+static void pinThread(std::thread& t, int index) {
+    unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+    unsigned cpu = (unsigned)index % cpus;
+#ifdef _WIN32
+    if (cpu < 8 * sizeof(DWORD_PTR)) SetThreadAffinityMask((HANDLE)t.native_handle(), (DWORD_PTR)1 << cpu);
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % CPU_SETSIZE, &set);
+    pthread_setaffinity_np(t.native_handle(), sizeof(set), &set);
+#else
+    (void)t;
+    (void)cpu;
+#endif
+}
+
+SessionPool::SessionPool() : blockLen(0), queueBlocks(0), running(false), stopping(false), droppedBlocks(0) {}
+
+SessionPool::~SessionPool() { stop(); }
+
+bool SessionPool::start(const SessionPoolConfig& cfg, std::string& err) {
+    if (running.load()) { err = "session pool already running"; return false; }
+    if (cfg.blockFrames == 0) { err = "block size must be positive"; return false; }
+    if (cfg.queueBlocks <= 0) { err = "queue length must be positive"; return false; }
+    if (cfg.maxSessions <= 0) { err = "maxSessions must be positive"; return false; }
+
+    int n = cfg.workers > 0 ? cfg.workers : (int)std::thread::hardware_concurrency();
+    if (n <= 0) n = 1;
+    blockLen = cfg.blockFrames;
+    queueBlocks = (size_t)cfg.queueBlocks;
+    droppedBlocks.store(0);
+    stopping.store(false);
+
+    sessions.clear();
+    sessions.resize((size_t)cfg.maxSessions);
+    workers.clear();
+    for (int i = 0; i < n; ++i) {
+        std::unique_ptr<Worker> w(new Worker());
+        w->ready.assign((size_t)cfg.maxSessions, -1);
+        w->in.assign(2 * blockLen, 0.0f);
+        w->out.assign(blockLen, 0.0f);
+        workers.push_back(std::move(w));
+    }
+    running.store(true, std::memory_order_release);
+    for (int i = 0; i < n; ++i) {
+        workers[i]->thread = std::thread(&SessionPool::workerLoop, this, i);
+        if (cfg.pinWorkers) pinThread(workers[i]->thread, i);
+    }
+    return true;
+}
+
+void SessionPool::stop() {
+    if (!running.load()) return;
+    drain();
+    stopping.store(true);
+    for (auto& w : workers) {
+        { std::lock_guard<std::mutex> lk(w->mtx); }
+        w->cv.notify_one();
+    }
+    for (auto& w : workers) {
+        if (w->thread.joinable()) w->thread.join();
+    }
+    running.store(false, std::memory_order_release);
+}
+
+int SessionPool::openSession(const AECParams& p, PipelineMode mode, SessionCallback cb) {
+    if (!running.load(std::memory_order_acquire)) return -1;
+    std::lock_guard<std::mutex> lk(openMtx);
+    size_t id = 0;
+    while (id < sessions.size() && sessions[id] && sessions[id]->state.load() != kFree) ++id;
+    if (id == sessions.size()) return -1;
+    if (!sessions[id]) sessions[id].reset(new Session());
+    Session& s = *sessions[id];
+
+    s.pipe.initialize(p, mode);
+    s.cb = std::move(cb);
+    s.input.reset(queueBlocks * 2 * blockLen);
+    s.tags.reset(queueBlocks);
+    s.output.reset(s.cb ? 0 : queueBlocks * blockLen);
+    s.outTags.reset(s.cb ? 0 : queueBlocks);
+    s.submitted.store(0);
+    s.processed.store(0);
+    s.droppedOutput.store(0);
+
+    // Home on the worker with the fewest sessions
+    int home = 0;
+    for (size_t i = 1; i < workers.size(); ++i) {
+        if (workers[i]->sessions < workers[home]->sessions) home = (int)i;
+    }
+    workers[home]->sessions++;
+    s.home = home;
+    s.state.store(kOpen, std::memory_order_release);
+    return (int)id;
+}
+
+void SessionPool::closeSession(int id) {
+    if (id < 0 || (size_t)id >= sessions.size()) return;
+    std::lock_guard<std::mutex> lk(openMtx);
+    if (!sessions[id] || sessions[id]->state.load() != kOpen) return;
+    Session& s = *sessions[id];
+    s.state.store(kClosing, std::memory_order_release);
+    // A worker that finds it closing drops it without processing
+    while (s.queued.load(std::memory_order_acquire)) std::this_thread::sleep_for(std::chrono::microseconds(100));
+    workers[s.home]->sessions--;
+    s.cb = nullptr;
+    s.state.store(kFree, std::memory_order_release);
+}
+
+bool SessionPool::submit(int id, const float* mic, const float* ref, uint64_t tag) {
+    if (id < 0 || (size_t)id >= sessions.size() || !sessions[id]) return false;
+    Session& s = *sessions[id];
+    if (s.state.load(std::memory_order_acquire) != kOpen) return false;
+    if (s.input.space() < 2 * blockLen || s.tags.space() < 1) {
+        droppedBlocks.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    s.input.push(mic, blockLen);
+    s.input.push(ref, blockLen);
+    s.tags.push(&tag, 1);
+    s.submitted.fetch_add(1, std::memory_order_relaxed);
+    // Pairs with the fence in runSession: either the worker sees this block or we
+    // see the session unqueued and queue it
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!s.queued.exchange(true, std::memory_order_acq_rel)) schedule(id);
+    return true;
+}
+
+bool SessionPool::receive(int id, float* out, uint64_t& tag) {
+    if (id < 0 || (size_t)id >= sessions.size() || !sessions[id]) return false;
+    Session& s = *sessions[id];
+    if (s.state.load(std::memory_order_acquire) != kOpen || s.cb) return false;
+    if (!s.outTags.pop(&tag, 1)) return false;
+    return s.output.pop(out, blockLen);
+}
+
+void SessionPool::drain() {
+    for (;;) {
+        bool busy = false;
+        for (auto& sp : sessions) {
+            if (!sp || sp->state.load(std::memory_order_acquire) != kOpen) continue;
+            if (sp->processed.load(std::memory_order_acquire) < sp->submitted.load(std::memory_order_relaxed)) {
+                busy = true;
+                break;
+            }
+        }
+        if (!busy) return;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+}
+
+SessionPoolStats SessionPool::getStats() const {
+    SessionPoolStats st;
+    st.blocks = 0;
+    st.steals = 0;
+    st.droppedBlocks = droppedBlocks.load(std::memory_order_relaxed);
+    st.droppedOutput = 0;
+    for (const auto& w : workers) {
+        uint64_t b = w->blocks.load(std::memory_order_relaxed);
+        st.workerBlocks.push_back(b);
+        st.blocks += b;
+        st.steals += w->steals.load(std::memory_order_relaxed);
+    }
+    for (const auto& sp : sessions) {
+        if (sp) st.droppedOutput += sp->droppedOutput.load(std::memory_order_relaxed);
+    }
+    return st;
+}
+
+AECProcessor* SessionPool::aec(int id) {
+    if (id < 0 || (size_t)id >= sessions.size() || !sessions[id]) return nullptr;
+    if (sessions[id]->state.load(std::memory_order_acquire) != kOpen) return nullptr;
+    return &sessions[id]->pipe.aec();
+}
+
+void SessionPool::schedule(int id) {
+    Session& s = *sessions[id];
+    Worker& home = *workers[s.home];
+    bool homeIdle;
+    {
+        std::lock_guard<std::mutex> lk(home.mtx);
+        home.ready[(home.head + home.count) % home.ready.size()] = id;
+        home.count++;
+        homeIdle = home.idle.load(std::memory_order_relaxed);
+    }
+    if (homeIdle) {
+        home.cv.notify_one();
+        return;
+    }
+    // Home worker is busy: wake an idle one to steal it
+    for (size_t i = 1; i < workers.size(); ++i) {
+        Worker& w = *workers[(s.home + i) % workers.size()];
+        if (!w.idle.load(std::memory_order_relaxed)) continue;
+        { std::lock_guard<std::mutex> lk(w.mtx); }
+        w.cv.notify_one();
+        break;
+    }
+}
+
+bool SessionPool::takeSession(int index, int& id) {
+    Worker& self = *workers[index];
+    {
+        std::lock_guard<std::mutex> lk(self.mtx);
+        if (self.count > 0) {
+            id = self.ready[self.head];
+            self.head = (self.head + 1) % self.ready.size();
+            self.count--;
+            return true;
+        }
+    }
+    for (size_t i = 1; i < workers.size(); ++i) {
+        Worker& victim = *workers[(index + i) % workers.size()];
+        std::lock_guard<std::mutex> lk(victim.mtx);
+        if (victim.count == 0) continue;
+        victim.count--;
+        id = victim.ready[(victim.head + victim.count) % victim.ready.size()];
+        self.steals.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void SessionPool::runSession(Worker& w, int id) {
+    Session& s = *sessions[id];
+    float* mic = w.in.data();
+    float* ref = w.in.data() + blockLen;
+    for (;;) {
+        int n = 0;
+        uint64_t tag;
+        while (n < kRunBlocks && s.state.load(std::memory_order_acquire) == kOpen && s.tags.pop(&tag, 1)) {
+            s.input.pop(w.in.data(), 2 * blockLen);
+            s.pipe.process(mic, ref, w.out.data(), blockLen);
+            if (s.cb) {
+                s.cb(id, tag, w.out.data(), blockLen);
+            } else if (s.output.space() >= blockLen && s.outTags.space() >= 1) {
+                s.output.push(w.out.data(), blockLen);
+                s.outTags.push(&tag, 1);
+            } else {
+                s.droppedOutput.fetch_add(1, std::memory_order_relaxed);
+            }
+            s.processed.fetch_add(1, std::memory_order_release);
+            w.blocks.fetch_add(1, std::memory_order_relaxed);
+            ++n;
+        }
+        bool open = s.state.load(std::memory_order_acquire) == kOpen;
+        if (open && n == kRunBlocks && s.tags.available() > 0) {
+            // Still backlogged: back of the home queue, still marked queued
+            schedule(id);
+            return;
+        }
+        s.queued.store(false, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        // A block submitted before the flag was cleared did not queue the session
+        if (!open || s.tags.available() == 0) return;
+        if (s.queued.exchange(true, std::memory_order_acq_rel)) return;
+    }
+}
+
+void SessionPool::workerLoop(int index) {
+    Worker& w = *workers[index];
+    for (;;) {
+        int id;
+        if (takeSession(index, id)) {
+            runSession(w, id);
+            continue;
+        }
+        std::unique_lock<std::mutex> lk(w.mtx);
+        if (w.count > 0) continue;
+        if (stopping.load(std::memory_order_acquire)) break;
+        w.idle.store(true, std::memory_order_relaxed);
+        w.cv.wait_for(lk, kIdleWait);
+        w.idle.store(false, std::memory_order_relaxed);
+    }
+}
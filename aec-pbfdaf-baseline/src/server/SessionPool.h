@@ -0,0 +1,98 @@
+#pragma once
+// Many echo-cancellation sessions (one per call participant) on a fixed set of
+// worker threads. Each session owns an AECPipeline and a lock-free queue of
+// submitted blocks; a session with queued blocks sits on its home worker's ready
+// queue, so its filter state stays in that core's cache. A worker with nothing of
+// its own steals ready sessions from the back of the other queues. A session runs
+// on one worker at a time, so its blocks are processed in order. Completed blocks
+// go to the session's callback (on the worker thread) or to its completion queue.
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../aec_core/AECPipeline.h"
+#include "../realtime/SpscRing.h"
+
+struct SessionPoolConfig {
+    int workers;          // <= 0: hardware concurrency
+    size_t blockFrames;   // Frames per submitted block, same for every session
+    int queueBlocks;      // Blocks a session can have waiting (input and completion queue)
+    int maxSessions;
+    bool pinWorkers;      // Pin worker i to CPU i (Linux and Windows)
+};
+
+SessionPoolConfig defaultSessionPoolConfig();
+
+// Runs on a worker thread; out is valid only for the duration of the call and the
+// callback must not block
+typedef std::function<void(int session, uint64_t tag, const float* out, size_t frames)> SessionCallback;
+
+struct SessionPoolStats {
+    uint64_t blocks;         // Blocks processed
+    uint64_t steals;         // Session runs taken from another worker's queue
+    uint64_t droppedBlocks;  // Submissions refused: the session's queue was full
+    uint64_t droppedOutput;  // Completed blocks lost: the completion queue was full
+    std::vector<uint64_t> workerBlocks;
+};
+
+class SessionPool {
+public:
+    SessionPool();
+    ~SessionPool();
+
+    bool start(const SessionPoolConfig& cfg, std::string& err);
+    // Once the producers have stopped: processes what is queued and joins the workers
+    void stop();
+    bool isRunning() const { return running.load(std::memory_order_acquire); }
+    int workerCount() const { return (int)workers.size(); }
+    size_t blockFrames() const { return blockLen; }
+
+    // Not real-time safe (allocates). Returns the session id, or -1 when all
+    // maxSessions slots are open. cb == nullptr: completed blocks go to receive().
+    int openSession(const AECParams& p, PipelineMode mode, SessionCallback cb = nullptr);
+    // The session's producer must have stopped. Waits for a block in progress;
+    // queued blocks are discarded.
+    void closeSession(int id);
+
+    // One producer thread per session. No allocation; a short lock on the home
+    // worker's ready queue. blockFrames() frames of each; false if the block was
+    // dropped (queue full or session not open).
+    bool submit(int id, const float* mic, const float* ref, uint64_t tag);
+    // One consumer thread per session, sessions without a callback. The next
+    // completed block in submission order; false if none is ready.
+    bool receive(int id, float* out, uint64_t& tag);
+
+    // Blocks until every block submitted so far has been processed
+    void drain();
+
+    SessionPoolStats getStats() const;
+    // Canceller stats, setters and load monitor of an open session (thread-safe
+    // getters and setters only while it runs)
+    AECProcessor* aec(int id);
+
+private:
+    struct Session;
+    struct Worker;
+
+    SessionPool(const SessionPool&) = delete;
+    SessionPool& operator=(const SessionPool&) = delete;
+    void workerLoop(int index);
+    bool takeSession(int index, int& id);
+    void runSession(Worker& w, int id);
+    void schedule(int id);
+
+    std::vector<std::unique_ptr<Session>> sessions;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::mutex openMtx;           // openSession / closeSession
+    size_t blockLen;
+    size_t queueBlocks;
+    std::atomic<bool> running;
+    std::atomic<bool> stopping;
+    std::atomic<uint64_t> droppedBlocks;
+};
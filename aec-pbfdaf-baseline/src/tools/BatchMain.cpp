@@ -0,0 +1,98 @@
+// aec_batch: runs the canceller over a manifest of mic/ref/out triples on all cores.
+//   aec_batch [options] manifest.txt
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "BatchProcess.h"
+
+static void usage() {
+    fprintf(stderr,
+        "Usage: aec_batch [options] manifest.txt\n"
+        "Manifest: one 'mic.wav ref.wav out.wav' per line (tab-separated if paths contain spaces)\n"
+        "Options: --threads n  --prefetch depth (0 = off)  --pending n  --summary out.json  --progress\n"
+        "         --chunk frames  --filter taps  --mu v  --eps v  --maxdelay ms  --res  --enhance  --fused\n"
+        "         --subband  --drift  --nlms  --block-nlms  --vss  --prop  --no-align\n");
+}
+
+int main(int argc, char** argv) {
+    BatchConfig cfg = defaultBatchConfig();
+    std::string manifest, summaryPath;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "--threads" && i + 1 < argc) {
+            cfg.threads = atoi(argv[++i]);
+        } else if (a == "--prefetch" && i + 1 < argc) {
+            cfg.prefetchDepth = atoi(argv[++i]);
+        } else if (a == "--pending" && i + 1 < argc) {
+            cfg.maxPendingWrites = atoi(argv[++i]);
+        } else if (a == "--summary" && i + 1 < argc) {
+            summaryPath = argv[++i];
+        } else if (a == "--progress") {
+            cfg.progress = true;
+        } else if (a == "--chunk" && i + 1 < argc) {
+            cfg.offline.chunkFrames = (size_t)atoi(argv[++i]);
+        } else if (a == "--filter" && i + 1 < argc) {
+            cfg.offline.aec.filterLen = atoi(argv[++i]);
+        } else if (a == "--mu" && i + 1 < argc) {
+            cfg.offline.aec.mu = (float)atof(argv[++i]);
+        } else if (a == "--eps" && i + 1 < argc) {
+            cfg.offline.aec.epsilon = (float)atof(argv[++i]);
+        } else if (a == "--maxdelay" && i + 1 < argc) {
+            cfg.offline.aec.maxDelayMs = atoi(argv[++i]);
+        } else if (a == "--enhance") {
+            cfg.offline.enhance = true;
+        } else if (a == "--res") {
+            cfg.offline.residualEcho = true;
+        } else if (a == "--subband") {
+            cfg.offline.subband = true;
+        } else if (a == "--drift") {
+            cfg.offline.drift = true;
+        } else if (a == "--nlms") {
+            cfg.offline.filter = AECFilterMode::Nlms;
+        } else if (a == "--block-nlms") {
+            cfg.offline.filter = AECFilterMode::BlockNlms;
+        } else if (a == "--vss") {
+            cfg.offline.vss = true;
+        } else if (a == "--prop") {
+            cfg.offline.aec.proportionate = true;
+        } else if (a == "--fused") {
+            cfg.offline.enhance = true;
+            cfg.offline.fused = true;
+        } else if (a == "--no-align") {
+            cfg.offline.alignOutput = false;
+        } else if (!a.empty() && a[0] != '-' && manifest.empty()) {
+            manifest = a;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (manifest.empty() || cfg.offline.chunkFrames == 0 || cfg.offline.aec.filterLen <= 0) {
+        usage();
+        return 1;
+    }
+
+    std::vector<BatchItem> items;
+    std::string err;
+    if (!loadBatchManifest(manifest, items, err)) {
+        fprintf(stderr, "%s\n", err.c_str());
+        return 2;
+    }
+
+    std::vector<BatchItemResult> results;
+    BatchSummary s;
+    bool ok = runBatch(cfg, items, results, s);
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        if (!results[i].ok) fprintf(stderr, "FAILED %s: %s\n", items[i].mic.c_str(), results[i].error.c_str());
+    }
+    fprintf(stderr, "%zu files (%zu failed), %.1f s of audio in %.2f s on %d threads: %.1fx real-time (prefetch: %s)\n",
+            s.files, s.failed, s.audioSec, s.wallSec, s.threads, s.xRealtime, s.prefetchBackend.c_str());
+
+    if (!summaryPath.empty() && !writeBatchSummary(summaryPath, s, items, results)) {
+        fprintf(stderr, "Summary write error: %s\n", summaryPath.c_str());
+        return 5;
+    }
+    return ok ? 0 : 3;
+}
@@ -0,0 +1,287 @@
+#include "BatchProcess.h"
+#include "../audio_io/WavFile.h"
+#include "../audio_io/FilePrefetcher.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <chrono>
+#include <algorithm>
+
+static bool isAbsolutePath(const std::string& p) {
+    if (p.empty()) return false;
+    if (p[0] == '/' || p[0] == '\\') return true;
+    return p.size() > 1 && p[1] == ':';
+}
+
+bool loadBatchManifest(const std::string& path, std::vector<BatchItem>& items, std::string& err) {
+    std::ifstream f(path);
+    if (!f) { err = "Manifest read error: " + path; return false; }
+    size_t slash = path.find_last_of("/\\");
+    std::string dir = slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(f, line)) {
+        lineNo++;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.resize(hash);
+
+        std::vector<std::string> fields;
+        if (line.find('\t') != std::string::npos) {
+            // Tab-separated: paths may contain spaces
+            std::stringstream ss(line);
+            std::string tok;
+            while (std::getline(ss, tok, '\t')) {
+                size_t a = tok.find_first_not_of(' ');
+                size_t b = tok.find_last_not_of(' ');
+                if (a != std::string::npos) fields.push_back(tok.substr(a, b - a + 1));
+            }
+        } else {
+            std::stringstream ss(line);
+            std::string tok;
+            while (ss >> tok) fields.push_back(tok);
+        }
+        if (fields.empty()) continue;
+        if (fields.size() != 3) {
+            err = path + ":" + std::to_string(lineNo) + ": expected 'mic ref out'";
+            return false;
+        }
+        for (auto& p : fields) {
+            if (!isAbsolutePath(p)) p = dir + p;
+        }
+        items.push_back({ fields[0], fields[1], fields[2] });
+    }
+    return true;
+}
+
+BatchConfig defaultBatchConfig() {
+    BatchConfig c;
+    c.offline = defaultOfflineConfig(16000);
+    c.threads = 0;
+    c.prefetchDepth = 8;
+    c.maxPendingWrites = 0;
+    c.progress = false;
+    return c;
+}
+
+// Single background writer; workers block in push() once 'limit' outputs are pending
+class BatchWriter {
+public:
+    struct Job {
+        size_t index;
+        int sampleRate;
+        std::vector<float> data;
+    };
+
+    BatchWriter(const std::vector<BatchItem>& items, std::vector<BatchItemResult>& results, size_t limit)
+        : items(items), results(results), limit(limit), done(false) {
+        worker = std::thread(&BatchWriter::run, this);
+    }
+
+    void push(Job&& job) {
+        std::unique_lock<std::mutex> lock(mtx);
+        spaceCv.wait(lock, [this] { return queue.size() < limit; });
+        queue.push_back(std::move(job));
+        lock.unlock();
+        jobCv.notify_one();
+    }
+
+    void finish() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            done = true;
+        }
+        jobCv.notify_one();
+        if (worker.joinable()) worker.join();
+    }
+
+private:
+    void run() {
+        while (true) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                jobCv.wait(lock, [this] { return done || !queue.empty(); });
+                if (queue.empty()) return;
+                job = std::move(queue.front());
+                queue.pop_front();
+            }
+            spaceCv.notify_one();
+
+            WavFileWriter w;
+            const std::string& path = items[job.index].out;
+            bool ok = w.open(path, job.sampleRate, 1);
+            ok = ok && w.write(job.data.data(), job.data.size());
+            ok = w.close() && ok;
+            if (!ok) {
+                results[job.index].ok = false;
+                results[job.index].error = "Write error: " + path;
+            }
+        }
+    }
+
+    const std::vector<BatchItem>& items;
+    std::vector<BatchItemResult>& results;
+    size_t limit;
+    bool done;
+    std::thread worker;
+    std::mutex mtx;
+    std::condition_variable jobCv;
+    std::condition_variable spaceCv;
+    std::deque<Job> queue;
+};
+
+bool runBatch(const BatchConfig& cfg, const std::vector<BatchItem>& items,
+              std::vector<BatchItemResult>& results, BatchSummary& summary) {
+    auto t0 = std::chrono::steady_clock::now();
+    size_t n = items.size();
+
+    BatchItemResult blank;
+    blank.ok = false;
+    blank.sampleRate = 0;
+    blank.frames = 0;
+    blank.audioSec = 0.0;
+    blank.procSec = 0.0;
+    blank.stats = AECStats();
+    blank.rtf = 0.0f;
+    results.assign(n, blank);
+
+    int threads = cfg.threads > 0 ? cfg.threads : (int)std::thread::hardware_concurrency();
+    if (threads <= 0) threads = 1;
+    if ((size_t)threads > n) threads = (int)std::max<size_t>(n, 1);
+    size_t depth = cfg.prefetchDepth > 0 ? (size_t)cfg.prefetchDepth : 0;
+    size_t pending = cfg.maxPendingWrites > 0 ? (size_t)cfg.maxPendingWrites : (size_t)threads * 2;
+
+    FilePrefetcher prefetcher;
+    if (depth > 0) prefetcher.start();
+    std::mutex prefetchMtx;
+    size_t prefetched = 0;
+    auto prefetchUpTo = [&](size_t upTo) {
+        if (depth == 0) return;
+        std::lock_guard<std::mutex> lock(prefetchMtx);
+        upTo = std::min(upTo, n);
+        for (; prefetched < upTo; ++prefetched) {
+            prefetcher.enqueue(items[prefetched].mic);
+            prefetcher.enqueue(items[prefetched].ref);
+        }
+    };
+    prefetchUpTo(depth);
+
+    BatchWriter writer(items, results, pending);
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> finished(0);
+    std::mutex progressMtx;
+    auto lastProgress = t0;
+
+    auto work = [&]() {
+        std::vector<float> out;
+        while (true) {
+            size_t i = next.fetch_add(1);
+            if (i >= n) break;
+            prefetchUpTo(i + 1 + depth);
+
+            auto s0 = std::chrono::steady_clock::now();
+            BatchItemResult& r = results[i];
+            OfflineResult res;
+            int sr = 0;
+            if (processWavToBuffer(cfg.offline, items[i].mic, items[i].ref, out, sr, res, r.error)) {
+                r.ok = true;
+                r.sampleRate = sr;
+                r.frames = res.frames;
+                r.audioSec = res.audioSec;
+                r.stats = res.stats;
+                r.rtf = res.load.rtf;
+                r.procSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - s0).count();
+                BatchWriter::Job job;
+                job.index = i;
+                job.sampleRate = sr;
+                job.data.swap(out);
+                writer.push(std::move(job));
+            } else {
+                r.procSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - s0).count();
+            }
+
+            size_t f = finished.fetch_add(1) + 1;
+            if (cfg.progress && progressMtx.try_lock()) {
+                auto now = std::chrono::steady_clock::now();
+                if (std::chrono::duration<double>(now - lastProgress).count() >= 1.0 || f == n) {
+                    lastProgress = now;
+                    fprintf(stderr, "\r%zu / %zu files", f, n);
+                    fflush(stderr);
+                }
+                progressMtx.unlock();
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) pool.emplace_back(work);
+    work();
+    for (auto& th : pool) th.join();
+    writer.finish();
+    if (cfg.progress) fprintf(stderr, "\n");
+
+    summary.threads = threads;
+    summary.prefetchBackend = depth > 0 ? prefetcher.backend() : "off";
+    summary.prefetchBytes = prefetcher.bytesIssued();
+    prefetcher.stop();
+
+    summary.files = n;
+    summary.failed = 0;
+    summary.audioSec = 0.0;
+    for (const auto& r : results) {
+        if (!r.ok) summary.failed++;
+        summary.audioSec += r.audioSec;
+    }
+    summary.wallSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    summary.xRealtime = summary.wallSec > 0.0 ? summary.audioSec / summary.wallSec : 0.0;
+    return summary.failed == 0;
+}
+
+static std::string jsonEscape(const std::string& s) {
+    std::string o;
+    o.reserve(s.size() + 2);
+    for (char c : s) {
+        if (c == '"' || c == '\\') { o += '\\'; o += c; }
+        else if ((unsigned char)c < 0x20) {
+            char b[8];
+            snprintf(b, sizeof(b), "\\u%04x", (unsigned)(unsigned char)c);
+            o += b;
+        } else {
+            o += c;
+        }
+    }
+    return o;
+}
+
+bool writeBatchSummary(const std::string& path, const BatchSummary& s,
+                       const std::vector<BatchItem>& items, const std::vector<BatchItemResult>& results) {
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) return false;
+    fprintf(f, "{\n  \"threads\": %d,\n  \"prefetch\": \"%s\",\n  \"files\": %zu,\n  \"failed\": %zu,\n"
+               "  \"audioSec\": %.3f,\n  \"wallSec\": %.3f,\n  \"xRealtime\": %.2f,\n  \"prefetchBytes\": %llu,\n"
+               "  \"items\": [\n",
+            s.threads, s.prefetchBackend.c_str(), s.files, s.failed, s.audioSec, s.wallSec, s.xRealtime,
+            (unsigned long long)s.prefetchBytes);
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BatchItemResult& r = results[i];
+        double x = r.procSec > 0.0 ? r.audioSec / r.procSec : 0.0;
+        fprintf(f, "    {\"mic\": \"%s\", \"ref\": \"%s\", \"out\": \"%s\", \"ok\": %s, \"error\": \"%s\", "
+                   "\"sampleRate\": %d, \"audioSec\": %.3f, \"procSec\": %.3f, \"xRealtime\": %.1f, "
+                   "\"avgErleDb\": %.2f, \"maxErleDb\": %.2f, \"convergenceMs\": %.0f, \"delayUpdates\": %d, "
+                   "\"rtf\": %.4f}%s\n",
+                jsonEscape(items[i].mic).c_str(), jsonEscape(items[i].ref).c_str(), jsonEscape(items[i].out).c_str(),
+                r.ok ? "true" : "false", jsonEscape(r.error).c_str(), r.sampleRate, r.audioSec, r.procSec, x,
+                r.stats.avgErle, r.stats.maxErle, r.stats.convergedTimeMs, r.stats.delayUpdateCount, r.rtf,
+                i + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    return fclose(f) == 0;
+}
@@ -0,0 +1,58 @@
+#pragma once
+// Corpus batch processing: independent AECProcessor instances over a manifest
+// of mic/ref/out triples on a worker pool, with input read-ahead and a
+// background output writer.
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "OfflineProcess.h"
+
+struct BatchItem {
+    std::string mic;
+    std::string ref;
+    std::string out;
+};
+
+struct BatchConfig {
+    OfflineConfig offline;
+    int threads;          // <= 0: hardware concurrency
+    int prefetchDepth;    // Items read ahead of the next dispatched one
+    int maxPendingWrites; // Finished outputs queued for the writer before workers block
+    bool progress;        // Periodic progress line on stderr
+};
+
+struct BatchItemResult {
+    bool ok;
+    std::string error;
+    int sampleRate;
+    uint64_t frames;
+    double audioSec;
+    double procSec;       // Worker time for read + process (excludes the background write)
+    AECStats stats;
+    float rtf;
+};
+
+struct BatchSummary {
+    int threads;
+    std::string prefetchBackend;
+    size_t files;
+    size_t failed;
+    double audioSec;
+    double wallSec;
+    double xRealtime;     // Aggregate audio seconds per wall second
+    uint64_t prefetchBytes;
+};
+
+// One "mic ref out" triple per line, tab- or whitespace-separated; '#' starts a comment.
+// Relative paths are taken relative to the manifest's directory.
+bool loadBatchManifest(const std::string& path, std::vector<BatchItem>& items, std::string& err);
+
+BatchConfig defaultBatchConfig();
+
+bool runBatch(const BatchConfig& cfg, const std::vector<BatchItem>& items,
+              std::vector<BatchItemResult>& results, BatchSummary& summary);
+
+bool writeBatchSummary(const std::string& path, const BatchSummary& summary,
+                       const std::vector<BatchItem>& items, const std::vector<BatchItemResult>& results);
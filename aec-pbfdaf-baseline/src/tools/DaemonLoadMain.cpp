@@ -0,0 +1,187 @@
+// aec_daemon_load: load generator for aec_daemon. Opens many sessions through the
+// client library (spread over one or more connections, as separate media processes
+// would), feeds each one block every block period (or as fast as the rings accept
+// with --flood) from one synthetic echo scenario, and reads the output on a second
+// thread. Reports throughput, submit-to-output latency through the daemon, drops and
+// the sessions' ERLE.
+//   aec_daemon_load [options]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <sys/epoll.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "LoadGen.h"
+#include "../server/AECClient.h"
+
+static void usage() {
+    fprintf(stderr,
+        "Usage: aec_daemon_load [options]\n"
+        "Options: --socket path (default $XDG_RUNTIME_DIR/aec_daemon.sock, else /tmp/aec_daemon.sock)\n"
+        "         --sessions n (default 100)  --conns n (client connections, default 1)  --sec s (default 5)\n"
+        "         --sr rate  --filter taps  --mu v  --mode aec|cascade|fused\n"
+        "         --history f32|fp16|bf16  --weights f32|fp16|bf16 (PBFDAF spectrum storage)\n"
+        "         --flood (submit as fast as the rings accept instead of in real time)\n");
+}
+
+int main(int argc, char** argv) {
+    std::string socketPath = defaultDaemonSocketPath();
+    AECParams ap = defaultAECParams(16000);
+    PipelineMode mode = PipelineMode::AecOnly;
+    int sessions = 100;
+    int conns = 1;
+    double seconds = 5.0;
+    bool flood = false;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "--socket" && i + 1 < argc) {
+            socketPath = argv[++i];
+        } else if (a == "--sessions" && i + 1 < argc) {
+            sessions = atoi(argv[++i]);
+        } else if (a == "--conns" && i + 1 < argc) {
+            conns = atoi(argv[++i]);
+        } else if (a == "--sec" && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+        } else if (a == "--sr" && i + 1 < argc) {
+            ap.sampleRate = atoi(argv[++i]);
+        } else if (a == "--filter" && i + 1 < argc) {
+            ap.filterLen = atoi(argv[++i]);
+        } else if (a == "--mu" && i + 1 < argc) {
+            ap.mu = (float)atof(argv[++i]);
+        } else if (a == "--mode" && i + 1 < argc) {
+            std::string m = argv[++i];
+            if (m == "aec") mode = PipelineMode::AecOnly;
+            else if (m == "cascade") mode = PipelineMode::Cascade;
+            else if (m == "fused") mode = PipelineMode::Fused;
+            else { usage(); return 1; }
+        } else if (a == "--history" && i + 1 < argc) {
+            if (!parseSpectrumPrecision(argv[++i], ap.historyPrecision)) { usage(); return 1; }
+        } else if (a == "--weights" && i + 1 < argc) {
+            if (!parseSpectrumPrecision(argv[++i], ap.weightPrecision)) { usage(); return 1; }
+        } else if (a == "--flood") {
+            flood = true;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (sessions < 1 || conns < 1 || seconds <= 0.0 || ap.sampleRate <= 0) {
+        usage();
+        return 1;
+    }
+    conns = std::min(conns, sessions);
+
+    std::string err;
+    std::vector<std::unique_ptr<AECClient>> clients;
+    for (int c = 0; c < conns; ++c) {
+        std::unique_ptr<AECClient> cl(new AECClient());
+        if (!cl->connect(socketPath, err)) {
+            fprintf(stderr, "%s\n", err.c_str());
+            return 1;
+        }
+        clients.push_back(std::move(cl));
+    }
+    std::vector<std::unique_ptr<AECClientSession>> ss;
+    for (int k = 0; k < sessions; ++k) {
+        std::unique_ptr<AECClientSession> s = clients[k % conns]->openSession(ap, mode, err);
+        if (!s) {
+            fprintf(stderr, "Could not open session %d: %s\n", k, err.c_str());
+            return 1;
+        }
+        ss.push_back(std::move(s));
+    }
+    const size_t B = ss[0]->blockFrames();
+
+    ScenarioFeed feed;
+    if (!feed.init("daemon", ap.sampleRate, B, ss.size())) {
+        fprintf(stderr, "Scenario generation failed\n");
+        return 1;
+    }
+
+    // Output thread: waits on every session's notify fd
+    int ep = epoll_create1(EPOLL_CLOEXEC);
+    for (size_t k = 0; k < ss.size(); ++k) {
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.u64 = k;
+        epoll_ctl(ep, EPOLL_CTL_ADD, ss[k]->notifyFd(), &ev);
+    }
+    LatencyHistogram hist;
+    std::atomic<bool> done(false);
+    std::thread reader([&]() {
+        std::vector<float> out(B);
+        std::vector<epoll_event> events(256);
+        while (!done.load(std::memory_order_acquire)) {
+            int n = epoll_wait(ep, events.data(), (int)events.size(), 50);
+            for (int i = 0; i < n; ++i) {
+                AECClientSession& s = *ss[events[i].data.u64];
+                s.clearNotify();
+                uint64_t tag;
+                while (s.receive(out.data(), tag)) hist.record(loadClockNs() - tag);
+            }
+        }
+    });
+
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point start = Clock::now();
+    FeedResult fr = runFeed(feed, seconds, flood, std::chrono::microseconds((int64_t)B * 1000000 / ap.sampleRate),
+        [&](size_t k, const float* mic, const float* ref) { return ss[k]->submit(mic, ref, loadClockNs()); });
+
+    // Collect what is still in flight, then the daemon's per-session stats (output
+    // blocks it dropped never come back)
+    uint64_t last = hist.count();
+    Clock::time_point quiet = Clock::now();
+    while (hist.count() < fr.submitted && Clock::now() - quiet < std::chrono::milliseconds(500)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        if (hist.count() != last) {
+            last = hist.count();
+            quiet = Clock::now();
+        }
+    }
+    double wall = std::chrono::duration<double>(Clock::now() - start).count();
+    done.store(true, std::memory_order_release);
+    reader.join();
+    close(ep);
+
+    uint64_t stalls = 0, dropOut = 0;
+    double erleSum = 0.0;
+    float erleMin = 1e9f;
+    DaemonSessionStats s0 = DaemonSessionStats();
+    for (size_t k = 0; k < ss.size(); ++k) {
+        DaemonSessionStats st;
+        if (!clients[k % conns]->getStats(*ss[k], st, err)) {
+            fprintf(stderr, "Stats of session %zu: %s\n", k, err.c_str());
+            return 1;
+        }
+        if (k == 0) s0 = st;
+        stalls += st.stalls;
+        dropOut += st.droppedOutput;
+        erleSum += st.aec.avgErle;
+        erleMin = std::min(erleMin, st.aec.avgErle);
+    }
+    for (size_t k = 0; k < ss.size(); ++k) clients[k % conns]->closeSession(*ss[k], err);
+
+    uint64_t got = hist.count();
+    double audioSec = (double)got * (double)B / (double)ap.sampleRate;
+    printf("%d sessions on %d connections, %s, %zu-frame blocks, %.2f s wall\n",
+        sessions, conns, flood ? "flood" : "paced", B, wall);
+    printf("  %llu blocks (%.0f blocks/s, %.1f x real time over all sessions), ring full %llu\n",
+        (unsigned long long)got, (double)got / wall, audioSec / wall, (unsigned long long)fr.refused);
+    printf("  daemon input stalls %llu (pool queue full), dropped output %llu (ring full)\n",
+        (unsigned long long)stalls, (unsigned long long)dropOut);
+    printf("  latency p50 %.0f us, p99 %.0f us, max %.0f us\n",
+        hist.percentileUs(0.5), hist.percentileUs(0.99), hist.maxUs());
+    if (!flood) printf("  feeder late on %llu ticks\n", (unsigned long long)fr.lateTicks);
+    printf("  ERLE avg %.1f dB over sessions (min %.1f dB); session 0: avg %.1f dB, max %.1f dB, %llu blocks\n",
+        erleSum / (double)ss.size(), erleMin, s0.aec.avgErle, s0.aec.maxErle, (unsigned long long)s0.blocks);
+    if (got + dropOut != fr.submitted) {
+        fprintf(stderr, "Received %llu of %llu submitted blocks\n", (unsigned long long)got, (unsigned long long)fr.submitted);
+        return 1;
+    }
+    return (!flood && (fr.refused > 0 || dropOut > 0)) ? 2 : 0;
+}
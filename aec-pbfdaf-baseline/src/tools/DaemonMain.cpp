@@ -0,0 +1,116 @@
+// aec_daemon: local echo-cancellation service. Media processes on this host connect
+// to its Unix socket (see server/AECClient.h), open sessions and exchange audio
+// through shared memory; all sessions share one worker pool. Runs until SIGINT or
+// SIGTERM (or for --sec seconds), printing pool and session stats periodically.
+//   aec_daemon [options]
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include "../server/AECDaemon.h"
+
+static volatile sig_atomic_t gStop = 0;
+
+static void onSignal(int) { gStop = 1; }
+
+static void usage() {
+    fprintf(stderr,
+        "Usage: aec_daemon [options]\n"
+        "Options: --socket path (default $XDG_RUNTIME_DIR/aec_daemon.sock, else /tmp/aec_daemon.sock)\n"
+        "         --socket-mode octal (socket permissions, default 600)  --workers n (0 = all cores)  --pin\n"
+        "         --frames n (frames per block, default 160)  --queue blocks (pool queue per session)\n"
+        "         --ring blocks (shared-memory ring per direction)  --max-sessions n\n"
+        "         --stats s (print stats every s seconds, 0 = off)  --verbose (per-session stats too)\n"
+        "         --sec s (exit after s seconds)\n");
+}
+
+static void printStats(AECDaemon& daemon, bool verbose) {
+    AECDaemonStats st = daemon.getStats();
+    printf("%d connections, %d sessions: %llu blocks, steals %llu, input stalls %llu, dropped output %llu, "
+           "protocol errors %llu\n",
+        st.connections, st.sessions, (unsigned long long)st.pool.blocks, (unsigned long long)st.pool.steals,
+        (unsigned long long)st.stalls, (unsigned long long)st.droppedOutput,
+        (unsigned long long)st.protocolErrors);
+    if (verbose) {
+        for (int id : daemon.sessionIds()) {
+            DaemonSessionStats ss;
+            if (!daemon.sessionStats(id, ss)) continue;
+            printf("  session %d: %llu blocks, ERLE %.1f dB (avg %.1f), lag %.1f ms, stalls %llu, dropped %llu\n",
+                id, (unsigned long long)ss.blocks, ss.aec.erle, ss.aec.avgErle, ss.aec.currentLagMs,
+                (unsigned long long)ss.stalls, (unsigned long long)ss.droppedOutput);
+        }
+    }
+    fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+    AECDaemonConfig cfg = defaultAECDaemonConfig();
+    double statsSec = 10.0;
+    double seconds = 0.0;
+    bool verbose = false;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "--socket" && i + 1 < argc) {
+            cfg.socketPath = argv[++i];
+        } else if (a == "--socket-mode" && i + 1 < argc) {
+            cfg.socketMode = (int)strtol(argv[++i], nullptr, 8);
+        } else if (a == "--workers" && i + 1 < argc) {
+            cfg.pool.workers = atoi(argv[++i]);
+        } else if (a == "--frames" && i + 1 < argc) {
+            cfg.pool.blockFrames = (size_t)atoi(argv[++i]);
+        } else if (a == "--queue" && i + 1 < argc) {
+            cfg.pool.queueBlocks = atoi(argv[++i]);
+        } else if (a == "--ring" && i + 1 < argc) {
+            cfg.ringBlocks = atoi(argv[++i]);
+        } else if (a == "--max-sessions" && i + 1 < argc) {
+            cfg.pool.maxSessions = atoi(argv[++i]);
+        } else if (a == "--stats" && i + 1 < argc) {
+            statsSec = atof(argv[++i]);
+        } else if (a == "--sec" && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+        } else if (a == "--pin") {
+            cfg.pool.pinWorkers = true;
+        } else if (a == "--verbose") {
+            verbose = true;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    struct sigaction sa;
+    sa.sa_handler = onSignal;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = 0;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+
+    AECDaemon daemon;
+    std::string err;
+    if (!daemon.start(cfg, err)) {
+        fprintf(stderr, "%s\n", err.c_str());
+        return 1;
+    }
+    printf("Listening on %s: %zu-frame blocks, %d-block rings, up to %d sessions\n",
+        cfg.socketPath.c_str(), cfg.pool.blockFrames, cfg.ringBlocks, cfg.pool.maxSessions);
+    fflush(stdout);
+
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point start = Clock::now();
+    Clock::time_point nextStats = start + std::chrono::microseconds((int64_t)(statsSec * 1e6));
+    while (!gStop) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        Clock::time_point now = Clock::now();
+        if (seconds > 0.0 && now - start >= std::chrono::microseconds((int64_t)(seconds * 1e6))) break;
+        if (statsSec > 0.0 && now >= nextStats) {
+            printStats(daemon, verbose);
+            nextStats += std::chrono::microseconds((int64_t)(statsSec * 1e6));
+        }
+    }
+    printStats(daemon, verbose);
+    daemon.stop();
+    return 0;
+}
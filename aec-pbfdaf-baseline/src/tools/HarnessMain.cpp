@@ -0,0 +1,659 @@
+// aec_harness: synthetic echo scenarios through AECProcessor with quality and
+// CPU pass/fail thresholds. Exit code is non-zero when any scenario fails.
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include "../aec_core/AECLockstep.h"
+#include "../aec_core/AECProcessor.h"
+#include "ScenarioGen.h"
+
+struct ScenarioCase {
+    ScenarioParams sp;
+    float minSteadyErleDb; // Mean ERLE over the last quarter of the run
+    float maxTime10Sec;    // Time to first reach 10 dB ERLE (< 0: not checked)
+    float maxTime20Sec;    // Time to first reach 20 dB ERLE (< 0: not checked)
+    float maxLagSettleSec; // Time for currentLag to settle (after the jump, if any)
+    bool warmStart;        // Start from the echo path learned on warmFrom (a previous call)
+    ScenarioParams warmFrom;
+    int expectWarm;        // AECStats::warmStart expected at the end of a warm-started run
+    bool subband;          // AECProcessor::setSubband
+    bool drift;            // AECProcessor::setDriftCompensation
+    AECFilterMode filter;  // AECProcessor::setFilterMode
+    bool vss;              // AECProcessor::setVariableStepSize
+    bool proportionate;    // AECParams::proportionate
+    SpectrumPrecision history; // AECParams::historyPrecision (Float32: the --history option)
+    SpectrumPrecision weights; // AECParams::weightPrecision (Float32: the --weights option)
+    int filterLen;         // Taps at 16 kHz (0: the --filter option)
+    int maxDelayUpdates;   // Lag changes (each clears the filter history) allowed (< 0: not checked)
+};
+
+struct ScenarioResult {
+    std::string name;
+    std::vector<float> erleDb;  // Per window, NaN where the echo is too weak to measure
+    float windowSec;
+    float time10Sec;            // < 0: never reached
+    float time20Sec;
+    float steadyErleDb;
+    float lagSettleSec;         // < 0: never settled
+    float finalLagErrMs;
+    int delayUpdates;
+    int warmStart;              // AECStats::warmStart at the end
+    double cpuSec;
+    double audioSec;
+    bool pass;
+    std::string why;
+};
+
+struct HarnessOptions {
+    size_t frames;       // Caller frame size (0 = 10 ms)
+    int filterLen;
+    float mu;
+    int maxDelayMs;
+    float maxRtf;
+    float windowSec;
+    bool trace;
+    bool drift;          // Drift compensation in every scenario
+    bool vss;            // Variable step size in every PBFDAF scenario
+    bool proportionate;  // AECParams::proportionate in every scenario
+    SpectrumPrecision history; // AECParams::historyPrecision / weightPrecision in every scenario
+    SpectrumPrecision weights;
+    bool lockstep;       // Run the scenarios AECLockstep supports through its lanes
+    std::string only;
+    std::string jsonPath;
+};
+
+static std::vector<ScenarioCase> defaultCases() {
+    std::vector<ScenarioCase> cases;
+    ScenarioCase c;
+    c.warmStart = false;
+    c.expectWarm = 0;
+    c.subband = false;
+    c.drift = false;
+    c.filter = AECFilterMode::Pbfdaf;
+    c.vss = false;
+    c.proportionate = false;
+    c.history = SpectrumPrecision::Float32;
+    c.weights = SpectrumPrecision::Float32;
+    c.filterLen = 0;
+    c.maxDelayUpdates = -1;
+    c.maxTime20Sec = -1.0f;
+
+    c.sp = defaultScenarioParams("single_talk", 16000, 20.0f);
+    c.minSteadyErleDb = 35.0f; c.maxTime10Sec = 6.0f; c.maxLagSettleSec = 3.0f;
+    cases.push_back(c);
+
+    c.sp = defaultScenarioParams("delay_jump", 16000, 24.0f);
+    c.sp.delayJumpSec = 12.0f; c.sp.delayJumpMs = 70.0f;
+    c.minSteadyErleDb = 20.0f; c.maxTime10Sec = 6.0f; c.maxLagSettleSec = 3.0f;
+    cases.push_back(c);
+
+    c.sp = defaultScenarioParams("double_talk", 16000, 20.0f);
+    c.sp.doubleTalkStartSec = 8.0f; c.sp.doubleTalkEndSec = 13.0f;
+    c.minSteadyErleDb = 18.0f; c.maxTime10Sec = 6.0f; c.maxLagSettleSec = 3.0f;
+    cases.push_back(c);
+
+    c.sp = defaultScenarioParams("noisy", 16000, 20.0f);
+    c.sp.noiseDb = -45.0f;
+    c.minSteadyErleDb = 25.0f; c.maxTime10Sec = 6.0f; c.maxLagSettleSec = 3.0f;
+    cases.push_back(c);
+
+    c.sp = defaultScenarioParams("clock_drift", 16000, 30.0f);
+    c.sp.driftPpm = 60.0f;
+    c.minSteadyErleDb = 2.0f; c.maxTime10Sec = -1.0f; c.maxLagSettleSec = -1.0f; // lag moves by design
+    cases.push_back(c);
+
+    // The same drift over a longer call with compensation: the reference follows the
+    // mic clock, so the filter keeps converging instead of being reset every few seconds
+    c.sp = defaultScenarioParams("drift_locked", 16000, 60.0f);
+    c.sp.driftPpm = 60.0f;
+    c.drift = true;
+    c.minSteadyErleDb = 35.0f; c.maxTime10Sec = 6.0f; c.maxLagSettleSec = 3.0f; c.maxDelayUpdates = 2;
+    cases.push_back(c);
+    c.drift = false;
+    c.maxDelayUpdates = -1;
+
+    c.sp = defaultScenarioParams("fullband_48k", 48000, 12.0f);
+    c.sp.rirLenMs = 60.0f;
+    c.minSteadyErleDb = 12.0f; c.maxTime10Sec = 6.0f; c.maxLagSettleSec = 10.0f;
+    cases.push_back(c);
+
+    // Same room and tail at 48 kHz, canceller on the 16 kHz low band
+    c.sp.name = "subband_48k";
+    c.subband = true;
+    cases.push_back(c);
+    c.subband = false;
+
+    // Headset: short, dry echo path covered by a 16 ms time-domain filter that adds no
+    // block latency
+    c.sp = defaultScenarioParams("headset_nlms", 16000, 20.0f);
+    c.sp.rt60Ms = 20.0f; c.sp.rirLenMs = 12.0f;
+    c.filter = AECFilterMode::Nlms;
+    c.filterLen = 256;
+    c.minSteadyErleDb = 25.0f; c.maxTime10Sec = 3.0f; c.maxLagSettleSec = 3.0f;
+    cases.push_back(c);
+
+    c.sp.name = "headset_block_nlms";
+    c.filter = AECFilterMode::BlockNlms;
+    cases.push_back(c);
+    c.filter = AECFilterMode::Pbfdaf;
+    c.filterLen = 0;
+
+    // Variable step size: the per-bin step rises to 3.5 mu while the error is echo, so
+    // 20 dB comes sooner than with the fixed step, and falls back under double-talk and
+    // noise, where a fixed step that large diverges
+    c.sp = defaultScenarioParams("vss_double_talk", 16000, 20.0f);
+    c.sp.doubleTalkStartSec = 8.0f; c.sp.doubleTalkEndSec = 13.0f;
+    c.vss = true;
+    c.minSteadyErleDb = 18.0f; c.maxTime10Sec = 6.0f; c.maxTime20Sec = 5.5f; c.maxLagSettleSec = 3.0f;
+    cases.push_back(c);
+
+    c.sp = defaultScenarioParams("vss_noisy", 16000, 20.0f);
+    c.sp.noiseDb = -45.0f;
+    cases.push_back(c);
+    c.vss = false;
+
+    // Proportionate update: the direct-path partition takes most of the step, so the
+    // sparse synthetic room reaches 20 dB sooner than with the uniform update (7.5 s)
+    c.sp = defaultScenarioParams("prop_single_talk", 16000, 20.0f);
+    c.proportionate = true;
+    c.minSteadyErleDb = 35.0f; c.maxTime10Sec = 6.0f; c.maxTime20Sec = 6.0f; c.maxLagSettleSec = 3.0f;
+    cases.push_back(c);
+    c.proportionate = false;
+    c.maxTime20Sec = -1.0f;
+
+    // Half-width spectrum storage: a bf16 reference history costs well under 1 dB of
+    // steady ERLE; fp16 (11-bit significand) can hold the weights as well
+    c.sp = defaultScenarioParams("bf16_history", 16000, 20.0f);
+    c.history = SpectrumPrecision::BFloat16;
+    c.minSteadyErleDb = 35.0f; c.maxTime10Sec = 6.0f; c.maxLagSettleSec = 3.0f;
+    cases.push_back(c);
+
+    c.sp = defaultScenarioParams("fp16_weights", 16000, 20.0f);
+    c.history = SpectrumPrecision::Float16;
+    c.weights = SpectrumPrecision::Float16;
+    cases.push_back(c);
+    c.history = SpectrumPrecision::Float32;
+    c.weights = SpectrumPrecision::Float32;
+
+    // Warm starts: the path cached from an earlier call in the same room must cancel
+    // from the first window, and as soon as the lag estimator has found a changed device
+    // latency; a path from another room must be dropped and cost no more than a cold start.
+    c.sp = defaultScenarioParams("warm_start", 16000, 10.0f);
+    c.warmStart = true;
+    c.warmFrom = c.sp;
+    c.minSteadyErleDb = 35.0f; c.maxTime10Sec = 0.25f; c.maxLagSettleSec = 3.0f; c.expectWarm = 2;
+    cases.push_back(c);
+
+    c.sp = defaultScenarioParams("warm_shifted", 16000, 10.0f);
+    c.sp.bulkDelayMs = c.warmFrom.bulkDelayMs + 10.0f;
+    c.minSteadyErleDb = 35.0f; c.maxTime10Sec = 2.0f; c.maxLagSettleSec = 3.0f; c.expectWarm = 2;
+    cases.push_back(c);
+
+    c.sp = defaultScenarioParams("warm_stale", 16000, 20.0f);
+    c.sp.bulkDelayMs = c.warmFrom.bulkDelayMs - 15.0f;
+    c.sp.seed = 5;
+    c.minSteadyErleDb = 35.0f; c.maxTime10Sec = 6.0f; c.maxLagSettleSec = 3.0f; c.expectWarm = -1;
+    cases.push_back(c);
+
+    return cases;
+}
+
+static AECParams harnessParams(const HarnessOptions& o, int sampleRate) {
+    AECParams p = defaultAECParams(sampleRate);
+    p.filterLen = o.filterLen * sampleRate / 16000; // Same tail coverage at every rate
+    p.mu = o.mu;
+    p.maxDelayMs = o.maxDelayMs;
+    p.proportionate = o.proportionate;
+    p.historyPrecision = o.history;
+    p.weightPrecision = o.weights;
+    return p;
+}
+
+// The previous call: converge on the same room with a different far-end talker
+static bool learnEchoPath(const HarnessOptions& o, const ScenarioParams& sp, AECEchoPath& path) {
+    size_t n = (size_t)(sp.durationSec * (float)sp.sampleRate);
+    std::vector<float> farEnd(n);
+    makeSpeechLike(farEnd, sp.sampleRate, -20.0f, sp.seed + 1000u);
+    Scenario sc;
+    if (!generateScenario(sp, farEnd, std::vector<float>(), sc)) return false;
+    AECProcessor aec;
+    aec.initialize(harnessParams(o, sp.sampleRate));
+    size_t frames = o.frames > 0 ? o.frames : (size_t)sp.sampleRate / 100;
+    for (size_t pos = 0; pos < n; pos += frames) {
+        size_t m = std::min(frames, n - pos);
+        aec.process(sc.mic.data() + pos, sc.ref.data() + pos, sc.mic.data() + pos, m);
+    }
+    aec.exportEchoPath(path);
+    return true;
+}
+
+static bool buildScenario(const ScenarioParams& sp, Scenario& sc) {
+    std::vector<float> farEnd((size_t)(sp.durationSec * (float)sp.sampleRate));
+    makeSpeechLike(farEnd, sp.sampleRate, -20.0f, sp.seed);
+    return generateScenario(sp, farEnd, std::vector<float>(), sc);
+}
+
+static ScenarioResult startResult(const HarnessOptions& o, const ScenarioParams& sp) {
+    ScenarioResult r;
+    r.name = sp.name;
+    r.windowSec = o.windowSec;
+    r.pass = true;
+    r.warmStart = 0;
+    r.delayUpdates = 0;
+    return r;
+}
+
+// ERLE, lag settling and the scenario's thresholds for one run's output. r carries the
+// CPU time, lag changes and warm-start state of the run.
+static void evaluate(const HarnessOptions& o, const ScenarioCase& c, const Scenario& sc,
+                     const std::vector<float>& out, int latency, const std::vector<int>& lagTrace,
+                     const std::vector<size_t>& lagPos, ScenarioResult& r) {
+    const ScenarioParams& sp = c.sp;
+    size_t n = sc.mic.size();
+
+    // ERLE against the ground-truth echo: residual = aligned output - near-end
+    size_t win = (size_t)(o.windowSec * (float)sp.sampleRate);
+    r.time10Sec = -1.0f;
+    r.time20Sec = -1.0f;
+    for (size_t w0 = 0; w0 + win + latency <= n; w0 += win) {
+        double echoE = 0.0, resE = 0.0;
+        for (size_t i = w0; i < w0 + win; ++i) {
+            float res = out[i + latency] - sc.nearEnd[i];
+            echoE += (double)sc.echo[i] * sc.echo[i];
+            resE += (double)res * res;
+        }
+        float erle = NAN;
+        if (echoE / (double)win > 1e-7) erle = (float)(10.0 * std::log10((echoE + 1e-12) / (resE + 1e-12)));
+        r.erleDb.push_back(erle);
+        float t = (float)(w0 + win) / (float)sp.sampleRate;
+        if (!std::isnan(erle) && erle >= 10.0f && r.time10Sec < 0.0f) r.time10Sec = t;
+        if (!std::isnan(erle) && erle >= 20.0f && r.time20Sec < 0.0f) r.time20Sec = t;
+    }
+    double steady = 0.0;
+    int cnt = 0;
+    for (size_t k = r.erleDb.size() * 3 / 4; k < r.erleDb.size(); ++k) {
+        if (!std::isnan(r.erleDb[k])) { steady += r.erleDb[k]; cnt++; }
+    }
+    r.steadyErleDb = cnt > 0 ? (float)(steady / cnt) : 0.0f;
+
+    // Lag settling: last time the estimate was off by more than 2 ms, counted from the jump
+    float tolSamples = 0.002f * (float)sp.sampleRate;
+    size_t from = sp.delayJumpSec > 0.0f ? (size_t)(sp.delayJumpSec * (float)sp.sampleRate) : 0;
+    size_t lastBad = from;
+    bool everGood = false;
+    for (size_t k = 0; k < lagTrace.size(); ++k) {
+        size_t p = lagPos[k];
+        if (p < from) continue;
+        float truth = sc.trueDelayMs[p - 1] * 0.001f * (float)sp.sampleRate;
+        if (std::fabs((float)lagTrace[k] - truth) > tolSamples) lastBad = p;
+        else everGood = true;
+    }
+    r.lagSettleSec = (everGood && lastBad < n) ? (float)(lastBad - from) / (float)sp.sampleRate : -1.0f;
+    r.finalLagErrMs = lagTrace.empty() ? 0.0f :
+        (float)lagTrace.back() * 1000.0f / (float)sp.sampleRate - sc.trueDelayMs[n - 1];
+
+    // Thresholds
+    double rtf = r.cpuSec / r.audioSec;
+    char buf[128];
+    if (r.steadyErleDb < c.minSteadyErleDb) {
+        snprintf(buf, sizeof(buf), "steady ERLE %.1f < %.1f dB; ", r.steadyErleDb, c.minSteadyErleDb);
+        r.pass = false; r.why += buf;
+    }
+    if (c.maxTime10Sec >= 0.0f && (r.time10Sec < 0.0f || r.time10Sec > c.maxTime10Sec)) {
+        snprintf(buf, sizeof(buf), "10 dB at %.2f s > %.2f s; ", r.time10Sec, c.maxTime10Sec);
+        r.pass = false; r.why += buf;
+    }
+    if (c.maxTime20Sec >= 0.0f && (r.time20Sec < 0.0f || r.time20Sec > c.maxTime20Sec)) {
+        snprintf(buf, sizeof(buf), "20 dB at %.2f s > %.2f s; ", r.time20Sec, c.maxTime20Sec);
+        r.pass = false; r.why += buf;
+    }
+    if (c.maxLagSettleSec >= 0.0f && (r.lagSettleSec < 0.0f || r.lagSettleSec > c.maxLagSettleSec)) {
+        snprintf(buf, sizeof(buf), "lag settle %.2f s > %.2f s; ", r.lagSettleSec, c.maxLagSettleSec);
+        r.pass = false; r.why += buf;
+    }
+    if (c.maxDelayUpdates >= 0 && r.delayUpdates > c.maxDelayUpdates) {
+        snprintf(buf, sizeof(buf), "%d lag changes > %d; ", r.delayUpdates, c.maxDelayUpdates);
+        r.pass = false; r.why += buf;
+    }
+    if (c.warmStart && r.warmStart != c.expectWarm) {
+        snprintf(buf, sizeof(buf), "warm start state %d != %d; ", r.warmStart, c.expectWarm);
+        r.pass = false; r.why += buf;
+    }
+    if (o.maxRtf > 0.0f && rtf > o.maxRtf) {
+        snprintf(buf, sizeof(buf), "RTF %.3f > %.3f; ", rtf, o.maxRtf);
+        r.pass = false; r.why += buf;
+    }
+}
+
+static ScenarioResult runCase(const HarnessOptions& o, const ScenarioCase& c) {
+    const ScenarioParams& sp = c.sp;
+    ScenarioResult r = startResult(o, sp);
+
+    size_t n = (size_t)(sp.durationSec * (float)sp.sampleRate);
+    Scenario sc;
+    if (!buildScenario(sp, sc)) {
+        r.pass = false;
+        r.why = "generator failed";
+        return r;
+    }
+
+    AECProcessor aec;
+    aec.setSubband(c.subband);
+    aec.setDriftCompensation(c.drift || o.drift);
+    aec.setFilterMode(c.filter);
+    aec.setVariableStepSize(c.vss || o.vss);
+    AECParams params = harnessParams(o, sp.sampleRate);
+    if (c.filterLen > 0) params.filterLen = c.filterLen * sp.sampleRate / 16000;
+    params.proportionate = params.proportionate || c.proportionate;
+    if (c.history != SpectrumPrecision::Float32) params.historyPrecision = c.history;
+    if (c.weights != SpectrumPrecision::Float32) params.weightPrecision = c.weights;
+    aec.initialize(params);
+    if (c.warmStart) {
+        AECEchoPath path;
+        if (!learnEchoPath(o, c.warmFrom, path) || !aec.importEchoPath(path)) {
+            r.pass = false;
+            r.why = "warm start path not accepted";
+            return r;
+        }
+    }
+    int latency = aec.getLatency();
+
+    size_t frames = o.frames > 0 ? o.frames : (size_t)sp.sampleRate / 100;
+    std::vector<float> out(n, 0.0f);
+    std::vector<int> lagTrace;   // currentLag after each call
+    std::vector<size_t> lagPos;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t pos = 0; pos < n; pos += frames) {
+        size_t m = std::min(frames, n - pos);
+        aec.process(sc.mic.data() + pos, sc.ref.data() + pos, out.data() + pos, m);
+        lagTrace.push_back(aec.getStats().currentLag);
+        lagPos.push_back(pos + m);
+    }
+    r.cpuSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    r.audioSec = (double)n / (double)sp.sampleRate;
+    r.delayUpdates = aec.getStats().delayUpdateCount;
+    r.warmStart = aec.getStats().warmStart;
+    evaluate(o, c, sc, out, latency, lagTrace, lagPos, r);
+    return r;
+}
+
+static void printResult(const HarnessOptions& o, const ScenarioResult& r) {
+    printf("%-14s steady %6.1f dB  t10 %6.2f s  t20 %6.2f s  lag settle %6.2f s (err %+5.1f ms, %3d changes)  cpu %6.3f s  RTF %.4f  %s\n",
+           r.name.c_str(), r.steadyErleDb, r.time10Sec, r.time20Sec, r.lagSettleSec, r.finalLagErrMs,
+           r.delayUpdates, r.cpuSec, r.cpuSec / r.audioSec, r.pass ? "PASS" : "FAIL");
+    if (!r.pass) printf("    -> %s\n", r.why.c_str());
+    if (o.trace) {
+        printf("    ERLE(t):");
+        for (size_t k = 0; k < r.erleDb.size(); ++k) {
+            if (k % 10 == 0) printf("\n    %6.2f s:", (float)k * r.windowSec);
+            if (std::isnan(r.erleDb[k])) printf("     -");
+            else printf(" %5.1f", r.erleDb[k]);
+        }
+        printf("\n");
+    }
+    fflush(stdout);
+}
+
+// Lockstep mode: AECLockstep lane vs AECProcessor on the same scenario. The lanes share
+// a block phase, so a lag change does not restart a lane's block and the outputs are
+// not bit-identical. Measured over caller frames 64 .. 1000: steady ERLE within 1.9 dB
+// (double talk), identical lags and lag changes, lag settling within 0.01 s.
+static const float kLockstepErleTolDb = 2.5f;
+static const float kLockstepLagTolMs = 0.5f;     // Final lag
+static const float kLockstepSettleTolSec = 0.25f;
+
+// Scenarios AECLockstep can run: the plain PBFDAF canceller at the default length
+static bool lockstepCase(const HarnessOptions& o, const ScenarioCase& c) {
+    return c.filter == AECFilterMode::Pbfdaf && !c.subband && !c.drift && !c.vss && !c.proportionate &&
+           !c.warmStart && c.history == SpectrumPrecision::Float32 && c.weights == SpectrumPrecision::Float32 &&
+           c.filterLen == 0 && (o.only.empty() || c.sp.name == o.only);
+}
+
+// The scenarios of each sample rate fill the lanes of one engine; lanes past the
+// scenario count repeat them in other rooms with other talkers (another seed). A lane
+// fails on its scenario's thresholds or when it strays from AECProcessor beyond the
+// tolerances above.
+static bool runLockstep(const HarnessOptions& o, const std::vector<ScenarioCase>& cases,
+                        std::vector<ScenarioResult>& results) {
+    const size_t L = AECLockstep::kLanes;
+    std::vector<int> rates;
+    for (const auto& c : cases) {
+        if (lockstepCase(o, c) && std::find(rates.begin(), rates.end(), c.sp.sampleRate) == rates.end()) {
+            rates.push_back(c.sp.sampleRate);
+        }
+    }
+    bool allPass = true;
+    for (int rate : rates) {
+        std::vector<ScenarioCase> group;
+        for (const auto& c : cases) if (lockstepCase(o, c) && c.sp.sampleRate == rate) group.push_back(c);
+        std::vector<ScenarioCase> lanes;
+        for (size_t l = 0; l < L; ++l) {
+            ScenarioCase lc = group[l % group.size()];
+            if (l >= group.size()) {
+                // The thresholds are tuned to the scenario's own room: a repeat is only
+                // checked against AECProcessor
+                lc.sp.seed += (uint32_t)(l / group.size()) * 100u;
+                lc.sp.name += "_seed" + std::to_string(lc.sp.seed);
+                lc.minSteadyErleDb = -INFINITY;
+                lc.maxTime10Sec = -1.0f;
+                lc.maxTime20Sec = -1.0f;
+                lc.maxLagSettleSec = -1.0f;
+                lc.maxDelayUpdates = -1;
+            }
+            lanes.push_back(lc);
+        }
+
+        std::vector<Scenario> sc(L);
+        size_t longest = 0;
+        for (size_t l = 0; l < L; ++l) {
+            if (!buildScenario(lanes[l].sp, sc[l])) {
+                fprintf(stderr, "Scenario generation failed: %s\n", lanes[l].sp.name.c_str());
+                return false;
+            }
+            longest = std::max(longest, sc[l].mic.size());
+        }
+        // Lanes advance together: shorter scenarios are fed silence up to the call that
+        // ends them, then idle
+        std::vector<std::vector<float>> micIn(L), refIn(L);
+        for (size_t l = 0; l < L; ++l) {
+            micIn[l] = sc[l].mic;
+            refIn[l] = sc[l].ref;
+            micIn[l].resize(longest, 0.0f);
+            refIn[l].resize(longest, 0.0f);
+        }
+
+        AECLockstep eng;
+        eng.initialize(harnessParams(o, rate));
+        int latency = eng.getLatency();
+        size_t frames = o.frames > 0 ? o.frames : (size_t)rate / 100;
+        std::vector<std::vector<float>> out(L, std::vector<float>(longest, 0.0f));
+        std::vector<std::vector<int>> lagTrace(L);
+        std::vector<std::vector<size_t>> lagPos(L);
+        std::vector<const float*> mic(L), ref(L);
+        std::vector<float*> outp(L);
+
+        auto t0 = std::chrono::steady_clock::now();
+        for (size_t pos = 0; pos < longest; pos += frames) {
+            size_t m = std::min(frames, longest - pos);
+            for (size_t l = 0; l < L; ++l) {
+                bool live = pos < sc[l].mic.size();
+                mic[l] = live ? micIn[l].data() + pos : nullptr;
+                ref[l] = live ? refIn[l].data() + pos : nullptr;
+                outp[l] = out[l].data() + pos;
+            }
+            eng.process(mic.data(), ref.data(), outp.data(), m);
+            for (size_t l = 0; l < L; ++l) {
+                if (!mic[l]) continue;
+                lagTrace[l].push_back(eng.getStats(l).currentLag);
+                lagPos[l].push_back(std::min(pos + m, sc[l].mic.size()));
+            }
+        }
+        double cpuSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        for (size_t l = 0; l < L; ++l) {
+            const ScenarioCase& c = lanes[l];
+            ScenarioResult r = startResult(o, c.sp);
+            r.name = "lockstep/" + c.sp.name;
+            r.audioSec = (double)sc[l].mic.size() / (double)rate;
+            r.cpuSec = cpuSec / (double)L; // The engine's time, shared by its lanes
+            r.delayUpdates = eng.getStats(l).delayUpdateCount;
+            evaluate(o, c, sc[l], out[l], latency, lagTrace[l], lagPos[l], r);
+
+            ScenarioResult base = runCase(o, c);
+            float erleDiff = r.steadyErleDb - base.steadyErleDb;
+            float lagDiff = r.finalLagErrMs - base.finalLagErrMs;
+            float settleDiff = r.lagSettleSec - base.lagSettleSec;
+            char buf[128];
+            if (std::fabs(erleDiff) > kLockstepErleTolDb) {
+                snprintf(buf, sizeof(buf), "steady ERLE %+.2f dB from AECProcessor (> %.1f); ", erleDiff, kLockstepErleTolDb);
+                r.pass = false; r.why += buf;
+            }
+            if (std::fabs(lagDiff) > kLockstepLagTolMs) {
+                snprintf(buf, sizeof(buf), "final lag %+.2f ms from AECProcessor (> %.1f); ", lagDiff, kLockstepLagTolMs);
+                r.pass = false; r.why += buf;
+            }
+            if ((r.lagSettleSec < 0.0f) != (base.lagSettleSec < 0.0f) || std::fabs(settleDiff) > kLockstepSettleTolSec) {
+                snprintf(buf, sizeof(buf), "lag settle %.2f s, AECProcessor %.2f s; ", r.lagSettleSec, base.lagSettleSec);
+                r.pass = false; r.why += buf;
+            }
+            if (r.delayUpdates != base.delayUpdates) {
+                snprintf(buf, sizeof(buf), "%d lag changes, AECProcessor %d; ", r.delayUpdates, base.delayUpdates);
+                r.pass = false; r.why += buf;
+            }
+            printResult(o, r);
+            printf("    vs AECProcessor: steady %+5.2f dB, final lag %+5.2f ms, lag settle %+5.2f s, lag changes %d/%d\n",
+                   erleDiff, lagDiff, settleDiff, r.delayUpdates, base.delayUpdates);
+            allPass = allPass && r.pass;
+            results.push_back(r);
+        }
+    }
+    return allPass;
+}
+
+static bool writeJson(const std::string& path, const std::vector<ScenarioResult>& res) {
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) return false;
+    fprintf(f, "{\n  \"scenarios\": [\n");
+    for (size_t i = 0; i < res.size(); ++i) {
+        const ScenarioResult& r = res[i];
+        fprintf(f, "    {\"name\": \"%s\", \"pass\": %s, \"steadyErleDb\": %.2f, \"time10Sec\": %.3f, \"time20Sec\": %.3f, "
+                   "\"lagSettleSec\": %.3f, \"finalLagErrMs\": %.2f, \"delayUpdates\": %d, \"cpuSec\": %.4f, "
+                   "\"audioSec\": %.2f, \"rtf\": %.5f, \"windowSec\": %.3f, \"erleDb\": [",
+                r.name.c_str(), r.pass ? "true" : "false", r.steadyErleDb, r.time10Sec, r.time20Sec,
+                r.lagSettleSec, r.finalLagErrMs, r.delayUpdates, r.cpuSec, r.audioSec, r.cpuSec / r.audioSec, r.windowSec);
+        for (size_t k = 0; k < r.erleDb.size(); ++k) {
+            if (std::isnan(r.erleDb[k])) fprintf(f, "%snull", k ? ", " : "");
+            else fprintf(f, "%s%.2f", k ? ", " : "", r.erleDb[k]);
+        }
+        fprintf(f, "]}%s\n", i + 1 < res.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+    return true;
+}
+
+static void usage() {
+    fprintf(stderr,
+        "Usage: aec_harness [--scenario name] [--frames n] [--filter taps@16k] [--mu v] [--maxdelay ms]\n"
+        "                   [--max-rtf v] [--window sec] [--trace] [--drift] [--vss] [--prop] [--json out.json]\n"
+        "                   [--history f32|fp16|bf16] [--weights f32|fp16|bf16] [--lockstep] [--list]\n");
+}
+
+int main(int argc, char** argv) {
+    HarnessOptions o;
+    o.frames = 0;
+    o.filterLen = 2048;
+    o.mu = 0.1f;
+    o.maxDelayMs = 80;
+    o.maxRtf = 0.5f;
+    o.windowSec = 0.25f;
+    o.trace = false;
+    o.drift = false;
+    o.vss = false;
+    o.proportionate = false;
+    o.history = SpectrumPrecision::Float32;
+    o.weights = SpectrumPrecision::Float32;
+    o.lockstep = false;
+    std::vector<ScenarioCase> cases = defaultCases();
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "--scenario" && i + 1 < argc) {
+            o.only = argv[++i];
+        } else if (a == "--frames" && i + 1 < argc) {
+            o.frames = (size_t)atoi(argv[++i]);
+        } else if (a == "--filter" && i + 1 < argc) {
+            o.filterLen = atoi(argv[++i]);
+        } else if (a == "--mu" && i + 1 < argc) {
+            o.mu = (float)atof(argv[++i]);
+        } else if (a == "--maxdelay" && i + 1 < argc) {
+            o.maxDelayMs = atoi(argv[++i]);
+        } else if (a == "--max-rtf" && i + 1 < argc) {
+            o.maxRtf = (float)atof(argv[++i]);
+        } else if (a == "--window" && i + 1 < argc) {
+            o.windowSec = (float)atof(argv[++i]);
+        } else if (a == "--trace") {
+            o.trace = true;
+        } else if (a == "--drift") {
+            o.drift = true;
+        } else if (a == "--vss") {
+            o.vss = true;
+        } else if (a == "--prop") {
+            o.proportionate = true;
+        } else if (a == "--history" && i + 1 < argc) {
+            if (!parseSpectrumPrecision(argv[++i], o.history)) { usage(); return 1; }
+        } else if (a == "--weights" && i + 1 < argc) {
+            if (!parseSpectrumPrecision(argv[++i], o.weights)) { usage(); return 1; }
+        } else if (a == "--lockstep") {
+            o.lockstep = true;
+        } else if (a == "--json" && i + 1 < argc) {
+            o.jsonPath = argv[++i];
+        } else if (a == "--list") {
+            for (const auto& c : cases) printf("%s\n", c.sp.name.c_str());
+            return 0;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (o.filterLen <= 0 || o.windowSec <= 0.0f) {
+        usage();
+        return 1;
+    }
+
+    // AECLockstep has none of the per-run canceller options
+    bool plain = !o.drift && !o.vss && !o.proportionate &&
+                 o.history == SpectrumPrecision::Float32 && o.weights == SpectrumPrecision::Float32;
+    if (o.lockstep && !plain) {
+        usage();
+        return 1;
+    }
+
+    std::vector<ScenarioResult> results;
+    bool allPass = true;
+    if (o.lockstep) {
+        allPass = runLockstep(o, cases, results);
+    } else {
+        for (const auto& c : cases) {
+            if (!o.only.empty() && c.sp.name != o.only) continue;
+            ScenarioResult r = runCase(o, c);
+            printResult(o, r);
+            allPass = allPass && r.pass;
+            results.push_back(r);
+        }
+    }
+    if (results.empty()) {
+        fprintf(stderr, "No %sscenario named %s\n", o.lockstep ? "lockstep " : "", o.only.c_str());
+        return 1;
+    }
+    if (!o.jsonPath.empty() && !writeJson(o.jsonPath, results)) {
+        fprintf(stderr, "JSON write error: %s\n", o.jsonPath.c_str());
+        return 2;
+    }
+    return allPass ? 0 : 3;
+}
@@ -0,0 +1,78 @@
+#include "LoadGen.h"
+#include <algorithm>
+#include <thread>
+
+static const double kBucketUs = 10.0;
+static const size_t kBuckets = 20000;
+
+typedef std::chrono::steady_clock Clock;
+
+uint64_t loadClockNs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+LatencyHistogram::LatencyHistogram() : buckets(kBuckets), total(0), maxNs(0) {}
+
+void LatencyHistogram::record(uint64_t latNs) {
+    size_t b = std::min(kBuckets - 1, (size_t)((double)latNs / (kBucketUs * 1000.0)));
+    buckets[b].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+    uint64_t m = maxNs.load(std::memory_order_relaxed);
+    while (latNs > m && !maxNs.compare_exchange_weak(m, latNs, std::memory_order_relaxed)) {}
+}
+
+double LatencyHistogram::percentileUs(double q) const {
+    uint64_t target = (uint64_t)((double)count() * q);
+    uint64_t acc = 0;
+    for (size_t b = 0; b < buckets.size(); ++b) {
+        acc += buckets[b].load(std::memory_order_relaxed);
+        if (acc > target) return (double)(b + 1) * kBucketUs;
+    }
+    return (double)buckets.size() * kBucketUs;
+}
+
+bool ScenarioFeed::init(const std::string& name, int sampleRate, size_t blockFrames, size_t sessions) {
+    const float lenSec = 20.0f;
+    ScenarioParams sp = defaultScenarioParams(name, sampleRate, lenSec);
+    std::vector<float> farEnd((size_t)(lenSec * (float)sampleRate));
+    makeSpeechLike(farEnd, sampleRate, -20.0f, sp.seed);
+    if (blockFrames == 0 || !generateScenario(sp, farEnd, std::vector<float>(), sc)) return false;
+    frames = blockFrames;
+    loopBlocks = sc.mic.size() / blockFrames;
+    if (loopBlocks == 0) return false;
+    pos.resize(sessions);
+    for (size_t k = 0; k < sessions; ++k) pos[k] = (k * 7919) % loopBlocks;
+    return true;
+}
+
+FeedResult runFeed(ScenarioFeed& feed, double seconds, bool flood, std::chrono::microseconds period,
+                   const FeedSubmit& submit) {
+    FeedResult r;
+    auto submitOne = [&](size_t k) {
+        if (submit(k, feed.mic(k), feed.ref(k))) {
+            feed.advance(k);
+            ++r.submitted;
+            return true;
+        }
+        ++r.refused;
+        return false;
+    };
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point end = start + std::chrono::microseconds((int64_t)(seconds * 1e6));
+    if (flood) {
+        while (Clock::now() < end) {
+            bool any = false;
+            for (size_t k = 0; k < feed.sessions(); ++k) any = submitOne(k) || any;
+            if (!any) std::this_thread::yield();
+        }
+    } else {
+        Clock::time_point tick = start;
+        while (tick < end) {
+            for (size_t k = 0; k < feed.sessions(); ++k) submitOne(k);
+            tick += period;
+            if (Clock::now() > tick) ++r.lateTicks;
+            std::this_thread::sleep_until(tick);
+        }
+    }
+    return r;
+}
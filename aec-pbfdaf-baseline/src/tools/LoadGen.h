@@ -0,0 +1,61 @@
+#pragma once
+// Shared parts of the multi-session load generators (aec_pool, aec_daemon_load): a
+// latency histogram, one looped echo scenario feeding every session, and the paced
+// (or flood) submit loop.
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "ScenarioGen.h"
+
+// Steady clock in ns; blocks are tagged with their submit time
+uint64_t loadClockNs();
+
+// Submit-to-completion latency: 10 us buckets up to 200 ms, the last one open-ended.
+// record() may be called from several threads.
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+    void record(uint64_t latNs);
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    double percentileUs(double q) const;
+    double maxUs() const { return (double)maxNs.load(std::memory_order_relaxed) / 1000.0; }
+
+private:
+    std::vector<std::atomic<uint64_t>> buckets;
+    std::atomic<uint64_t> total;
+    std::atomic<uint64_t> maxNs;
+};
+
+// One 20 s scenario shared by all sessions and looped; each session reads from its
+// own offset
+class ScenarioFeed {
+public:
+    bool init(const std::string& name, int sampleRate, size_t blockFrames, size_t sessions);
+    const float* mic(size_t k) const { return sc.mic.data() + pos[k] * frames; }
+    const float* ref(size_t k) const { return sc.ref.data() + pos[k] * frames; }
+    void advance(size_t k) { pos[k] = (pos[k] + 1) % loopBlocks; }
+    size_t sessions() const { return pos.size(); }
+
+private:
+    Scenario sc;
+    size_t frames = 0;
+    size_t loopBlocks = 0;
+    std::vector<size_t> pos;  // Next block per session
+};
+
+struct FeedResult {
+    uint64_t submitted = 0;
+    uint64_t refused = 0;     // submit() returned false (queue or ring full)
+    uint64_t lateTicks = 0;   // Paced: periods the feeder overran
+};
+
+// Offers every session its next block once per period for the given time, or with
+// flood as fast as submit() accepts them. A refused block is offered again next time.
+typedef std::function<bool(size_t k, const float* mic, const float* ref)> FeedSubmit;
+FeedResult runFeed(ScenarioFeed& feed, double seconds, bool flood, std::chrono::microseconds period,
+                   const FeedSubmit& submit);
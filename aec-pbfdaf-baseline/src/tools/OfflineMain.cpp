@@ -0,0 +1,187 @@
+// aec_offline: portable streaming file processor.
+//   aec_offline [options] mic.wav ref.wav out.wav
+//   aec_offline [options] --segments n mic.wav ref.wav out.wav   (segment-parallel, long files)
+//   aec_offline [options] --raw --sr 16000 [--f32] < mic_ref_interleaved.pcm > out.pcm
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+#include "OfflineProcess.h"
+#include "SegmentParallel.h"
+#include "../aec_core/EchoPathCache.h"
+#include "../audio_io/WavFile.h"
+#include "../audio_io/MappedWavReader.h"
+
+// Paths that did not reach this average ERLE are not worth starting from
+static const float kCacheMinErleDb = 10.0f;
+
+static int wavSampleRate(const std::string& path) {
+    MappedWavReader m;
+    if (m.open(path)) return m.info().sampleRate;
+    WavFileReader r;
+    return r.open(path) ? r.info().sampleRate : 0;
+}
+
+static void usage() {
+    fprintf(stderr,
+        "Usage: aec_offline [options] mic.wav ref.wav out.wav\n"
+        "       aec_offline [options] --raw --sr <rate> [--f32]  (stdin: interleaved mic/ref, stdout: mono)\n"
+        "Options: --chunk frames  --filter taps  --mu v  --eps v  --maxdelay ms  --alpha v  --beta v\n"
+        "         --res (residual echo suppression)  --enhance  --fused (enhance on the canceller's spectrum)\n"
+        "         --subband (32/48 kHz: cancel on 0-8 kHz)  --drift (clock-drift compensation)  --no-align  --quiet\n"
+        "         --nlms | --block-nlms (time-domain filter, no block latency; for short echo paths)\n"
+        "         --vss (per-bin variable step size, mu up to min(4 mu, 0.35))  --prop (proportionate update)\n"
+        "         --history f32|fp16|bf16  --weights f32|fp16|bf16 (PBFDAF spectrum storage)\n"
+        "Warm start: --warm-cache dir  --device-key id  (echo path cached per device key, rate and filter layout)\n"
+        "Segment-parallel (WAV only): --segments n (0 = one per thread)  --threads n  --leadin sec  --leadin-mu scale  --crossfade sec\n");
+}
+
+int main(int argc, char** argv) {
+    OfflineConfig cfg = defaultOfflineConfig(16000);
+    SegmentConfig seg = defaultSegmentConfig();
+    bool raw = false, f32 = false, quiet = false, segmented = false;
+    int sr = 0;
+    std::string cacheDir, deviceKey = "offline";
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "--raw") {
+            raw = true;
+        } else if (a == "--f32") {
+            f32 = true;
+        } else if (a == "--sr" && i + 1 < argc) {
+            sr = atoi(argv[++i]);
+        } else if (a == "--chunk" && i + 1 < argc) {
+            cfg.chunkFrames = (size_t)atoi(argv[++i]);
+        } else if (a == "--filter" && i + 1 < argc) {
+            cfg.aec.filterLen = atoi(argv[++i]);
+        } else if (a == "--mu" && i + 1 < argc) {
+            cfg.aec.mu = (float)atof(argv[++i]);
+        } else if (a == "--eps" && i + 1 < argc) {
+            cfg.aec.epsilon = (float)atof(argv[++i]);
+        } else if (a == "--maxdelay" && i + 1 < argc) {
+            cfg.aec.maxDelayMs = atoi(argv[++i]);
+        } else if (a == "--alpha" && i + 1 < argc) {
+            cfg.aec.dtdAlpha = (float)atof(argv[++i]);
+        } else if (a == "--beta" && i + 1 < argc) {
+            cfg.aec.dtdBeta = (float)atof(argv[++i]);
+        } else if (a == "--segments" && i + 1 < argc) {
+            seg.segments = atoi(argv[++i]);
+            segmented = true;
+        } else if (a == "--threads" && i + 1 < argc) {
+            seg.threads = atoi(argv[++i]);
+            segmented = true;
+        } else if (a == "--leadin" && i + 1 < argc) {
+            seg.leadInSec = (float)atof(argv[++i]);
+        } else if (a == "--leadin-mu" && i + 1 < argc) {
+            seg.leadInMuScale = (float)atof(argv[++i]);
+        } else if (a == "--crossfade" && i + 1 < argc) {
+            seg.crossfadeSec = (float)atof(argv[++i]);
+        } else if (a == "--warm-cache" && i + 1 < argc) {
+            cacheDir = argv[++i];
+        } else if (a == "--device-key" && i + 1 < argc) {
+            deviceKey = argv[++i];
+        } else if (a == "--enhance") {
+            cfg.enhance = true;
+        } else if (a == "--res") {
+            cfg.residualEcho = true;
+        } else if (a == "--subband") {
+            cfg.subband = true;
+        } else if (a == "--drift") {
+            cfg.drift = true;
+        } else if (a == "--nlms") {
+            cfg.filter = AECFilterMode::Nlms;
+        } else if (a == "--block-nlms") {
+            cfg.filter = AECFilterMode::BlockNlms;
+        } else if (a == "--vss") {
+            cfg.vss = true;
+        } else if (a == "--prop") {
+            cfg.aec.proportionate = true;
+        } else if (a == "--history" && i + 1 < argc) {
+            if (!parseSpectrumPrecision(argv[++i], cfg.aec.historyPrecision)) { usage(); return 1; }
+        } else if (a == "--weights" && i + 1 < argc) {
+            if (!parseSpectrumPrecision(argv[++i], cfg.aec.weightPrecision)) { usage(); return 1; }
+        } else if (a == "--fused") {
+            cfg.enhance = true;
+            cfg.fused = true;
+        } else if (a == "--no-align") {
+            cfg.alignOutput = false;
+        } else if (a == "--quiet") {
+            quiet = true;
+        } else if (!a.empty() && a[0] == '-' && a != "-") {
+            usage();
+            return 1;
+        } else {
+            files.push_back(a);
+        }
+    }
+    if (cfg.chunkFrames == 0 || cfg.aec.filterLen <= 0) {
+        usage();
+        return 1;
+    }
+
+    // The cache key needs the stream rate, so WAV headers are probed up front
+    EchoPathCache cache(cacheDir);
+    AECEchoPath warm;
+    uint64_t cacheKey = 0;
+    if (!cacheDir.empty()) {
+        AECParams keyParams = cfg.aec;
+        keyParams.sampleRate = raw ? sr : (files.empty() ? 0 : wavSampleRate(files[0]));
+        cacheKey = EchoPathCache::fingerprint(deviceKey, deviceKey, keyParams);
+        if (keyParams.sampleRate > 0 && cache.load(cacheKey, warm)) cfg.warmStart = &warm;
+    }
+
+    OfflineResult res;
+    std::string err;
+    if (raw) {
+        if (sr <= 0 || !files.empty()) {
+            usage();
+            return 1;
+        }
+#ifdef _WIN32
+        _setmode(_fileno(stdin), _O_BINARY);
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        cfg.aec.sampleRate = sr;
+        if (!processRawPipe(cfg, stdin, stdout, f32, res, err)) {
+            fprintf(stderr, "%s\n", err.c_str());
+            return 5;
+        }
+    } else {
+        if (files.size() != 3) {
+            usage();
+            return 1;
+        }
+        bool ok = segmented ? processWavPairSegmented(cfg, seg, files[0], files[1], files[2], res, err)
+                            : processWavPair(cfg, files[0], files[1], files[2], res, err);
+        if (!ok) {
+            fprintf(stderr, "%s\n", err.c_str());
+            return 2;
+        }
+    }
+
+    bool stored = false;
+    if (!cacheDir.empty() && res.echoPath.erleDb >= kCacheMinErleDb) {
+        stored = cache.store(cacheKey, res.echoPath);
+        if (!stored) fprintf(stderr, "Warning: could not write %s\n", cache.entryPath(cacheKey).c_str());
+    }
+
+    if (!quiet) {
+        double x = res.wallSec > 0.0 ? res.audioSec / res.wallSec : 0.0;
+        fprintf(stderr, "Processed %.1f s of audio in %.2f s (%.1fx real-time)\n", res.audioSec, res.wallSec, x);
+        fprintf(stderr, "Avg ERLE: %.2f dB, Max ERLE: %.2f dB, Convergence: %.0f ms, Delay updates: %d\n",
+                res.stats.avgErle, res.stats.maxErle, res.stats.convergedTimeMs, res.stats.delayUpdateCount);
+        fprintf(stderr, "AEC load: RTF %.4f, p99 %.1f us, max %.1f us per %zu-frame call\n",
+                res.load.rtf, res.load.p99Us, res.load.maxUs, cfg.chunkFrames);
+        if (!cacheDir.empty()) {
+            static const char* const kWarm[] = { "rejected", "none", "probing", "confirmed" };
+            fprintf(stderr, "Warm start: %s, cache %s\n", kWarm[res.stats.warmStart + 1],
+                    stored ? "updated" : "unchanged");
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,176 @@
+#include "OfflineProcess.h"
+#include "../audio_io/WavFile.h"
+#include "../audio_io/MappedWavReader.h"
+#include "../audio_io/SampleConvert.h"
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+OfflineConfig defaultOfflineConfig(int sampleRate) {
+    OfflineConfig c;
+    c.aec = defaultAECParams(sampleRate);
+    c.aec.mu = 0.2f;
+    c.enhance = false;
+    c.fused = false;
+    c.residualEcho = false;
+    c.subband = false;
+    c.drift = false;
+    c.filter = AECFilterMode::Pbfdaf;
+    c.vss = false;
+    c.chunkFrames = 4096;
+    c.alignOutput = true;
+    c.warmStart = nullptr;
+    return c;
+}
+
+PipelineMode offlinePipelineMode(const OfflineConfig& cfg) {
+    if (!cfg.enhance) return PipelineMode::AecOnly;
+    return cfg.fused ? PipelineMode::Fused : PipelineMode::Cascade;
+}
+
+bool runOfflineStream(const OfflineConfig& cfg, const StreamSource& src, const StreamSink& sink,
+                      OfflineResult& res) {
+    auto t0 = std::chrono::steady_clock::now();
+    size_t chunk = cfg.chunkFrames > 0 ? cfg.chunkFrames : 4096;
+
+    AECPipeline pipe;
+    pipe.aec().setSubband(cfg.subband);
+    pipe.aec().setDriftCompensation(cfg.drift);
+    pipe.aec().setFilterMode(cfg.filter);
+    pipe.aec().setVariableStepSize(cfg.vss);
+    if (cfg.warmStart) pipe.initialize(cfg.aec, offlinePipelineMode(cfg), *cfg.warmStart);
+    else pipe.initialize(cfg.aec, offlinePipelineMode(cfg));
+    pipe.aec().setResidualSuppression(cfg.residualEcho);
+
+    std::vector<float> mic(chunk), ref(chunk), out(chunk);
+    size_t skip = cfg.alignOutput ? (size_t)pipe.getLatency() : 0;
+    size_t flush = skip;
+    uint64_t total = 0;
+    bool ok = true;
+
+    while (ok) {
+        size_t n = src(mic.data(), ref.data(), chunk);
+        if (n == 0) {
+            // Push the pipeline latency out with silence so every input sample has an output
+            if (flush == 0) break;
+            n = std::min(flush, chunk);
+            std::fill(mic.begin(), mic.begin() + n, 0.0f);
+            std::fill(ref.begin(), ref.begin() + n, 0.0f);
+            flush -= n;
+        } else {
+            total += n;
+        }
+        pipe.process(mic.data(), ref.data(), out.data(), n);
+        size_t drop = std::min(skip, n);
+        skip -= drop;
+        if (n > drop) ok = sink(out.data() + drop, n - drop);
+    }
+
+    res.frames = total;
+    res.audioSec = (double)total / (double)cfg.aec.sampleRate;
+    res.wallSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    res.stats = pipe.aec().getStats();
+    res.load = pipe.aec().getLoadStats();
+    pipe.aec().exportEchoPath(res.echoPath);
+    return ok;
+}
+
+// Memory-mapped when possible; buffered reads for pipes and files that cannot be mapped
+struct WavInput {
+    MappedWavReader mapped;
+    WavFileReader streamed;
+    bool isMapped = false;
+
+    bool open(const std::string& path) {
+        isMapped = mapped.open(path);
+        return isMapped || streamed.open(path);
+    }
+    const WavInfo& info() const { return isMapped ? mapped.info() : streamed.info(); }
+    size_t readMono(float* dst, size_t frames) {
+        return isMapped ? mapped.readMono(dst, frames) : streamed.readMono(dst, frames);
+    }
+};
+
+// Opens both inputs and runs the canceller; 'begin' is called with the file rate before any output
+static bool runWavInputs(const OfflineConfig& cfgIn, const std::string& micPath, const std::string& refPath,
+                         const std::function<bool(int sampleRate)>& begin, const StreamSink& sink,
+                         OfflineResult& res, std::string& err) {
+    WavInput micR, refR;
+    if (!micR.open(micPath)) { err = "Mic read error: " + micPath; return false; }
+    if (!refR.open(refPath)) { err = "Ref read error: " + refPath; return false; }
+    if (micR.info().sampleRate != refR.info().sampleRate) { err = "Sample rate mismatch"; return false; }
+
+    OfflineConfig cfg = cfgIn;
+    cfg.aec.sampleRate = micR.info().sampleRate;
+    if (!begin(cfg.aec.sampleRate)) return false;
+
+    bool refDone = false;
+    StreamSource src = [&](float* mic, float* ref, size_t frames) -> size_t {
+        size_t n = micR.readMono(mic, frames);
+        size_t r = refDone ? 0 : refR.readMono(ref, n);
+        if (r < n) {
+            refDone = true;
+            std::fill(ref + r, ref + n, 0.0f);
+        }
+        return n;
+    };
+    return runOfflineStream(cfg, src, sink, res);
+}
+
+bool processWavPair(const OfflineConfig& cfg, const std::string& micPath, const std::string& refPath,
+                    const std::string& outPath, OfflineResult& res, std::string& err) {
+    WavFileWriter w;
+    auto begin = [&](int sampleRate) {
+        if (w.open(outPath, sampleRate, 1)) return true;
+        err = "Write error: " + outPath;
+        return false;
+    };
+    StreamSink sink = [&](const float* out, size_t frames) { return w.write(out, frames); };
+
+    if (!runWavInputs(cfg, micPath, refPath, begin, sink, res, err)) {
+        w.close();
+        if (err.empty()) err = "Write error: " + outPath;
+        return false;
+    }
+    if (!w.close()) { err = "Write error: " + outPath; return false; }
+    return true;
+}
+
+bool processWavToBuffer(const OfflineConfig& cfg, const std::string& micPath, const std::string& refPath,
+                        std::vector<float>& out, int& sampleRate, OfflineResult& res, std::string& err) {
+    out.clear();
+    auto begin = [&](int sr) { sampleRate = sr; return true; };
+    StreamSink sink = [&](const float* o, size_t frames) {
+        out.insert(out.end(), o, o + frames);
+        return true;
+    };
+    return runWavInputs(cfg, micPath, refPath, begin, sink, res, err);
+}
+
+bool processRawPipe(const OfflineConfig& cfg, FILE* in, FILE* out, bool float32,
+                    OfflineResult& res, std::string& err) {
+    WavSampleFormat fmt = float32 ? WavSampleFormat::Float32 : WavSampleFormat::Int16;
+    size_t bytesPerSample = sampleBytes(fmt);
+    std::vector<uint8_t> raw(cfg.chunkFrames * 2 * bytesPerSample);
+    std::vector<float> pair(cfg.chunkFrames * 2);
+    std::vector<uint8_t> rawOut(cfg.chunkFrames * bytesPerSample);
+
+    StreamSource src = [&](float* mic, float* ref, size_t frames) -> size_t {
+        size_t want = std::min(frames, raw.size() / (2 * bytesPerSample));
+        size_t n = fread(raw.data(), 2 * bytesPerSample, want, in);
+        decodeSamples(fmt, raw.data(), pair.data(), 2 * n);
+        float* const chans[2] = { mic, ref };
+        deinterleave(pair.data(), 2, chans, n);
+        return n;
+    };
+    StreamSink sink = [&](const float* o, size_t frames) -> bool {
+        if (rawOut.size() < frames * bytesPerSample) rawOut.resize(frames * bytesPerSample);
+        encodeSamples(fmt, o, rawOut.data(), frames);
+        return fwrite(rawOut.data(), bytesPerSample, frames, out) == frames;
+    };
+
+    bool ok = runOfflineStream(cfg, src, sink, res);
+    if (fflush(out) != 0) ok = false;
+    if (!ok) err = "Write error: stdout";
+    return ok;
+}
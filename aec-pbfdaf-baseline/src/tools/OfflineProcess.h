@@ -0,0 +1,58 @@
+#pragma once
+// Chunked, bounded-memory offline processing of mic/ref streams through
+// AECPipeline (canceller, optionally with noise suppression). Shared by the offline tools.
+
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <functional>
+#include "../aec_core/AECPipeline.h"
+
+struct OfflineConfig {
+    AECParams aec;
+    bool enhance;       // Noise suppression after the canceller
+    bool fused;         // With enhance: suppress on the canceller's error spectrum (PipelineMode::Fused)
+    bool residualEcho;  // Per-bin residual echo suppression in the canceller
+    bool subband;       // 32/48 kHz: cancel on the 0-8 kHz band (AECProcessor::setSubband)
+    bool drift;         // Clock-drift compensation (AECProcessor::setDriftCompensation)
+    AECFilterMode filter; // AECProcessor::setFilterMode
+    bool vss;           // Per-bin variable step size (AECProcessor::setVariableStepSize)
+    size_t chunkFrames; // Frames per process() call
+    bool alignOutput;   // Drop the pipeline latency so out[i] lines up with mic[i]
+    const AECEchoPath* warmStart; // Cached echo path to start from (nullptr: cold start)
+};
+
+struct OfflineResult {
+    uint64_t frames;
+    double wallSec;     // Including I/O
+    double audioSec;
+    AECStats stats;
+    AECLoadStats load;
+    AECEchoPath echoPath; // Filter at the end of the stream, for EchoPathCache
+};
+
+// Fills up to 'frames' mic/ref samples and returns the count (0 = end of input).
+// A reference that ends early is zero-filled by the source.
+typedef std::function<size_t(float* mic, float* ref, size_t frames)> StreamSource;
+typedef std::function<bool(const float* out, size_t frames)> StreamSink;
+
+OfflineConfig defaultOfflineConfig(int sampleRate);
+PipelineMode offlinePipelineMode(const OfflineConfig& cfg);
+
+bool runOfflineStream(const OfflineConfig& cfg, const StreamSource& src, const StreamSink& sink,
+                      OfflineResult& res);
+
+// WAV in (int16/24/32, float32, EXTENSIBLE, RF64), 16-bit mono WAV out.
+// Multi-channel inputs are downmixed.
+bool processWavPair(const OfflineConfig& cfg, const std::string& micPath, const std::string& refPath,
+                    const std::string& outPath, OfflineResult& res, std::string& err);
+
+// Same input handling as processWavPair, output kept in memory (mono, aligned as configured)
+bool processWavToBuffer(const OfflineConfig& cfg, const std::string& micPath, const std::string& refPath,
+                        std::vector<float>& out, int& sampleRate, OfflineResult& res, std::string& err);
+
+// Raw little-endian PCM: 'in' carries interleaved (mic, ref) frames, 'out' gets mono frames.
+bool processRawPipe(const OfflineConfig& cfg, FILE* in, FILE* out, bool float32,
+                    OfflineResult& res, std::string& err);
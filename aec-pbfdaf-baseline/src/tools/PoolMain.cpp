@@ -0,0 +1,134 @@
+// aec_pool: load generator for the multi-session pool. Opens many sessions on one
+// synthetic echo scenario (each reading from its own offset), feeds them one block
+// per session every block period (or as fast as the queues accept with --flood), and
+// reports throughput, submit-to-completion latency, drops and work stealing.
+//   aec_pool [options]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "LoadGen.h"
+#include "../server/SessionPool.h"
+
+static void usage() {
+    fprintf(stderr,
+        "Usage: aec_pool [options]\n"
+        "Options: --sessions n (default 500)  --workers n (0 = all cores)  --sec s (default 5)\n"
+        "         --block ms (default 10)  --queue blocks  --sr rate  --filter taps  --mu v\n"
+        "         --mode aec|cascade|fused  --pin (pin workers to cores)\n"
+        "         --history f32|fp16|bf16  --weights f32|fp16|bf16 (PBFDAF spectrum storage)\n"
+        "         --flood (submit as fast as the queues accept instead of in real time)\n");
+}
+
+int main(int argc, char** argv) {
+    SessionPoolConfig pc = defaultSessionPoolConfig();
+    AECParams ap = defaultAECParams(16000);
+    PipelineMode mode = PipelineMode::AecOnly;
+    int sessions = 500;
+    double seconds = 5.0;
+    int blockMs = 10;
+    bool flood = false;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "--sessions" && i + 1 < argc) {
+            sessions = atoi(argv[++i]);
+        } else if (a == "--workers" && i + 1 < argc) {
+            pc.workers = atoi(argv[++i]);
+        } else if (a == "--sec" && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+        } else if (a == "--block" && i + 1 < argc) {
+            blockMs = atoi(argv[++i]);
+        } else if (a == "--queue" && i + 1 < argc) {
+            pc.queueBlocks = atoi(argv[++i]);
+        } else if (a == "--sr" && i + 1 < argc) {
+            ap.sampleRate = atoi(argv[++i]);
+        } else if (a == "--filter" && i + 1 < argc) {
+            ap.filterLen = atoi(argv[++i]);
+        } else if (a == "--mu" && i + 1 < argc) {
+            ap.mu = (float)atof(argv[++i]);
+        } else if (a == "--mode" && i + 1 < argc) {
+            std::string m = argv[++i];
+            if (m == "aec") mode = PipelineMode::AecOnly;
+            else if (m == "cascade") mode = PipelineMode::Cascade;
+            else if (m == "fused") mode = PipelineMode::Fused;
+            else { usage(); return 1; }
+        } else if (a == "--history" && i + 1 < argc) {
+            if (!parseSpectrumPrecision(argv[++i], ap.historyPrecision)) { usage(); return 1; }
+        } else if (a == "--weights" && i + 1 < argc) {
+            if (!parseSpectrumPrecision(argv[++i], ap.weightPrecision)) { usage(); return 1; }
+        } else if (a == "--pin") {
+            pc.pinWorkers = true;
+        } else if (a == "--flood") {
+            flood = true;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (sessions < 1 || seconds <= 0.0 || blockMs <= 0 || ap.sampleRate <= 0) {
+        usage();
+        return 1;
+    }
+    pc.maxSessions = sessions;
+    pc.blockFrames = (size_t)ap.sampleRate * (size_t)blockMs / 1000;
+
+    const size_t B = pc.blockFrames;
+    ScenarioFeed feed;
+    if (!feed.init("pool", ap.sampleRate, B, (size_t)sessions)) {
+        fprintf(stderr, "Scenario generation failed\n");
+        return 1;
+    }
+    LatencyHistogram hist;
+    SessionCallback cb = [&](int, uint64_t tag, const float*, size_t) { hist.record(loadClockNs() - tag); };
+
+    SessionPool pool;
+    std::string err;
+    if (!pool.start(pc, err)) {
+        fprintf(stderr, "%s\n", err.c_str());
+        return 1;
+    }
+    std::vector<int> ids;
+    for (int k = 0; k < sessions; ++k) {
+        int id = pool.openSession(ap, mode, cb);
+        if (id < 0) {
+            fprintf(stderr, "Could not open session %d\n", k);
+            return 1;
+        }
+        ids.push_back(id);
+    }
+
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point start = Clock::now();
+    FeedResult fr = runFeed(feed, seconds, flood, std::chrono::microseconds(blockMs * 1000),
+        [&](size_t k, const float* mic, const float* ref) { return pool.submit(ids[k], mic, ref, loadClockNs()); });
+    pool.drain();
+    double wall = std::chrono::duration<double>(Clock::now() - start).count();
+    SessionPoolStats st = pool.getStats();
+    AECStats s0 = pool.aec(ids[0])->getStats();
+    pool.stop();
+
+    uint64_t done = hist.count();
+    double audioSec = (double)done * (double)B / (double)ap.sampleRate;
+    uint64_t wMin = st.workerBlocks.empty() ? 0 : *std::min_element(st.workerBlocks.begin(), st.workerBlocks.end());
+    uint64_t wMax = st.workerBlocks.empty() ? 0 : *std::max_element(st.workerBlocks.begin(), st.workerBlocks.end());
+    printf("%d sessions on %d workers, %s, %zu-frame blocks, %.2f s wall\n",
+        sessions, pool.workerCount(), flood ? "flood" : "paced", B, wall);
+    printf("  canceller memory %.1f KB per session (history %s, weights %s)\n",
+        (double)AECProcessor::memoryFootprint(ap) / 1024.0, spectrumPrecisionName(ap.historyPrecision),
+        spectrumPrecisionName(ap.weightPrecision));
+    printf("  %llu blocks (%.0f blocks/s, %.1f x real time over all sessions), refused %llu, steals %llu\n",
+        (unsigned long long)done, (double)done / wall, audioSec / wall,
+        (unsigned long long)fr.refused, (unsigned long long)st.steals);
+    printf("  latency p50 %.0f us, p99 %.0f us, max %.0f us; worker blocks min %llu max %llu\n",
+        hist.percentileUs(0.5), hist.percentileUs(0.99), hist.maxUs(),
+        (unsigned long long)wMin, (unsigned long long)wMax);
+    if (!flood) printf("  feeder late on %llu ticks\n", (unsigned long long)fr.lateTicks);
+    printf("  session 0: ERLE avg %.1f dB, max %.1f dB\n", s0.avgErle, s0.maxErle);
+    if (done != fr.submitted) {
+        fprintf(stderr, "Completed %llu of %llu submitted blocks\n", (unsigned long long)done, (unsigned long long)fr.submitted);
+        return 1;
+    }
+    return (!flood && fr.refused > 0) ? 2 : 0;
+}
@@ -0,0 +1,175 @@
+// aec_realtime: runs the real-time engine (capture thread, SPSC rings, processing
+// thread) on the file/synthetic backend, paced at wall-clock rate. Load-tests the
+// full real-time path without audio hardware.
+//   aec_realtime [options] mic.wav ref.wav [out.wav]
+//   aec_realtime [options] --synthetic [out.wav]
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ScenarioGen.h"
+#include "../realtime/RealtimeEngine.h"
+#include "../realtime/FileBackend.h"
+
+static void usage() {
+    fprintf(stderr,
+        "Usage: aec_realtime [options] mic.wav ref.wav [out.wav]\n"
+        "       aec_realtime [options] --synthetic [--sr rate] [--len sec] [--ppm drift] [out.wav]\n"
+        "Options: --speed x (1 = real time, 0 = unpaced)  --packet ms  --block ms  --ring ms  --dur ms\n"
+        "         --streams n (independent engines in parallel)  --mode aec|cascade|fused\n"
+        "         --filter taps  --mu v  --maxdelay ms  --float (32-bit float out.wav)\n"
+        "Device simulation (timestamped mic/ref packet streams re-aligned by a jitter buffer):\n"
+        "         --jitter ms (timestamp jitter, enables it)  --ref-packet ms  --hold ms\n");
+}
+
+int main(int argc, char** argv) {
+    RealtimeConfig cfg = defaultRealtimeConfig();
+    std::vector<std::string> files;
+    bool synthetic = false;
+    int sr = 16000;
+    float lenSec = 20.0f;
+    float ppm = 0.0f;
+    double speed = 1.0;
+    int packetMs = 10;
+    int streams = 1;
+    double jitterMs = -1.0;
+    int refPacketMs = 7;
+    int holdMs = 30;
+    WavOutputFormat outFormat = WavOutputFormat::Int16;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "--synthetic") {
+            synthetic = true;
+        } else if (a == "--sr" && i + 1 < argc) {
+            sr = atoi(argv[++i]);
+        } else if (a == "--len" && i + 1 < argc) {
+            lenSec = (float)atof(argv[++i]);
+        } else if (a == "--ppm" && i + 1 < argc) {
+            ppm = (float)atof(argv[++i]);
+        } else if (a == "--speed" && i + 1 < argc) {
+            speed = atof(argv[++i]);
+        } else if (a == "--packet" && i + 1 < argc) {
+            packetMs = atoi(argv[++i]);
+        } else if (a == "--block" && i + 1 < argc) {
+            cfg.blockMs = atoi(argv[++i]);
+        } else if (a == "--ring" && i + 1 < argc) {
+            cfg.ringMs = atoi(argv[++i]);
+        } else if (a == "--dur" && i + 1 < argc) {
+            cfg.durationMs = atoi(argv[++i]);
+        } else if (a == "--float") {
+            outFormat = WavOutputFormat::Float32;
+        } else if (a == "--jitter" && i + 1 < argc) {
+            jitterMs = atof(argv[++i]);
+        } else if (a == "--ref-packet" && i + 1 < argc) {
+            refPacketMs = atoi(argv[++i]);
+        } else if (a == "--hold" && i + 1 < argc) {
+            holdMs = atoi(argv[++i]);
+        } else if (a == "--streams" && i + 1 < argc) {
+            streams = atoi(argv[++i]);
+        } else if (a == "--mode" && i + 1 < argc) {
+            std::string m = argv[++i];
+            if (m == "aec") cfg.mode = PipelineMode::AecOnly;
+            else if (m == "cascade") cfg.mode = PipelineMode::Cascade;
+            else if (m == "fused") cfg.mode = PipelineMode::Fused;
+            else { usage(); return 1; }
+        } else if (a == "--filter" && i + 1 < argc) {
+            cfg.aec.filterLen = atoi(argv[++i]);
+        } else if (a == "--mu" && i + 1 < argc) {
+            cfg.aec.mu = (float)atof(argv[++i]);
+        } else if (a == "--maxdelay" && i + 1 < argc) {
+            cfg.aec.maxDelayMs = atoi(argv[++i]);
+        } else if (!a.empty() && a[0] == '-') {
+            usage();
+            return 1;
+        } else {
+            files.push_back(a);
+        }
+    }
+    if (streams < 1) streams = 1;
+    if (synthetic ? files.size() > 1 : (files.size() < 2 || files.size() > 3)) {
+        usage();
+        return 1;
+    }
+
+    // One input shared by all streams; only stream 0 writes the output file
+    std::vector<std::unique_ptr<FileBackend>> backends;
+    Scenario sc;
+    if (synthetic) {
+        ScenarioParams sp = defaultScenarioParams("realtime", sr, lenSec);
+        sp.driftPpm = ppm;
+        std::vector<float> farEnd((size_t)(lenSec * (float)sr));
+        makeSpeechLike(farEnd, sr, -20.0f, sp.seed);
+        if (!generateScenario(sp, farEnd, std::vector<float>(), sc)) {
+            fprintf(stderr, "Scenario generation failed\n");
+            return 1;
+        }
+    }
+    std::string err;
+    for (int k = 0; k < streams; k++) {
+        backends.emplace_back(new FileBackend());
+        FileBackend& b = *backends.back();
+        if (synthetic) {
+            b.setSignals(sc.mic, sc.ref, sr);
+        } else if (!b.openWav(files[0], files[1], err)) {
+            fprintf(stderr, "%s\n", err.c_str());
+            return 1;
+        }
+        if (k == 0 && files.size() == (synthetic ? 1u : 3u)) b.setOutputPath(files.back(), outFormat);
+        b.setPacing(packetMs, speed);
+        if (jitterMs >= 0.0) b.setDeviceSimulation(jitterMs, refPacketMs, holdMs);
+    }
+
+    std::vector<std::unique_ptr<RealtimeEngine>> engines;
+    for (int k = 0; k < streams; k++) {
+        engines.emplace_back(new RealtimeEngine());
+        if (!backends[k]->start(err) || !engines[k]->start(*backends[k], cfg, err)) {
+            fprintf(stderr, "Stream %d: %s\n", k, err.c_str());
+            return 1;
+        }
+    }
+    for (auto& e : engines) e->wait();
+    for (auto& b : backends) b->stop();
+
+    bool ok = true;
+    for (int k = 0; k < streams; k++) {
+        const RealtimeEngine& e = *engines[k];
+        RealtimeStats rs = e.getStats();
+        AECStats s = e.aec().getStats();
+        AECLoadStats la = e.aec().getLoadStats();
+        AECLoadStats lc = e.getChainLoadStats();
+        int rate = backends[k]->sampleRate();
+        printf("stream %d: %.2f s captured, %.2f s processed, dropped %llu frames in %llu packets, "
+               "max ring fill %.1f ms, pacing late max %.2f ms\n",
+            k, (double)rs.capturedFrames / rate, (double)rs.processedFrames / rate,
+            (unsigned long long)rs.droppedFrames, (unsigned long long)rs.droppedPackets,
+            1000.0 * (double)rs.maxFillFrames / rate, backends[k]->maxLateMs());
+        printf("  ERLE avg %.1f dB, max %.1f dB, lag %.1f ms (%d changes)\n",
+            s.avgErle, s.maxErle, s.currentLagMs, s.delayUpdateCount);
+        printf("  AEC load:   RTF %.4f, p50 %.1f us, p99 %.1f us, max %.1f us, misses %llu/%llu\n",
+            la.rtf, la.p50Us, la.p99Us, la.maxUs,
+            (unsigned long long)la.deadlineMisses, (unsigned long long)la.calls);
+        printf("  Chain load: RTF %.4f, p50 %.1f us, p99 %.1f us, max %.1f us, misses %llu/%llu\n",
+            lc.rtf, lc.p50Us, lc.p99Us, lc.maxUs,
+            (unsigned long long)lc.deadlineMisses, (unsigned long long)lc.calls);
+        JitterStats js;
+        if (backends[k]->getJitterStats(js)) {
+            printf("  Alignment: ref underrun %llu, mic gaps %llu, late %llu, overrun %llu frames, "
+                   "%llu resyncs, align error mean %.2f ms, max %.2f ms\n",
+                (unsigned long long)js.refUnderrunFrames, (unsigned long long)js.micGapFrames,
+                (unsigned long long)js.lateFrames, (unsigned long long)js.overrunFrames,
+                (unsigned long long)js.resyncs, js.alignErrorMs, js.maxAlignErrorMs);
+        }
+        AsyncWavStats ws;
+        if (backends[k]->getWriterStats(ws)) {
+            printf("  Output: %.2f s written in %llu batches, dropped %llu frames in %llu blocks, "
+                   "max queue %.1f ms%s\n",
+                (double)ws.writtenFrames / rate, (unsigned long long)ws.batches,
+                (unsigned long long)ws.droppedFrames, (unsigned long long)ws.droppedBlocks,
+                1000.0 * (double)ws.maxQueueFrames / rate, ws.ioError ? ", write error" : "");
+            ok = ok && ws.droppedFrames == 0 && !ws.ioError;
+        }
+        ok = ok && rs.droppedFrames == 0;
+    }
+    return ok ? 0 : 2;
+}
@@ -0,0 +1,197 @@
+#include "ScenarioGen.h"
+#include <cmath>
+#include <algorithm>
+
+static const float kPi = 3.14159265358979323846f;
+
+// Small deterministic generator so scenarios are reproducible across platforms
+struct Rng {
+    uint32_t s;
+    explicit Rng(uint32_t seed) : s(seed ? seed : 1u) {}
+    uint32_t next() { s ^= s << 13; s ^= s >> 17; s ^= s << 5; return s; }
+    float uniform() { return (float)(next() >> 8) * (1.0f / 16777216.0f); }
+    float gauss() {
+        float u1 = uniform() + 1e-7f, u2 = uniform();
+        return std::sqrt(-2.0f * std::log(u1)) * std::cos(2.0f * kPi * u2);
+    }
+};
+
+static inline float dbToLin(float db) { return std::pow(10.0f, db / 20.0f); }
+
+ScenarioParams defaultScenarioParams(const std::string& name, int sampleRate, float durationSec) {
+    ScenarioParams p;
+    p.name = name;
+    p.sampleRate = sampleRate;
+    p.durationSec = durationSec;
+    p.bulkDelayMs = 40.0f;
+    p.delayJumpSec = 0.0f;
+    p.delayJumpMs = 40.0f;
+    p.rt60Ms = 150.0f;
+    p.rirLenMs = 100.0f;
+    p.echoGainDb = -6.0f;
+    p.doubleTalkStartSec = 0.0f;
+    p.doubleTalkEndSec = 0.0f;
+    p.nearEndDb = -26.0f;
+    p.noiseDb = -130.0f;
+    p.driftPpm = 0.0f;
+    p.seed = 1;
+    return p;
+}
+
+// Two-pole resonator, r close to 1 for narrow formants
+struct Resonator {
+    float a1, a2, g, y1, y2;
+    Resonator() : a1(0), a2(0), g(0), y1(0), y2(0) {}
+    void set(float freq, float bw, int sr) {
+        float r = std::exp(-kPi * bw / (float)sr);
+        a1 = 2.0f * r * std::cos(2.0f * kPi * freq / (float)sr);
+        a2 = -r * r;
+        g = 1.0f - r;
+    }
+    float tick(float x) {
+        float y = g * x + a1 * y1 + a2 * y2;
+        y2 = y1; y1 = y;
+        return y;
+    }
+};
+
+void makeSpeechLike(std::vector<float>& out, int sampleRate, float rmsDb, uint32_t seed) {
+    Rng rng(seed);
+    size_t n = out.size();
+    Resonator f1, f2, f3;
+    float pitchPhase = 0.0f;
+    float pitchHz = 110.0f + 40.0f * rng.uniform();
+
+    size_t i = 0;
+    while (i < n) {
+        // A talk spurt of a few syllables, then a pause
+        int syllables = 2 + (int)(rng.uniform() * 6.0f);
+        for (int s = 0; s < syllables && i < n; ++s) {
+            size_t len = (size_t)((0.12f + 0.18f * rng.uniform()) * (float)sampleRate);
+            f1.set(300.0f + 500.0f * rng.uniform(), 80.0f, sampleRate);
+            f2.set(900.0f + 1400.0f * rng.uniform(), 120.0f, sampleRate);
+            f3.set(2400.0f + 1000.0f * rng.uniform(), 200.0f, sampleRate);
+            bool voiced = rng.uniform() < 0.8f;
+            float pitch = pitchHz * (0.85f + 0.3f * rng.uniform());
+            for (size_t k = 0; k < len && i < n; ++k, ++i) {
+                float env = std::sin(kPi * (float)k / (float)len);
+                float exc;
+                if (voiced) {
+                    pitchPhase += pitch / (float)sampleRate;
+                    float pulse = 0.0f;
+                    if (pitchPhase >= 1.0f) { pitchPhase -= 1.0f; pulse = 8.0f; }
+                    exc = pulse + 0.3f * rng.gauss();
+                } else {
+                    exc = rng.gauss();
+                }
+                float v = f1.tick(exc) * 1.0f + f2.tick(exc) * 0.6f + f3.tick(exc) * 0.3f;
+                out[i] = v * env;
+            }
+        }
+        size_t pause = (size_t)((0.15f + 0.6f * rng.uniform()) * (float)sampleRate);
+        for (size_t k = 0; k < pause && i < n; ++k, ++i) out[i] = 0.0f;
+    }
+
+    // Normalize over the active portion
+    double e = 0.0;
+    size_t active = 0;
+    for (size_t k = 0; k < n; ++k) {
+        if (out[k] != 0.0f) { e += (double)out[k] * out[k]; active++; }
+    }
+    if (active == 0 || e <= 0.0) return;
+    float g = dbToLin(rmsDb) / (float)std::sqrt(e / (double)active);
+    for (size_t k = 0; k < n; ++k) out[k] *= g;
+}
+
+void makeRoomResponse(std::vector<float>& h, int sampleRate, float rt60Ms, float lenMs, float gainDb, uint32_t seed) {
+    Rng rng(seed);
+    size_t len = (size_t)(lenMs * 0.001f * (float)sampleRate);
+    if (len < 1) len = 1;
+    h.assign(len, 0.0f);
+    // 60 dB decay over rt60: amplitude envelope exp(-6.9 t / rt60)
+    float decay = rt60Ms > 0.0f ? 6.9f / (rt60Ms * 0.001f * (float)sampleRate) : 1.0f;
+    float g = dbToLin(gainDb);
+    h[0] = g;
+    double tailE = 0.0;
+    for (size_t k = 1; k < len; ++k) {
+        h[k] = rng.gauss() * std::exp(-decay * (float)k);
+        tailE += (double)h[k] * h[k];
+    }
+    // Direct-to-reverberant ratio of +6 dB, typical for a desk/laptop setup
+    if (tailE > 0.0) {
+        float s = g * (float)std::sqrt(std::pow(10.0, -6.0 / 10.0) / tailE);
+        for (size_t k = 1; k < len; ++k) h[k] *= s;
+    }
+}
+
+// Catmull-Rom interpolation of x at fractional position pos (0 outside the signal)
+static inline float interp(const std::vector<float>& x, double pos) {
+    if (pos < 0.0) return 0.0f;
+    long i = (long)pos;
+    float t = (float)(pos - (double)i);
+    long n = (long)x.size();
+    auto at = [&](long k) { return (k >= 0 && k < n) ? x[(size_t)k] : 0.0f; };
+    float p0 = at(i - 1), p1 = at(i), p2 = at(i + 1), p3 = at(i + 2);
+    return p1 + 0.5f * t * (p2 - p0 + t * (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3 + t * (3.0f * (p1 - p2) + p3 - p0)));
+}
+
+bool generateScenario(const ScenarioParams& p, const std::vector<float>& farEnd,
+                      const std::vector<float>& nearEnd, Scenario& out) {
+    if (p.sampleRate <= 0 || p.durationSec <= 0.0f) return false;
+    size_t n = (size_t)(p.durationSec * (float)p.sampleRate);
+    if (farEnd.size() < n) return false;
+
+    out.ref.assign(farEnd.begin(), farEnd.begin() + n);
+    out.echo.assign(n, 0.0f);
+    out.nearEnd.assign(n, 0.0f);
+    out.mic.assign(n, 0.0f);
+    out.trueDelayMs.assign(n, 0.0f);
+
+    // Loudspeaker output in the mic clock domain: bulk delay + clock drift
+    double eps = (double)p.driftPpm * 1e-6;
+    double sr = (double)p.sampleRate;
+    std::vector<float> spk(n);
+    for (size_t i = 0; i < n; ++i) {
+        double t = (double)i / sr;
+        double dMs = (p.delayJumpSec > 0.0f && t >= p.delayJumpSec) ? p.delayJumpMs : p.bulkDelayMs;
+        double src = ((double)i - dMs * 0.001 * sr) * (1.0 + eps);
+        spk[i] = interp(out.ref, src);
+        out.trueDelayMs[i] = (float)(((double)i - src) * 1000.0 / sr);
+    }
+
+    // Room
+    std::vector<float> h;
+    makeRoomResponse(h, p.sampleRate, p.rt60Ms, p.rirLenMs, p.echoGainDb, p.seed * 7919u + 13u);
+    for (size_t k = 0; k < h.size(); ++k) {
+        float hk = h[k];
+        if (hk == 0.0f) continue;
+        float* e = out.echo.data() + k;
+        const float* x = spk.data();
+        size_t m = n - std::min(n, k);
+        for (size_t i = 0; i < m; ++i) e[i] += hk * x[i];
+    }
+
+    // Near-end talker during the double-talk interval
+    if (p.doubleTalkEndSec > p.doubleTalkStartSec) {
+        std::vector<float> talker;
+        if (nearEnd.size() >= n) {
+            talker.assign(nearEnd.begin(), nearEnd.begin() + n);
+        } else {
+            talker.assign(n, 0.0f);
+            makeSpeechLike(talker, p.sampleRate, p.nearEndDb, p.seed * 31u + 5u);
+        }
+        size_t a = (size_t)(p.doubleTalkStartSec * (float)p.sampleRate);
+        size_t b = std::min(n, (size_t)(p.doubleTalkEndSec * (float)p.sampleRate));
+        for (size_t i = a; i < b; ++i) out.nearEnd[i] = talker[i];
+    }
+
+    // Background noise
+    if (p.noiseDb > -120.0f) {
+        Rng rng(p.seed * 104729u + 3u);
+        float g = dbToLin(p.noiseDb);
+        for (size_t i = 0; i < n; ++i) out.nearEnd[i] += g * rng.gauss();
+    }
+
+    for (size_t i = 0; i < n; ++i) out.mic[i] = out.echo[i] + out.nearEnd[i];
+    return true;
+}
@@ -0,0 +1,46 @@
+#pragma once
+// Synthetic echo scenarios: builds mic/ref pairs from far-end (and optional
+// near-end) source signals through a synthetic room, with bulk delay, delay
+// jumps, double-talk, noise and loudspeaker/mic clock drift.
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+struct ScenarioParams {
+    std::string name;
+    int sampleRate;
+    float durationSec;
+    float bulkDelayMs;        // Loudspeaker -> mic bulk delay
+    float delayJumpSec;       // Time of a bulk delay change (<= 0: none)
+    float delayJumpMs;        // Bulk delay after the jump
+    float rt60Ms;             // Synthetic room decay time
+    float rirLenMs;           // Length of the synthetic impulse response
+    float echoGainDb;         // Echo path gain (direct path relative to far-end)
+    float doubleTalkStartSec; // Near-end talker interval (end <= start: none)
+    float doubleTalkEndSec;
+    float nearEndDb;          // Near-end talker level (dBFS RMS)
+    float noiseDb;            // Near-end background noise (dBFS RMS, <= -120: none)
+    float driftPpm;           // Loudspeaker clock offset relative to the mic clock
+    uint32_t seed;
+};
+
+struct Scenario {
+    std::vector<float> mic;     // echo + near-end + noise
+    std::vector<float> ref;     // far-end reference as seen by the canceller
+    std::vector<float> echo;    // echo component of mic (ground truth)
+    std::vector<float> nearEnd; // near-end speech + noise (ground truth)
+    std::vector<float> trueDelayMs; // Bulk delay per sample (includes drift)
+};
+
+ScenarioParams defaultScenarioParams(const std::string& name, int sampleRate, float durationSec);
+
+// Speech-like test signal: resonant filtered noise with syllabic envelope and pauses
+void makeSpeechLike(std::vector<float>& out, int sampleRate, float rmsDb, uint32_t seed);
+
+// Exponentially decaying random room impulse response with a direct-path peak
+void makeRoomResponse(std::vector<float>& h, int sampleRate, float rt60Ms, float lenMs, float gainDb, uint32_t seed);
+
+// farEnd: loudspeaker signal; nearEnd may be empty (a speech-like talker is synthesized).
+bool generateScenario(const ScenarioParams& p, const std::vector<float>& farEnd,
+                      const std::vector<float>& nearEnd, Scenario& out);
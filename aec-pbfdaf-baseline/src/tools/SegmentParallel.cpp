@@ -0,0 +1,252 @@
+#include "SegmentParallel.h"
+#include "../audio_io/WavFile.h"
+#include "../audio_io/MappedWavReader.h"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+static const float kPi = 3.14159265358979323846f;
+
+SegmentConfig defaultSegmentConfig() {
+    SegmentConfig s;
+    s.segments = 0;
+    s.threads = 0;
+    s.leadInSec = 8.0f;
+    s.crossfadeSec = 0.25f;
+    s.leadInMuScale = 1.0f; // Larger steps buy under 1 dB at the seams and diverge from ~1.5x
+    s.minSegmentSec = 30.0f;
+    return s;
+}
+
+// Mono frames [pos, pos + n); zeros past the end of the input
+static void readRegion(const MappedWavReader& r, uint64_t pos, float* dst, size_t n) {
+    size_t got = r.readMonoAt(pos, dst, n);
+    std::fill(dst + got, dst + n, 0.0f);
+}
+
+struct SegmentJob {
+    uint64_t begin;      // First frame owned by this segment
+    uint64_t end;
+    uint64_t outBegin;   // begin minus the crossfade overlap
+    std::vector<float> head; // Aligned output over [outBegin, begin)
+    std::vector<float> tail; // Aligned output over [end - overlap, end)
+    AECStats stats;
+    AECLoadStats load;
+    AECEchoPath path;
+    bool ok;
+};
+
+bool processWavPairSegmented(const OfflineConfig& cfgIn, const SegmentConfig& seg,
+                             const std::string& micPath, const std::string& refPath,
+                             const std::string& outPath, OfflineResult& res, std::string& err) {
+    auto t0 = std::chrono::steady_clock::now();
+    MappedWavReader micR, refR;
+    // Post-filters and the band split have no checkpoint support, so they stay sequential
+    if (cfgIn.enhance || cfgIn.residualEcho || cfgIn.subband || !micR.open(micPath) || !refR.open(refPath)) {
+        return processWavPair(cfgIn, micPath, refPath, outPath, res, err);
+    }
+    if (micR.info().sampleRate != refR.info().sampleRate) { err = "Sample rate mismatch"; return false; }
+
+    OfflineConfig cfg = cfgIn;
+    int sr = micR.info().sampleRate;
+    cfg.aec.sampleRate = sr;
+    uint64_t total = micR.info().frames;
+    size_t chunk = cfg.chunkFrames > 0 ? cfg.chunkFrames : 4096;
+
+    int threads = seg.threads > 0 ? seg.threads : (int)std::thread::hardware_concurrency();
+    if (threads <= 0) threads = 1;
+    int count = seg.segments > 0 ? seg.segments : threads;
+    uint64_t minLen = (uint64_t)std::max(1.0f, seg.minSegmentSec * (float)sr);
+    if ((uint64_t)count > total / minLen) count = (int)(total / minLen);
+    if (count <= 1) return processWavPair(cfgIn, micPath, refPath, outPath, res, err);
+
+    uint64_t overlap = (uint64_t)std::max(0.0f, seg.crossfadeSec * (float)sr);
+    overlap = std::min(overlap, minLen / 2);
+    uint64_t leadIn = (uint64_t)std::max(0.0f, seg.leadInSec * (float)sr);
+
+    std::vector<SegmentJob> jobs(count);
+    for (int k = 0; k < count; ++k) {
+        jobs[k].begin = total * (uint64_t)k / (uint64_t)count;
+        jobs[k].end = total * (uint64_t)(k + 1) / (uint64_t)count;
+        jobs[k].outBegin = k > 0 ? jobs[k].begin - overlap : 0;
+        jobs[k].ok = false;
+    }
+
+    WavFileWriter w;
+    if (!w.open(outPath, sr, 1)) { err = "Write error: " + outPath; return false; }
+    std::mutex writeMtx;
+
+    // Unaligned output keeps the canceller latency as leading silence, like processWavPair
+    AECProcessor probe;
+    probe.initialize(cfg.aec);
+    uint64_t latency = (uint64_t)probe.getLatency();
+    uint64_t shift = cfg.alignOutput ? 0 : latency;
+
+    auto writeAligned = [&](uint64_t frame, const float* data, size_t n) {
+        uint64_t pos = frame + shift;
+        if (pos >= total) return true;
+        n = (size_t)std::min<uint64_t>(n, total - pos);
+        std::lock_guard<std::mutex> lock(writeMtx);
+        return w.writeAt(pos, data, n);
+    };
+
+    auto runSegment = [&](int k) {
+        SegmentJob& job = jobs[k];
+        std::vector<float> mic(chunk), ref(chunk), out(chunk);
+        // The pre-convergence pass runs the segment's canceller configuration, or its
+        // snapshot would not match the segment processor
+        auto configure = [&](AECProcessor& p) {
+            p.setDriftCompensation(cfg.drift);
+            p.setFilterMode(cfg.filter);
+            p.setVariableStepSize(cfg.vss);
+        };
+        AECProcessor aec;
+        configure(aec);
+        if (k == 0 && cfg.warmStart) aec.initialize(cfg.aec, *cfg.warmStart);
+        else aec.initialize(cfg.aec);
+
+        if (k > 0) {
+            // Pre-convergence over the lead-in at a fixed step size (a cold start with
+            // the variable step size can diverge), then a settling stretch with the
+            // segment's own configuration so the snapshot carries its step-size state
+            uint64_t preBegin = job.outBegin > leadIn ? job.outBegin - leadIn : 0;
+            uint64_t settle = preBegin + (job.outBegin - preBegin) * 3 / 4;
+            AECProcessor pre;
+            configure(pre);
+            pre.initialize(cfg.aec);
+            pre.setVariableStepSize(false);
+            pre.setMu(cfg.aec.mu * seg.leadInMuScale);
+            for (uint64_t pos = preBegin; pos < job.outBegin;) {
+                if (pos >= settle) {
+                    pre.setVariableStepSize(cfg.vss);
+                    pre.setMu(cfg.aec.mu);
+                }
+                uint64_t stop = pos < settle ? settle : job.outBegin;
+                size_t n = (size_t)std::min<uint64_t>(chunk, stop - pos);
+                readRegion(micR, pos, mic.data(), n);
+                readRegion(refR, pos, ref.data(), n);
+                pre.process(mic.data(), ref.data(), out.data(), n);
+                pos += n;
+            }
+            AECSnapshot snap;
+            pre.saveSnapshot(snap);
+            if (!aec.restoreSnapshot(snap)) return;
+        }
+
+        // Input frame i leaves the canceller as output frame i + latency
+        uint64_t stop = job.end + latency;
+        uint64_t skip = latency;
+        uint64_t outPos = job.outBegin;
+        uint64_t headEnd = k > 0 ? job.begin : job.outBegin;
+        uint64_t tailBegin = k + 1 < count ? job.end - overlap : job.end;
+        job.head.clear();
+        job.tail.clear();
+        for (uint64_t pos = job.outBegin; pos < stop;) {
+            size_t n = (size_t)std::min<uint64_t>(chunk, stop - pos);
+            readRegion(micR, pos, mic.data(), n);
+            readRegion(refR, pos, ref.data(), n);
+            aec.process(mic.data(), ref.data(), out.data(), n);
+            pos += n;
+
+            size_t drop = (size_t)std::min<uint64_t>(skip, n);
+            skip -= drop;
+            const float* o = out.data() + drop;
+            size_t m = n - drop;
+            while (m > 0) {
+                // Split the aligned output into head / body / tail
+                size_t take;
+                if (outPos < headEnd) {
+                    take = (size_t)std::min<uint64_t>(m, headEnd - outPos);
+                    job.head.insert(job.head.end(), o, o + take);
+                } else if (outPos < tailBegin) {
+                    take = (size_t)std::min<uint64_t>(m, tailBegin - outPos);
+                    if (!writeAligned(outPos, o, take)) return;
+                } else {
+                    take = (size_t)std::min<uint64_t>(m, job.end - outPos);
+                    job.tail.insert(job.tail.end(), o, o + take);
+                }
+                o += take;
+                m -= take;
+                outPos += take;
+            }
+        }
+        job.stats = aec.getStats();
+        job.load = aec.getLoadStats();
+        if (k + 1 == count) aec.exportEchoPath(job.path);
+        job.ok = true;
+    };
+
+    std::vector<std::thread> pool;
+    std::mutex nextMtx;
+    int next = 0;
+    auto work = [&]() {
+        while (true) {
+            int k;
+            {
+                std::lock_guard<std::mutex> lock(nextMtx);
+                k = next++;
+            }
+            if (k >= count) break;
+            runSegment(k);
+        }
+    };
+    for (int t = 1; t < std::min(threads, count); ++t) pool.emplace_back(work);
+    work();
+    for (auto& th : pool) th.join();
+
+    bool ok = true;
+    for (const auto& job : jobs) ok = ok && job.ok;
+
+    // Seams: raised-cosine crossfade from the earlier segment into the later one
+    std::vector<float> blend;
+    for (int k = 1; ok && k < count; ++k) {
+        const std::vector<float>& a = jobs[k - 1].tail;
+        const std::vector<float>& b = jobs[k].head;
+        size_t n = std::min(a.size(), b.size());
+        blend.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            float g = std::sin(0.5f * kPi * ((float)i + 0.5f) / (float)n);
+            g *= g;
+            blend[i] = (1.0f - g) * a[i] + g * b[i];
+        }
+        ok = writeAligned(jobs[k].outBegin, blend.data(), n);
+    }
+    // Unaligned output: leading silence for the canceller latency
+    if (ok && shift > 0) {
+        std::vector<float> zeros((size_t)std::min<uint64_t>(shift, total), 0.0f);
+        ok = w.writeAt(0, zeros.data(), zeros.size());
+    }
+    ok = w.close() && ok;
+    if (!ok) { err = "Write error: " + outPath; return false; }
+
+    // Merge per-segment statistics
+    res.frames = total;
+    res.audioSec = (double)total / (double)sr;
+    res.stats = jobs[0].stats;
+    res.load = jobs[0].load;
+    double erleSum = 0.0;
+    res.stats.delayUpdateCount = 0;
+    for (const auto& job : jobs) {
+        double frac = (double)(job.end - job.begin) / (double)total;
+        erleSum += frac * job.stats.avgErle;
+        res.stats.maxErle = std::max(res.stats.maxErle, job.stats.maxErle);
+        res.stats.delayUpdateCount += job.stats.delayUpdateCount;
+        if (&job == &jobs[0]) continue;
+        res.load.calls += job.load.calls;
+        res.load.frames += job.load.frames;
+        res.load.deadlineMisses += job.load.deadlineMisses;
+        res.load.maxUs = std::max(res.load.maxUs, job.load.maxUs);
+        res.load.p99Us = std::max(res.load.p99Us, job.load.p99Us);
+        res.load.peakRtf = std::max(res.load.peakRtf, job.load.peakRtf);
+        res.load.rtf = std::max(res.load.rtf, job.load.rtf);
+    }
+    res.stats.avgErle = (float)erleSum;
+    res.stats.currentLag = jobs.back().stats.currentLag;
+    res.stats.currentLagMs = jobs.back().stats.currentLagMs;
+    res.echoPath = jobs.back().path;
+    res.wallSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    return true;
+}
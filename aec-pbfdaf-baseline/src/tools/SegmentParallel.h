@@ -0,0 +1,26 @@
+#pragma once
+// Segment-parallel processing of one long recording. The file is split into
+// segments that run on separate cores; each segment starts from an
+// AECSnapshot taken after a short pre-convergence pass over the audio just
+// before it, and neighbouring segments are crossfaded over a short overlap.
+
+#include <string>
+#include "OfflineProcess.h"
+
+struct SegmentConfig {
+    int segments;        // <= 0: one per thread
+    int threads;         // <= 0: hardware concurrency
+    float leadInSec;     // Pre-convergence span before each segment
+    float crossfadeSec;  // Overlap blended at each seam
+    float leadInMuScale; // Step-size multiplier for the first three quarters of the lead-in
+    float minSegmentSec; // Segments are never shorter than this (short files run sequentially)
+};
+
+SegmentConfig defaultSegmentConfig();
+
+// Output matches processWavPair up to the seams. Falls back to processWavPair
+// when the inputs cannot be memory-mapped, the file is too short to split or
+// cfg.enhance, cfg.residualEcho or cfg.subband is set.
+bool processWavPairSegmented(const OfflineConfig& cfg, const SegmentConfig& seg,
+                             const std::string& micPath, const std::string& refPath,
+                             const std::string& outPath, OfflineResult& res, std::string& err);
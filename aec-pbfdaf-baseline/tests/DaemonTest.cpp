@@ -0,0 +1,178 @@
+// aec_daemon_test: AECDaemon checks (Linux). Starts the daemon on a socket in a
+// temporary directory, then lets a client that breaks the protocol at it (truncating
+// the session memory, corrupting the input ring index, a bad request) before running
+// the load generator against it for a second. The daemon must survive the bad client,
+// count it, and still serve every load generator session.
+//   aec_daemon_test path/to/aec_daemon_load
+// Exit code is non-zero when a check fails.
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "AECDaemon.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+// A raw protocol client: keeps the descriptors the daemon passes, which AECClient
+// would not expose
+struct RawSession {
+    int fd = -1;
+    int fds[3] = { -1, -1, -1 };   // memfd, doorbell, notify
+    DaemonReply rep;
+
+    ~RawSession() {
+        for (int d : fds) if (d >= 0) close(d);
+        if (fd >= 0) close(fd);
+    }
+};
+
+static bool rawRequest(RawSession& s, const DaemonRequest& rq) {
+    if (send(s.fd, &rq, sizeof(rq), MSG_NOSIGNAL) != (ssize_t)sizeof(rq)) return false;
+    iovec iov;
+    iov.iov_base = &s.rep;
+    iov.iov_len = sizeof(s.rep);
+    alignas(cmsghdr) char ctrl[CMSG_SPACE(3 * sizeof(int))];
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl;
+    msg.msg_controllen = sizeof(ctrl);
+    if (recvmsg(s.fd, &msg, MSG_CMSG_CLOEXEC) != (ssize_t)sizeof(s.rep)) return false;
+    cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+    if (cm && cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_RIGHTS &&
+        cm->cmsg_len == CMSG_LEN(sizeof(s.fds))) {
+        memcpy(s.fds, CMSG_DATA(cm), sizeof(s.fds));
+    }
+    return s.rep.status == 0;
+}
+
+static bool rawOpen(RawSession& s, const std::string& path) {
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.c_str(), path.size());
+    s.fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (s.fd < 0 || connect(s.fd, (const sockaddr*)&addr, sizeof(addr)) != 0) return false;
+    AECParams p = defaultAECParams(16000);
+    DaemonRequest rq;
+    memset(&rq, 0, sizeof(rq));
+    rq.version = kDaemonProtocolVersion;
+    rq.type = kDaemonOpen;
+    rq.session = -1;
+    rq.sampleRate = p.sampleRate;
+    rq.filterLen = p.filterLen;
+    rq.maxDelayMs = p.maxDelayMs;
+    rq.corrBlock = p.corrBlock;
+    rq.mu = p.mu;
+    rq.epsilon = p.epsilon;
+    rq.leak = p.leak;
+    rq.dtdAlpha = p.dtdAlpha;
+    rq.dtdBeta = p.dtdBeta;
+    rq.mode = (uint8_t)PipelineMode::AecOnly;
+    return rawRequest(s, rq) && s.fds[0] >= 0;
+}
+
+// Waits up to a second for the daemon's protocol error count to reach n
+static bool waitProtocolErrors(AECDaemon& daemon, uint64_t n) {
+    for (int i = 0; i < 100; ++i) {
+        if (daemon.getStats().protocolErrors >= n) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: aec_daemon_test path/to/aec_daemon_load\n");
+        return 1;
+    }
+    char dir[] = "/tmp/aec_daemon_test.XXXXXX";
+    if (!mkdtemp(dir)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    AECDaemonConfig cfg = defaultAECDaemonConfig();
+    cfg.socketPath = std::string(dir) + "/aec_daemon.sock";
+    AECDaemon daemon;
+    std::string err;
+    if (!daemon.start(cfg, err)) {
+        printf("FAIL: daemon start: %s\n", err.c_str());
+        rmdir(dir);
+        return 1;
+    }
+    struct stat sb;
+    check(stat(cfg.socketPath.c_str(), &sb) == 0 && (sb.st_mode & 0777) == 0600, "socket is private to its user");
+
+    // Session memory is sealed at its size
+    {
+        RawSession s;
+        check(rawOpen(s, cfg.socketPath), "raw open");
+        if (s.fds[0] >= 0) {
+            check(ftruncate(s.fds[0], 0) != 0, "session memory cannot shrink");
+            check(ftruncate(s.fds[0], (off_t)s.rep.shmBytes * 2) != 0, "session memory cannot grow");
+        }
+    }
+
+    // Input index past the end of the ring: the daemon closes the session
+    uint64_t errors = daemon.getStats().protocolErrors;
+    {
+        RawSession s;
+        check(rawOpen(s, cfg.socketPath), "raw open");
+        void* mem = s.fds[0] >= 0
+            ? mmap(nullptr, (size_t)s.rep.shmBytes, PROT_READ | PROT_WRITE, MAP_SHARED, s.fds[0], 0)
+            : MAP_FAILED;
+        if (mem != MAP_FAILED) {
+            DaemonShmHeader* h = static_cast<DaemonShmHeader*>(mem);
+            h->inWrite.store((uint64_t)s.rep.ringBlocks * 1000u, std::memory_order_release);
+            uint64_t one = 1;
+            check(write(s.fds[1], &one, sizeof(one)) == (ssize_t)sizeof(one), "doorbell");
+            check(waitProtocolErrors(daemon, errors + 1), "corrupt ring counted");
+            munmap(mem, (size_t)s.rep.shmBytes);
+        }
+
+        // A request with the wrong version is refused on the same connection
+        DaemonRequest rq;
+        memset(&rq, 0, sizeof(rq));
+        rq.version = kDaemonProtocolVersion + 1;
+        rq.type = kDaemonStats;
+        check(!rawRequest(s, rq) && s.rep.status != 0, "bad request refused");
+        check(waitProtocolErrors(daemon, errors + 2), "bad request counted");
+    }
+    check(daemon.isRunning(), "daemon survives the bad client");
+    errors = daemon.getStats().protocolErrors;
+    printf("bad client: %llu protocol errors\n", (unsigned long long)errors);
+
+    // Real-time load through the client library; exit code 0 means no session was
+    // refused and no block dropped
+    uint64_t blocks = daemon.getStats().pool.blocks;
+    std::string cmd = std::string(argv[1]) + " --socket " + cfg.socketPath + " --sessions 8 --sec 1";
+    int rc = system(cmd.c_str());
+    check(rc != -1 && WIFEXITED(rc) && WEXITSTATUS(rc) == 0, "load generator");
+    AECDaemonStats st = daemon.getStats();
+    printf("load: %llu blocks, %d sessions left open\n",
+        (unsigned long long)(st.pool.blocks - blocks), st.sessions);
+    check(st.pool.blocks - blocks >= 8 * 90, "load generator sessions served");
+    check(st.protocolErrors == errors, "no protocol errors from the client library");
+
+    daemon.stop();
+    rmdir(dir);
+    printf("%s\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}